@@ -0,0 +1,41 @@
+#ifndef APPLIANCE_REGISTRY_H
+#define APPLIANCE_REGISTRY_H
+
+#include "Appliance.h"
+#include "EVCharger.h"
+#include "Heater.h"
+#include "AirConditioner.h"
+#include "Light.h"
+#include "Curtain.h"
+#include <memory>
+#include <vector>
+
+// Appliance container indexed by concrete type
+// Each appliance is classified once when it is added, so optimizer passes can
+// walk only the devices they care about without RTTI casts or refcount bumps.
+// An appliance that derives from several kinds is listed under each of them.
+// The registry owns the appliances; the typed lists hold non-owning pointers.
+class ApplianceRegistry {
+public:
+    void add(std::shared_ptr<Appliance> appliance);
+
+    const std::vector<std::shared_ptr<Appliance>>& getAll() const;
+    const std::vector<EVCharger*>& getEVChargers() const;
+    const std::vector<Heater*>& getHeaters() const;
+    const std::vector<AirConditioner*>& getAirConditioners() const;
+    const std::vector<Light*>& getLights() const;
+    const std::vector<Curtain*>& getCurtains() const;
+
+    size_t size() const;
+    bool empty() const;
+
+private:
+    std::vector<std::shared_ptr<Appliance>> appliances_;
+    std::vector<EVCharger*> evChargers_;
+    std::vector<Heater*> heaters_;
+    std::vector<AirConditioner*> airConditioners_;
+    std::vector<Light*> lights_;
+    std::vector<Curtain*> curtains_;
+};
+
+#endif // APPLIANCE_REGISTRY_H
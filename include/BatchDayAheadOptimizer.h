@@ -0,0 +1,91 @@
+#ifndef BATCH_DAY_AHEAD_OPTIMIZER_H
+#define BATCH_DAY_AHEAD_OPTIMIZER_H
+
+#include "DayAheadOptimizer.h"
+#include "WorkStealingPool.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <map>
+
+// One customer site in a batch
+struct SiteConfig {
+    std::string siteId;
+    std::string priceZone;                              // Sites of a zone share its forecast
+    std::vector<std::shared_ptr<Appliance>> appliances;
+    std::vector<HourlyForecast> forecasts;              // Replaces the zone forecast if not empty
+
+    // Constraints, as on DayAheadOptimizer
+    double targetTemperature = 22.0;
+    int evChargingHoursNeeded = 4;
+    double importLimitKw = 0.0;                         // 0 = none
+    ScheduleBattery battery;
+    double degreesPerKwh = 0.5;
+    double lossPerHour = 0.05;
+};
+
+struct BatchConfig {
+    size_t threads = 0;                                 // 0 = one per hardware thread
+    SlotLength slotLength = SlotLength::ONE_HOUR;
+    MILPScheduleSolverConfig solver;                    // Each worker has its own solver
+    bool keepSchedules = true;                          // false keeps only the per-site totals
+};
+
+struct SiteResult {
+    std::string siteId;
+    bool feasible = false;
+    double estimatedCost = 0.0;
+    double estimatedConsumption = 0.0;                  // kWh
+    double planMs = 0.0;                                // Wall time spent on this site
+    double cpuMs = 0.0;                                 // CPU time of the worker on this site
+    size_t worker = 0;
+    DayAheadSchedule schedule;                          // Empty unless keepSchedules
+};
+
+struct BatchStats {
+    size_t sites = 0;
+    size_t feasibleSites = 0;
+    size_t zoneForecasts = 0;            // Forecasts computed, one per zone in use
+    size_t sharedForecastSites = 0;      // Sites planned on a zone forecast
+    size_t threads = 0;
+    size_t steals = 0;
+    double forecastMs = 0.0;
+    double wallMs = 0.0;                 // Forecasts plus planning
+    double totalSiteMs = 0.0;            // Sum of planMs
+    double maxSiteMs = 0.0;
+    double totalCpuMs = 0.0;             // Sum of cpuMs
+    double sitesPerSecond = 0.0;
+    double parallelEfficiency = 0.0;     // totalCpuMs / (planning wall time * threads)
+};
+
+// Day-ahead planning for many sites at once
+// Each price zone's predictor is queried once per batch and its forecast is
+// shared read-only by every site in the zone. Sites are then planned on a
+// WorkStealingPool: every worker owns a solver and builds a DayAheadOptimizer
+// per site, so sites share nothing mutable and throughput grows with the
+// number of cores. Results come back in the order of the input.
+class BatchDayAheadOptimizer {
+public:
+    explicit BatchDayAheadOptimizer(const BatchConfig& config = BatchConfig());
+
+    void addPriceZone(const std::string& zone, std::shared_ptr<MLPredictor> predictor);
+
+    // Plan every site for the 24 hours from currentHour:currentMinute. A site
+    // whose zone is unknown and that brings no forecasts is reported infeasible.
+    std::vector<SiteResult> optimize(const std::vector<SiteConfig>& sites, int currentHour, int currentDayOfWeek,
+                                     int currentMinute = 0);
+
+    const BatchStats& getLastStats() const;
+    void printStats() const;
+
+private:
+    SiteResult planSite(size_t worker, const SiteConfig& site, const std::vector<HourlyForecast>& forecasts);
+
+    BatchConfig config_;
+    WorkStealingPool pool_;
+    std::vector<std::shared_ptr<ScheduleSolver>> solvers_;     // One per worker
+    std::map<std::string, std::shared_ptr<MLPredictor>> zones_;
+    BatchStats stats_;
+};
+
+#endif // BATCH_DAY_AHEAD_OPTIMIZER_H
@@ -0,0 +1,108 @@
+#ifndef BOUNDED_MPSC_QUEUE_H
+#define BOUNDED_MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Bounded lock-free multi-producer / single-consumer ring buffer
+// Each cell carries a sequence number so producers can claim slots with a
+// single CAS and the consumer never has to take a lock. Capacity is rounded
+// up to the next power of two.
+template <typename T>
+class BoundedMPSCQueue {
+public:
+    explicit BoundedMPSCQueue(size_t capacity)
+        : enqueuePos_(0), dequeuePos_(0) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask_ = size - 1;
+        buffer_.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            buffer_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~BoundedMPSCQueue() {
+        // Destroy anything that was never consumed
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = buffer_[pos & mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+                break;
+            }
+            std::launder(reinterpret_cast<T*>(cell.storage))->~T();
+            cell.sequence.store(pos + mask_ + 1, std::memory_order_relaxed);
+            ++pos;
+        }
+    }
+
+    BoundedMPSCQueue(const BoundedMPSCQueue&) = delete;
+    BoundedMPSCQueue& operator=(const BoundedMPSCQueue&) = delete;
+
+    // Returns false if the queue is full (the value is not enqueued)
+    bool tryPush(const T& value) {
+        Cell* cell;
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &buffer_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        new (cell->storage) T(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Must only be called from the single consumer thread
+    bool tryPop(T& out) {
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        Cell* cell = &buffer_[pos & mask_];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        if (seq != pos + 1) {
+            return false;
+        }
+        T* item = std::launder(reinterpret_cast<T*>(cell->storage));
+        out = std::move(*item);
+        item->~T();
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        dequeuePos_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool empty() const {
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        const Cell& cell = buffer_[pos & mask_];
+        return cell.sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+    size_t capacity() const {
+        return mask_ + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::unique_ptr<Cell[]> buffer_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> enqueuePos_;
+    alignas(64) std::atomic<size_t> dequeuePos_;
+};
+
+#endif // BOUNDED_MPSC_QUEUE_H
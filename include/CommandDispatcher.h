@@ -0,0 +1,148 @@
+#ifndef COMMAND_DISPATCHER_H
+#define COMMAND_DISPATCHER_H
+
+#include <string>
+#include <functional>
+#include <memory>
+#include <map>
+#include <deque>
+#include <array>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+
+// Commands of a higher class are always sent first
+enum class CommandPriority {
+    SAFETY,     // Not debounced, not held back by the rate limit
+    COMFORT,
+    ECONOMY
+};
+
+enum class CommandStatus {
+    SENT,
+    FAILED,       // The transport reported an error
+    SUPERSEDED,   // A newer command for the same device replaced it before it was sent
+    REJECTED      // Unknown transport, dispatcher stopped, or a more important command for the device is queued
+};
+
+struct DeviceCommand {
+    std::string transport;    // Name passed to addTransport ("mqtt", "rest", ...)
+    std::string deviceId;     // Debounce key, usually the HA entity ID
+    std::string command;      // "ON", "OFF" or a service name
+    std::string data;         // Optional JSON payload
+    CommandPriority priority = CommandPriority::ECONOMY;
+};
+
+// Token bucket for one transport
+struct TransportRateLimit {
+    double commandsPerSecond = 10.0;   // 0 = unlimited
+    double burst = 10.0;               // Commands that may go out back to back
+};
+
+struct CommandDispatcherConfig {
+    int debounceMs = 100;           // Non-safety commands wait this long for a superseding command
+    bool verboseLogging = false;    // Log every sent command
+};
+
+struct CommandDispatcherStats {
+    uint64_t submitted = 0;
+    uint64_t sent = 0;
+    uint64_t failed = 0;
+    uint64_t superseded = 0;
+    uint64_t rejected = 0;
+    size_t queued = 0;              // Accepted but not completed yet
+};
+
+// Outbound device command queue
+// Decisions are submitted from any thread and return immediately. Each
+// transport has its own sending thread, a token bucket and one queue per
+// priority class. A device has at most one queued command: a newer one
+// replaces it (the old one completes as SUPERSEDED), so on/off flapping
+// inside the debounce window never reaches Home Assistant. Completion
+// callbacks for SENT and FAILED run on the transport thread, the others on
+// the submitting thread.
+class CommandDispatcher {
+public:
+    // Sends one command; returns false on failure. May block, e.g. on HTTP.
+    using Transport = std::function<bool(const DeviceCommand& command)>;
+    using CompletionCallback = std::function<void(const DeviceCommand& command, CommandStatus status)>;
+
+    explicit CommandDispatcher(const CommandDispatcherConfig& config = CommandDispatcherConfig());
+    ~CommandDispatcher();
+
+    CommandDispatcher(const CommandDispatcher&) = delete;
+    CommandDispatcher& operator=(const CommandDispatcher&) = delete;
+
+    // Register a transport; replacing an existing one is not supported
+    void addTransport(const std::string& name, Transport send,
+                      const TransportRateLimit& limit = TransportRateLimit());
+
+    // Start the transport threads; commands submitted before are kept
+    void start();
+
+    // Send everything still queued, ignoring debounce and rate limits, and
+    // stop the transport threads. Commands queued on a dispatcher that was
+    // never started have no thread to send them and complete as REJECTED.
+    // Later submissions are rejected until the next start().
+    void stop();
+
+    // Queue a command; returns false if it was rejected
+    bool submit(const DeviceCommand& command, CompletionCallback onComplete = nullptr);
+
+    // Block until every accepted command has completed
+    bool waitUntilIdle(std::chrono::milliseconds timeout);
+
+    CommandDispatcherStats getStats() const;
+
+private:
+    struct PendingCommand {
+        DeviceCommand command;
+        CompletionCallback onComplete;
+        std::chrono::steady_clock::time_point readyAt;
+        bool cancelled = false;     // Superseded; skipped when it reaches the queue head
+    };
+
+    struct TransportQueue {
+        std::string name;
+        Transport send;
+        TransportRateLimit limit;
+
+        // Guarded by mutex
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::array<std::deque<std::shared_ptr<PendingCommand>>, 3> queues;   // By priority
+        std::map<std::string, std::shared_ptr<PendingCommand>> queuedByDevice;
+        bool running = false;
+        bool closed = false;        // Stopped: submit() rejects instead of queueing
+
+        // Transport thread only
+        double tokens = 0.0;
+        std::chrono::steady_clock::time_point lastRefill;
+        std::thread thread;
+    };
+
+    void startTransport(TransportQueue& transport);
+    void transportLoop(TransportQueue& transport);
+    void complete(const std::shared_ptr<PendingCommand>& pending, CommandStatus status);   // SENT, FAILED or REJECTED
+
+    CommandDispatcherConfig config_;
+    bool running_;                          // Guarded by transportsMutex_
+
+    mutable std::mutex transportsMutex_;
+    std::map<std::string, std::unique_ptr<TransportQueue>> transports_;
+
+    mutable std::mutex idleMutex_;
+    std::condition_variable idleCondition_;
+    size_t queued_;                         // Guarded by idleMutex_
+
+    std::atomic<uint64_t> submitted_;
+    std::atomic<uint64_t> sent_;
+    std::atomic<uint64_t> failed_;
+    std::atomic<uint64_t> superseded_;
+    std::atomic<uint64_t> rejected_;
+};
+
+#endif // COMMAND_DISPATCHER_H
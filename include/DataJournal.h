@@ -0,0 +1,111 @@
+#ifndef DATA_JOURNAL_H
+#define DATA_JOURNAL_H
+
+#include "HistoricalDataStore.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+
+// Configuration for the write-ahead journal
+struct JournalConfig {
+    size_t groupCommitSize = 16;       // fsync once this many points are pending...
+    int groupCommitIntervalMs = 1000;  // ...or this long after the first pending point
+    size_t compactionThreshold = 168;  // Fold the journal into the store after this many points
+    size_t maxStoreRecords = 90 * 24;  // Records kept in the store after compaction
+};
+
+// Write-ahead journal in front of a HistoricalDataStore
+//
+// append() only queues the point; a flusher thread writes queued points
+// to the journal file and fsyncs them as one group. Once enough points
+// have been journaled they are appended to the main store (tagged with the
+// last journal sequence number) and the journal is truncated. On open(),
+// entries newer than the store's journal sequence are replayed.
+class DataJournal {
+public:
+    DataJournal(std::shared_ptr<HistoricalDataStore> store,
+                const std::string& path,
+                const JournalConfig& config = JournalConfig());
+    ~DataJournal();
+
+    DataJournal(const DataJournal&) = delete;
+    DataJournal& operator=(const DataJournal&) = delete;
+
+    // Replay entries not yet in the store into recovered, fold them into
+    // the store and start the flusher thread
+    bool open(std::deque<HistoricalDataPoint>& recovered);
+
+    // Queue a point; it is durable after the next group commit
+    void append(const HistoricalDataPoint& point);
+
+    // Write and fsync everything queued, then compact into the store
+    bool sync();
+
+    // Sync, then replace the store's contents with data (e.g. after an import)
+    bool replaceStore(const std::deque<HistoricalDataPoint>& data);
+
+    // Stop the flusher thread after a final sync
+    void close();
+
+    uint64_t getDurableSequence() const;
+    size_t getFsyncCount() const;
+    size_t getCompactionCount() const;
+
+    const std::string& getPath() const;
+
+private:
+#pragma pack(push, 1)
+    struct FileHeader {
+        char magic[8];          // "HDCJRNL1"
+        uint32_t version;
+        uint32_t entrySize;
+    };
+
+    struct Entry {
+        uint64_t sequence;
+        HistoricalDataStore::Record record;
+        uint64_t checksum;      // FNV-1a over sequence and record
+    };
+#pragma pack(pop)
+
+    static_assert(sizeof(FileHeader) == 16, "FileHeader must be 16 bytes");
+    static_assert(sizeof(Entry) == 48, "Entry must be 48 bytes");
+
+    static uint64_t entryChecksum(const Entry& entry);
+
+    void flushLoop();
+    bool flush(bool forceCompaction);   // Requires ioMutex_
+    bool compact();                     // Requires ioMutex_
+    bool resetFile();                   // Requires ioMutex_
+
+    std::shared_ptr<HistoricalDataStore> store_;
+    std::string path_;
+    JournalConfig config_;
+
+    // Pending entries, guarded by mutex_
+    std::mutex mutex_;
+    std::condition_variable flushCondition_;
+    std::vector<Entry> pending_;
+    uint64_t nextSequence_;
+    bool running_;
+
+    // File state, guarded by ioMutex_ (held only by the flusher and sync())
+    std::mutex ioMutex_;
+    int fd_;
+    uint64_t fileSize_;
+    std::vector<HistoricalDataStore::Record> uncompacted_;
+    uint64_t lastJournaledSequence_;
+
+    std::thread flusherThread_;
+    std::atomic<uint64_t> durableSequence_;
+    std::atomic<size_t> fsyncCount_;
+    std::atomic<size_t> compactionCount_;
+};
+
+#endif // DATA_JOURNAL_H
@@ -3,36 +3,25 @@
 
 #include "MLPredictor.h"
 #include "Appliance.h"
-#include "EVCharger.h"
-#include "Heater.h"
-#include "AirConditioner.h"
+#include "ApplianceRegistry.h"
 #include "DeferrableLoadController.h"
+#include "DayAheadSchedule.h"
+#include "ScheduleSolver.h"
+#include "RecedingHorizonPlanner.h"
 #include <memory>
 #include <vector>
 #include <map>
 #include <iostream>
 
-// Scheduled action for a specific hour
-struct ScheduledAction {
-    int hour;
-    std::string applianceId;
-    std::string action;  // "on", "off", "charge", "defer"
-    double value;        // For power levels, temperatures, etc.
-    std::string reason;  // Explanation of the decision
-};
-
-// Day-ahead schedule for all appliances
-struct DayAheadSchedule {
-    std::vector<ScheduledAction> actions;
-    double estimatedCost;      // Estimated total cost for the day
-    double estimatedConsumption; // Estimated total energy consumption (kWh)
-    
-    void addAction(int hour, const std::string& applianceId, const std::string& action, 
-                   double value, const std::string& reason);
-    std::vector<ScheduledAction> getActionsForHour(int hour) const;
-};
-
 // Day-ahead optimizer using ML predictions
+// The ML forecasts become a ScheduleProblem with one slot per settlement
+// interval (an hour by default, or 15 or 5 minutes); the
+// pluggable ScheduleSolver (MILP by default) then minimizes the cost of the
+// whole day under the import limit, the comfort band around the target
+// temperature and the EV energy target. The band is soft: a room the heating
+// cannot hold costs a penalty instead of leaving the day without a plan. Each heater and air conditioner is
+// modelled as its own thermal zone. updateSchedule() re-plans the rest of the
+// day as forecasts and measurements come in (model-predictive control).
 class DayAheadOptimizer {
 public:
     DayAheadOptimizer(std::shared_ptr<MLPredictor> predictor);
@@ -40,27 +29,66 @@ public:
     void addAppliance(std::shared_ptr<Appliance> appliance);
     void setTargetTemperature(double temp);
     void setEVChargingHoursNeeded(int hours);
+    void setImportLimit(double kw);                  // 0 = none
+    void setBattery(const ScheduleBattery& battery);
+    void setThermalModel(double degreesPerKwh, double lossPerHour);
+    // $ per °C·h the room spends outside the band; 0 makes the band hard, so
+    // a day the heating cannot hold gets no device plan at all
+    void setComfortPenalty(double perDegreeHour);
+    void setScheduleSolver(std::shared_ptr<ScheduleSolver> solver);
+    void setSlotLength(SlotLength length);
+    SlotLength getSlotLength() const;
+    void setVerbose(bool verbose);                   // Progress, summary and solver failures
     
     // Set deferrable load controller
     void setDeferrableLoadController(std::shared_ptr<DeferrableLoadController> controller);
 
     // Generate optimal schedule for next 24 hours
-    DayAheadSchedule generateSchedule(int currentHour, int currentDayOfWeek);
+    DayAheadSchedule generateSchedule(int currentHour, int currentDayOfWeek, int currentMinute = 0);
+
+    // Same, from forecasts made elsewhere (e.g. shared by a price zone); they
+    // must use the configured slot length
+    DayAheadSchedule generateSchedule(const std::vector<HourlyForecast>& forecasts);
     void printSchedule(const DayAheadSchedule& schedule);
 
+    // Re-plan the slots left after `elapsedSlots` of the last generated
+    // schedule (hours at the default slot length). `latest` holds fresh
+    // forecasts for the same slots; only the part of the day they or the
+    // measurements change is solved again.
+    DayAheadSchedule updateSchedule(int elapsedSlots, const std::vector<HourlyForecast>& latest,
+                                    const ScheduleMeasurement& measured = ScheduleMeasurement());
+
+    // Solver output behind the last generated or updated schedule
+    const ScheduleSolution& getLastSolution() const;
+    const ReplanStats& getLastReplanStats() const;
+
 private:
-    std::vector<int> findBestEVChargingHours(const std::vector<HourlyForecast>& forecasts);
-    void optimizeHour(const HourlyForecast& forecast, 
-                     const std::vector<int>& bestEVHours,
-                     DayAheadSchedule& schedule);
+    ScheduleProblem buildProblem(const std::vector<HourlyForecast>& forecasts) const;
+    DayAheadSchedule makeSchedule(const std::vector<HourlyForecast>& forecasts) const;
+    // Actions of one slot of the current plan; returns the energy it uses
+    double addDeviceActions(size_t slot, const HourlyForecast& forecast,
+                            const std::vector<std::vector<double>>& temps,
+                            const std::vector<ApplianceHandle>& devices,
+                            DayAheadSchedule& schedule) const;
+    void addDeferrableActions(size_t slot, const HourlyForecast& forecast,
+                              const std::vector<ApplianceHandle>& loads,
+                              DayAheadSchedule& schedule) const;
 
     std::shared_ptr<MLPredictor> predictor_;
     std::shared_ptr<DeferrableLoadController> deferrableController_;
-    std::vector<std::shared_ptr<Appliance>> appliances_;
+    std::shared_ptr<ScheduleSolver> solver_;
+    RecedingHorizonPlanner planner_;
+    ApplianceRegistry appliances_;
+    ScheduleBattery battery_;
     double targetIndoorTemp_;
     double highCostThreshold_;
-    double lowCostThreshold_;
     int evChargingHoursNeeded_;
+    double importLimitKw_;
+    double degreesPerKwh_;
+    double lossPerHour_;
+    double comfortPenalty_;
+    SlotLength slotLength_;
+    bool verbose_;
 };
 
 #endif // DAY_AHEAD_OPTIMIZER_H
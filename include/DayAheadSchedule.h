@@ -0,0 +1,112 @@
+#ifndef DAY_AHEAD_SCHEDULE_H
+#define DAY_AHEAD_SCHEDULE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+enum class ActionType : uint8_t {
+    ON,
+    OFF,
+    CHARGE,
+    DISCHARGE,
+    DEFER
+};
+
+const char* toString(ActionType type);
+
+// Why an action was scheduled; the text is only built by formatReason()
+enum class ActionReason : uint8_t {
+    PLANNED_CHARGE,        // price, detail = solar kW
+    CHARGE_DEFERRED,
+    HEATING,               // price, detail = indoor °C
+    COOLING,               // price, detail = indoor °C
+    NO_HEATING_NEEDED,
+    NO_COOLING_NEEDED,
+    BATTERY_CHARGE,        // price
+    BATTERY_DISCHARGE,     // price
+    DEFERRABLE_OFF,        // price
+    DEFERRABLE_ON          // price
+};
+
+using ApplianceHandle = uint16_t;   // Index into the schedule's appliance IDs
+
+struct ScheduledAction {
+    ApplianceHandle appliance;
+    ActionType type;
+    ActionReason reason;
+    float price;          // $/kWh in the slot
+    float detail;         // Depends on the reason
+    double value;         // Power in kW; 0 when off
+};
+
+// Contiguous actions of one slot; valid until the schedule changes
+class ActionSpan {
+public:
+    ActionSpan() : begin_(nullptr), end_(nullptr) {}
+    ActionSpan(const ScheduledAction* begin, const ScheduledAction* end) : begin_(begin), end_(end) {}
+
+    const ScheduledAction* begin() const { return begin_; }
+    const ScheduledAction* end() const { return end_; }
+    size_t size() const { return static_cast<size_t>(end_ - begin_); }
+    bool empty() const { return begin_ == end_; }
+    const ScheduledAction& operator[](size_t index) const { return begin_[index]; }
+
+private:
+    const ScheduledAction* begin_;
+    const ScheduledAction* end_;
+};
+
+// Day-ahead schedule for all appliances
+// Actions are stored slot by slot in one array with an offset per slot, so
+// the actions of a slot are a span rather than a filtered copy. Appliance IDs
+// are interned once per schedule and reasons kept as codes plus numbers, so
+// adding an action does not allocate once the array is reserved. Actions must
+// be added in slot order. Slots are consecutive, of equal length and span at
+// most one day, so the slot of a clock time is computed rather than looked up.
+class DayAheadSchedule {
+public:
+    DayAheadSchedule();
+
+    // slotCount slots of slotMinutes each, the first starting at startMinute
+    // (minutes after midnight)
+    DayAheadSchedule(int startMinute, int slotMinutes, size_t slotCount, size_t expectedActions = 0);
+
+    ApplianceHandle internAppliance(const std::string& applianceId);
+    const std::string& getApplianceId(ApplianceHandle appliance) const;
+
+    // Returns false if the slot is unknown or lies before the last slot added to
+    bool addAction(size_t slot, ApplianceHandle appliance, ActionType type, double value,
+                   ActionReason reason, double price, double detail = 0.0);
+
+    size_t getSlotCount() const;
+    int getSlotMinutes() const;
+    int getSlotHour(size_t slot) const;
+    int getSlotMinute(size_t slot) const;          // Minute within the hour
+    std::string getSlotLabel(size_t slot) const;    // "8:15"
+    size_t getActionCount() const;
+    ActionSpan getActionsForSlot(size_t slot) const;
+    ActionSpan getActionsAt(int hour, int minute) const;   // Slot holding hour:minute
+    ActionSpan getActionsForHour(int hour) const;          // Slot holding hour:00
+
+    std::string formatReason(const ScheduledAction& action) const;
+
+    void setEstimates(double cost, double consumptionKwh);
+    double getEstimatedCost() const;            // Estimated total cost for the day
+    double getEstimatedConsumption() const;     // Estimated total energy consumption (kWh)
+
+private:
+    std::vector<ScheduledAction> actions_;
+    std::vector<size_t> offsets_;           // First action of each slot up to lastSlot_
+    size_t lastSlot_;                       // Slot actions are being added to
+    size_t slotCount_;
+    int startMinute_;
+    int slotMinutes_;
+    std::vector<std::string> applianceIds_;
+    std::map<std::string, ApplianceHandle> applianceHandles_;
+    double estimatedCost_;
+    double estimatedConsumption_;
+};
+
+#endif // DAY_AHEAD_SCHEDULE_H
@@ -4,6 +4,7 @@
 #include "Appliance.h"
 #include "HistoricalDataGenerator.h"
 #include "MLPredictor.h"
+#include "CommandDispatcher.h"
 #include <memory>
 #include <vector>
 #include <map>
@@ -24,6 +25,16 @@ struct BusyHourAnalysis {
     double averageOffPeakPrice;          // Average price during optimal hours
 };
 
+// Day-ahead recommendations, one entry per slot of the day
+struct DayAheadRecommendations {
+    SlotLength slotLength = SlotLength::ONE_HOUR;
+    std::vector<std::vector<std::string>> bySlot;   // [slot of day]; empty if none
+
+    // Recommendations for the slot holding hour:minute
+    const std::vector<std::string>& at(int hour, int minute = 0) const;
+    size_t getSlotCount() const;                    // Slots with recommendations
+};
+
 // Controller for managing deferrable loads based on price and historical data
 class DeferrableLoadController {
 public:
@@ -32,19 +43,26 @@ public:
     // Configure thresholds
     void setPriceThreshold(double threshold);
     void setBusyHourThreshold(double threshold);
+    void setSlotLength(SlotLength length);
     
     // Add appliances to manage
     void addDeferrableLoad(std::shared_ptr<Appliance> appliance);
     
+    // Also send switch decisions to Home Assistant as ECONOMY commands
+    // The entity ID is entityPrefix + appliance ID. Without a dispatcher only
+    // the local appliances are switched.
+    void setCommandDispatcher(std::shared_ptr<CommandDispatcher> dispatcher, const std::string& transport,
+                              const std::string& entityPrefix = "switch.");
+    
     // Analyze historical data to identify busy hours
     BusyHourAnalysis analyzeBusyHours(const std::vector<HistoricalDataPoint>& historicalData);
     
     // Control deferrable loads based on current price
     void controlLoadsByPrice(double currentPrice);
     
-    // Get recommendations for next 24 hours
-    std::map<int, std::vector<std::string>> getDayAheadRecommendations(
-        int currentHour, int currentDayOfWeek);
+    // Get recommendations for the slots of the next 24 hours
+    DayAheadRecommendations getDayAheadRecommendations(
+        int currentHour, int currentDayOfWeek, int currentMinute = 0);
     
     // Switch off all deferrable loads (emergency/high price)
     void switchOffAllDeferrableLoads(const std::string& reason);
@@ -59,12 +77,17 @@ private:
     std::vector<std::shared_ptr<Appliance>> deferrableLoads_;
     std::map<std::string, bool> previousStates_;  // Track previous states for resume
     
+    std::shared_ptr<CommandDispatcher> commandDispatcher_;
+    std::string commandTransport_;
+    std::string entityPrefix_;
+    
     double priceThreshold_;        // Price threshold for switching off loads ($/kWh)
     double busyHourThreshold_;     // Threshold for identifying busy hours
+    SlotLength slotLength_;
     
     // Helper functions
     bool isHighPriceHour(double price) const;
-    std::vector<int> identifyBusyHours(const std::vector<HourlyForecast>& forecasts);
+    void sendCommand(const Appliance& appliance, const std::string& command);
 };
 
 #endif // DEFERRABLE_LOAD_CONTROLLER_H
@@ -4,14 +4,12 @@
 #include "EventManager.h"
 #include "HTTPClient.h"
 #include "Appliance.h"
-#include "Heater.h"
-#include "AirConditioner.h"
-#include "Light.h"
-#include "Curtain.h"
-#include "EVCharger.h"
+#include "ApplianceRegistry.h"
 #include <memory>
 #include <vector>
 #include <iostream>
+#include <mutex>
+#include <atomic>
 
 class EnergyOptimizer {
 public:
@@ -22,6 +20,13 @@ public:
     void updateEnergyCost();
     void optimizeEnergyUsage();
 
+    // Sensor events only record the new readings. Call this once per control
+    // tick: it runs a single optimization pass if any reading changed since
+    // the last call, however many events arrived, and returns whether it ran.
+    bool processPendingUpdates();
+
+    size_t getOptimizationRunCount() const;
+
 private:
     void subscribeToEvents();
     void optimizeEVCharging();
@@ -30,7 +35,7 @@ private:
     void optimizeCurtains();
 
     std::shared_ptr<HTTPClient> httpClient_;
-    std::vector<std::shared_ptr<Appliance>> appliances_;
+    ApplianceRegistry appliances_;
     
     double currentEnergyCost_;
     double indoorTemp_;
@@ -40,6 +45,10 @@ private:
     double targetIndoorTemp_;
     double highCostThreshold_;
     double lowCostThreshold_;
+
+    std::mutex stateMutex_;              // Readings may arrive on the async dispatcher thread
+    std::atomic<bool> pendingUpdates_;
+    std::atomic<size_t> optimizationRuns_;
 };
 
 #endif // ENERGY_OPTIMIZER_H
@@ -3,7 +3,8 @@
 
 #include <string>
 #include <memory>
-#include <map>
+#include <array>
+#include <cstdint>
 
 enum class EventType {
     TEMPERATURE_CHANGE,
@@ -14,17 +15,61 @@ enum class EventType {
     APPLIANCE_CONTROL
 };
 
+// Interned event payload keys
+// Built-in keys are resolved at compile time. Any other string passed to the
+// string-keyed compatibility API is interned once at runtime and gets an ID
+// above BUILTIN_COUNT.
+enum class EventKey : uint16_t {
+    TEMPERATURE,
+    LOCATION,
+    PRODUCTION_KW,
+    CONSUMPTION_KW,
+    IS_CHARGING,
+    CHARGE_POWER_KW,
+    COST_PER_KWH,
+    BUILTIN_COUNT
+};
+
+// Name of a key ("temperature", "location", ...)
+std::string eventKeyName(EventKey key);
+
+// Look up a key by name without interning it; returns false if unknown
+bool findEventKey(const std::string& name, EventKey& key);
+
+// Look up a key by name, interning it if it has not been seen before
+EventKey internEventKey(const std::string& name);
+
 class Event {
 public:
+    static constexpr size_t MAX_DATA_ENTRIES = 8;
+
+    struct DataEntry {
+        EventKey key;
+        double value;
+    };
+
     EventType type;
     std::string source;
-    std::map<std::string, double> data;
     long timestamp;
 
     Event(EventType t, const std::string& src);
-    
-    void addData(const std::string& key, double value);
+
+    // Store a value inline (no allocation). Returns false if the key is new
+    // and all MAX_DATA_ENTRIES slots are already in use.
+    bool addData(EventKey key, double value);
+    double getData(EventKey key, double defaultValue = 0.0) const;
+    bool hasData(EventKey key) const;
+
+    // String-keyed compatibility API
+    bool addData(const std::string& key, double value);
     double getData(const std::string& key, double defaultValue = 0.0) const;
+
+    size_t getDataCount() const;
+    const DataEntry& getDataEntry(size_t index) const;
+
+private:
+    std::array<DataEntry, MAX_DATA_ENTRIES> data_;
+    uint8_t dataCount_;
 };
 
 #endif // EVENT_H
@@ -2,27 +2,116 @@
 #define EVENT_MANAGER_H
 
 #include "Event.h"
+#include "BoundedMPSCQueue.h"
 #include <functional>
 #include <vector>
 #include <map>
+#include <string>
+#include <chrono>
+#include <memory>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+// Delivery mode for published events
+enum class DispatchMode {
+    SYNCHRONOUS,   // Handlers run on the publishing thread (default)
+    ASYNCHRONOUS   // Events are queued and delivered by a dispatcher thread
+};
 
 class EventManager {
 public:
     using EventHandler = std::function<void(const Event&)>;
+    using BatchHandler = std::function<void(const std::vector<Event>&)>;
 
     static EventManager& getInstance();
 
     void subscribe(EventType type, EventHandler handler);
     void publish(const Event& event);
 
+    // Receive coalesced batches instead of single events
+    // Each batch holds only the newest event per (type, source) among the
+    // requested types, ordered by when each was last published, so the most
+    // recent event comes last. In synchronous mode every event is a batch of
+    // one.
+    void subscribeBatch(const std::vector<EventType>& types, BatchHandler handler);
+
+    // How long the async dispatcher keeps gathering events after the first one
+    // before delivering batches (0 = deliver as soon as the queue is drained)
+    void setCoalescingWindow(std::chrono::milliseconds window);
+
+    // Switch to asynchronous delivery: publish() only pushes into a bounded
+    // lock-free ring and returns, a dispatcher thread runs the handlers
+    void startAsyncDispatch(size_t queueCapacity = 4096);
+
+    // Deliver everything still queued, stop the dispatcher thread and
+    // return to synchronous delivery. Every event a racing publish() got into
+    // the ring is delivered; events published once the ring is closed are
+    // delivered synchronously and may overtake queued ones.
+    // Must be called from outside the handlers: the dispatcher thread cannot
+    // join itself, so a call from a handler it runs is ignored and returns
+    // false.
+    bool stopAsyncDispatch();
+
+    DispatchMode getDispatchMode() const;
+
+    // Events rejected because the async queue was full
+    size_t getDroppedEventCount() const;
+
 private:
-    EventManager() = default;
+    struct BatchSubscription {
+        uint32_t typeMask;   // Bit per EventType
+        BatchHandler handler;
+    };
+
+    struct HandlerTable {
+        std::map<EventType, std::vector<EventHandler>> handlers;
+        std::vector<BatchSubscription> batchHandlers;
+        uint32_t batchTypeMask = 0;   // Union of all batch subscriptions
+    };
+
+    // Newest pending event per (type, source). A replaced entry keeps its
+    // slot; lastSeen orders the batch by the newest publish of each entry.
+    struct CoalescingBuffer {
+        std::vector<Event> events;
+        std::vector<uint64_t> lastSeen;
+        std::map<std::pair<EventType, std::string>, size_t> index;
+        uint64_t sequence = 0;
+    };
+
+    static uint32_t typeBit(EventType type);
+
+    EventManager();
+    ~EventManager();
     EventManager(const EventManager&) = delete;
     EventManager& operator=(const EventManager&) = delete;
 
-    std::map<EventType, std::vector<EventHandler>> handlers_;
-    std::mutex mutex_;
+    void dispatch(const Event& event);
+    void dispatchLoop();
+    bool drainQueue(BoundedMPSCQueue<Event>& queue, CoalescingBuffer& pending);
+    void flushBatches(CoalescingBuffer& pending);
+
+    // Copy-on-write handler table: subscribe() swaps in a new table,
+    // readers take a snapshot with std::atomic_load and never lock
+    std::shared_ptr<const HandlerTable> handlers_;
+    std::mutex mutex_;                        // Serializes subscribe() and mode changes
+    std::recursive_mutex syncDispatchMutex_;  // Serializes synchronous delivery, allows re-publishing
+
+    std::unique_ptr<BoundedMPSCQueue<Event>> queueStorage_;
+    std::atomic<BoundedMPSCQueue<Event>*> asyncQueue_;   // nullptr = not accepting
+    std::atomic<size_t> activePublishers_;                // Inside publish() right now
+    std::atomic<size_t> droppedEvents_;
+    std::atomic<long long> coalescingWindowMs_;
+    std::thread dispatcherThread_;
+    std::atomic<std::thread::id> dispatcherThreadId_;     // Set by the dispatcher itself
+    std::atomic<bool> dispatcherRunning_;
+
+    // Dispatcher parking: publishers only touch wakeMutex_ while the
+    // dispatcher is idle
+    std::atomic<bool> dispatcherIdle_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
 };
 
 #endif // EVENT_MANAGER_H
@@ -0,0 +1,174 @@
+#ifndef HA_BRIDGE_H
+#define HA_BRIDGE_H
+
+#include "HAIntegration.h"
+#include "Event.h"
+#include "BoundedMPSCQueue.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+
+struct HABridgeConfig {
+    std::string nodeId = "home_automation";   // Discovery node ID and unique_id prefix
+    std::vector<EventType> eventTypes = {     // Sensor events mirrored to HA
+        EventType::TEMPERATURE_CHANGE,
+        EventType::ENERGY_CONSUMPTION_UPDATE,
+        EventType::SOLAR_PRODUCTION_UPDATE,
+        EventType::EV_CHARGER_STATUS
+    };
+    size_t queueCapacity = 4096;          // Events buffered between flushes before overflowing
+    int flushIntervalMs = 200;            // How often the publish thread drains the queue
+    size_t maxBatchSize = 64;             // States sent per flush at most
+    double maxPublishesPerSecond = 50.0;  // Token-bucket rate for state messages (0 = unlimited)
+    bool verboseLogging = false;          // Log discovery and every flush
+};
+
+struct HABridgeStats {
+    uint64_t eventsReceived = 0;
+    uint64_t eventsOverflowed = 0;        // Queue was full; only the newest per sensor is kept
+    uint64_t statesCoalesced = 0;         // Overwritten by a newer value before being sent
+    uint64_t statesPublished = 0;
+    uint64_t statesSuppressed = 0;        // Unchanged or within the deadband
+    uint64_t statesFailed = 0;            // MQTT down or dropped; retried on the next flush
+    uint64_t discoveryPublished = 0;      // Sent by the bridge (HAIntegration repeats them on reconnect)
+    uint64_t batches = 0;                 // Flushes that sent at least one state
+    size_t entities = 0;
+    size_t pending = 0;                   // Waiting for rate-limit tokens
+};
+
+// How one event value maps onto a Home Assistant entity
+struct HABridgeChannel {
+    std::string component;    // "sensor", "binary_sensor"; empty = not published
+    std::string suffix;       // Appended to the source ID to form the object ID
+    std::string label;        // Appended to the friendly name
+    std::string unit;
+    std::string deviceClass;
+    double deadband = 0.0;
+};
+
+// Mirrors local sensor events into Home Assistant
+// Subscribes to the EventManager for every sensor event type, so any Sensor
+// subclass is picked up on its first update() without further code. Each
+// (source, value) pair becomes one HA entity whose discovery config is
+// generated once and handed to HAIntegration, which keeps it retained and
+// republishes it after reconnects. The event handler only pushes into a
+// lock-free queue (or, when that is full, replaces the sensor's entry in an
+// overflow map); a publish thread drains both every flushIntervalMs, keeps the
+// newest value per entity and sends them through HAIntegration's delta cache
+// under a token-bucket rate limit, so sensor threads never wait on MQTT.
+// States that cannot be sent stay queued (coalescing with newer values) and
+// are retried on the next flush.
+class HABridge {
+public:
+    HABridge(std::shared_ptr<HAIntegration> integration, const HABridgeConfig& config = HABridgeConfig());
+    ~HABridge();
+
+    HABridge(const HABridge&) = delete;
+    HABridge& operator=(const HABridge&) = delete;
+
+    // Subscribe (first call only) and start the publish thread
+    void start();
+
+    // Send everything still queued, ignoring the rate limit, and stop the
+    // thread. Events published afterwards are ignored.
+    void stop();
+
+    // Map an event key (e.g. one interned by a new sensor type) to an entity
+    // Built-in keys have defaults; unknown keys become unitless sensors.
+    void setChannel(EventKey key, const HABridgeChannel& channel);
+
+    // Publish a (source, key) pair as <component>.<objectId> instead of the
+    // generated <source>_<suffix>, e.g. to keep entity IDs Home Assistant
+    // already knows. Call before the sensor's first event.
+    void setObjectId(const std::string& sourceId, EventKey key, const std::string& objectId);
+
+    // Entity ID a (source, key) pair is published under
+    std::string getEntityId(const std::string& sourceId, EventKey key) const;
+
+    HABridgeStats getStats() const;
+
+private:
+    // Event stamped in arrival order, so overflowed events cannot overwrite newer ones
+    struct StampedEvent {
+        StampedEvent() : sequence(0), event(EventType::TEMPERATURE_CHANGE, "") {}
+        StampedEvent(uint64_t seq, const Event& e) : sequence(seq), event(e) {}
+
+        uint64_t sequence;
+        Event event;
+    };
+
+    // Shared with the EventManager handlers, which may outlive the bridge
+    struct Inbox {
+        explicit Inbox(size_t capacity) : queue(capacity), open(false), sequence(0), received(0), overflowed(0) {}
+
+        BoundedMPSCQueue<StampedEvent> queue;
+        std::mutex overflowMutex;
+        std::map<std::pair<EventType, std::string>, StampedEvent> overflow;
+        std::atomic<bool> open;
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> received;
+        std::atomic<uint64_t> overflowed;
+    };
+
+    // One published entity; publish thread only
+    struct Entity {
+        HAIntegration::EntityHandle handle = nullptr;
+        bool binary = false;
+        bool pending = false;
+        double value = 0.0;
+        uint64_t sequence = 0;         // Of the event the value came from
+    };
+
+    void publishLoop();
+    void drainInbox();
+    void addEvent(const StampedEvent& stamped);
+    void addValue(const std::string& sourceId, EventKey key, double value, uint64_t sequence);
+    Entity& createEntity(const std::string& sourceId, EventKey key, const HABridgeChannel& channel);
+    size_t flushPending(bool ignoreRateLimit);
+    HABridgeChannel channelFor(EventKey key) const;
+    std::string objectIdFor(const std::string& sourceId, EventKey key, const HABridgeChannel& channel) const;
+
+    static std::string toObjectId(const std::string& text);
+    static std::string toFriendlyName(const std::string& sourceId);
+
+    std::shared_ptr<HAIntegration> integration_;
+    HABridgeConfig config_;
+    std::shared_ptr<Inbox> inbox_;
+    bool subscribed_;
+
+    mutable std::mutex channelsMutex_;
+    std::map<EventKey, HABridgeChannel> channels_;
+    std::map<std::pair<std::string, EventKey>, std::string> objectIds_;
+
+    std::thread publishThread_;
+    std::atomic<bool> running_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
+
+    // Publish thread only
+    std::map<std::pair<std::string, EventKey>, Entity> entities_;
+    std::deque<Entity*> pendingOrder_;    // First-seen order of unsent values
+    double tokens_;
+    std::chrono::steady_clock::time_point lastRefill_;
+    std::string stateBuffer_;
+    bool publishFailing_;                 // Last flush stopped on a failed send
+
+    std::atomic<uint64_t> statesCoalesced_;
+    std::atomic<uint64_t> statesPublished_;
+    std::atomic<uint64_t> statesSuppressed_;
+    std::atomic<uint64_t> statesFailed_;
+    std::atomic<uint64_t> discoveryPublished_;
+    std::atomic<uint64_t> batches_;
+    std::atomic<size_t> entityCount_;
+    std::atomic<size_t> pendingCount_;
+};
+
+#endif // HA_BRIDGE_H
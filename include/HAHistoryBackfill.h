@@ -0,0 +1,78 @@
+#ifndef HA_HISTORY_BACKFILL_H
+#define HA_HISTORY_BACKFILL_H
+
+#include "HARestClient.h"
+#include "HistoricalDataset.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+class HistoricalDataCollector;
+
+// Which Home Assistant entities feed each HistoricalDataPoint column, and
+// how the history is fetched
+struct HistoryBackfillConfig {
+    std::string outdoorTempEntity;        // Empty = column left at 0
+    std::string solarProductionEntity;
+    std::string energyCostEntity;
+    int windowHours = 24;                 // Time range covered by one request
+    size_t maxParallelRequests = 4;       // Windows fetched concurrently
+    int maxRetries = 3;                   // Extra attempts per window
+    int retryDelayMs = 500;               // Doubles after every failed attempt
+    long requestTimeoutSeconds = 60;      // Per window (large windows take longer than normal polls)
+    bool minimalResponse = true;          // Ask HA for state/last_changed only
+    bool noAttributes = true;
+    bool verboseLogging = false;
+};
+
+struct HistoryBackfillStats {
+    size_t windows = 0;
+    size_t failedWindows = 0;             // Gave up after all retries
+    size_t retries = 0;
+    size_t entries = 0;                   // History entries received
+    size_t hoursProduced = 0;             // Points with every configured column covered
+    double elapsedMs = 0.0;
+};
+
+// Seeds training data from Home Assistant's recorder
+// The requested range is split into windowHours-long windows that are
+// fetched in parallel on a few worker threads, each window retried with
+// exponential backoff. Responses are streamed and resampled on the fly:
+// HA history is a step function, so every hour gets the time-weighted mean
+// of each entity's numeric state, and nothing but the hourly accumulators
+// is kept in memory.
+class HAHistoryBackfill {
+public:
+    HAHistoryBackfill(std::shared_ptr<HARestClient> client,
+                      const HistoryBackfillConfig& config = HistoryBackfillConfig());
+
+    // Hourly points for [startTimestamp, endTimestamp), oldest first
+    // Hours in which a configured entity has no numeric state are skipped.
+    std::vector<HistoricalDataPoint> run(long startTimestamp, long endTimestamp);
+
+    // run() and add the points to the collector; returns the number added
+    size_t backfill(HistoricalDataCollector& collector, long startTimestamp, long endTimestamp);
+
+    HistoryBackfillStats getStats() const { return stats_; }
+
+private:
+    static constexpr int COLUMNS = 3;   // outdoorTemp, solarProduction, energyCost
+
+    // Time-weighted sums for one window, committed only when it succeeds
+    struct WindowAccumulator {
+        std::vector<double> weightedSum;   // [column * hours + hour]
+        std::vector<double> coveredSeconds;
+    };
+
+    bool fetchWindow(long windowStart, long windowEnd, WindowAccumulator& accumulator, size_t& entries);
+    int columnFor(const std::string& entityId) const;
+
+    std::shared_ptr<HARestClient> client_;
+    HistoryBackfillConfig config_;
+    std::string entities_[COLUMNS];
+    HistoryBackfillStats stats_;
+};
+
+#endif // HA_HISTORY_BACKFILL_H
@@ -6,40 +6,99 @@
 #include <functional>
 #include <memory>
 #include <map>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+class HAEntity;
+
+// Delta publishing policy for publishState
+struct HAPublishConfig {
+    bool suppressUnchanged = true;      // Skip states equal to the last published one
+    double deadband = 0.0;              // Numeric states: skip changes smaller than this
+    int heartbeatSeconds = 300;         // Republish state and attributes at least this often (0 = never)
+    bool verboseLogging = true;         // Log every published and received state
+};
+
+struct HAPublishStats {
+    uint64_t published = 0;             // State messages sent, heartbeats included
+    uint64_t suppressed = 0;            // Unchanged or within the deadband
+    uint64_t failed = 0;                // MQTT down or the message was dropped
+    uint64_t discoveryPublished = 0;    // Discovery configs sent, republishes included
+    uint64_t heartbeats = 0;
+    uint64_t attributesPublished = 0;   // Messages that carried attributes
+};
+
+// Outcome of one state publish
+enum class HAPublishResult {
+    SENT,
+    SUPPRESSED,                         // Unchanged or within the deadband
+    FAILED                              // MQTT down or the message was dropped
+};
 
 // Home Assistant MQTT Integration
 // Handles communication with Home Assistant via MQTT for:
 // - Fetching sensor data from HA
 // - Executing commands to control HA devices
 // - Supporting HA's MQTT discovery protocol
+// State publishing goes through a per-entity cache of the last published
+// value: unchanged or within-deadband updates are suppressed, attributes are
+// only sent when they change, and a heartbeat republishes everything now and
+// then so late subscribers and liveness checks still see the entity.
+// Entities are registered once (registerEntity) and addressed through the
+// returned handle, which caches topic strings and resolved callbacks; the
+// entity-ID overloads look the handle up first.
+// Discovery configs are retained on the broker and remembered here, and
+// every (re)connect republishes them, so entities survive Home Assistant and
+// broker restarts.
 class HAIntegration {
 public:
     // Callback types for handling HA data
     using StateCallback = std::function<void(const std::string& entityId, const std::string& state, const std::string& attributes)>;
     using DiscoveryCallback = std::function<void(const std::string& entityId, const std::string& config)>;
+    
+    // Valid for the lifetime of the HAIntegration
+    using EntityHandle = HAEntity*;
 
-    HAIntegration(std::shared_ptr<MQTTClient> mqttClient, const std::string& haDiscoveryPrefix = "homeassistant");
+    HAIntegration(std::shared_ptr<MQTTClient> mqttClient, const std::string& haDiscoveryPrefix = "homeassistant",
+                  const HAPublishConfig& publishConfig = HAPublishConfig());
+    ~HAIntegration();
+    
+    HAIntegration(const HAIntegration&) = delete;
+    HAIntegration& operator=(const HAIntegration&) = delete;
+    
+    // Register an entity (or return its existing handle); thread-safe
+    EntityHandle registerEntity(const std::string& entityId);
     
     // Subscribe to HA entity state updates
     // entityId: HA entity ID (e.g., "sensor.temperature_living_room")
     // callback: Called when state changes
     void subscribeToEntity(const std::string& entityId, StateCallback callback);
+    void subscribeToEntity(EntityHandle entity, StateCallback callback);
     
     // Subscribe to all entities of a specific domain
     // domain: HA domain (e.g., "sensor", "switch", "light")
     // callback: Called when any entity in domain changes
+    // All domains share one subscription to <prefix>/state/+ and are told
+    // apart by the entity ID. Entity and domain callbacks run once each per
+    // message, also when both are registered for the same entity.
     void subscribeToDomain(const std::string& domain, StateCallback callback);
     
     // Publish command to control HA device
     // entityId: HA entity ID (e.g., "switch.heater")
     // command: Command to send (e.g., "ON", "OFF")
-    void publishCommand(const std::string& entityId, const std::string& command);
+    // Returns false if MQTT is down or the message was dropped
+    bool publishCommand(const std::string& entityId, const std::string& command);
+    bool publishCommand(EntityHandle entity, const std::string& command);
     
     // Publish command with additional data (for lights, climate, etc.)
     // entityId: HA entity ID
     // command: Command to send
     // data: Additional data in JSON format (e.g., brightness, temperature)
-    void publishCommandWithData(const std::string& entityId, const std::string& command, const std::string& data);
+    bool publishCommandWithData(const std::string& entityId, const std::string& command, const std::string& data);
     
     // Request current state of an entity
     // entityId: HA entity ID
@@ -50,14 +109,39 @@ public:
     
     // Publish a discovery message for this system's entities
     // Used to make this system's sensors/controls visible in HA
-    void publishDiscovery(const std::string& component, const std::string& nodeId, 
-                         const std::string& objectId, const std::string& config);
+    // Sent retained with QoS 1 and republished after every reconnect. Returns
+    // false if it could not be sent now; it then goes out on the next connect.
+    bool publishDiscovery(const std::string& component, const std::string& nodeId, 
+                          const std::string& objectId, const std::string& config);
     
     // Publish sensor state to MQTT (for publishing LOCAL sensor states TO HA)
     // entityId: HA entity ID for this sensor (e.g., "sensor.local_temperature")
     // state: State value to publish (e.g., "22.5")
     // attributes: Optional JSON attributes (e.g., {"unit": "°C", "friendly_name": "Living Room"})
-    void publishState(const std::string& entityId, const std::string& state, const std::string& attributes = "");
+    // Returns true if a message was sent, false if it was suppressed or MQTT is down.
+    // Unchanged attributes are left out, so the payload is then the plain state.
+    bool publishState(const std::string& entityId, const std::string& state, const std::string& attributes = "");
+    bool publishState(EntityHandle entity, const std::string& state, const std::string& attributes = "");
+    
+    // publishState without logging, telling suppressed states from failed
+    // sends so callers can retry the latter
+    HAPublishResult tryPublishState(EntityHandle entity, const std::string& state,
+                                    const std::string& attributes = "");
+    
+    // Per-entity deadband overriding HAPublishConfig::deadband
+    void setDeadband(const std::string& entityId, double deadband);
+    void setDeadband(EntityHandle entity, double deadband);
+    
+    // Republish every entity whose last message is older than the heartbeat
+    // interval; call periodically when sensors may stop reporting. Returns the
+    // number of heartbeats sent.
+    size_t publishHeartbeats();
+    
+    // Forget what was published, e.g. after the broker lost its state
+    // Done automatically on every reconnect.
+    void resetPublishCache();
+    
+    HAPublishStats getPublishStats() const;
     
     // Helper to parse HA state message (JSON format)
     // Returns: state value and attributes as separate strings
@@ -68,14 +152,44 @@ public:
     
     // Helper to escape JSON strings (prevents injection attacks)
     static std::string escapeJsonString(const std::string& input);
+    static void appendJsonEscaped(std::string& out, const std::string& input);
 
 private:
     std::shared_ptr<MQTTClient> mqttClient_;
     std::string haDiscoveryPrefix_;
-    std::map<std::string, StateCallback> entityCallbacks_;
-    std::map<std::string, StateCallback> domainCallbacks_;
+    std::string statePrefix_;           // "<prefix>/state/", built once
     DiscoveryCallback discoveryCallback_;
     
+    // Registered entities; std::less<> allows lookups by string_view
+    mutable std::mutex entitiesMutex_;
+    std::map<std::string, std::unique_ptr<HAEntity>, std::less<>> entities_;
+    std::map<std::string, const StateCallback*, std::less<>> domainCallbacks_;
+    std::deque<StateCallback> callbackStore_;   // Only grows, so handles can point into it
+    bool stateWildcardSubscribed_ = false;      // <prefix>/state/+ for the domain callbacks
+    
+    HAPublishConfig publishConfig_;
+    mutable std::mutex publishMutex_;   // Guards every entity's published state
+    std::atomic<uint64_t> published_;
+    std::atomic<uint64_t> suppressed_;
+    std::atomic<uint64_t> heartbeats_;
+    std::atomic<uint64_t> attributesPublished_;
+    std::atomic<uint64_t> failed_;
+    
+    // Every discovery config published, by topic, for republishing on reconnect
+    std::mutex discoveryMutex_;
+    std::map<std::string, std::string> discoveryConfigs_;
+    std::atomic<uint64_t> discoveryPublished_;
+    size_t connectionCallbackId_;
+    
+    // MQTT (re)connected: republish discovery and forget published states
+    void onConnected(bool reconnected);
+    
+    // Send state (with attributes when non-empty) and record it as published
+    bool sendState(HAEntity& entity, const std::string& state, const std::string& attributes);
+    
+    // Parse an incoming state payload and run callback (if set) with it
+    void dispatchState(const HAEntity& entity, const StateCallback* callback, const std::string& payload);
+    
     // Generate HA MQTT topic for entity state
     std::string getStateTopic(const std::string& entityId) const;
     
@@ -89,11 +203,48 @@ private:
     // Extract domain from entity ID (e.g., "sensor" from "sensor.temperature")
     static std::string extractDomain(const std::string& entityId);
     
-    // Handle incoming state message from HA
+    // Handle incoming state message from HA on the domain wildcard subscription
     void handleStateMessage(const std::string& topic, const std::string& payload);
     
     // Handle incoming discovery message from HA
     void handleDiscoveryMessage(const std::string& topic, const std::string& payload);
 };
 
+// One registered Home Assistant entity
+// Holds the topic strings, callbacks and delta-publishing state of the
+// entity so that publishing and dispatching need no string building or
+// map lookups. Created by HAIntegration::registerEntity.
+class HAEntity {
+public:
+    const std::string& getEntityId() const { return entityId_; }
+    const std::string& getDomain() const { return domain_; }
+    const std::string& getStateTopic() const { return stateTopic_; }
+    const std::string& getCommandTopic() const { return commandTopic_; }
+
+private:
+    friend class HAIntegration;
+
+    HAEntity(const std::string& entityId, const std::string& domain, const std::string& stateTopic,
+             const std::string& commandTopic)
+        : entityId_(entityId), domain_(domain), stateTopic_(stateTopic), commandTopic_(commandTopic),
+          callback_(nullptr), domainCallback_(nullptr) {}
+
+    std::string entityId_;
+    std::string domain_;
+    std::string stateTopic_;
+    std::string commandTopic_;
+
+    // Set from the registering thread, read on the MQTT thread
+    std::atomic<const HAIntegration::StateCallback*> callback_;
+    std::atomic<const HAIntegration::StateCallback*> domainCallback_;
+
+    // Last published state, guarded by HAIntegration::publishMutex_
+    std::string publishedState_;
+    double publishedValue_ = 0.0;       // Numeric value of publishedState_, if numeric
+    bool publishedNumeric_ = false;
+    std::string publishedAttributes_;
+    std::chrono::steady_clock::time_point lastSent_;
+    double deadband_ = -1.0;            // < 0 = HAPublishConfig::deadband
+};
+
 #endif // HA_INTEGRATION_H
@@ -0,0 +1,215 @@
+#ifndef HA_JSON_PARSER_H
+#define HA_JSON_PARSER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+struct HASensorData;
+struct HAHistoricalData;
+
+// Pull-style JSON tokenizer over a std::string_view
+// Each next() call returns one token; strings, keys and numbers are
+// returned as views into the input, so tokenizing never copies or
+// allocates. String views are still escaped; use HAJsonParser::unescape
+// (or appendString) when the text is needed.
+class JsonTokenizer {
+public:
+    enum class Token {
+        BEGIN_OBJECT,
+        END_OBJECT,
+        BEGIN_ARRAY,
+        END_ARRAY,
+        KEY,        // Object member name, value() holds it
+        STRING,
+        NUMBER,
+        TRUE_VALUE,
+        FALSE_VALUE,
+        NULL_VALUE,
+        END,        // Input exhausted
+        ERROR       // Malformed input, position() points at the problem
+    };
+
+    static constexpr size_t MAX_DEPTH = 64;
+
+    explicit JsonTokenizer(std::string_view json);
+
+    Token next();
+
+    // Skip the value that follows (a whole object or array, or one scalar)
+    // Returns false on malformed input.
+    bool skipValue();
+
+    // Skip the rest of the object or array whose BEGIN token was just returned
+    bool skipContainer();
+
+    // Text of the last KEY/STRING (without quotes) or NUMBER/literal token
+    std::string_view value() const { return value_; }
+
+    // True if the last KEY/STRING contains backslash escapes
+    bool hasEscapes() const { return escaped_; }
+
+    // Offset of the start of the last token, and of the next unread byte
+    size_t tokenStart() const { return tokenStart_; }
+    size_t position() const { return pos_; }
+
+    size_t depth() const { return depth_; }
+
+    std::string_view input() const { return json_; }
+
+private:
+    bool inObject() const;
+    void push(bool object);
+    void finishValue();
+    Token fail();
+
+    std::string_view json_;
+    size_t pos_;
+    size_t tokenStart_;
+    std::string_view value_;
+    bool escaped_;
+    bool expectKey_;
+    bool failed_;
+    size_t depth_;
+    uint64_t objectBits_;   // Bit per nesting level: 1 = object, 0 = array
+};
+
+// Home Assistant REST payloads decoded in a single pass with JsonTokenizer
+// Fields are written straight into the output structs; unknown members and
+// nested attributes are skipped without being materialized.
+class HAJsonParser {
+public:
+    // One state object as returned by /api/states/<entity_id>
+    static bool parseState(std::string_view json, HASensorData& data);
+
+    // The array returned by /api/states; appends to states
+    static bool parseStates(std::string_view json, std::vector<HASensorData>& states);
+
+    // The array of per-entity arrays returned by /api/history/period
+    static bool parseHistory(std::string_view json, std::vector<HAHistoricalData>& history);
+
+    // One entry object of a history response
+    static bool parseHistoryEntry(std::string_view json, HAHistoricalData& entry);
+
+    // entity_id of a state object without decoding anything else
+    // Returns false if the object is malformed or has no entity_id.
+    static bool peekEntityId(std::string_view json, std::string_view& entityId);
+
+    // ISO 8601 timestamp ("2024-01-15T10:30:00.123+00:00" or "...Z") to
+    // Unix seconds; returns 0 if the text is not a timestamp
+    static long parseTimestamp(std::string_view text);
+
+    // Decode a JSON string body (escapes included) and append it to out
+    static bool unescape(std::string_view raw, std::string& out);
+
+private:
+    // Read the object whose BEGIN_OBJECT was just returned by tokenizer
+    static bool readState(JsonTokenizer& tokenizer, HASensorData& data);
+    static bool readHistoryEntry(JsonTokenizer& tokenizer, HAHistoricalData& entry);
+    static bool readString(JsonTokenizer& tokenizer, std::string& out);
+    static bool readTimestamp(JsonTokenizer& tokenizer, long& out);
+};
+
+// Resumable splitter for a stream of JSON objects
+// feed() accepts the input in arbitrary chunks (e.g. straight from the curl
+// write callback) and passes every object found at objectDepth (1 = elements
+// of the top-level array) to the callback as soon as its closing brace
+// arrives. Only an object that straddles two chunks is buffered, so memory
+// stays bounded by the largest single object rather than the response.
+class JsonObjectStream {
+public:
+    // Return false to reject the object (treated as malformed input)
+    using ObjectCallback = std::function<bool(std::string_view object)>;
+
+    JsonObjectStream(size_t objectDepth, ObjectCallback callback);
+
+    // Returns false once the input is malformed; later calls are ignored
+    bool feed(const char* data, size_t length);
+
+    // True if the input ended after a complete top-level array
+    bool finish() const;
+
+    void reset();
+
+    size_t getBytesConsumed() const { return bytesConsumed_; }
+    size_t getPeakBufferSize() const { return peakBufferSize_; }   // Largest object split across chunks
+
+private:
+    bool fail();
+
+    size_t objectDepth_;
+    ObjectCallback callback_;
+    std::string pending_;       // Object started in an earlier chunk
+    size_t depth_;
+    bool inString_;
+    bool escape_;
+    bool capturing_;
+    bool started_;
+    bool done_;
+    bool failed_;
+    size_t bytesConsumed_;
+    size_t peakBufferSize_;
+};
+
+// Streaming parser for /api/history/period responses
+// Emits each entry while the response is still downloading. Entries
+// without an entity_id (minimal_response) inherit the previous one.
+class HAHistoryStreamParser {
+public:
+    using EntryCallback = std::function<void(const HAHistoricalData& entry)>;
+
+    explicit HAHistoryStreamParser(EntryCallback callback);
+    ~HAHistoryStreamParser();
+
+    bool feed(const char* data, size_t length) { return stream_.feed(data, length); }
+    bool finish() const { return stream_.finish(); }
+    void reset();
+
+    size_t getEntryCount() const { return entryCount_; }
+    size_t getBytesConsumed() const { return stream_.getBytesConsumed(); }
+    size_t getPeakBufferSize() const { return stream_.getPeakBufferSize(); }
+
+private:
+    bool emit(std::string_view object);
+
+    EntryCallback callback_;
+    std::unique_ptr<HAHistoricalData> entry_;   // Reused for every entry
+    std::string previousEntityId_;              // Carried forward for minimal_response
+    JsonObjectStream stream_;
+    size_t entryCount_;
+};
+
+// Streaming parser for /api/states responses
+// Entities whose entity_id does not start with entityPrefix are dropped
+// after reading only their entity_id, before any other field is decoded.
+class HAStateStreamParser {
+public:
+    using StateCallback = std::function<void(const HASensorData& state)>;
+
+    explicit HAStateStreamParser(StateCallback callback, const std::string& entityPrefix = "");
+    ~HAStateStreamParser();
+
+    bool feed(const char* data, size_t length) { return stream_.feed(data, length); }
+    bool finish() const { return stream_.finish(); }
+    void reset();
+
+    size_t getEntryCount() const { return entryCount_; }
+    size_t getSkippedCount() const { return skippedCount_; }
+    size_t getBytesConsumed() const { return stream_.getBytesConsumed(); }
+
+private:
+    bool emit(std::string_view object);
+
+    StateCallback callback_;
+    std::string entityPrefix_;
+    std::unique_ptr<HASensorData> state_;       // Reused for every entity
+    JsonObjectStream stream_;
+    size_t entryCount_;
+    size_t skippedCount_;
+};
+
+#endif // HA_JSON_PARSER_H
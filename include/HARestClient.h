@@ -6,6 +6,9 @@
 #include <vector>
 #include <functional>
 #include <map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
 
 // Structure to hold sensor data from Home Assistant
 struct HASensorData {
@@ -14,36 +17,88 @@ struct HASensorData {
     std::string unitOfMeasurement;
     std::string friendlyName;
     std::string deviceClass;
-    long lastChanged;
-    long lastUpdated;
+    long lastChanged = 0;   // Unix seconds
+    long lastUpdated = 0;
 };
 
 // Structure to hold historical data point
 struct HAHistoricalData {
     std::string entityId;
     std::string state;
-    long timestamp;
+    long timestamp = 0;     // Unix seconds (last_changed)
     std::map<std::string, std::string> attributes;
 };
 
+// Options for an /api/history/period request
+struct HAHistoryQuery {
+    std::vector<std::string> entityIds;   // filter_entity_id (empty = all entities)
+    long startTimestamp = 0;              // Unix seconds
+    long endTimestamp = 0;                // 0 = Home Assistant default (one day)
+    bool minimalResponse = false;         // Only state/last_changed after each entity's first entry
+    bool noAttributes = false;            // Skip attributes in the response
+    long timeoutSeconds = -1;             // -1 = HARestClientConfig::timeoutSeconds
+};
+
+// Configuration for the REST connection
+struct HARestClientConfig {
+    long timeoutSeconds = 10;           // Whole-transfer timeout (0 = none)
+    long connectTimeoutSeconds = 5;
+    bool verifyPeer = true;             // Disable for self-signed certificates
+    bool enableHttp2 = true;            // Negotiate HTTP/2 over TLS and multiplex requests
+    size_t maxIdleHandles = 8;          // Easy handles kept for reuse
+    bool verboseLogging = true;         // Log every call to stdout
+};
+
+// Counters for monitoring connection reuse
+struct HARestClientStats {
+    uint64_t requests = 0;
+    uint64_t connectionsOpened = 0;     // New TCP (+TLS) connections; stays flat while reusing
+    uint64_t handlesCreated = 0;
+    size_t idleHandles = 0;
+};
+
 // Home Assistant REST API Client
-// Provides methods to extract sensor data from Home Assistant using RESTful API
-// In production, this would use libcurl or similar HTTP library
+// Provides methods to extract sensor data from Home Assistant using RESTful API.
+// Requests run on pooled libcurl easy handles that share one DNS and TLS
+// session cache. Each pooled handle keeps its keep-alive connections, and
+// batched fetches run on a persistent multi handle, so connections and TLS
+// sessions are reused across calls instead of handshaking for every request.
 class HARestClient {
 public:
-    HARestClient(const std::string& baseUrl, const std::string& token);
+    HARestClient(const std::string& baseUrl, const std::string& token,
+                 const HARestClientConfig& config = HARestClientConfig());
 
     ~HARestClient();
     
     // Get current state of a specific sensor
     HASensorData getSensorState(const std::string& entityId);
     
+    // Get the states of several entities concurrently (curl_multi, at most
+    // maxConcurrent requests in flight). Results keep the order of entityIds;
+    // entities that could not be fetched have an empty entityId.
+    std::vector<HASensorData> getSensorStates(const std::vector<std::string>& entityIds,
+                                              size_t maxConcurrent = 8);
+    
     // Get all sensors from Home Assistant
     std::vector<HASensorData> getAllSensors();
     
+    // Get entities of one domain ("sensor", "switch", ...) or with an entity_id
+    // prefix. /api/states is streamed and other entities are dropped as they arrive.
+    std::vector<HASensorData> getStatesByDomain(const std::string& domain);
+    std::vector<HASensorData> getStatesByPrefix(const std::string& prefix);
+    
     // Get historical data for a sensor
     std::vector<HAHistoricalData> getHistory(const std::string& entityId, long startTimestamp);
     
+    // Get historical data without buffering the response: callback runs for
+    // each entry as it is downloaded. Returns the number of entries delivered.
+    size_t getHistoryStreaming(const std::string& entityId, long startTimestamp,
+                               std::function<void(const HAHistoricalData&)> callback);
+    
+    // Stream a history query without logging; safe to call from several threads.
+    // Returns true if the complete response was received and parsed.
+    bool fetchHistory(const HAHistoryQuery& query, std::function<void(const HAHistoricalData&)> callback);
+    
     // Get all entities (sensors, switches, lights, etc.)
     std::vector<HASensorData> getAllStates();
     
@@ -53,22 +108,49 @@ public:
     
     // Check if API is accessible
     bool testConnection();
+    
+    HARestClientStats getStats() const;
+
+    HARestClient(const HARestClient&) = delete;
+    HARestClient& operator=(const HARestClient&) = delete;
 
 private:
     std::string baseUrl_;
     std::string token_;
+    HARestClientConfig config_;
+    
+    // Connection reuse: pooled easy handles sharing caches through share_
+    CURLSH* share_;
+    CURLM* multi_;                      // Used by getSensorStates, guarded by multiMutex_
+    std::mutex multiMutex_;
+    struct curl_slist* headers_;        // Built once, used by every handle
+    mutable std::mutex poolMutex_;
+    std::vector<CURL*> idleHandles_;
+    std::mutex shareLocks_[CURL_LOCK_DATA_LAST];
+    
+    std::atomic<uint64_t> requests_;
+    std::atomic<uint64_t> connectionsOpened_;
+    std::atomic<uint64_t> handlesCreated_;
+    
+    using CurlWriteFunction = size_t (*)(void* contents, size_t size, size_t nmemb, void* userp);
     
     // Helper methods for HTTP operations
     std::string httpGet(const std::string& endpoint);
     std::string httpPost(const std::string& endpoint, const std::string& data);
+    long httpGetStreaming(const std::string& url, CurlWriteFunction writeFunction, void* userdata);
+    long perform(const std::string& url, const std::string* postData,
+                 CurlWriteFunction writeFunction, void* userdata, long timeoutSeconds);
+    static std::string formatTimestamp(long timestamp);
     
-    // Parse JSON response into sensor data
-    HASensorData parseSensorData(const std::string& jsonResponse);
-    std::vector<HASensorData> parseMultipleSensors(const std::string& jsonResponse);
-    std::vector<HAHistoricalData> parseHistoricalData(const std::string& jsonResponse);
+    void prepareRequest(CURL* curl, const std::string& url, const std::string* postData,
+                        CurlWriteFunction writeFunction, void* userdata);
+    long finishRequest(CURL* curl, CURLcode res);   // Updates stats, logs errors, returns HTTP status
+    std::vector<HASensorData> streamStates(const std::string& prefix);
     
-    // Simple JSON value extractor (in production, use proper JSON library)
-    std::string extractJsonValue(const std::string& json, const std::string& key);
+    CURL* acquireHandle();
+    void releaseHandle(CURL* curl);
+    static void lockShared(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlockShared(CURL* handle, curl_lock_data data, void* userptr);
 };
 
 #endif // HA_REST_CLIENT_H
@@ -0,0 +1,135 @@
+#ifndef HA_STUB_SERVER_H
+#define HA_STUB_SERVER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+// Size and behaviour of the generated Home Assistant fixtures
+struct HAStubServerConfig {
+    int port = 0;                        // 0 = pick a free port
+    size_t entityCount = 200;            // Entities in /api/states
+    size_t historyEntries = 288;         // Entries per entity in a history response
+    int latencyMs = 0;                   // Delay before every response is sent
+    std::string token;                   // Required bearer token (empty = accept any)
+    bool verboseLogging = false;         // Log every request
+};
+
+struct HAStubServerStats {
+    uint64_t requests = 0;
+    uint64_t bytesSent = 0;              // Response bodies only
+    size_t connectionsAccepted = 0;
+};
+
+// Minimal in-process Home Assistant REST stand-in on 127.0.0.1
+// Serves /api/, /api/states, /api/states/<entity_id>, /api/history/period
+// (filter_entity_id, end_time, minimal_response and no_attributes are
+// honoured) and /api/services over HTTP/1.1 keep-alive, so HARestClient can
+// be exercised and benchmarked without a live Home Assistant. Responses are
+// shaped like recorded HA output; setResponse() replaces one with a real
+// recording. Plain HTTP only, no TLS or compression.
+class HAStubServer {
+public:
+    explicit HAStubServer(const HAStubServerConfig& config = HAStubServerConfig());
+    ~HAStubServer();
+
+    HAStubServer(const HAStubServer&) = delete;
+    HAStubServer& operator=(const HAStubServer&) = delete;
+
+    bool start();
+    void stop();
+
+    int getPort() const;
+    std::string getBaseUrl() const;
+    HAStubServerStats getStats() const;
+
+    // Serve body (status 200) for every GET of path, ignoring the query
+    void setResponse(const std::string& path, const std::string& body);
+
+    // Answer the next count GETs of path with status instead, e.g. to
+    // exercise retries
+    void failRequests(const std::string& path, size_t count, int status = 503);
+
+    // The generated fixtures, e.g. to benchmark the parser on its own
+    const std::string& getStatesBody() const { return statesBody_; }
+    const std::vector<std::string>& getEntityIds() const { return entityIds_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingResponse {
+        Clock::time_point readyAt;
+        std::string data;
+    };
+
+    struct Session {
+        int fd = -1;
+        std::string readBuffer;
+        std::string writeBuffer;
+        size_t writeOffset = 0;
+        bool wantWrite = false;
+        bool closeAfterWrite = false;
+        std::deque<PendingResponse> pending;   // Held back by latencyMs, in request order
+    };
+
+    struct Request {
+        std::string method;
+        std::string path;                      // Percent-decoded, without query
+        std::map<std::string, std::string> query;
+        std::string authorization;
+        std::string body;
+        bool keepAlive = true;
+    };
+
+    void buildFixtures();
+    void appendState(std::string& out, size_t index) const;
+    std::string renderHistory(const Request& request) const;
+
+    void run();
+    void acceptClients();
+    void handleReadable(Session& session);
+    // False if malformed; consumed stays 0 while the request is incomplete
+    static bool parseRequest(std::string_view buffer, size_t& consumed, Request& request);
+    void respond(Session& session, const Request& request);
+    void queueResponse(Session& session, int status, const std::string& body, bool close);
+    int nextTimeoutMs() const;
+    void releaseReady(Session& session);
+    void flush(Session& session);
+    void closeSession(int fd);
+    void closeAllSessions();
+
+    HAStubServerConfig config_;
+    std::atomic<int> port_;
+    int listenFd_;
+    int epollFd_;
+    int wakeFd_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    // Built once before start(); read-only while serving
+    std::string statesBody_;
+    std::vector<std::pair<size_t, size_t>> stateSpans_;   // Offset/length of each entity in statesBody_
+    std::vector<std::string> entityIds_;
+    std::map<std::string, size_t> entityIndex_;
+    std::string servicesBody_;
+
+    mutable std::mutex overridesMutex_;
+    std::map<std::string, std::string> overrides_;
+    std::map<std::string, std::pair<size_t, int>> failures_;   // Remaining count and status per path
+
+    // Server thread only
+    std::map<int, Session> sessions_;
+
+    std::atomic<uint64_t> requests_;
+    std::atomic<uint64_t> bytesSent_;
+    std::atomic<size_t> connectionsAccepted_;
+};
+
+#endif // HA_STUB_SERVER_H
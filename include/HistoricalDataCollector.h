@@ -3,19 +3,31 @@
 
 #include "MLPredictor.h"
 #include "EventManager.h"
+#include "HistoricalDataStore.h"
+#include "DataJournal.h"
 #include <vector>
 #include <deque>
 #include <memory>
 #include <ctime>
+#include <mutex>
 #include <fstream>
 #include <iostream>
 
+// On-disk format used for persistence
+enum class PersistenceFormat {
+    CSV,     // Human-readable, rewritten on every save
+    BINARY   // Fixed-record append-only log (HistoricalDataStore)
+};
+
 // Configuration for data collection
 struct DataCollectionConfig {
     int maxDaysToRetain = 90;           // Keep last 90 days
     bool enablePersistence = true;      // Save to file
-    std::string persistenceFile = "historical_data.csv";
-    int collectionIntervalMinutes = 60; // Collect data every hour
+    std::string persistenceFile = "historical_data.bin";
+    PersistenceFormat persistenceFormat = PersistenceFormat::BINARY;
+    bool enableJournal = false;         // Journal every point to <persistenceFile>.wal (binary format only)
+    JournalConfig journal;              // Group commit and compaction settings for the journal
+    int collectionIntervalMinutes = 60; // Collect data every hour; sizes retention and getRecentData()
     bool verboseLogging = false;        // Enable verbose logging (disable in production)
 };
 
@@ -33,6 +45,9 @@ public:
     // Get all historical data
     std::vector<HistoricalDataPoint> getAllData() const;
     
+    // Get all historical data in columnar form (for training)
+    HistoricalDataset getDataset() const;
+    
     // Get recent data (last N days)
     std::vector<HistoricalDataPoint> getRecentData(int numDays) const;
     
@@ -43,20 +58,54 @@ public:
     void cleanupOldData();
     
     // Save data to file
+    // In binary format only points added since the last save are appended
+    // to the persistence file; any other filename gets a full snapshot.
+    // With the journal enabled this forces a group commit and compaction.
     bool saveToFile(const std::string& filename = "") const;
     
     // Load data from file
+    // In binary format an unreadable persistence file is kept as
+    // <file>.corrupt rather than overwritten by the next save. If there is
+    // no binary file yet, CSV data from an older build (<file> itself, or
+    // the same name with a .csv extension) is imported and written out.
     bool loadFromFile(const std::string& filename = "");
     
+    // CSV import/export (independent of the persistence format)
+    bool exportToCsv(const std::string& filename) const;
+    bool importFromCsv(const std::string& filename);
+    
     // Subscribe to sensor events for automatic data collection
     void subscribeToSensorEvents();
+    
+    // Feed every new data point to the predictor's incremental update()
+    // If seedFromHistory is set and the predictor is untrained, it is first
+    // trained on the data already collected.
+    void attachPredictor(std::shared_ptr<MLPredictor> predictor, bool seedFromHistory = true);
 
 private:
     DataCollectionConfig config_;
     std::deque<HistoricalDataPoint> dataPoints_;  // Use deque for efficient removal from front
+    std::shared_ptr<MLPredictor> onlinePredictor_; // Receives incremental updates (optional)
+    
+    // Binary persistence state (saveToFile is const, so these are mutable)
+    mutable std::shared_ptr<HistoricalDataStore> store_;
+    mutable size_t unsavedCount_;                  // Points not yet written to the store
+    std::unique_ptr<DataJournal> journal_;         // Write-ahead journal (optional)
+    
+    // Guards all of the above; recursive because public methods call each other
+    mutable std::recursive_mutex mutex_;
+    
+    // Import CSV data left by an older build into the binary file
+    bool migrateCsv(const std::string& file);
+    
+    // Open the journal and replay points a previous run did not compact
+    void openJournal();
     
     // Helper to get current hour and day of week
-    void getCurrentTimeInfo(int& hour, int& dayOfWeek) const;
+    void getCurrentTimeInfo(int& hour, int& minute, int& dayOfWeek) const;
+    
+    // Points collected per day at collectionIntervalMinutes
+    size_t pointsPerDay() const;
     
     // Helper to remove data older than retention period
     size_t removeOldDataPoints();
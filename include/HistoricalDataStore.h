@@ -0,0 +1,116 @@
+#ifndef HISTORICAL_DATA_STORE_H
+#define HISTORICAL_DATA_STORE_H
+
+#include "HistoricalDataset.h"
+#include <string>
+#include <deque>
+#include <vector>
+#include <cstdint>
+
+// Binary, append-only persistence for historical data points
+//
+// File layout: a 64-byte header followed by fixed 32-byte records.
+// The header carries a schema version, the number of committed records and
+// an FNV-1a checksum over those records. Records are written before the
+// header is updated, so a torn append leaves the previous header valid and
+// the trailing bytes are simply overwritten by the next append.
+// Loading maps the file with mmap and copies the records out directly.
+// Data is fsync'ed before the header that commits it, and a rewrite syncs
+// the directory after renaming the new file into place.
+// A file that fails validation (bad header, truncated, checksum mismatch)
+// is never overwritten: it is renamed to <path>.corrupt before a new file
+// is started, and if that rename fails every write is refused.
+class HistoricalDataStore {
+public:
+    static constexpr uint32_t SCHEMA_VERSION = 1;
+
+#pragma pack(push, 1)
+    struct Header {
+        char magic[8];          // "HDCSTORE"
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t recordCount;
+        uint64_t checksum;      // FNV-1a over the first recordCount records
+        uint64_t journalSequence; // Last DataJournal entry folded into this file
+        uint8_t reserved[24];
+    };
+
+    struct Record {
+        uint8_t hour;
+        uint8_t dayOfWeek;
+        uint8_t minute;         // 0 in files written before sub-hourly readings
+        uint8_t reserved0;
+        uint32_t reserved1;
+        double outdoorTemp;
+        double solarProduction;
+        double energyCost;
+    };
+#pragma pack(pop)
+
+    static_assert(sizeof(Header) == 64, "Header must be 64 bytes");
+    static_assert(sizeof(Record) == 32, "Record must be 32 bytes");
+
+    static constexpr uint64_t CHECKSUM_SEED = 14695981039346656037ULL;
+
+    explicit HistoricalDataStore(const std::string& path);
+
+    // Map the file and load every committed record into out.
+    // Returns false if the file is missing or fails validation; a file that
+    // fails validation is moved aside (see getCorruptPath()).
+    bool load(std::deque<HistoricalDataPoint>& out);
+
+    // Append the last count points of data to the file
+    bool append(const std::deque<HistoricalDataPoint>& data, size_t count);
+
+    // Append journal entries and record the last journal sequence in the
+    // same header update, so replay knows which entries are already stored
+    bool appendJournaled(const std::vector<Record>& records, uint64_t journalSequence);
+
+    // Replace the file contents with data (used for compaction)
+    bool rewrite(const std::deque<HistoricalDataPoint>& data);
+
+    // Drop all but the newest keep records
+    bool retainLast(size_t keep);
+
+    // False once an unreadable file could not be moved aside
+    bool isWritable() const;
+
+    // Where the last unreadable file was moved to ("" if none)
+    const std::string& getCorruptPath() const;
+
+    // Records committed in the file (as of the last load/append/rewrite)
+    uint64_t getRecordCount() const;
+
+    uint64_t getJournalSequence() const;
+
+    const std::string& getPath() const;
+
+    static Record toRecord(const HistoricalDataPoint& point);
+    static HistoricalDataPoint fromRecord(const Record& record);
+    static uint64_t checksum(uint64_t seed, const void* data, size_t length);
+
+private:
+    enum class FileState {
+        MISSING,    // No file, or an empty one
+        VALID,
+        CORRUPT
+    };
+
+    Header makeHeader(uint64_t recordCount, uint64_t checksum) const;
+
+    // Validate the file; if valid and out is set, copy its records there
+    FileState inspect(Header& header, std::deque<HistoricalDataPoint>* out) const;
+    bool setAside();
+    bool appendRecords(const std::vector<Record>& records);
+    bool writeFile(const std::vector<Record>& records);
+
+    std::string path_;
+    uint64_t recordCount_;
+    uint64_t checksum_;
+    uint64_t journalSequence_;
+    bool headerKnown_;
+    bool writable_;
+    std::string corruptPath_;
+};
+
+#endif // HISTORICAL_DATA_STORE_H
@@ -0,0 +1,118 @@
+#ifndef HISTORICAL_DATASET_H
+#define HISTORICAL_DATASET_H
+
+#include "TimeSlots.h"
+#include <vector>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// Historical data point for training
+struct HistoricalDataPoint {
+    int hour;              // Hour of day (0-23)
+    int dayOfWeek;         // Day of week (0-6, 0=Sunday)
+    double outdoorTemp;    // Outdoor temperature
+    double solarProduction; // Solar production
+    double energyCost;     // Energy cost per kWh
+    int minute = 0;        // Minute within the hour (0-59) for sub-hourly readings
+};
+
+// Cache-line aligned allocator so columns start on a SIMD-friendly boundary
+template <typename T, size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+// Mean and variance of one series within a bucket
+struct SeriesStats {
+    double mean = 0.0;
+    double variance = 0.0;
+};
+
+// Statistics for one hour, hour/weekday or fine-slot bucket
+struct BucketStats {
+    double count = 0.0;
+    SeriesStats cost;
+    SeriesStats solar;
+    SeriesStats temp;
+};
+
+// Per-hour, per-(weekday, hour) and per-fine-slot statistics over a dataset
+struct HistoricalAggregates {
+    static constexpr int HOURS_PER_DAY = 24;
+    static constexpr int DAYS_PER_WEEK = 7;
+
+    std::array<BucketStats, HOURS_PER_DAY> hourly;
+    std::array<BucketStats, HOURS_PER_DAY * DAYS_PER_WEEK> hourlyByWeekday; // [dayOfWeek * 24 + hour]
+    SlotArray<TimeSlots::FINEST, BucketStats> bySlot;                         // [slot of day at 5 minutes]
+
+    const BucketStats& forWeekday(int dayOfWeek, int hour) const {
+        return hourlyByWeekday[dayOfWeek * HOURS_PER_DAY + hour];
+    }
+};
+
+// Columnar (structure-of-arrays) store of historical data points
+// Each field lives in its own contiguous, aligned array so the aggregation
+// kernel streams through memory instead of striding over whole structs.
+class HistoricalDataset {
+public:
+    template <typename T>
+    using Column = std::vector<T, AlignedAllocator<T>>;
+
+    HistoricalDataset() = default;
+    explicit HistoricalDataset(const std::vector<HistoricalDataPoint>& points);
+
+    void reserve(size_t capacity);
+    void append(const HistoricalDataPoint& point);
+    void clear();
+
+    size_t size() const;
+    bool empty() const;
+    HistoricalDataPoint at(size_t index) const;
+
+    const Column<int32_t>& getHours() const;
+    const Column<int32_t>& getMinutes() const;
+    const Column<int32_t>& getDaysOfWeek() const;
+    const Column<double>& getOutdoorTemps() const;
+    const Column<double>& getSolarProduction() const;
+    const Column<double>& getEnergyCosts() const;
+
+    // Every per-hour, per-(weekday, hour) and per-slot statistic in two
+    // sweeps (means, then variances). Points with an out-of-range hour are
+    // ignored; an out-of-range day or minute only keeps a point out of the
+    // weekday or slot buckets.
+    HistoricalAggregates aggregate() const;
+
+private:
+    Column<int32_t> hours_;
+    Column<int32_t> minutes_;
+    Column<int32_t> daysOfWeek_;
+    Column<double> outdoorTemps_;
+    Column<double> solarProduction_;
+    Column<double> energyCosts_;
+};
+
+#endif // HISTORICAL_DATASET_H
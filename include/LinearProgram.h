@@ -0,0 +1,102 @@
+#ifndef LINEAR_PROGRAM_H
+#define LINEAR_PROGRAM_H
+
+#include <vector>
+#include <utility>
+#include <limits>
+#include <cstddef>
+
+enum class ConstraintSense {
+    LESS_EQUAL,
+    GREATER_EQUAL,
+    EQUAL
+};
+
+struct LinearConstraint {
+    std::vector<std::pair<int, double>> terms;   // (variable, coefficient)
+    ConstraintSense sense = ConstraintSense::LESS_EQUAL;
+    double rhs = 0.0;
+};
+
+// Minimize c'x subject to linear rows and lower <= x <= upper
+// Lower bounds must be finite; upper bounds may be infinite.
+class LinearProgram {
+public:
+    static constexpr double INF = std::numeric_limits<double>::infinity();
+
+    // Returns the variable index
+    int addVariable(double cost, double lower = 0.0, double upper = INF);
+    void addConstraint(const LinearConstraint& constraint);
+
+    size_t getVariableCount() const;
+    size_t getConstraintCount() const;
+    double getCost(int variable) const;
+    double getLower(int variable) const;
+    double getUpper(int variable) const;
+    const std::vector<LinearConstraint>& getConstraints() const;
+
+private:
+    std::vector<double> cost_;
+    std::vector<double> lower_;
+    std::vector<double> upper_;
+    std::vector<LinearConstraint> constraints_;
+};
+
+enum class LPStatus {
+    OPTIMAL,
+    INFEASIBLE,
+    UNBOUNDED,
+    ITERATION_LIMIT
+};
+
+// Dense bounded-variable simplex tableau
+// Starts from the all-slack basis with every variable at the bound its cost
+// prefers, which is dual feasible, and runs the dual simplex. Tightening a
+// bound keeps the basis dual feasible, so branch-and-bound nodes re-optimise
+// in a few pivots instead of from scratch. Adding a column keeps it primal
+// feasible instead; solve() then prices the column in with the primal
+// simplex, as column generation needs.
+class SimplexTableau {
+public:
+    explicit SimplexTableau(const LinearProgram& lp);
+
+    LPStatus solve();
+
+    // Bounds may only be tightened
+    void setBounds(int variable, double lower, double upper);
+
+    // New column with (row, coefficient) entries; returns the variable index
+    int addVariable(double cost, double lower, double upper, const std::vector<std::pair<int, double>>& column);
+
+    double getObjective() const;
+    std::vector<double> getValues() const;
+    std::vector<double> getDuals() const;      // One price per row, from the last solve()
+    double getLower(int variable) const;
+    double getUpper(int variable) const;
+    size_t getIterations() const;
+
+private:
+    void pivot(size_t row, size_t column);
+    bool isPrimalFeasible() const;
+    LPStatus primalSimplex(size_t limit);
+    void makeDualFeasible();
+    void shiftNonbasic(size_t column, double value);
+    void recomputeBasicValues();
+
+    std::vector<size_t> variableColumn_;   // Tableau column of each variable
+    std::vector<size_t> slackColumn_;      // Tableau column of each row's slack
+    std::vector<std::vector<double>> rows_;   // B^-1 [A | I]; the slack columns hold B^-1
+    std::vector<double> rhs_;              // Right-hand side of each row
+    std::vector<size_t> basis_;            // Column basic in each row
+    std::vector<int> basicRow_;            // Row of each basic column, -1 if nonbasic
+    std::vector<double> cost_;
+    std::vector<double> reducedCost_;
+    std::vector<double> lower_;
+    std::vector<double> upper_;
+    std::vector<double> value_;
+    std::vector<char> atUpper_;            // Nonbasic columns resting on their upper bound
+    std::vector<char> boxed_;              // Infinite bound replaced to restore dual feasibility
+    size_t iterations_;
+};
+
+#endif // LINEAR_PROGRAM_H
@@ -1,27 +1,32 @@
 #ifndef ML_PREDICTOR_H
 #define ML_PREDICTOR_H
 
+#include "HistoricalDataset.h"
+#include "TimeSlots.h"
 #include <vector>
 #include <cmath>
 #include <algorithm>
 #include <map>
+#include <array>
+#include <mutex>
 
-// Historical data point for training
-struct HistoricalDataPoint {
-    int hour;              // Hour of day (0-23)
-    int dayOfWeek;         // Day of week (0-6, 0=Sunday)
-    double outdoorTemp;    // Outdoor temperature
-    double solarProduction; // Solar production
-    double energyCost;     // Energy cost per kWh
-};
-
-// Forecast for a specific hour
+// Forecast for one slot, starting at hour:minute
 struct HourlyForecast {
     int hour;
     double predictedEnergyCost;
     double predictedSolarProduction;
     double predictedOutdoorTemp;
     double confidenceScore;  // 0-1, higher is better
+    int minute = 0;          // Slot start within the hour; 0 for hourly slots
+};
+
+// Forecast for every slot of one day from midnight, sized at compile time
+template <SlotLength Length>
+struct SlotProfile {
+    SlotArray<Length> cost;
+    SlotArray<Length> solar;
+    SlotArray<Length> temp;
+    SlotArray<Length> confidence;
 };
 
 // Simple ML predictor using linear regression and pattern matching
@@ -32,25 +37,71 @@ public:
 
     // Train the model with historical data
     void train(const std::vector<HistoricalDataPoint>& historicalData);
+    void train(const HistoricalDataset& dataset);
+
+    // Incrementally refine the model with one new reading in O(1)
+    // Uses weighted Welford updates per hour and per (weekday, hour) bucket;
+    // older readings decay by the forgetting factor on every bucket update.
+    void update(const HistoricalDataPoint& point);
+
+    // Forgetting factor in (0, 1]; 1.0 weighs all readings equally
+    void setForgettingFactor(double lambda);
+    double getForgettingFactor() const;
 
     // Predict the next 24 hours
     std::vector<HourlyForecast> predictNext24Hours(int currentHour, int currentDayOfWeek);
 
+    // Predict the next 24 hours in slots of the given length, starting with
+    // the slot holding currentHour:currentMinute. Sub-hourly slots use the
+    // 5-minute statistics where readings carry minutes and fall back to the
+    // hour they lie in otherwise.
+    std::vector<HourlyForecast> predictNextDay(SlotLength length, int currentHour, int currentDayOfWeek,
+                                               int currentMinute = 0);
+
+    // Forecast for every slot of one day
+    template <SlotLength Length>
+    SlotProfile<Length> predictProfile(int dayOfWeek);
+
     bool isTrained() const;
 
+    // Statistics learned so far (batch training plus incremental updates)
+    HistoricalAggregates getStatistics() const;
+
 private:
-    struct HourlyStats {
-        double avgCost = 0.0;
-        double avgSolar = 0.0;
-        double avgTemp = 0.0;
+    // Exponentially weighted running moments for one series
+    struct RunningSeries {
+        double mean = 0.0;
+        double m2 = 0.0;
     };
 
-    double average(const std::vector<double>& values);
-    std::vector<HourlyForecast> generateDefaultForecasts(int currentHour);
+    struct RunningBucket {
+        double weight = 0.0;
+        RunningSeries cost;
+        RunningSeries solar;
+        RunningSeries temp;
+    };
+
+    static void seedBucket(RunningBucket& bucket, const BucketStats& stats);
+    static void updateSeries(RunningSeries& series, double value, double lambda, double weight);
+    static BucketStats toStats(const RunningBucket& bucket);
+    void updateBucket(RunningBucket& running, BucketStats& stats, const HistoricalDataPoint& point);
+
+    // These expect mutex_ to be held
+    // Ratio of the weekday's price at this hour to the all-days mean
+    double weekdayCostFactor(int dayOfWeek, int hour) const;
+    template <SlotLength Length>
+    void fillProfile(int dayOfWeek, SlotProfile<Length>& profile) const;
+    template <SlotLength Length>
+    std::vector<HourlyForecast> forecastFrom(int minuteOfDay, int dayOfWeek);
 
+    mutable std::mutex mutex_;
     bool trained_;
-    std::vector<HistoricalDataPoint> historicalData_;
-    std::map<int, HourlyStats> hourlyStats_;
+    double forgettingFactor_;
+    HistoricalAggregates stats_;
+    std::array<RunningBucket, HistoricalAggregates::HOURS_PER_DAY> hourlyRunning_;
+    std::array<RunningBucket, HistoricalAggregates::HOURS_PER_DAY *
+                              HistoricalAggregates::DAYS_PER_WEEK> weekdayRunning_;
+    SlotArray<TimeSlots::FINEST, RunningBucket> slotRunning_;
 };
 
 #endif // ML_PREDICTOR_H
@@ -16,6 +16,7 @@ struct TrainingScheduleConfig {
     int minDataPointsForTraining = 168; // Minimum 7 days of hourly data (7*24)
     bool autoRetrain = true;             // Enable automatic retraining
     bool verboseLogging = true;          // Enable detailed logging
+    bool incrementalLearning = false;    // Update the model per data point instead of periodic retraining
 };
 
 // Scheduler for periodic ML model retraining
@@ -1,39 +1,189 @@
-// MQTTClient.h - Interface remains unchanged
 #ifndef MQTT_CLIENT_H
 #define MQTT_CLIENT_H
 
+#include "MQTTPacket.h"
+#include "MQTTTopicTrie.h"
 #include <string>
 #include <functional>
 #include <map>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 
+// Configuration for the MQTT connection
+struct MQTTClientConfig {
+    std::string clientId;                   // Empty = generated from the process id
+    std::string username;
+    std::string password;
+    int keepAliveSeconds = 30;              // PINGREQ after this much idle time
+    int connectTimeoutMs = 3000;            // How long connect() waits for CONNACK
+    int reconnectMinDelayMs = 250;          // Backoff starts here...
+    int reconnectMaxDelayMs = 30000;        // ...and doubles up to this
+    size_t maxQueuedBytes = 4 * 1024 * 1024;// Outgoing bytes buffered while offline or congested
+    size_t maxInflight = 4096;              // Unacknowledged QoS 1 publishes; more wait for PUBACKs
+    bool deliverInProcessMessages = false;  // Run callbacks in processMessages() instead of the network thread
+    bool verboseLogging = false;            // Log every publish/receive (disable in production)
+};
+
+// Counters for monitoring the transport
+struct MQTTClientStats {
+    uint64_t messagesPublished = 0;
+    uint64_t messagesReceived = 0;
+    uint64_t messagesDropped = 0;    // Rejected because the outgoing queue was full
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t writeCalls = 0;         // send() calls; lower than messagesPublished when batching
+    uint64_t reconnects = 0;
+    size_t inflight = 0;
+};
+
+// MQTT 3.1.1 client on a non-blocking socket
+// connect() starts a network thread running an epoll loop. publish() and
+// subscribe() only encode into an outgoing buffer and wake the loop, which
+// writes everything queued with as few send() calls as possible. QoS 1
+// publishes are pipelined and retransmitted after a reconnect; lost
+// connections are re-established with exponential backoff and all
+// subscriptions are restored. Incoming topics are matched against a
+// subscription trie; several callbacks may share one filter.
 class MQTTClient {
 public:
     using MessageCallback = std::function<void(const std::string& topic, const std::string& payload)>;
+    using ConnectionCallback = std::function<void(bool reconnected)>;
 
-    MQTTClient(const std::string& brokerAddress, int port = 1883);
+    MQTTClient(const std::string& brokerAddress, int port = 1883,
+               const MQTTClientConfig& config = MQTTClientConfig());
     ~MQTTClient();
 
+    MQTTClient(const MQTTClient&) = delete;
+    MQTTClient& operator=(const MQTTClient&) = delete;
+
+    // Start the network thread and wait up to connectTimeoutMs for the broker
+    // Returns false if not connected yet; the client keeps retrying in the background.
     bool connect();
     void disconnect();
     bool isConnected() const;
-    void subscribe(const std::string& topic, MessageCallback callback);
-    void publish(const std::string& topic, const std::string& payload);
+    void subscribe(const std::string& topic, MessageCallback callback, int qos = 0);
+
+    // Run callback on the network thread after every CONNACK, once the
+    // subscriptions are restored (reconnected is false the first time), e.g.
+    // to republish what a restarted broker forgot. It may publish() but must
+    // not add or remove connection callbacks. Returns an ID for
+    // removeConnectionCallback, which waits for a running callback to return.
+    size_t addConnectionCallback(ConnectionCallback callback);
+    void removeConnectionCallback(size_t id);
+
+    // Queue a message; returns false if it was dropped
+    bool publish(const std::string& topic, const std::string& payload, int qos = 0, bool retain = false);
+
+    // Deliver queued messages when deliverInProcessMessages is set
     void processMessages();
-    
+
     // Simulate receiving a message (for testing without real broker)
     void simulateMessage(const std::string& topic, const std::string& payload);
 
+    // Block until all queued data is written and QoS 1 publishes are acknowledged
+    bool waitForDelivery(std::chrono::milliseconds timeout);
+
+    MQTTClientStats getStats() const;
+
 private:
+    enum class ConnectionState {
+        DISCONNECTED,
+        CONNECTING,        // TCP connect in progress
+        AWAITING_CONNACK,
+        CONNECTED
+    };
+
+    using CallbackPtr = std::shared_ptr<const MessageCallback>;
+
+    struct InflightPublish {
+        std::string packet;
+        bool transmitted;   // Handed to the socket at least once
+    };
+
+    // QoS 1 publish waiting for a free inflight slot
+    struct PendingPublish {
+        std::string topic;
+        std::string payload;
+        bool retain;
+    };
+
+    // Network thread
+    void networkLoop();
+    void startConnect();
+    void onConnectComplete();
+    void onConnack(const MQTTPacket& packet);
+    void handleReadable();
+    void handlePacket(const MQTTPacket& packet);
+    void takeOutbound();
+    void flushWrites();
+    void updateWriteInterest();
+    void closeSocket(const char* reason);
+    void checkTimers(std::chrono::steady_clock::time_point now);
+    int computeTimeout(std::chrono::steady_clock::time_point now) const;
+    void wakeLoop();
+
+    void deliver(const std::string& topic, const std::string& payload);
+    void releaseBacklog();         // Requires mutex_
+    uint16_t allocatePacketId();   // Requires mutex_
+
     std::string brokerAddress_;
     int port_;
-    bool connected_;
-    std::map<std::string, MessageCallback> subscriptions_;
-    
-    // Check if a topic matches a subscription pattern (supports + and # wildcards)
-    bool topicMatches(const std::string& pattern, const std::string& topic) const;
-    
-    // Mock-only member (kept for interface compatibility)
-    void* mosq_;
+    MQTTClientConfig config_;
+
+    std::atomic<bool> connected_;     // CONNACK received on the current connection
+    std::atomic<bool> running_;
+    std::thread networkThread_;
+    int epollFd_;
+    int wakeFd_;
+
+    // Shared with API threads, guarded by mutex_
+    mutable std::mutex mutex_;
+    std::condition_variable stateCondition_;
+    MQTTTopicTrie<CallbackPtr> subscriptionTrie_;
+    std::map<std::string, int> subscribedFilters_;   // Filter -> QoS, for (re)subscribing
+    std::string outbound_;                      // Encoded packets waiting for the network thread
+    std::vector<uint16_t> queuedPublishIds_;    // QoS 1 ids whose packet is in outbound_
+    std::map<uint16_t, InflightPublish> inflight_;
+    std::deque<PendingPublish> inflightBacklog_;
+    size_t backlogBytes_;
+    uint16_t nextPacketId_;
+    std::deque<std::pair<std::string, std::string>> inbound_;   // For deliverInProcessMessages
+    bool writeIdle_;                            // Network thread has nothing left to write
+
+    // Held while connection callbacks run, so removal can wait for them
+    std::mutex connectionCallbacksMutex_;
+    std::map<size_t, ConnectionCallback> connectionCallbacks_;
+    size_t nextConnectionCallbackId_;
+
+    // Network thread only
+    ConnectionState state_;
+    int socketFd_;
+    bool wantWrite_;
+    std::string writeBuffer_;
+    size_t writeOffset_;
+    std::string readBuffer_;
+    int reconnectDelayMs_;
+    std::chrono::steady_clock::time_point nextReconnect_;
+    std::chrono::steady_clock::time_point connectStarted_;
+    std::chrono::steady_clock::time_point lastSend_;
+    std::chrono::steady_clock::time_point pingSent_;
+    bool pingOutstanding_;
+    bool everConnected_;
+
+    std::atomic<uint64_t> messagesPublished_;
+    std::atomic<uint64_t> messagesReceived_;
+    std::atomic<uint64_t> messagesDropped_;
+    std::atomic<uint64_t> bytesSent_;
+    std::atomic<uint64_t> bytesReceived_;
+    std::atomic<uint64_t> writeCalls_;
+    std::atomic<uint64_t> reconnects_;
 };
 
-#endif // MQTT_CLIENT_H
\ No newline at end of file
+#endif // MQTT_CLIENT_H
@@ -0,0 +1,76 @@
+#ifndef MQTT_LOOPBACK_BROKER_H
+#define MQTT_LOOPBACK_BROKER_H
+
+#include "MQTTPacket.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+// Minimal in-process MQTT 3.1.1 broker on 127.0.0.1
+// Intended for integration tests and demos without a network: supports
+// CONNECT, PUBLISH (QoS 0/1, retained), SUBSCRIBE with wildcards, PINGREQ
+// and DISCONNECT. QoS 2 is downgraded to 1. No persistence or auth.
+class MQTTLoopbackBroker {
+public:
+    explicit MQTTLoopbackBroker(int port = 0);   // 0 = pick a free port
+    ~MQTTLoopbackBroker();
+
+    MQTTLoopbackBroker(const MQTTLoopbackBroker&) = delete;
+    MQTTLoopbackBroker& operator=(const MQTTLoopbackBroker&) = delete;
+
+    bool start();
+    void stop();
+
+    int getPort() const;
+    size_t getConnectionCount() const;
+    uint64_t getPublishCount() const;    // PUBLISH packets received from clients
+
+    // Close every client connection (simulates a broker restart)
+    // forgetRetained also drops the retained messages, like a broker that
+    // keeps them only in memory.
+    void dropConnections(bool forgetRetained = false);
+
+private:
+    struct Session {
+        int fd = -1;
+        bool connected = false;
+        std::string clientId;
+        std::string readBuffer;
+        std::string writeBuffer;
+        size_t writeOffset = 0;
+        bool wantWrite = false;
+        std::vector<std::pair<std::string, int>> subscriptions;
+        uint16_t nextPacketId = 1;
+    };
+
+    void run();
+    void acceptClients();
+    void handleReadable(Session& session);
+    bool handlePacket(Session& session, const MQTTPacket& packet);
+    void route(const MQTTPublishMessage& message);
+    void flush(Session& session);
+    void closeSession(int fd);
+    void closeAllSessions();
+
+    int requestedPort_;
+    std::atomic<int> port_;
+    int listenFd_;
+    int epollFd_;
+    int wakeFd_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+    std::atomic<bool> dropRequested_;
+    std::atomic<bool> forgetRetained_;
+
+    // Broker thread only
+    std::map<int, Session> sessions_;
+    std::map<std::string, std::string> retained_;
+
+    std::atomic<size_t> connectionCount_;
+    std::atomic<uint64_t> publishCount_;
+};
+
+#endif // MQTT_LOOPBACK_BROKER_H
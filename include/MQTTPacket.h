@@ -0,0 +1,92 @@
+#ifndef MQTT_PACKET_H
+#define MQTT_PACKET_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+// MQTT 3.1.1 control packet types (high nibble of the fixed header)
+enum class MQTTPacketType : uint8_t {
+    CONNECT = 1,
+    CONNACK = 2,
+    PUBLISH = 3,
+    PUBACK = 4,
+    PUBREC = 5,
+    PUBREL = 6,
+    PUBCOMP = 7,
+    SUBSCRIBE = 8,
+    SUBACK = 9,
+    UNSUBSCRIBE = 10,
+    UNSUBACK = 11,
+    PINGREQ = 12,
+    PINGRESP = 13,
+    DISCONNECT = 14
+};
+
+// A decoded control packet: fixed header flags plus the raw variable
+// header and payload
+struct MQTTPacket {
+    MQTTPacketType type;
+    uint8_t flags;        // Low nibble of the fixed header
+    std::string body;
+};
+
+struct MQTTPublishMessage {
+    std::string topic;
+    std::string payload;
+    int qos = 0;
+    bool retain = false;
+    bool dup = false;
+    uint16_t packetId = 0;
+};
+
+// Encoding and decoding shared by MQTTClient and MQTTLoopbackBroker
+// Encoders append to an output buffer so several packets can be batched
+// into a single write.
+class MQTTCodec {
+public:
+    enum class ParseResult {
+        COMPLETE,     // packet decoded, consumed holds its size
+        INCOMPLETE,   // need more bytes
+        MALFORMED     // protocol error, drop the connection
+    };
+
+    static constexpr size_t MAX_PACKET_SIZE = 268435455;  // Largest remaining length
+
+    static ParseResult parse(const char* data, size_t length, size_t& consumed, MQTTPacket& packet);
+
+    static void appendConnect(std::string& out, const std::string& clientId, uint16_t keepAliveSeconds,
+                              bool cleanSession, const std::string& username = "",
+                              const std::string& password = "");
+    static void appendConnack(std::string& out, bool sessionPresent, uint8_t returnCode);
+    static void appendPublish(std::string& out, const std::string& topic, const std::string& payload,
+                              int qos, bool retain, uint16_t packetId, bool dup = false);
+    static void appendSubscribe(std::string& out, uint16_t packetId,
+                                const std::vector<std::pair<std::string, int>>& filters);
+    static void appendSuback(std::string& out, uint16_t packetId, const std::vector<uint8_t>& grantedQos);
+    static void appendAck(std::string& out, MQTTPacketType type, uint16_t packetId);  // PUBACK, UNSUBACK, ...
+    static void appendEmpty(std::string& out, MQTTPacketType type);                   // PINGREQ, PINGRESP, DISCONNECT
+
+    static bool decodePublish(const MQTTPacket& packet, MQTTPublishMessage& message);
+    static bool decodeConnect(const MQTTPacket& packet, std::string& clientId, uint16_t& keepAliveSeconds);
+    static bool decodeSubscribe(const MQTTPacket& packet, uint16_t& packetId,
+                                std::vector<std::pair<std::string, int>>& filters);
+    static bool decodePacketId(const MQTTPacket& packet, uint16_t& packetId);
+
+    // Set the DUP flag on an encoded PUBLISH (for retransmission)
+    static void markDuplicate(std::string& encodedPublish);
+
+    // Match a topic against a filter with + and # wildcards
+    static bool topicMatches(const std::string& filter, const std::string& topic);
+
+private:
+    static void appendFixedHeader(std::string& out, MQTTPacketType type, uint8_t flags, size_t remainingLength);
+    static void appendUint16(std::string& out, uint16_t value);
+    static void appendString(std::string& out, const std::string& value);
+    static bool readUint16(const std::string& data, size_t& pos, uint16_t& value);
+    static bool readString(const std::string& data, size_t& pos, std::string& value);
+};
+
+#endif // MQTT_PACKET_H
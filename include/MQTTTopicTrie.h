@@ -0,0 +1,138 @@
+#ifndef MQTT_TOPIC_TRIE_H
+#define MQTT_TOPIC_TRIE_H
+
+#include <string>
+#include <string_view>
+#include <map>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+// Subscription index keyed by topic level
+// Each node has literal children plus optional '+' and '#' wildcard
+// children, so matching a topic walks O(levels) nodes. Literal children
+// use std::less<> so lookups take a std::string_view slice of the topic
+// and never allocate. Any number of values can be stored per filter.
+template <typename T>
+class MQTTTopicTrie {
+public:
+    MQTTTopicTrie() : root_(new Node()), size_(0) {}
+
+    MQTTTopicTrie(const MQTTTopicTrie&) = delete;
+    MQTTTopicTrie& operator=(const MQTTTopicTrie&) = delete;
+
+    // Add a value for a filter such as "homeassistant/+/state" or "sensors/#"
+    void insert(std::string_view filter, T value) {
+        Node* node = root_.get();
+        size_t start = 0;
+        for (;;) {
+            size_t end = filter.find('/', start);
+            std::string_view level = filter.substr(start, end == std::string_view::npos ? end : end - start);
+
+            std::unique_ptr<Node>* child;
+            if (level == "+") {
+                child = &node->plus;
+            } else if (level == "#") {
+                child = &node->hash;
+            } else {
+                auto it = node->children.find(level);
+                if (it == node->children.end()) {
+                    it = node->children.emplace(std::string(level), std::unique_ptr<Node>()).first;
+                }
+                child = &it->second;
+            }
+            if (!*child) {
+                child->reset(new Node());
+            }
+            node = child->get();
+
+            if (end == std::string_view::npos) {
+                break;
+            }
+            start = end + 1;
+        }
+        node->values.push_back(std::move(value));
+        ++size_;
+    }
+
+    // Call visit(const T&) for every value whose filter matches topic
+    template <typename Visitor>
+    void match(std::string_view topic, Visitor&& visit) const {
+        // Wildcards at the first level don't match $SYS-style topics
+        bool system = !topic.empty() && topic[0] == '$';
+        matchLevel(*root_, topic, 0, system, visit);
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    void clear() {
+        root_.reset(new Node());
+        size_ = 0;
+    }
+
+private:
+    struct Node {
+        std::map<std::string, std::unique_ptr<Node>, std::less<>> children;
+        std::unique_ptr<Node> plus;    // '+' child
+        std::unique_ptr<Node> hash;    // '#' child (always a leaf)
+        std::vector<T> values;
+    };
+
+    template <typename Visitor>
+    static void visitAll(const Node& node, Visitor& visit) {
+        for (const auto& value : node.values) {
+            visit(value);
+        }
+    }
+
+    // Match the topic suffix starting at pos against node's subtree
+    template <typename Visitor>
+    static void matchLevel(const Node& node, std::string_view topic, size_t pos,
+                           bool skipWildcards, Visitor& visit) {
+        if (node.hash && !skipWildcards) {
+            visitAll(*node.hash, visit);   // '#' covers this level and below
+        }
+
+        size_t end = topic.find('/', pos);
+        std::string_view level = topic.substr(pos, end == std::string_view::npos ? end : end - pos);
+        bool last = end == std::string_view::npos;
+
+        auto it = node.children.find(level);
+        if (it != node.children.end()) {
+            if (last) {
+                visitLeaf(*it->second, visit);
+            } else {
+                matchLevel(*it->second, topic, end + 1, false, visit);
+            }
+        }
+
+        if (node.plus && !skipWildcards) {
+            if (last) {
+                visitLeaf(*node.plus, visit);
+            } else {
+                matchLevel(*node.plus, topic, end + 1, false, visit);
+            }
+        }
+    }
+
+    // Topic ends at this node: its own values plus "parent/#" filters
+    template <typename Visitor>
+    static void visitLeaf(const Node& node, Visitor& visit) {
+        visitAll(node, visit);
+        if (node.hash) {
+            visitAll(*node.hash, visit);
+        }
+    }
+
+    std::unique_ptr<Node> root_;
+    size_t size_;
+};
+
+#endif // MQTT_TOPIC_TRIE_H
@@ -0,0 +1,79 @@
+#ifndef RECEDING_HORIZON_PLANNER_H
+#define RECEDING_HORIZON_PLANNER_H
+
+#include "ScheduleSolver.h"
+#include <map>
+#include <memory>
+#include <string>
+
+// Plant state measured at the start of the current slot, by device ID
+// Devices left out are assumed to be where the plan put them.
+struct ScheduleMeasurement {
+    std::map<std::string, double> indoorTemp;     // Thermal devices
+    std::map<std::string, double> deliveredKwh;   // Energy targets, since the horizon started
+    double batteryKwh = -1.0;                     // -1 = not measured
+};
+
+// Differences below these are treated as noise and do not trigger a re-solve
+struct RecedingHorizonConfig {
+    double priceTolerance = 0.005;        // $/kWh
+    double solarToleranceKw = 0.2;
+    double loadToleranceKw = 0.2;
+    double outdoorTolerance = 0.5;        // °C
+    double temperatureTolerance = 0.3;    // Indoor, °C
+    double energyToleranceKwh = 0.25;     // Delivered to an energy target
+    double batteryToleranceKwh = 0.25;
+};
+
+struct ReplanStats {
+    size_t slot = 0;              // Slot the update was made at
+    size_t fromSlot = 0;          // First slot re-solved; the plan before it was kept
+    size_t resolvedSlots = 0;     // 0 = nothing changed, plan kept as is
+    bool stateDiverged = false;   // A measurement was off the plan's prediction
+    bool feasible = true;         // False if the solver found no plan; the old one is kept
+    double solveMs = 0.0;
+};
+
+// Model-predictive control over a ScheduleSolver
+// start() plans the whole horizon. Each update() drops the slots that have
+// passed, re-bases the problem on the measured state and compares the latest
+// forecasts with the ones the plan was made for. Only the suffix from the
+// first slot that changed is re-solved, warm-started from the old plan's
+// suffix; if neither forecasts nor measurements moved, no solver runs.
+// Slot indices are counted from the start() of the horizon, which ends where
+// the first plan's does.
+class RecedingHorizonPlanner {
+public:
+    explicit RecedingHorizonPlanner(std::shared_ptr<ScheduleSolver> solver,
+                                    const RecedingHorizonConfig& config = RecedingHorizonConfig());
+
+    void setSolver(std::shared_ptr<ScheduleSolver> solver);
+
+    const ScheduleSolution& start(const ScheduleProblem& problem);
+
+    // `latest` holds the current forecasts over the original horizon; only its
+    // prices, solar, base load and outdoor temperatures are read
+    const ScheduleSolution& update(size_t slot, const ScheduleProblem& latest,
+                                   const ScheduleMeasurement& measured = ScheduleMeasurement());
+
+    // Remaining horizon, from getStartSlot() on
+    const ScheduleProblem& getProblem() const;
+    const ScheduleSolution& getPlan() const;
+    size_t getStartSlot() const;
+    const ReplanStats& getLastStats() const;
+
+private:
+    void advance(size_t slots);
+    bool applyMeasurement(const ScheduleMeasurement& measured);
+    size_t firstChangedSlot(const ScheduleProblem& latest) const;
+
+    std::shared_ptr<ScheduleSolver> solver_;
+    RecedingHorizonConfig config_;
+    ScheduleProblem problem_;
+    ScheduleSolution plan_;
+    std::vector<double> deliveredKwh_;    // Per device, before the start slot
+    size_t startSlot_;
+    ReplanStats lastStats_;
+};
+
+#endif // RECEDING_HORIZON_PLANNER_H
@@ -0,0 +1,73 @@
+#ifndef TIME_SLOTS_H
+#define TIME_SLOTS_H
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+// Length of one settlement interval, and so of one forecast and schedule slot
+enum class SlotLength {
+    FIVE_MINUTES = 5,
+    FIFTEEN_MINUTES = 15,
+    ONE_HOUR = 60
+};
+
+namespace TimeSlots {
+    constexpr int MINUTES_PER_HOUR = 60;
+    constexpr int MINUTES_PER_DAY = 24 * MINUTES_PER_HOUR;
+
+    // Historical statistics are kept at the finest slot length; coarser
+    // slots are sums of whole fine slots
+    constexpr SlotLength FINEST = SlotLength::FIVE_MINUTES;
+
+    constexpr int minutes(SlotLength length) {
+        return static_cast<int>(length);
+    }
+
+    constexpr size_t slotsPerDay(SlotLength length) {
+        return static_cast<size_t>(MINUTES_PER_DAY / minutes(length));
+    }
+
+    constexpr double hours(SlotLength length) {
+        return minutes(length) / static_cast<double>(MINUTES_PER_HOUR);
+    }
+
+    // Slot of the day holding hour:minute
+    constexpr size_t slotOfDay(SlotLength length, int hour, int minute) {
+        return static_cast<size_t>((hour * MINUTES_PER_HOUR + minute) / minutes(length));
+    }
+
+    constexpr size_t FINEST_SLOTS_PER_DAY = slotsPerDay(FINEST);
+    constexpr size_t FINEST_SLOTS_PER_HOUR = MINUTES_PER_HOUR / minutes(FINEST);
+
+    // Minutes 5, 15 or 60 as a slot length; false for anything else
+    constexpr bool fromMinutes(int value, SlotLength& length) {
+        switch (value) {
+            case 5: length = SlotLength::FIVE_MINUTES; return true;
+            case 15: length = SlotLength::FIFTEEN_MINUTES; return true;
+            case 60: length = SlotLength::ONE_HOUR; return true;
+        }
+        return false;
+    }
+
+    // Calls f with the slot length as a compile-time constant, so code sized
+    // by SlotArray is instantiated once per supported length
+    template <typename F>
+    auto dispatch(SlotLength length, F&& f) {
+        switch (length) {
+            case SlotLength::FIVE_MINUTES:
+                return f(std::integral_constant<SlotLength, SlotLength::FIVE_MINUTES>());
+            case SlotLength::FIFTEEN_MINUTES:
+                return f(std::integral_constant<SlotLength, SlotLength::FIFTEEN_MINUTES>());
+            case SlotLength::ONE_HOUR:
+                break;
+        }
+        return f(std::integral_constant<SlotLength, SlotLength::ONE_HOUR>());
+    }
+}
+
+// One value per slot of a day
+template <SlotLength Length, typename T = double>
+using SlotArray = std::array<T, TimeSlots::slotsPerDay(Length)>;
+
+#endif // TIME_SLOTS_H
@@ -0,0 +1,72 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+
+struct WorkStealingStats {
+    size_t tasks = 0;
+    size_t steals = 0;                    // Ranges taken over from another worker
+    std::vector<size_t> tasksPerWorker;
+};
+
+// Fixed set of worker threads for data-parallel loops
+// parallelFor() hands every worker an equal contiguous range of indices.
+// A worker takes indices from the front of its own range; once that is
+// empty it steals the back half of another worker's range, so a few slow
+// tasks do not leave the other cores idle. The only shared state on the
+// hot path is one lock per worker range.
+class WorkStealingPool {
+public:
+    using Task = std::function<void(size_t worker, size_t index)>;
+
+    explicit WorkStealingPool(size_t threadCount = 0);   // 0 = one per hardware thread
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t getThreadCount() const;
+
+    // Run task(worker, index) for every index in [0, count) and wait for all
+    // of them. Calls must not overlap.
+    void parallelFor(size_t count, const Task& task);
+
+    // Statistics of the last parallelFor()
+    const WorkStealingStats& getLastStats() const;
+
+private:
+    // Indices [begin, end) still to run; padded so workers do not share a line
+    struct alignas(64) Range {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+        size_t completed = 0;       // Owner only
+        size_t steals = 0;          // Owner only
+    };
+
+    void workerLoop(size_t worker);
+    void runRange(size_t worker);
+    bool steal(size_t thief);
+
+    std::vector<std::unique_ptr<Range>> ranges_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    uint64_t generation_;           // Guarded by mutex_; bumped by every parallelFor()
+    size_t active_;                 // Guarded by mutex_; workers still in the current call
+    bool stopping_;                 // Guarded by mutex_
+    const Task* task_;
+
+    WorkStealingStats stats_;
+};
+
+#endif // WORK_STEALING_POOL_H
@@ -0,0 +1,60 @@
+#include "ApplianceRegistry.h"
+
+void ApplianceRegistry::add(std::shared_ptr<Appliance> appliance) {
+    if (!appliance) {
+        return;
+    }
+
+    // Not an else-if chain: a device that is several kinds (a heat pump
+    // deriving from Heater and AirConditioner) belongs in each list
+    Appliance* raw = appliance.get();
+    if (auto evCharger = dynamic_cast<EVCharger*>(raw)) {
+        evChargers_.push_back(evCharger);
+    }
+    if (auto heater = dynamic_cast<Heater*>(raw)) {
+        heaters_.push_back(heater);
+    }
+    if (auto ac = dynamic_cast<AirConditioner*>(raw)) {
+        airConditioners_.push_back(ac);
+    }
+    if (auto light = dynamic_cast<Light*>(raw)) {
+        lights_.push_back(light);
+    }
+    if (auto curtain = dynamic_cast<Curtain*>(raw)) {
+        curtains_.push_back(curtain);
+    }
+
+    appliances_.push_back(std::move(appliance));
+}
+
+const std::vector<std::shared_ptr<Appliance>>& ApplianceRegistry::getAll() const {
+    return appliances_;
+}
+
+const std::vector<EVCharger*>& ApplianceRegistry::getEVChargers() const {
+    return evChargers_;
+}
+
+const std::vector<Heater*>& ApplianceRegistry::getHeaters() const {
+    return heaters_;
+}
+
+const std::vector<AirConditioner*>& ApplianceRegistry::getAirConditioners() const {
+    return airConditioners_;
+}
+
+const std::vector<Light*>& ApplianceRegistry::getLights() const {
+    return lights_;
+}
+
+const std::vector<Curtain*>& ApplianceRegistry::getCurtains() const {
+    return curtains_;
+}
+
+size_t ApplianceRegistry::size() const {
+    return appliances_.size();
+}
+
+bool ApplianceRegistry::empty() const {
+    return appliances_.empty();
+}
@@ -0,0 +1,157 @@
+#include "BatchDayAheadOptimizer.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// CPU time of the calling thread; unlike wall time it does not grow when
+// more workers than cores share the machine
+double threadCpuMs() {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+}
+
+}
+
+BatchDayAheadOptimizer::BatchDayAheadOptimizer(const BatchConfig& config)
+    : config_(config), pool_(config.threads) {
+    for (size_t i = 0; i < pool_.getThreadCount(); ++i) {
+        solvers_.push_back(std::make_shared<MILPScheduleSolver>(config_.solver));
+    }
+}
+
+void BatchDayAheadOptimizer::addPriceZone(const std::string& zone, std::shared_ptr<MLPredictor> predictor) {
+    zones_[zone] = predictor;
+}
+
+std::vector<SiteResult> BatchDayAheadOptimizer::optimize(const std::vector<SiteConfig>& sites, int currentHour,
+                                                         int currentDayOfWeek, int currentMinute) {
+    auto start = Clock::now();
+    stats_ = BatchStats();
+    stats_.sites = sites.size();
+    stats_.threads = pool_.getThreadCount();
+
+    // One forecast per zone that a site without its own forecasts is in
+    std::map<std::string, size_t> zoneIndex;
+    std::vector<std::shared_ptr<MLPredictor>> zonePredictors;
+    for (const auto& site : sites) {
+        auto zone = zones_.find(site.priceZone);
+        if (site.forecasts.empty() && zone != zones_.end() && zoneIndex.count(site.priceZone) == 0) {
+            zoneIndex[site.priceZone] = zonePredictors.size();
+            zonePredictors.push_back(zone->second);
+        }
+    }
+    std::vector<std::vector<HourlyForecast>> zoneForecasts(zonePredictors.size());
+    pool_.parallelFor(zonePredictors.size(), [&](size_t, size_t zone) {
+        zoneForecasts[zone] = zonePredictors[zone]->predictNextDay(config_.slotLength, currentHour, currentDayOfWeek,
+                                                                   currentMinute);
+    });
+    stats_.zoneForecasts = zoneForecasts.size();
+    stats_.forecastMs = millisecondsSince(start);
+
+    std::vector<const std::vector<HourlyForecast>*> siteForecasts(sites.size(), nullptr);
+    for (size_t i = 0; i < sites.size(); ++i) {
+        if (!sites[i].forecasts.empty()) {
+            siteForecasts[i] = &sites[i].forecasts;
+            continue;
+        }
+        auto zone = zoneIndex.find(sites[i].priceZone);
+        if (zone != zoneIndex.end()) {
+            siteForecasts[i] = &zoneForecasts[zone->second];
+            stats_.sharedForecastSites++;
+        }
+    }
+
+    // Each task writes only its own result
+    auto planStart = Clock::now();
+    std::vector<SiteResult> results(sites.size());
+    pool_.parallelFor(sites.size(), [&](size_t worker, size_t i) {
+        if (siteForecasts[i]) {
+            results[i] = planSite(worker, sites[i], *siteForecasts[i]);
+        } else {
+            results[i].siteId = sites[i].siteId;
+            results[i].worker = worker;
+        }
+    });
+    double planWallMs = millisecondsSince(planStart);
+    stats_.steals = pool_.getLastStats().steals;
+
+    for (size_t i = 0; i < sites.size(); ++i) {
+        if (!siteForecasts[i]) {
+            std::cerr << "BatchDayAheadOptimizer: No forecasts for site '" << sites[i].siteId << "' in zone '"
+                      << sites[i].priceZone << "'" << std::endl;
+        }
+        stats_.feasibleSites += results[i].feasible ? 1 : 0;
+        stats_.totalSiteMs += results[i].planMs;
+        stats_.totalCpuMs += results[i].cpuMs;
+        stats_.maxSiteMs = std::max(stats_.maxSiteMs, results[i].planMs);
+    }
+    stats_.wallMs = millisecondsSince(start);
+    if (stats_.wallMs > 0.0) {
+        stats_.sitesPerSecond = stats_.sites * 1000.0 / stats_.wallMs;
+    }
+    if (planWallMs > 0.0) {
+        stats_.parallelEfficiency = stats_.totalCpuMs / (planWallMs * stats_.threads);
+    }
+    return results;
+}
+
+const BatchStats& BatchDayAheadOptimizer::getLastStats() const {
+    return stats_;
+}
+
+void BatchDayAheadOptimizer::printStats() const {
+    std::cout << "\n=== Batch Day-Ahead Planning ===" << std::endl;
+    std::cout << "Sites: " << stats_.sites << " (" << stats_.feasibleSites << " feasible), "
+              << stats_.zoneForecasts << " zone forecasts shared by " << stats_.sharedForecastSites << " sites"
+              << std::endl;
+    std::cout << "Threads: " << stats_.threads << ", steals: " << stats_.steals << std::endl;
+    std::cout << "Wall time: " << stats_.wallMs << " ms (forecasts " << stats_.forecastMs << " ms), "
+              << stats_.sitesPerSecond << " sites/s" << std::endl;
+    std::cout << "Per site: " << (stats_.sites > 0 ? stats_.totalSiteMs / stats_.sites : 0.0) << " ms average ("
+              << (stats_.sites > 0 ? stats_.totalCpuMs / stats_.sites : 0.0) << " ms CPU), "
+              << stats_.maxSiteMs << " ms max, parallel efficiency " << stats_.parallelEfficiency * 100.0 << "%"
+              << std::endl;
+}
+
+SiteResult BatchDayAheadOptimizer::planSite(size_t worker, const SiteConfig& site,
+                                            const std::vector<HourlyForecast>& forecasts) {
+    auto start = Clock::now();
+    double cpuStart = threadCpuMs();
+
+    // Forecasts are passed in, so the optimizer never queries a predictor
+    DayAheadOptimizer optimizer(nullptr);
+    optimizer.setVerbose(false);
+    optimizer.setScheduleSolver(solvers_[worker]);
+    optimizer.setSlotLength(config_.slotLength);
+    optimizer.setTargetTemperature(site.targetTemperature);
+    optimizer.setEVChargingHoursNeeded(site.evChargingHoursNeeded);
+    optimizer.setImportLimit(site.importLimitKw);
+    optimizer.setBattery(site.battery);
+    optimizer.setThermalModel(site.degreesPerKwh, site.lossPerHour);
+    for (const auto& appliance : site.appliances) {
+        optimizer.addAppliance(appliance);
+    }
+
+    SiteResult result;
+    result.siteId = site.siteId;
+    result.worker = worker;
+    DayAheadSchedule schedule = optimizer.generateSchedule(forecasts);
+    result.feasible = optimizer.getLastSolution().feasible;
+    result.estimatedCost = schedule.getEstimatedCost();
+    result.estimatedConsumption = schedule.getEstimatedConsumption();
+    if (config_.keepSchedules) {
+        result.schedule = std::move(schedule);
+    }
+    result.planMs = millisecondsSince(start);
+    result.cpuMs = threadCpuMs() - cpuStart;
+    return result;
+}
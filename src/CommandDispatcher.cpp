@@ -0,0 +1,308 @@
+#include "CommandDispatcher.h"
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+const char* priorityName(CommandPriority priority) {
+    switch (priority) {
+        case CommandPriority::SAFETY: return "safety";
+        case CommandPriority::COMFORT: return "comfort";
+        case CommandPriority::ECONOMY: return "economy";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+CommandDispatcher::CommandDispatcher(const CommandDispatcherConfig& config)
+    : config_(config), running_(false), queued_(0), submitted_(0), sent_(0), failed_(0),
+      superseded_(0), rejected_(0) {}
+
+CommandDispatcher::~CommandDispatcher() {
+    stop();
+}
+
+void CommandDispatcher::addTransport(const std::string& name, Transport send, const TransportRateLimit& limit) {
+    std::lock_guard<std::mutex> lock(transportsMutex_);
+    if (transports_.count(name)) {
+        std::cerr << "CommandDispatcher: Transport " << name << " already registered" << std::endl;
+        return;
+    }
+
+    std::unique_ptr<TransportQueue> transport(new TransportQueue());
+    transport->name = name;
+    transport->send = std::move(send);
+    transport->limit = limit;
+    if (running_) {
+        startTransport(*transport);
+    }
+    transports_.emplace(name, std::move(transport));
+}
+
+void CommandDispatcher::start() {
+    std::lock_guard<std::mutex> lock(transportsMutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    for (auto& entry : transports_) {
+        startTransport(*entry.second);
+    }
+}
+
+void CommandDispatcher::stop() {
+    // Also runs when never started: submissions made before start() are
+    // queued and still need completing
+    std::vector<TransportQueue*> stopping;
+    {
+        std::lock_guard<std::mutex> lock(transportsMutex_);
+        running_ = false;
+        for (auto& entry : transports_) {
+            stopping.push_back(entry.second.get());
+        }
+    }
+
+    // Joined without transportsMutex_, so completion callbacks may still
+    // submit (and are rejected) without deadlocking
+    for (TransportQueue* transport : stopping) {
+        {
+            std::lock_guard<std::mutex> lock(transport->mutex);
+            transport->running = false;
+            transport->closed = true;
+        }
+        transport->wake.notify_one();
+    }
+    for (TransportQueue* transport : stopping) {
+        if (transport->thread.joinable()) {
+            transport->thread.join();
+        }
+    }
+
+    // A transport thread drains its queues before exiting, so anything left
+    // was queued on a transport that never started
+    for (TransportQueue* transport : stopping) {
+        std::vector<std::shared_ptr<PendingCommand>> unsent;
+        {
+            std::lock_guard<std::mutex> lock(transport->mutex);
+            for (auto& queue : transport->queues) {
+                for (auto& pending : queue) {
+                    if (!pending->cancelled) {
+                        unsent.push_back(pending);
+                    }
+                }
+                queue.clear();
+            }
+            transport->queuedByDevice.clear();
+        }
+        if (!unsent.empty()) {
+            std::cerr << "CommandDispatcher: Stopped before start, rejecting " << unsent.size()
+                      << " queued command(s) for " << transport->name << std::endl;
+        }
+        for (auto& pending : unsent) {
+            complete(pending, CommandStatus::REJECTED);
+        }
+    }
+}
+
+bool CommandDispatcher::submit(const DeviceCommand& command, CompletionCallback onComplete) {
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+
+    TransportQueue* transport = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(transportsMutex_);
+        auto it = transports_.find(command.transport);
+        if (it != transports_.end()) {
+            transport = it->second.get();
+        }
+    }
+    if (!transport) {
+        std::cerr << "CommandDispatcher: Unknown transport " << command.transport << std::endl;
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        if (onComplete) {
+            onComplete(command, CommandStatus::REJECTED);
+        }
+        return false;
+    }
+
+    auto pending = std::make_shared<PendingCommand>();
+    pending->command = command;
+    pending->onComplete = std::move(onComplete);
+    pending->readyAt = std::chrono::steady_clock::now();
+    if (command.priority != CommandPriority::SAFETY) {
+        pending->readyAt += std::chrono::milliseconds(config_.debounceMs);
+    }
+
+    // Counted before it is visible to the transport thread
+    {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        ++queued_;
+    }
+
+    std::shared_ptr<PendingCommand> superseded;
+    bool accepted = true;
+    bool closed = false;
+    {
+        // Checked under the transport lock, so nothing is queued after the
+        // transport thread has drained its queues and exited
+        std::lock_guard<std::mutex> lock(transport->mutex);
+        auto it = transport->queuedByDevice.find(command.deviceId);
+        if (transport->closed) {
+            accepted = false;
+            closed = true;
+        } else if (it != transport->queuedByDevice.end()) {
+            if (it->second->command.priority < command.priority) {
+                // A more important decision for this device is still waiting
+                accepted = false;
+            } else {
+                superseded = it->second;
+                superseded->cancelled = true;
+                it->second = pending;
+            }
+        } else {
+            transport->queuedByDevice.emplace(command.deviceId, pending);
+        }
+        if (accepted) {
+            transport->queues[static_cast<size_t>(command.priority)].push_back(pending);
+        }
+    }
+    if (accepted) {
+        transport->wake.notify_one();
+    }
+
+    std::shared_ptr<PendingCommand> dropped = accepted ? superseded : pending;
+    if (!dropped) {
+        return true;
+    }
+    if (closed) {
+        std::cerr << "CommandDispatcher: Stopped, rejecting " << command.command << " for " << command.deviceId
+                  << std::endl;
+    }
+    (accepted ? superseded_ : rejected_).fetch_add(1, std::memory_order_relaxed);
+    if (dropped->onComplete) {
+        dropped->onComplete(dropped->command, accepted ? CommandStatus::SUPERSEDED : CommandStatus::REJECTED);
+    }
+    {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        if (--queued_ == 0) {
+            idleCondition_.notify_all();
+        }
+    }
+    return accepted;
+}
+
+bool CommandDispatcher::waitUntilIdle(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(idleMutex_);
+    return idleCondition_.wait_for(lock, timeout, [this] { return queued_ == 0; });
+}
+
+CommandDispatcherStats CommandDispatcher::getStats() const {
+    CommandDispatcherStats stats;
+    stats.submitted = submitted_.load();
+    stats.sent = sent_.load();
+    stats.failed = failed_.load();
+    stats.superseded = superseded_.load();
+    stats.rejected = rejected_.load();
+    {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        stats.queued = queued_;
+    }
+    return stats;
+}
+
+void CommandDispatcher::startTransport(TransportQueue& transport) {
+    {
+        std::lock_guard<std::mutex> lock(transport.mutex);
+        transport.running = true;
+        transport.closed = false;
+    }
+    transport.tokens = transport.limit.burst;
+    transport.lastRefill = std::chrono::steady_clock::now();
+    transport.thread = std::thread(&CommandDispatcher::transportLoop, this, std::ref(transport));
+}
+
+void CommandDispatcher::transportLoop(TransportQueue& transport) {
+    std::unique_lock<std::mutex> lock(transport.mutex);
+    for (;;) {
+        auto now = std::chrono::steady_clock::now();
+        if (transport.limit.commandsPerSecond > 0.0) {
+            double elapsed = std::chrono::duration<double>(now - transport.lastRefill).count();
+            transport.tokens = std::min(transport.limit.burst,
+                                        transport.tokens + elapsed * transport.limit.commandsPerSecond);
+        } else {
+            transport.tokens = std::max(transport.tokens, 1.0);
+        }
+        transport.lastRefill = now;
+
+        // Highest priority ready command; once stopping, debounce no longer applies
+        std::deque<std::shared_ptr<PendingCommand>>* source = nullptr;
+        auto nextReady = std::chrono::steady_clock::time_point::max();
+        for (auto& queue : transport.queues) {
+            while (!queue.empty() && queue.front()->cancelled) {
+                queue.pop_front();
+            }
+            if (queue.empty()) {
+                continue;
+            }
+            if (queue.front()->readyAt <= now || !transport.running) {
+                source = &queue;
+                break;
+            }
+            nextReady = std::min(nextReady, queue.front()->readyAt);
+        }
+
+        if (!source) {
+            if (!transport.running) {
+                break;
+            }
+            if (nextReady == std::chrono::steady_clock::time_point::max()) {
+                transport.wake.wait(lock);
+            } else {
+                transport.wake.wait_until(lock, nextReady);
+            }
+            continue;
+        }
+
+        std::shared_ptr<PendingCommand> pending = source->front();
+        bool bypassLimit = pending->command.priority == CommandPriority::SAFETY || !transport.running;
+        if (!bypassLimit && transport.tokens < 1.0) {
+            // Safety commands may drive the bucket negative, so this can be more than one interval
+            auto wait = std::chrono::duration<double>((1.0 - transport.tokens) / transport.limit.commandsPerSecond);
+            transport.wake.wait_for(lock, wait);
+            continue;
+        }
+
+        source->pop_front();
+        auto it = transport.queuedByDevice.find(pending->command.deviceId);
+        if (it != transport.queuedByDevice.end() && it->second == pending) {
+            transport.queuedByDevice.erase(it);
+        }
+        transport.tokens -= 1.0;
+
+        lock.unlock();
+        bool ok = transport.send(pending->command);
+        if (config_.verboseLogging) {
+            std::cout << "CommandDispatcher: " << (ok ? "Sent" : "Failed to send") << " " << pending->command.command
+                      << " to " << pending->command.deviceId << " via " << transport.name << " ("
+                      << priorityName(pending->command.priority) << ")" << std::endl;
+        }
+        complete(pending, ok ? CommandStatus::SENT : CommandStatus::FAILED);
+        lock.lock();
+    }
+}
+
+void CommandDispatcher::complete(const std::shared_ptr<PendingCommand>& pending, CommandStatus status) {
+    std::atomic<uint64_t>& counter = status == CommandStatus::SENT     ? sent_
+                                     : status == CommandStatus::FAILED ? failed_
+                                                                       : rejected_;
+    counter.fetch_add(1, std::memory_order_relaxed);
+    if (pending->onComplete) {
+        pending->onComplete(pending->command, status);
+    }
+
+    std::lock_guard<std::mutex> lock(idleMutex_);
+    if (--queued_ == 0) {
+        idleCondition_.notify_all();
+    }
+}
@@ -0,0 +1,272 @@
+#include "DataJournal.h"
+#include <cstring>
+#include <chrono>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace {
+
+const char JOURNAL_MAGIC[8] = {'H', 'D', 'C', 'J', 'R', 'N', 'L', '1'};
+constexpr uint32_t JOURNAL_VERSION = 1;
+
+bool writeAll(int fd, const void* data, size_t length, off_t offset) {
+    const char* p = static_cast<const char*>(data);
+    while (length > 0) {
+        ssize_t written = ::pwrite(fd, p, length, offset);
+        if (written < 0) {
+            return false;
+        }
+        p += written;
+        offset += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+DataJournal::DataJournal(std::shared_ptr<HistoricalDataStore> store,
+                         const std::string& path,
+                         const JournalConfig& config)
+    : store_(store), path_(path), config_(config),
+      nextSequence_(1), running_(false),
+      fd_(-1), fileSize_(0), lastJournaledSequence_(0),
+      durableSequence_(0), fsyncCount_(0), compactionCount_(0) {}
+
+DataJournal::~DataJournal() {
+    close();
+}
+
+bool DataJournal::open(std::deque<HistoricalDataPoint>& recovered) {
+    std::lock_guard<std::mutex> ioLock(ioMutex_);
+    if (fd_ >= 0) {
+        return true;
+    }
+
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+        std::cerr << "DataJournal: Failed to open journal: " << path_ << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    size_t size = (::fstat(fd_, &st) == 0) ? static_cast<size_t>(st.st_size) : 0;
+    uint64_t storedSequence = store_->getJournalSequence();
+    lastJournaledSequence_ = storedSequence;
+
+    // Replay entries the store has not seen yet; stop at the first torn
+    // or out-of-order entry
+    FileHeader header;
+    if (size >= sizeof(FileHeader) &&
+        ::pread(fd_, &header, sizeof(FileHeader), 0) == static_cast<ssize_t>(sizeof(FileHeader)) &&
+        std::memcmp(header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) == 0 &&
+        header.version == JOURNAL_VERSION && header.entrySize == sizeof(Entry)) {
+
+        std::vector<Entry> entries((size - sizeof(FileHeader)) / sizeof(Entry));
+        size_t bytes = entries.size() * sizeof(Entry);
+        if (bytes > 0 && ::pread(fd_, entries.data(), bytes, sizeof(FileHeader)) != static_cast<ssize_t>(bytes)) {
+            entries.clear();
+        }
+
+        std::vector<HistoricalDataStore::Record> replayed;
+        for (const auto& entry : entries) {
+            if (entry.checksum != entryChecksum(entry)) {
+                break;
+            }
+            if (entry.sequence <= storedSequence) {
+                continue;
+            }
+            if (entry.sequence != lastJournaledSequence_ + 1) {
+                break;
+            }
+            replayed.push_back(entry.record);
+            recovered.push_back(HistoricalDataStore::fromRecord(entry.record));
+            lastJournaledSequence_ = entry.sequence;
+        }
+
+        if (!replayed.empty()) {
+            std::cout << "DataJournal: Replayed " << replayed.size() 
+                      << " journaled data points from " << path_ << std::endl;
+            uncompacted_.swap(replayed);
+        }
+    } else if (size > 0) {
+        std::cerr << "DataJournal: Ignoring unreadable journal: " << path_ << std::endl;
+    }
+
+    // Start every session from an empty journal
+    if (!uncompacted_.empty() && !compact()) {
+        return false;
+    }
+    if (!resetFile()) {
+        return false;
+    }
+
+    durableSequence_.store(lastJournaledSequence_, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        nextSequence_ = lastJournaledSequence_ + 1;
+        running_ = true;
+    }
+    flusherThread_ = std::thread(&DataJournal::flushLoop, this);
+    return true;
+}
+
+void DataJournal::append(const HistoricalDataPoint& point) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry entry;
+    std::memset(&entry, 0, sizeof(Entry));
+    entry.sequence = nextSequence_++;
+    entry.record = HistoricalDataStore::toRecord(point);
+    entry.checksum = entryChecksum(entry);
+    pending_.push_back(entry);
+
+    if (pending_.size() >= config_.groupCommitSize) {
+        flushCondition_.notify_one();
+    }
+}
+
+bool DataJournal::sync() {
+    std::lock_guard<std::mutex> ioLock(ioMutex_);
+    if (fd_ < 0) {
+        return false;
+    }
+    return flush(true);
+}
+
+bool DataJournal::replaceStore(const std::deque<HistoricalDataPoint>& data) {
+    std::lock_guard<std::mutex> ioLock(ioMutex_);
+    if (fd_ < 0 || !flush(true)) {
+        return false;
+    }
+    return store_->rewrite(data);
+}
+
+void DataJournal::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    flushCondition_.notify_one();
+    if (flusherThread_.joinable()) {
+        flusherThread_.join();
+    }
+
+    std::lock_guard<std::mutex> ioLock(ioMutex_);
+    if (fd_ >= 0) {
+        flush(true);
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+uint64_t DataJournal::getDurableSequence() const {
+    return durableSequence_.load(std::memory_order_acquire);
+}
+
+size_t DataJournal::getFsyncCount() const {
+    return fsyncCount_.load(std::memory_order_relaxed);
+}
+
+size_t DataJournal::getCompactionCount() const {
+    return compactionCount_.load(std::memory_order_relaxed);
+}
+
+const std::string& DataJournal::getPath() const {
+    return path_;
+}
+
+uint64_t DataJournal::entryChecksum(const Entry& entry) {
+    return HistoricalDataStore::checksum(HistoricalDataStore::CHECKSUM_SEED, &entry,
+                                         sizeof(Entry) - sizeof(entry.checksum));
+}
+
+void DataJournal::flushLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        flushCondition_.wait(lock, [this] { return !running_ || !pending_.empty(); });
+
+        // Group commit: wait for a full group or the commit interval
+        flushCondition_.wait_for(lock, std::chrono::milliseconds(config_.groupCommitIntervalMs),
+                                 [this] { return !running_ || pending_.size() >= config_.groupCommitSize; });
+        if (!running_) {
+            break;   // close() does the final flush
+        }
+
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> ioLock(ioMutex_);
+            flush(false);
+        }
+        lock.lock();
+    }
+}
+
+bool DataJournal::flush(bool forceCompaction) {
+    std::vector<Entry> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batch.swap(pending_);
+    }
+
+    if (!batch.empty()) {
+        size_t bytes = batch.size() * sizeof(Entry);
+        if (!writeAll(fd_, batch.data(), bytes, static_cast<off_t>(fileSize_)) || ::fdatasync(fd_) != 0) {
+            std::cerr << "DataJournal: Failed to write journal: " << path_ << std::endl;
+            // Keep the entries queued, in order, for the next attempt
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.insert(pending_.begin(), batch.begin(), batch.end());
+            return false;
+        }
+
+        fileSize_ += bytes;
+        fsyncCount_.fetch_add(1, std::memory_order_relaxed);
+        for (const auto& entry : batch) {
+            uncompacted_.push_back(entry.record);
+        }
+        lastJournaledSequence_ = batch.back().sequence;
+        durableSequence_.store(lastJournaledSequence_, std::memory_order_release);
+    }
+
+    if (!uncompacted_.empty() &&
+        (forceCompaction || uncompacted_.size() >= config_.compactionThreshold)) {
+        return compact();
+    }
+    return true;
+}
+
+bool DataJournal::compact() {
+    // The store header records the last folded sequence, so a crash between
+    // here and the truncation below only causes already-stored entries to
+    // be skipped on replay
+    if (!store_->appendJournaled(uncompacted_, lastJournaledSequence_)) {
+        std::cerr << "DataJournal: Failed to compact into " << store_->getPath() << std::endl;
+        return false;
+    }
+    uncompacted_.clear();
+
+    if (store_->getRecordCount() > 2 * config_.maxStoreRecords) {
+        store_->retainLast(config_.maxStoreRecords);
+    }
+    compactionCount_.fetch_add(1, std::memory_order_relaxed);
+
+    return resetFile();
+}
+
+bool DataJournal::resetFile() {
+    FileHeader header;
+    std::memset(&header, 0, sizeof(FileHeader));
+    std::memcpy(header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    header.version = JOURNAL_VERSION;
+    header.entrySize = sizeof(Entry);
+
+    if (::ftruncate(fd_, 0) != 0 ||
+        !writeAll(fd_, &header, sizeof(FileHeader), 0) ||
+        ::fdatasync(fd_) != 0) {
+        std::cerr << "DataJournal: Failed to reset journal: " << path_ << std::endl;
+        return false;
+    }
+    fileSize_ = sizeof(FileHeader);
+    return true;
+}
@@ -1,37 +1,29 @@
 #include "DayAheadOptimizer.h"
 #include <algorithm>
 
-void DayAheadSchedule::addAction(int hour, const std::string& applianceId, const std::string& action, 
-               double value, const std::string& reason) {
-    ScheduledAction sa;
-    sa.hour = hour;
-    sa.applianceId = applianceId;
-    sa.action = action;
-    sa.value = value;
-    sa.reason = reason;
-    actions.push_back(sa);
-}
-
-std::vector<ScheduledAction> DayAheadSchedule::getActionsForHour(int hour) const {
-    std::vector<ScheduledAction> hourActions;
-    for (const auto& action : actions) {
-        if (action.hour == hour) {
-            hourActions.push_back(action);
-        }
-    }
-    return hourActions;
+namespace {
+
+const double ACTIVE_KW = 1e-3;   // Planned power below this counts as off
+
 }
 
 DayAheadOptimizer::DayAheadOptimizer(std::shared_ptr<MLPredictor> predictor)
     : predictor_(predictor), 
       deferrableController_(nullptr),
+      solver_(std::make_shared<MILPScheduleSolver>()),
+      planner_(solver_),
       targetIndoorTemp_(22.0),
       highCostThreshold_(0.15),
-      lowCostThreshold_(0.10),
-      evChargingHoursNeeded_(4) {}
+      evChargingHoursNeeded_(4),
+      importLimitKw_(0.0),
+      degreesPerKwh_(0.5),
+      lossPerHour_(0.05),
+      comfortPenalty_(2.0),
+      slotLength_(SlotLength::ONE_HOUR),
+      verbose_(true) {}
 
 void DayAheadOptimizer::addAppliance(std::shared_ptr<Appliance> appliance) {
-    appliances_.push_back(appliance);
+    appliances_.add(appliance);
 }
 
 void DayAheadOptimizer::setTargetTemperature(double temp) {
@@ -42,157 +34,285 @@ void DayAheadOptimizer::setEVChargingHoursNeeded(int hours) {
     evChargingHoursNeeded_ = hours;
 }
 
+void DayAheadOptimizer::setImportLimit(double kw) {
+    importLimitKw_ = kw;
+}
+
+void DayAheadOptimizer::setBattery(const ScheduleBattery& battery) {
+    battery_ = battery;
+}
+
+void DayAheadOptimizer::setThermalModel(double degreesPerKwh, double lossPerHour) {
+    degreesPerKwh_ = degreesPerKwh;
+    lossPerHour_ = lossPerHour;
+}
+
+void DayAheadOptimizer::setComfortPenalty(double perDegreeHour) {
+    comfortPenalty_ = perDegreeHour;
+}
+
+void DayAheadOptimizer::setScheduleSolver(std::shared_ptr<ScheduleSolver> solver) {
+    solver_ = solver;
+    planner_.setSolver(solver);
+}
+
+void DayAheadOptimizer::setSlotLength(SlotLength length) {
+    slotLength_ = length;
+}
+
+SlotLength DayAheadOptimizer::getSlotLength() const {
+    return slotLength_;
+}
+
+void DayAheadOptimizer::setVerbose(bool verbose) {
+    verbose_ = verbose;
+}
+
 void DayAheadOptimizer::setDeferrableLoadController(std::shared_ptr<DeferrableLoadController> controller) {
     deferrableController_ = controller;
 }
 
-DayAheadSchedule DayAheadOptimizer::generateSchedule(int currentHour, int currentDayOfWeek) {
-    std::cout << "\n=== Generating Day-Ahead Schedule with ML ===" << std::endl;
+const ScheduleSolution& DayAheadOptimizer::getLastSolution() const {
+    return planner_.getPlan();
+}
+
+const ReplanStats& DayAheadOptimizer::getLastReplanStats() const {
+    return planner_.getLastStats();
+}
+
+DayAheadSchedule DayAheadOptimizer::generateSchedule(int currentHour, int currentDayOfWeek, int currentMinute) {
+    if (verbose_) {
+        std::cout << "\n=== Generating Day-Ahead Schedule with ML ===" << std::endl;
+    }
     
     // Get ML predictions
-    auto forecasts = predictor_->predictNext24Hours(currentHour, currentDayOfWeek);
+    auto forecasts = predictor_->predictNextDay(slotLength_, currentHour, currentDayOfWeek, currentMinute);
     
-    DayAheadSchedule schedule;
-    schedule.estimatedCost = 0.0;
-    schedule.estimatedConsumption = 0.0;
+    // Plan every controllable appliance for the whole day at once
+    planner_.start(buildProblem(forecasts));
+    return makeSchedule(forecasts);
+}
 
-    // Find best hours for EV charging (lowest cost, highest solar)
-    std::vector<int> bestEVHours = findBestEVChargingHours(forecasts);
+DayAheadSchedule DayAheadOptimizer::generateSchedule(const std::vector<HourlyForecast>& forecasts) {
+    if (verbose_) {
+        std::cout << "\n=== Generating Day-Ahead Schedule from " << forecasts.size() << " forecasts ===" << std::endl;
+    }
+    planner_.start(buildProblem(forecasts));
+    return makeSchedule(forecasts);
+}
 
-    // Generate schedule for each hour
-    for (const auto& forecast : forecasts) {
-        optimizeHour(forecast, bestEVHours, schedule);
+DayAheadSchedule DayAheadOptimizer::updateSchedule(int elapsedSlots, const std::vector<HourlyForecast>& latest,
+                                                   const ScheduleMeasurement& measured) {
+    if (verbose_) {
+        std::cout << "\n=== Re-planning Day-Ahead Schedule after " << elapsedSlots << " slots ===" << std::endl;
     }
 
-    std::cout << "Schedule generated: " << schedule.actions.size() << " actions" << std::endl;
-    std::cout << "Estimated daily cost: $" << schedule.estimatedCost << std::endl;
-    std::cout << "Estimated consumption: " << schedule.estimatedConsumption << " kWh" << std::endl;
+    planner_.update(static_cast<size_t>(std::max(0, elapsedSlots)), buildProblem(latest), measured);
+    const ReplanStats& stats = planner_.getLastStats();
+    if (verbose_ && stats.resolvedSlots == 0) {
+        std::cout << "Forecasts and measurements match the plan; schedule kept" << std::endl;
+    } else if (verbose_ && stats.fromSlot < latest.size()) {
+        const HourlyForecast& from = latest[stats.fromSlot];
+        std::cout << "Re-solved " << stats.resolvedSlots << " slots from " << from.hour
+                  << (from.minute < 10 ? ":0" : ":") << from.minute
+                  << (stats.stateDiverged ? " (measured state off the plan)" : "") << std::endl;
+    }
+
+    size_t first = std::min(planner_.getStartSlot(), latest.size());
+    return makeSchedule(std::vector<HourlyForecast>(latest.begin() + first, latest.end()));
+}
+
+DayAheadSchedule DayAheadOptimizer::makeSchedule(const std::vector<HourlyForecast>& forecasts) const {
+    const ScheduleProblem& problem = planner_.getProblem();
+    const ScheduleSolution& solution = planner_.getPlan();
+    std::vector<std::shared_ptr<Appliance>> loads;
+    if (deferrableController_) {
+        loads = deferrableController_->getDeferrableLoads();
+    }
+
+    int startMinute = forecasts.empty() ? 0 : forecasts[0].hour * TimeSlots::MINUTES_PER_HOUR + forecasts[0].minute;
+    size_t perSlot = problem.devices.size() + 1 + loads.size();
+    DayAheadSchedule schedule(startMinute, TimeSlots::minutes(slotLength_), forecasts.size(),
+                              forecasts.size() * perSlot);
+
+    // Devices in problem order, then the battery
+    std::vector<ApplianceHandle> devices;
+    for (const auto& device : problem.devices) {
+        devices.push_back(schedule.internAppliance(device.id));
+    }
+    if (problem.battery.capacityKwh > 0.0) {
+        devices.push_back(schedule.internAppliance("battery"));
+    }
+    std::vector<ApplianceHandle> deferrable;
+    for (const auto& load : loads) {
+        deferrable.push_back(schedule.internAppliance(load->getId()));
+    }
+
+    std::vector<std::vector<double>> temps(problem.devices.size());
+    if (solution.feasible) {
+        for (size_t d = 0; d < problem.devices.size(); d++) {
+            if (problem.devices[d].thermal) {
+                temps[d] = ScheduleSolver::simulateTemperature(problem, problem.devices[d], solution.powerKw[d]);
+            }
+        }
+    } else if (verbose_) {
+        std::cerr << "Schedule solver '" << solver_->getName()
+                  << "' found no plan within the import limit" << std::endl;
+    }
+
+    double consumption = 0.0;
+    for (size_t slot = 0; slot < forecasts.size(); slot++) {
+        if (solution.feasible) {
+            consumption += addDeviceActions(slot, forecasts[slot], temps, devices, schedule);
+        }
+        addDeferrableActions(slot, forecasts[slot], deferrable, schedule);
+    }
+    schedule.setEstimates(solution.feasible ? solution.cost - solution.comfortCost : 0.0, consumption);
+
+    if (!verbose_) {
+        return schedule;
+    }
+    std::cout << "Solver: " << solver_->getName() << ", " << solution.solveMs << " ms, "
+              << solution.nodes << " nodes, " << solution.columns << " plans"
+              << (solution.optimal ? " (optimal)" : "")
+              << ", lower bound $" << solution.lowerBound << std::endl;
+    std::cout << "Schedule generated: " << schedule.getActionCount() << " actions" << std::endl;
+    std::cout << "Estimated daily cost: $" << schedule.getEstimatedCost() << std::endl;
+    if (solution.comfortCost > 0.0) {
+        std::cout << "Comfort band missed: $" << solution.comfortCost << " penalty" << std::endl;
+    }
+    std::cout << "Estimated consumption: " << schedule.getEstimatedConsumption() << " kWh" << std::endl;
 
     return schedule;
 }
 
 void DayAheadOptimizer::printSchedule(const DayAheadSchedule& schedule) {
     std::cout << "\n=== Day-Ahead Schedule ===" << std::endl;
-    std::cout << "Total estimated cost: $" << schedule.estimatedCost << std::endl;
-    std::cout << "Total estimated consumption: " << schedule.estimatedConsumption << " kWh\n" << std::endl;
+    std::cout << "Total estimated cost: $" << schedule.getEstimatedCost() << std::endl;
+    std::cout << "Total estimated consumption: " << schedule.getEstimatedConsumption() << " kWh\n" << std::endl;
 
-    for (int hour = 0; hour < 24; hour++) {
-        auto actions = schedule.getActionsForHour(hour);
+    for (size_t slot = 0; slot < schedule.getSlotCount(); slot++) {
+        auto actions = schedule.getActionsForSlot(slot);
         if (!actions.empty()) {
-            std::cout << "Hour " << hour << ":00" << std::endl;
+            std::cout << "Slot " << schedule.getSlotLabel(slot) << std::endl;
             for (const auto& action : actions) {
-                std::cout << "  - " << action.applianceId << ": " << action.action;
+                std::cout << "  - " << schedule.getApplianceId(action.appliance) << ": " << toString(action.type);
                 if (action.value != 0.0) {
                     std::cout << " (" << action.value << ")";
                 }
-                std::cout << " - " << action.reason << std::endl;
+                std::cout << " - " << schedule.formatReason(action) << std::endl;
             }
         }
     }
     std::cout << "=========================\n" << std::endl;
 }
 
-std::vector<int> DayAheadOptimizer::findBestEVChargingHours(const std::vector<HourlyForecast>& forecasts) {
-    // Score each hour for EV charging
-    struct HourScore {
-        int hour;
-        double score;
-    };
-    
-    std::vector<HourScore> scores;
+ScheduleProblem DayAheadOptimizer::buildProblem(const std::vector<HourlyForecast>& forecasts) const {
+    ScheduleProblem problem;
+    problem.slotHours = TimeSlots::hours(slotLength_);
+    problem.importLimitKw = importLimitKw_;
+    problem.battery = battery_;
     for (const auto& forecast : forecasts) {
-        HourScore hs;
-        hs.hour = forecast.hour;
-        
-        // Lower cost is better, higher solar is better
-        hs.score = -forecast.predictedEnergyCost + (forecast.predictedSolarProduction * 0.1);
-        
-        scores.push_back(hs);
+        problem.prices.push_back(forecast.predictedEnergyCost);
+        problem.solarKw.push_back(forecast.predictedSolarProduction);
+        problem.outdoorTemp.push_back(forecast.predictedOutdoorTemp);
     }
-    
-    // Sort by score (best first)
-    std::sort(scores.begin(), scores.end(), 
-              [](const HourScore& a, const HourScore& b) { return a.score > b.score; });
-    
-    // Select top N hours
-    std::vector<int> bestHours;
-    for (int i = 0; i < std::min(evChargingHoursNeeded_, (int)scores.size()); i++) {
-        bestHours.push_back(scores[i].hour);
+
+    for (EVCharger* evCharger : appliances_.getEVChargers()) {
+        ScheduleDevice device;
+        device.id = evCharger->getId();
+        device.maxPowerKw = evCharger->getMaxChargePower();
+        double horizonHours = forecasts.size() * problem.slotHours;
+        device.energyKwh = std::min<double>(evChargingHoursNeeded_, horizonHours) * device.maxPowerKw;
+        problem.devices.push_back(device);
     }
-    
-    return bestHours;
+
+    // A heater cannot cool nor an air conditioner heat, so the side a device
+    // cannot hold is opened up to where the outdoors can drag the room
+    double coldest = targetIndoorTemp_ - 1.0;
+    double warmest = targetIndoorTemp_ + 1.0;
+    for (double outdoor : problem.outdoorTemp) {
+        coldest = std::min(coldest, outdoor);
+        warmest = std::max(warmest, outdoor);
+    }
+    auto addThermal = [&](const Appliance& appliance, double degreesPerKwh) {
+        ScheduleDevice device;
+        device.id = appliance.getId();
+        device.maxPowerKw = appliance.getPowerConsumption();
+        device.thermal = true;
+        device.initialTemp = targetIndoorTemp_;
+        device.minTemp = degreesPerKwh > 0.0 ? targetIndoorTemp_ - 1.0 : coldest;
+        device.maxTemp = degreesPerKwh > 0.0 ? warmest : targetIndoorTemp_ + 1.0;
+        device.degreesPerKwh = degreesPerKwh;
+        device.lossPerHour = lossPerHour_;
+        device.comfortPenalty = comfortPenalty_;
+        problem.devices.push_back(device);
+    };
+    for (Heater* heater : appliances_.getHeaters()) {
+        addThermal(*heater, degreesPerKwh_);
+    }
+    for (AirConditioner* ac : appliances_.getAirConditioners()) {
+        addThermal(*ac, -degreesPerKwh_);
+    }
+    return problem;
 }
 
-void DayAheadOptimizer::optimizeHour(const HourlyForecast& forecast, 
-                  const std::vector<int>& bestEVHours,
-                  DayAheadSchedule& schedule) {
-    int hour = forecast.hour;
+double DayAheadOptimizer::addDeviceActions(size_t slot, const HourlyForecast& forecast,
+                                           const std::vector<std::vector<double>>& temps,
+                                           const std::vector<ApplianceHandle>& devices,
+                                           DayAheadSchedule& schedule) const {
+    const ScheduleProblem& problem = planner_.getProblem();
+    const ScheduleSolution& solution = planner_.getPlan();
     double cost = forecast.predictedEnergyCost;
-    double solar = forecast.predictedSolarProduction;
-    
-    // Deferrable load optimization - NEW FEATURE
-    if (deferrableController_) {
-        auto deferrableLoads = deferrableController_->getDeferrableLoads();
-        for (const auto& load : deferrableLoads) {
-            if (cost > highCostThreshold_) {
-                schedule.addAction(hour, load->getId(), "off", 0,
-                                 "Deferrable load - switched off during high price ($" + 
-                                 std::to_string(cost) + "/kWh)");
+    double energy = 0.0;
+
+    for (size_t d = 0; d < problem.devices.size(); d++) {
+        const ScheduleDevice& device = problem.devices[d];
+        double power = solution.powerKw[d][slot];
+        bool active = power > ACTIVE_KW;
+        energy += power * problem.slotHours;
+
+        if (!device.thermal) {
+            if (active) {
+                schedule.addAction(slot, devices[d], ActionType::CHARGE, power, ActionReason::PLANNED_CHARGE,
+                                   cost, forecast.predictedSolarProduction);
             } else {
-                schedule.addAction(hour, load->getId(), "on", 0,
-                                 "Deferrable load - allowed during optimal price ($" + 
-                                 std::to_string(cost) + "/kWh)");
+                schedule.addAction(slot, devices[d], ActionType::DEFER, 0, ActionReason::CHARGE_DEFERRED, cost);
             }
+            continue;
         }
-    }
-    
-    // EV Charging optimization
-    for (auto& appliance : appliances_) {
-        auto evCharger = std::dynamic_pointer_cast<EVCharger>(appliance);
-        if (evCharger) {
-            bool shouldCharge = std::find(bestEVHours.begin(), bestEVHours.end(), hour) 
-                               != bestEVHours.end();
-            
-            if (shouldCharge) {
-                std::string reason = "Low cost ($" + std::to_string(cost) + "/kWh)";
-                if (solar > 5.0) {
-                    reason += ", high solar (" + std::to_string(solar) + " kW)";
-                }
-                schedule.addAction(hour, evCharger->getId(), "charge", 
-                                 evCharger->getMaxChargePower(), reason);
-                schedule.estimatedConsumption += evCharger->getMaxChargePower();
-                schedule.estimatedCost += evCharger->getMaxChargePower() * cost;
-            } else {
-                schedule.addAction(hour, evCharger->getId(), "defer", 0, 
-                                 "Not optimal hour for charging");
-            }
+
+        bool heating = device.degreesPerKwh > 0.0;
+        if (active) {
+            schedule.addAction(slot, devices[d], ActionType::ON, power,
+                               heating ? ActionReason::HEATING : ActionReason::COOLING, cost, temps[d][slot]);
+        } else {
+            schedule.addAction(slot, devices[d], ActionType::OFF, 0,
+                               heating ? ActionReason::NO_HEATING_NEEDED : ActionReason::NO_COOLING_NEEDED, cost);
         }
     }
 
-    // Temperature control optimization
-    // Preheat/precool during low-cost hours
-    if (cost < lowCostThreshold_) {
-        for (auto& appliance : appliances_) {
-            auto heater = std::dynamic_pointer_cast<Heater>(appliance);
-            if (heater) {
-                schedule.addAction(hour, heater->getId(), "on", targetIndoorTemp_ + 1.0,
-                                 "Preheat during low cost");
-                schedule.estimatedConsumption += heater->getPowerConsumption();
-                schedule.estimatedCost += heater->getPowerConsumption() * cost;
-            }
+    if (problem.battery.capacityKwh > 0.0) {
+        double power = solution.batteryKw[slot];
+        ApplianceHandle battery = devices.back();
+        if (power > ACTIVE_KW) {
+            schedule.addAction(slot, battery, ActionType::CHARGE, power, ActionReason::BATTERY_CHARGE, cost);
+        } else if (power < -ACTIVE_KW) {
+            schedule.addAction(slot, battery, ActionType::DISCHARGE, -power, ActionReason::BATTERY_DISCHARGE, cost);
         }
-    } else if (cost > highCostThreshold_) {
-        // Minimize HVAC during high cost
-        for (auto& appliance : appliances_) {
-            auto heater = std::dynamic_pointer_cast<Heater>(appliance);
-            auto ac = std::dynamic_pointer_cast<AirConditioner>(appliance);
-            if (heater) {
-                schedule.addAction(hour, heater->getId(), "minimize", 0,
-                                 "Reduce heating during high cost");
-            } else if (ac) {
-                schedule.addAction(hour, ac->getId(), "minimize", 0,
-                                 "Reduce cooling during high cost");
-            }
+    }
+    return energy;
+}
+
+void DayAheadOptimizer::addDeferrableActions(size_t slot, const HourlyForecast& forecast,
+                                             const std::vector<ApplianceHandle>& loads,
+                                             DayAheadSchedule& schedule) const {
+    double cost = forecast.predictedEnergyCost;
+    for (ApplianceHandle load : loads) {
+        if (cost > highCostThreshold_) {
+            schedule.addAction(slot, load, ActionType::OFF, 0, ActionReason::DEFERRABLE_OFF, cost);
+        } else {
+            schedule.addAction(slot, load, ActionType::ON, 0, ActionReason::DEFERRABLE_ON, cost);
         }
     }
 }
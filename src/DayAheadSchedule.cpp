@@ -0,0 +1,159 @@
+#include "DayAheadSchedule.h"
+#include "TimeSlots.h"
+
+const char* toString(ActionType type) {
+    switch (type) {
+        case ActionType::ON: return "on";
+        case ActionType::OFF: return "off";
+        case ActionType::CHARGE: return "charge";
+        case ActionType::DISCHARGE: return "discharge";
+        case ActionType::DEFER: return "defer";
+    }
+    return "unknown";
+}
+
+DayAheadSchedule::DayAheadSchedule() : DayAheadSchedule(0, TimeSlots::MINUTES_PER_HOUR, 0) {}
+
+DayAheadSchedule::DayAheadSchedule(int startMinute, int slotMinutes, size_t slotCount, size_t expectedActions)
+    : offsets_(slotCount + 1, 0),
+      lastSlot_(0),
+      slotCount_(slotCount),
+      startMinute_(startMinute),
+      slotMinutes_(slotMinutes > 0 ? slotMinutes : TimeSlots::MINUTES_PER_HOUR),
+      estimatedCost_(0.0),
+      estimatedConsumption_(0.0) {
+    actions_.reserve(expectedActions);
+}
+
+ApplianceHandle DayAheadSchedule::internAppliance(const std::string& applianceId) {
+    auto it = applianceHandles_.find(applianceId);
+    if (it != applianceHandles_.end()) {
+        return it->second;
+    }
+    ApplianceHandle handle = static_cast<ApplianceHandle>(applianceIds_.size());
+    applianceIds_.push_back(applianceId);
+    applianceHandles_[applianceId] = handle;
+    return handle;
+}
+
+const std::string& DayAheadSchedule::getApplianceId(ApplianceHandle appliance) const {
+    return applianceIds_[appliance];
+}
+
+bool DayAheadSchedule::addAction(size_t slot, ApplianceHandle appliance, ActionType type, double value,
+                                 ActionReason reason, double price, double detail) {
+    if (slot >= slotCount_ || slot < lastSlot_) {
+        return false;
+    }
+    while (lastSlot_ < slot) {
+        offsets_[++lastSlot_] = actions_.size();
+    }
+
+    ScheduledAction action;
+    action.appliance = appliance;
+    action.type = type;
+    action.reason = reason;
+    action.price = static_cast<float>(price);
+    action.detail = static_cast<float>(detail);
+    action.value = value;
+    actions_.push_back(action);
+    return true;
+}
+
+size_t DayAheadSchedule::getSlotCount() const {
+    return slotCount_;
+}
+
+int DayAheadSchedule::getSlotMinutes() const {
+    return slotMinutes_;
+}
+
+int DayAheadSchedule::getSlotHour(size_t slot) const {
+    if (slot >= slotCount_) {
+        return -1;
+    }
+    int start = (startMinute_ + static_cast<int>(slot) * slotMinutes_) % TimeSlots::MINUTES_PER_DAY;
+    return start / TimeSlots::MINUTES_PER_HOUR;
+}
+
+int DayAheadSchedule::getSlotMinute(size_t slot) const {
+    if (slot >= slotCount_) {
+        return -1;
+    }
+    return (startMinute_ + static_cast<int>(slot) * slotMinutes_) % TimeSlots::MINUTES_PER_HOUR;
+}
+
+std::string DayAheadSchedule::getSlotLabel(size_t slot) const {
+    int minute = getSlotMinute(slot);
+    return std::to_string(getSlotHour(slot)) + (minute < 10 ? ":0" : ":") + std::to_string(minute);
+}
+
+size_t DayAheadSchedule::getActionCount() const {
+    return actions_.size();
+}
+
+ActionSpan DayAheadSchedule::getActionsForSlot(size_t slot) const {
+    // Slots past the one being filled have no actions yet
+    if (slot >= slotCount_ || slot > lastSlot_) {
+        return ActionSpan();
+    }
+    size_t end = slot < lastSlot_ ? offsets_[slot + 1] : actions_.size();
+    return ActionSpan(actions_.data() + offsets_[slot], actions_.data() + end);
+}
+
+ActionSpan DayAheadSchedule::getActionsAt(int hour, int minute) const {
+    int time = hour * TimeSlots::MINUTES_PER_HOUR + minute;
+    if (hour < 0 || minute < 0 || time >= TimeSlots::MINUTES_PER_DAY) {
+        return ActionSpan();
+    }
+    // Minutes since the schedule started, wrapping past midnight
+    int offset = (time - startMinute_ + TimeSlots::MINUTES_PER_DAY) % TimeSlots::MINUTES_PER_DAY;
+    return getActionsForSlot(static_cast<size_t>(offset / slotMinutes_));
+}
+
+ActionSpan DayAheadSchedule::getActionsForHour(int hour) const {
+    return getActionsAt(hour, 0);
+}
+
+std::string DayAheadSchedule::formatReason(const ScheduledAction& action) const {
+    std::string price = "$" + std::to_string(action.price) + "/kWh";
+    switch (action.reason) {
+        case ActionReason::PLANNED_CHARGE:
+            if (action.detail > 5.0f) {
+                return "Planned at " + price + ", high solar (" + std::to_string(action.detail) + " kW)";
+            }
+            return "Planned at " + price;
+        case ActionReason::CHARGE_DEFERRED:
+            return "Cheaper hours cover the charging target";
+        case ActionReason::HEATING:
+            return "Indoor " + std::to_string(action.detail) + "°C, heating at " + price;
+        case ActionReason::COOLING:
+            return "Indoor " + std::to_string(action.detail) + "°C, cooling at " + price;
+        case ActionReason::NO_HEATING_NEEDED:
+            return "Comfort band holds without heating";
+        case ActionReason::NO_COOLING_NEEDED:
+            return "Comfort band holds without cooling";
+        case ActionReason::BATTERY_CHARGE:
+            return "Store energy at " + price;
+        case ActionReason::BATTERY_DISCHARGE:
+            return "Cover load at " + price;
+        case ActionReason::DEFERRABLE_OFF:
+            return "Deferrable load - switched off during high price (" + price + ")";
+        case ActionReason::DEFERRABLE_ON:
+            return "Deferrable load - allowed during optimal price (" + price + ")";
+    }
+    return "";
+}
+
+void DayAheadSchedule::setEstimates(double cost, double consumptionKwh) {
+    estimatedCost_ = cost;
+    estimatedConsumption_ = consumptionKwh;
+}
+
+double DayAheadSchedule::getEstimatedCost() const {
+    return estimatedCost_;
+}
+
+double DayAheadSchedule::getEstimatedConsumption() const {
+    return estimatedConsumption_;
+}
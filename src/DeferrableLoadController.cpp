@@ -1,11 +1,22 @@
 #include "DeferrableLoadController.h"
 #include <algorithm>
-#include <numeric>
+
+const std::vector<std::string>& DayAheadRecommendations::at(int hour, int minute) const {
+    static const std::vector<std::string> none;
+    size_t slot = TimeSlots::slotOfDay(slotLength, hour, minute);
+    return hour >= 0 && minute >= 0 && slot < bySlot.size() ? bySlot[slot] : none;
+}
+
+size_t DayAheadRecommendations::getSlotCount() const {
+    return static_cast<size_t>(std::count_if(bySlot.begin(), bySlot.end(),
+                                             [](const std::vector<std::string>& slot) { return !slot.empty(); }));
+}
 
 DeferrableLoadController::DeferrableLoadController(std::shared_ptr<MLPredictor> predictor)
     : predictor_(predictor),
       priceThreshold_(DeferrableLoadDefaults::DEFAULT_PRICE_THRESHOLD),
-      busyHourThreshold_(DeferrableLoadDefaults::DEFAULT_BUSY_HOUR_THRESHOLD) {
+      busyHourThreshold_(DeferrableLoadDefaults::DEFAULT_BUSY_HOUR_THRESHOLD),
+      slotLength_(SlotLength::ONE_HOUR) {
 }
 
 void DeferrableLoadController::setPriceThreshold(double threshold) {
@@ -16,6 +27,10 @@ void DeferrableLoadController::setBusyHourThreshold(double threshold) {
     busyHourThreshold_ = threshold;
 }
 
+void DeferrableLoadController::setSlotLength(SlotLength length) {
+    slotLength_ = length;
+}
+
 void DeferrableLoadController::addDeferrableLoad(std::shared_ptr<Appliance> appliance) {
     if (appliance && appliance->isDeferrable()) {
         deferrableLoads_.push_back(appliance);
@@ -23,6 +38,13 @@ void DeferrableLoadController::addDeferrableLoad(std::shared_ptr<Appliance> appl
     }
 }
 
+void DeferrableLoadController::setCommandDispatcher(std::shared_ptr<CommandDispatcher> dispatcher,
+                                                    const std::string& transport, const std::string& entityPrefix) {
+    commandDispatcher_ = dispatcher;
+    commandTransport_ = transport;
+    entityPrefix_ = entityPrefix;
+}
+
 BusyHourAnalysis DeferrableLoadController::analyzeBusyHours(
     const std::vector<HistoricalDataPoint>& historicalData) {
     
@@ -35,12 +57,8 @@ BusyHourAnalysis DeferrableLoadController::analyzeBusyHours(
         return analysis;
     }
     
-    // Calculate average price per hour of day
-    std::map<int, std::vector<double>> hourlyPrices;
-    
-    for (const auto& dataPoint : historicalData) {
-        hourlyPrices[dataPoint.hour].push_back(dataPoint.energyCost);
-    }
+    // Calculate average price per hour of day in a single pass
+    HistoricalAggregates stats = HistoricalDataset(historicalData).aggregate();
     
     // Calculate average and identify busy hours
     double totalPeakPrice = 0.0;
@@ -49,11 +67,9 @@ BusyHourAnalysis DeferrableLoadController::analyzeBusyHours(
     int offPeakCount = 0;
     
     for (int hour = 0; hour < 24; hour++) {
-        if (hourlyPrices[hour].empty()) continue;
+        if (stats.hourly[hour].count == 0.0) continue;
         
-        double avgPrice = std::accumulate(hourlyPrices[hour].begin(), 
-                                         hourlyPrices[hour].end(), 0.0) 
-                         / hourlyPrices[hour].size();
+        double avgPrice = stats.hourly[hour].cost.mean;
         
         if (avgPrice > busyHourThreshold_) {
             analysis.busyHours.push_back(hour);
@@ -88,45 +104,42 @@ void DeferrableLoadController::controlLoadsByPrice(double currentPrice) {
     }
 }
 
-std::map<int, std::vector<std::string>> DeferrableLoadController::getDayAheadRecommendations(
-    int currentHour, int currentDayOfWeek) {
+DayAheadRecommendations DeferrableLoadController::getDayAheadRecommendations(
+    int currentHour, int currentDayOfWeek, int currentMinute) {
     
     std::cout << "\n=== Generating Day-Ahead Recommendations for Deferrable Loads ===" << std::endl;
     
-    std::map<int, std::vector<std::string>> recommendations;
-    
-    // Get ML predictions for next 24 hours
-    auto forecasts = predictor_->predictNext24Hours(currentHour, currentDayOfWeek);
+    DayAheadRecommendations recommendations;
+    recommendations.slotLength = slotLength_;
+    recommendations.bySlot.resize(TimeSlots::slotsPerDay(slotLength_));
     
-    // Identify busy hours
-    auto busyHours = identifyBusyHours(forecasts);
+    // Get ML predictions for the slots of the next 24 hours
+    auto forecasts = predictor_->predictNextDay(slotLength_, currentHour, currentDayOfWeek, currentMinute);
     
     for (const auto& forecast : forecasts) {
-        bool isBusy = std::find(busyHours.begin(), busyHours.end(), forecast.hour) 
-                     != busyHours.end();
+        // A slot is busy when its forecast price is above the busy threshold
+        bool isBusy = forecast.predictedEnergyCost > busyHourThreshold_;
         
-        std::vector<std::string> hourRecommendations;
+        std::vector<std::string>& slotRecommendations =
+            recommendations.bySlot[TimeSlots::slotOfDay(slotLength_, forecast.hour, forecast.minute)];
+        slotRecommendations.reserve(deferrableLoads_.size());
         
         if (isBusy) {
             for (const auto& load : deferrableLoads_) {
                 std::string rec = load->getName() + ": Switch OFF (busy hour, price: $" 
                                 + std::to_string(forecast.predictedEnergyCost) + "/kWh)";
-                hourRecommendations.push_back(rec);
+                slotRecommendations.push_back(rec);
             }
         } else {
             for (const auto& load : deferrableLoads_) {
                 std::string rec = load->getName() + ": Can operate (optimal hour, price: $" 
                                 + std::to_string(forecast.predictedEnergyCost) + "/kWh)";
-                hourRecommendations.push_back(rec);
+                slotRecommendations.push_back(rec);
             }
         }
-        
-        if (!hourRecommendations.empty()) {
-            recommendations[forecast.hour] = hourRecommendations;
-        }
     }
     
-    std::cout << "Generated recommendations for " << recommendations.size() << " hours" << std::endl;
+    std::cout << "Generated recommendations for " << recommendations.getSlotCount() << " slots" << std::endl;
     
     return recommendations;
 }
@@ -139,6 +152,7 @@ void DeferrableLoadController::switchOffAllDeferrableLoads(const std::string& re
             // Save previous state for potential resume
             previousStates_[load->getId()] = true;
             load->turnOff();
+            sendCommand(*load, "OFF");
             std::cout << "  - " << load->getName() << " switched OFF" << std::endl;
         }
     }
@@ -151,6 +165,7 @@ void DeferrableLoadController::resumeDeferrableLoads() {
         // Only resume if it was on before
         if (previousStates_[load->getId()] && !load->isOn()) {
             load->turnOn();
+            sendCommand(*load, "ON");
             std::cout << "  - " << load->getName() << " resumed" << std::endl;
         }
     }
@@ -164,16 +179,16 @@ bool DeferrableLoadController::isHighPriceHour(double price) const {
     return price > priceThreshold_;
 }
 
-std::vector<int> DeferrableLoadController::identifyBusyHours(
-    const std::vector<HourlyForecast>& forecasts) {
-    
-    std::vector<int> busyHours;
-    
-    for (const auto& forecast : forecasts) {
-        if (forecast.predictedEnergyCost > busyHourThreshold_) {
-            busyHours.push_back(forecast.hour);
-        }
+void DeferrableLoadController::sendCommand(const Appliance& appliance, const std::string& command) {
+    if (!commandDispatcher_) {
+        return;
     }
     
-    return busyHours;
+    // Queued, so a burst of decisions never waits on Home Assistant
+    DeviceCommand deviceCommand;
+    deviceCommand.transport = commandTransport_;
+    deviceCommand.deviceId = entityPrefix_ + appliance.getId();
+    deviceCommand.command = command;
+    deviceCommand.priority = CommandPriority::ECONOMY;
+    commandDispatcher_->submit(deviceCommand);
 }
@@ -5,8 +5,8 @@ EVChargerSensor::EVChargerSensor(const std::string& id, const std::string& name)
 
 void EVChargerSensor::update() {
     Event event(EventType::EV_CHARGER_STATUS, id_);
-    event.addData("is_charging", isCharging_ ? 1.0 : 0.0);
-    event.addData("charge_power_kw", chargePower_);
+    event.addData(EventKey::IS_CHARGING, isCharging_ ? 1.0 : 0.0);
+    event.addData(EventKey::CHARGE_POWER_KW, chargePower_);
     publishEvent(event);
 }
 
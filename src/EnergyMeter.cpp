@@ -5,7 +5,7 @@ EnergyMeter::EnergyMeter(const std::string& id, const std::string& name)
 
 void EnergyMeter::update() {
     Event event(EventType::ENERGY_CONSUMPTION_UPDATE, id_);
-    event.addData("consumption_kw", currentConsumption_);
+    event.addData(EventKey::CONSUMPTION_KW, currentConsumption_);
     publishEvent(event);
 }
 
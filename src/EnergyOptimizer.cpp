@@ -9,13 +9,15 @@ EnergyOptimizer::EnergyOptimizer(std::shared_ptr<HTTPClient> httpClient)
       energyConsumption_(0.0),
       targetIndoorTemp_(22.0),
       highCostThreshold_(0.15),
-      lowCostThreshold_(0.10) {
+      lowCostThreshold_(0.10),
+      pendingUpdates_(false),
+      optimizationRuns_(0) {
     
     subscribeToEvents();
 }
 
 void EnergyOptimizer::addAppliance(std::shared_ptr<Appliance> appliance) {
-    appliances_.push_back(appliance);
+    appliances_.add(appliance);
 }
 
 void EnergyOptimizer::setTargetTemperature(double temp) {
@@ -23,9 +25,13 @@ void EnergyOptimizer::setTargetTemperature(double temp) {
 }
 
 void EnergyOptimizer::updateEnergyCost() {
-    currentEnergyCost_ = httpClient_->getCurrentEnergyCost();
+    double cost = httpClient_->getCurrentEnergyCost();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        currentEnergyCost_ = cost;
+    }
     Event event(EventType::ENERGY_COST_UPDATE, "energy_optimizer");
-    event.addData("cost_per_kwh", currentEnergyCost_);
+    event.addData(EventKey::COST_PER_KWH, cost);
     EventManager::getInstance().publish(event);
     
     // Re-evaluate decisions based on new cost
@@ -33,6 +39,9 @@ void EnergyOptimizer::updateEnergyCost() {
 }
 
 void EnergyOptimizer::optimizeEnergyUsage() {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    optimizationRuns_++;
+
     std::cout << "=== Energy Optimization Cycle ===" << std::endl;
     std::cout << "Current Energy Cost: $" << currentEnergyCost_ << "/kWh" << std::endl;
     std::cout << "Indoor Temperature: " << indoorTemp_ << "°C" << std::endl;
@@ -55,53 +64,67 @@ void EnergyOptimizer::optimizeEnergyUsage() {
     std::cout << "=================================" << std::endl << std::endl;
 }
 
+bool EnergyOptimizer::processPendingUpdates() {
+    if (!pendingUpdates_.exchange(false)) {
+        return false;
+    }
+    optimizeEnergyUsage();
+    return true;
+}
+
+size_t EnergyOptimizer::getOptimizationRunCount() const {
+    return optimizationRuns_.load();
+}
+
 void EnergyOptimizer::subscribeToEvents() {
     auto& eventMgr = EventManager::getInstance();
 
-    eventMgr.subscribe(EventType::TEMPERATURE_CHANGE, 
-        [this](const Event& e) {
-            double temp = e.getData("temperature");
-            int location = static_cast<int>(e.getData("location"));
-            if (location == 0) { // Indoor
-                indoorTemp_ = temp;
-            } else { // Outdoor
-                outdoorTemp_ = temp;
+    // Temperature and solar updates only record the newest readings; the next
+    // processPendingUpdates() runs one pass for the whole burst, whether the
+    // events were delivered synchronously or as an async batch
+    eventMgr.subscribeBatch({EventType::TEMPERATURE_CHANGE, EventType::SOLAR_PRODUCTION_UPDATE},
+        [this](const std::vector<Event>& events) {
+            std::lock_guard<std::mutex> lock(stateMutex_);
+            for (const auto& e : events) {
+                if (e.type == EventType::TEMPERATURE_CHANGE) {
+                    double temp = e.getData(EventKey::TEMPERATURE);
+                    int location = static_cast<int>(e.getData(EventKey::LOCATION));
+                    if (location == 0) { // Indoor
+                        indoorTemp_ = temp;
+                    } else { // Outdoor
+                        outdoorTemp_ = temp;
+                    }
+                } else {
+                    solarProduction_ = e.getData(EventKey::PRODUCTION_KW);
+                }
             }
-            optimizeEnergyUsage();
-        });
-
-    eventMgr.subscribe(EventType::SOLAR_PRODUCTION_UPDATE,
-        [this](const Event& e) {
-            solarProduction_ = e.getData("production_kw");
-            optimizeEnergyUsage();
+            pendingUpdates_ = true;
         });
 
     eventMgr.subscribe(EventType::ENERGY_CONSUMPTION_UPDATE,
         [this](const Event& e) {
-            energyConsumption_ = e.getData("consumption_kw");
+            std::lock_guard<std::mutex> lock(stateMutex_);
+            energyConsumption_ = e.getData(EventKey::CONSUMPTION_KW);
         });
 }
 
 void EnergyOptimizer::optimizeEVCharging() {
-    for (auto& appliance : appliances_) {
-        auto evCharger = std::dynamic_pointer_cast<EVCharger>(appliance);
-        if (evCharger) {
-            // Stop charging if cost is high and solar production is low
-            if (currentEnergyCost_ > highCostThreshold_ && 
-                solarProduction_ < evCharger->getChargePower()) {
-                if (evCharger->isOn()) {
-                    std::cout << "Stopping EV charging: High energy cost ($" 
-                              << currentEnergyCost_ << "/kWh)" << std::endl;
-                    evCharger->turnOff();
-                }
-            } 
-            // Resume charging if cost is low or solar production is sufficient
-            else if (currentEnergyCost_ <= lowCostThreshold_ || 
-                     solarProduction_ >= evCharger->getChargePower()) {
-                if (!evCharger->isOn()) {
-                    std::cout << "Resuming EV charging: Favorable conditions" << std::endl;
-                    evCharger->turnOn();
-                }
+    for (EVCharger* evCharger : appliances_.getEVChargers()) {
+        // Stop charging if cost is high and solar production is low
+        if (currentEnergyCost_ > highCostThreshold_ && 
+            solarProduction_ < evCharger->getChargePower()) {
+            if (evCharger->isOn()) {
+                std::cout << "Stopping EV charging: High energy cost ($" 
+                          << currentEnergyCost_ << "/kWh)" << std::endl;
+                evCharger->turnOff();
+            }
+        } 
+        // Resume charging if cost is low or solar production is sufficient
+        else if (currentEnergyCost_ <= lowCostThreshold_ || 
+                 solarProduction_ >= evCharger->getChargePower()) {
+            if (!evCharger->isOn()) {
+                std::cout << "Resuming EV charging: Favorable conditions" << std::endl;
+                evCharger->turnOn();
             }
         }
     }
@@ -110,44 +133,40 @@ void EnergyOptimizer::optimizeEVCharging() {
 void EnergyOptimizer::optimizeTemperatureControl() {
     double tempDiff = targetIndoorTemp_ - indoorTemp_;
     
-    for (auto& appliance : appliances_) {
-        auto heater = std::dynamic_pointer_cast<Heater>(appliance);
-        if (heater) {
-            // Turn on heater if too cold
-            if (tempDiff > 2.0) {
-                if (!heater->isOn()) {
-                    std::cout << "Turning on heater: Temperature " << tempDiff 
-                              << "°C below target" << std::endl;
-                    heater->turnOn();
-                }
-            } 
-            // Turn off heater if temperature is acceptable or cost is too high
-            else if (tempDiff < 0.5 || 
-                     (currentEnergyCost_ > highCostThreshold_ && tempDiff < 1.5)) {
-                if (heater->isOn()) {
-                    std::cout << "Turning off heater: Target reached or high cost" << std::endl;
-                    heater->turnOff();
-                }
+    for (Heater* heater : appliances_.getHeaters()) {
+        // Turn on heater if too cold
+        if (tempDiff > 2.0) {
+            if (!heater->isOn()) {
+                std::cout << "Turning on heater: Temperature " << tempDiff 
+                          << "°C below target" << std::endl;
+                heater->turnOn();
+            }
+        } 
+        // Turn off heater if temperature is acceptable or cost is too high
+        else if (tempDiff < 0.5 || 
+                 (currentEnergyCost_ > highCostThreshold_ && tempDiff < 1.5)) {
+            if (heater->isOn()) {
+                std::cout << "Turning off heater: Target reached or high cost" << std::endl;
+                heater->turnOff();
             }
         }
+    }
 
-        auto ac = std::dynamic_pointer_cast<AirConditioner>(appliance);
-        if (ac) {
-            // Turn on AC if too hot
-            if (tempDiff < -2.0) {
-                if (!ac->isOn()) {
-                    std::cout << "Turning on AC: Temperature " << (-tempDiff) 
-                              << "°C above target" << std::endl;
-                    ac->turnOn();
-                }
+    for (AirConditioner* ac : appliances_.getAirConditioners()) {
+        // Turn on AC if too hot
+        if (tempDiff < -2.0) {
+            if (!ac->isOn()) {
+                std::cout << "Turning on AC: Temperature " << (-tempDiff) 
+                          << "°C above target" << std::endl;
+                ac->turnOn();
             }
-            // Turn off AC if temperature is acceptable or cost is too high
-            else if (tempDiff > -0.5 || 
-                     (currentEnergyCost_ > highCostThreshold_ && tempDiff > -1.5)) {
-                if (ac->isOn()) {
-                    std::cout << "Turning off AC: Target reached or high cost" << std::endl;
-                    ac->turnOff();
-                }
+        }
+        // Turn off AC if temperature is acceptable or cost is too high
+        else if (tempDiff > -0.5 || 
+                 (currentEnergyCost_ > highCostThreshold_ && tempDiff > -1.5)) {
+            if (ac->isOn()) {
+                std::cout << "Turning off AC: Target reached or high cost" << std::endl;
+                ac->turnOff();
             }
         }
     }
@@ -155,37 +174,33 @@ void EnergyOptimizer::optimizeTemperatureControl() {
 
 void EnergyOptimizer::optimizeLighting() {
     // Simple optimization: dim lights when solar production is low and cost is high
-    for (auto& appliance : appliances_) {
-        auto light = std::dynamic_pointer_cast<Light>(appliance);
-        if (light && light->isOn()) {
-            if (currentEnergyCost_ > highCostThreshold_ && solarProduction_ < 1.0) {
-                if (light->getBrightness() > 70) {
-                    std::cout << "Reducing light brightness to save energy" << std::endl;
-                    light->setBrightness(70);
-                }
-            }
+    if (currentEnergyCost_ <= highCostThreshold_ || solarProduction_ >= 1.0) {
+        return;
+    }
+
+    for (Light* light : appliances_.getLights()) {
+        if (light->isOn() && light->getBrightness() > 70) {
+            std::cout << "Reducing light brightness to save energy" << std::endl;
+            light->setBrightness(70);
         }
     }
 }
 
 void EnergyOptimizer::optimizeCurtains() {
     // Passive temperature control with curtains
-    for (auto& appliance : appliances_) {
-        auto curtain = std::dynamic_pointer_cast<Curtain>(appliance);
-        if (curtain) {
-            // Close curtains if it's hot outside and need cooling
-            if (outdoorTemp_ > indoorTemp_ + 5.0 && indoorTemp_ > targetIndoorTemp_) {
-                if (curtain->getPosition() > 20) {
-                    std::cout << "Closing curtains to block heat" << std::endl;
-                    curtain->setPosition(20);
-                }
+    for (Curtain* curtain : appliances_.getCurtains()) {
+        // Close curtains if it's hot outside and need cooling
+        if (outdoorTemp_ > indoorTemp_ + 5.0 && indoorTemp_ > targetIndoorTemp_) {
+            if (curtain->getPosition() > 20) {
+                std::cout << "Closing curtains to block heat" << std::endl;
+                curtain->setPosition(20);
             }
-            // Open curtains if it's cold outside and we have solar production
-            else if (outdoorTemp_ < indoorTemp_ && solarProduction_ > 0.5) {
-                if (curtain->getPosition() < 80) {
-                    std::cout << "Opening curtains to utilize solar heat" << std::endl;
-                    curtain->setPosition(80);
-                }
+        }
+        // Open curtains if it's cold outside and we have solar production
+        else if (outdoorTemp_ < indoorTemp_ && solarProduction_ > 0.5) {
+            if (curtain->getPosition() < 80) {
+                std::cout << "Opening curtains to utilize solar heat" << std::endl;
+                curtain->setPosition(80);
             }
         }
     }
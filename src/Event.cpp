@@ -1,13 +1,147 @@
 #include "Event.h"
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+const char* const BUILTIN_KEY_NAMES[] = {
+    "temperature",
+    "location",
+    "production_kw",
+    "consumption_kw",
+    "is_charging",
+    "charge_power_kw",
+    "cost_per_kwh"
+};
+
+static_assert(sizeof(BUILTIN_KEY_NAMES) / sizeof(BUILTIN_KEY_NAMES[0]) ==
+              static_cast<size_t>(EventKey::BUILTIN_COUNT),
+              "BUILTIN_KEY_NAMES must match EventKey");
+
+// Registry for keys that are not built in (only touched by the string API)
+struct DynamicKeyRegistry {
+    std::mutex mutex;
+    std::vector<std::string> names;
+    std::map<std::string, uint16_t> ids;
+};
+
+DynamicKeyRegistry& dynamicKeys() {
+    static DynamicKeyRegistry registry;
+    return registry;
+}
+
+bool findBuiltinKey(const std::string& name, EventKey& key) {
+    for (size_t i = 0; i < static_cast<size_t>(EventKey::BUILTIN_COUNT); ++i) {
+        if (std::strcmp(BUILTIN_KEY_NAMES[i], name.c_str()) == 0) {
+            key = static_cast<EventKey>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+std::string eventKeyName(EventKey key) {
+    size_t id = static_cast<size_t>(key);
+    if (id < static_cast<size_t>(EventKey::BUILTIN_COUNT)) {
+        return BUILTIN_KEY_NAMES[id];
+    }
+
+    auto& registry = dynamicKeys();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    size_t index = id - static_cast<size_t>(EventKey::BUILTIN_COUNT);
+    return index < registry.names.size() ? registry.names[index] : std::string();
+}
+
+bool findEventKey(const std::string& name, EventKey& key) {
+    if (findBuiltinKey(name, key)) {
+        return true;
+    }
+
+    auto& registry = dynamicKeys();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto it = registry.ids.find(name);
+    if (it == registry.ids.end()) {
+        return false;
+    }
+    key = static_cast<EventKey>(it->second);
+    return true;
+}
+
+EventKey internEventKey(const std::string& name) {
+    EventKey key;
+    if (findBuiltinKey(name, key)) {
+        return key;
+    }
+
+    auto& registry = dynamicKeys();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto it = registry.ids.find(name);
+    if (it != registry.ids.end()) {
+        return static_cast<EventKey>(it->second);
+    }
+
+    uint16_t id = static_cast<uint16_t>(static_cast<size_t>(EventKey::BUILTIN_COUNT) +
+                                        registry.names.size());
+    registry.names.push_back(name);
+    registry.ids[name] = id;
+    return static_cast<EventKey>(id);
+}
 
 Event::Event(EventType t, const std::string& src) 
-    : type(t), source(src), timestamp(0) {}
+    : type(t), source(src), timestamp(0), dataCount_(0) {}
+
+bool Event::addData(EventKey key, double value) {
+    for (uint8_t i = 0; i < dataCount_; ++i) {
+        if (data_[i].key == key) {
+            data_[i].value = value;
+            return true;
+        }
+    }
+    if (dataCount_ >= MAX_DATA_ENTRIES) {
+        return false;
+    }
+    data_[dataCount_++] = DataEntry{key, value};
+    return true;
+}
+
+double Event::getData(EventKey key, double defaultValue) const {
+    for (uint8_t i = 0; i < dataCount_; ++i) {
+        if (data_[i].key == key) {
+            return data_[i].value;
+        }
+    }
+    return defaultValue;
+}
+
+bool Event::hasData(EventKey key) const {
+    for (uint8_t i = 0; i < dataCount_; ++i) {
+        if (data_[i].key == key) {
+            return true;
+        }
+    }
+    return false;
+}
 
-void Event::addData(const std::string& key, double value) {
-    data[key] = value;
+bool Event::addData(const std::string& key, double value) {
+    return addData(internEventKey(key), value);
 }
 
 double Event::getData(const std::string& key, double defaultValue) const {
-    auto it = data.find(key);
-    return (it != data.end()) ? it->second : defaultValue;
+    EventKey id;
+    if (!findEventKey(key, id)) {
+        return defaultValue;
+    }
+    return getData(id, defaultValue);
+}
+
+size_t Event::getDataCount() const {
+    return dataCount_;
+}
+
+const Event::DataEntry& Event::getDataEntry(size_t index) const {
+    return data_[index];
 }
@@ -1,4 +1,20 @@
 #include "EventManager.h"
+#include <algorithm>
+#include <chrono>
+
+EventManager::EventManager()
+    : handlers_(std::make_shared<const HandlerTable>()),
+      asyncQueue_(nullptr),
+      activePublishers_(0),
+      droppedEvents_(0),
+      coalescingWindowMs_(0),
+      dispatcherThreadId_(std::thread::id()),
+      dispatcherRunning_(false),
+      dispatcherIdle_(false) {}
+
+EventManager::~EventManager() {
+    stopAsyncDispatch();
+}
 
 EventManager& EventManager::getInstance() {
     static EventManager instance;
@@ -7,15 +23,239 @@ EventManager& EventManager::getInstance() {
 
 void EventManager::subscribe(EventType type, EventHandler handler) {
     std::lock_guard<std::mutex> lock(mutex_);
-    handlers_[type].push_back(handler);
+    auto updated = std::make_shared<HandlerTable>(*std::atomic_load(&handlers_));
+    updated->handlers[type].push_back(handler);
+    std::atomic_store(&handlers_, std::shared_ptr<const HandlerTable>(std::move(updated)));
+}
+
+void EventManager::subscribeBatch(const std::vector<EventType>& types, BatchHandler handler) {
+    BatchSubscription subscription;
+    subscription.typeMask = 0;
+    for (EventType type : types) {
+        subscription.typeMask |= typeBit(type);
+    }
+    subscription.handler = handler;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto updated = std::make_shared<HandlerTable>(*std::atomic_load(&handlers_));
+    updated->batchHandlers.push_back(subscription);
+    updated->batchTypeMask |= subscription.typeMask;
+    std::atomic_store(&handlers_, std::shared_ptr<const HandlerTable>(std::move(updated)));
+}
+
+void EventManager::setCoalescingWindow(std::chrono::milliseconds window) {
+    coalescingWindowMs_.store(window.count(), std::memory_order_relaxed);
 }
 
 void EventManager::publish(const Event& event) {
+    // Announce ourselves before looking at the queue. stopAsyncDispatch()
+    // closes the queue and then waits for announced publishers, so either we
+    // see it closed or it waits for our push (both sides are seq_cst)
+    activePublishers_.fetch_add(1, std::memory_order_seq_cst);
+    BoundedMPSCQueue<Event>* queue = asyncQueue_.load(std::memory_order_seq_cst);
+    if (queue) {
+        if (!queue->tryPush(event)) {
+            droppedEvents_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            // Pairs with the fence in dispatchLoop(): either we see the dispatcher
+            // parked, or it sees our event before parking
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (dispatcherIdle_.load(std::memory_order_relaxed)) {
+                std::lock_guard<std::mutex> lock(wakeMutex_);
+                wakeCondition_.notify_one();
+            }
+        }
+        activePublishers_.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+    activePublishers_.fetch_sub(1, std::memory_order_release);
+
+    std::lock_guard<std::recursive_mutex> lock(syncDispatchMutex_);
+    dispatch(event);
+}
+
+void EventManager::startAsyncDispatch(size_t queueCapacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dispatcherRunning_) {
+        return;
+    }
+
+    // No publisher can reach the old ring here: stopAsyncDispatch() waited
+    // for all of them before the dispatcher was stopped
+    if (!queueStorage_ || queueStorage_->capacity() < queueCapacity) {
+        queueStorage_.reset(new BoundedMPSCQueue<Event>(queueCapacity));
+    }
+
+    dispatcherRunning_ = true;
+    dispatcherThread_ = std::thread(&EventManager::dispatchLoop, this);
+    asyncQueue_.store(queueStorage_.get(), std::memory_order_release);
+}
+
+bool EventManager::stopAsyncDispatch() {
+    // A handler on the dispatcher thread would join itself, or wait on
+    // mutex_ held by another thread that is joining it
+    if (dispatcherThreadId_.load(std::memory_order_acquire) == std::this_thread::get_id()) {
+        return false;
+    }
+
     std::lock_guard<std::mutex> lock(mutex_);
-    auto it = handlers_.find(event.type);
-    if (it != handlers_.end()) {
+    if (!dispatcherRunning_) {
+        return true;
+    }
+
+    // New publishes go back to synchronous delivery. Publishers that saw the
+    // queue open finish their push first, so the dispatcher's final drain
+    // delivers every event that was accepted
+    asyncQueue_.store(nullptr, std::memory_order_seq_cst);
+    while (activePublishers_.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+    dispatcherRunning_ = false;
+    {
+        std::lock_guard<std::mutex> wakeLock(wakeMutex_);
+        wakeCondition_.notify_one();
+    }
+
+    if (dispatcherThread_.joinable()) {
+        dispatcherThread_.join();
+    }
+    dispatcherThreadId_.store(std::thread::id(), std::memory_order_release);
+    return true;
+}
+
+DispatchMode EventManager::getDispatchMode() const {
+    return asyncQueue_.load(std::memory_order_acquire) ? DispatchMode::ASYNCHRONOUS
+                                                       : DispatchMode::SYNCHRONOUS;
+}
+
+size_t EventManager::getDroppedEventCount() const {
+    return droppedEvents_.load(std::memory_order_relaxed);
+}
+
+uint32_t EventManager::typeBit(EventType type) {
+    return 1u << static_cast<uint32_t>(type);
+}
+
+void EventManager::dispatch(const Event& event) {
+    auto table = std::atomic_load(&handlers_);
+    auto it = table->handlers.find(event.type);
+    if (it != table->handlers.end()) {
         for (const auto& handler : it->second) {
             handler(event);
         }
     }
+
+    // Synchronous delivery: batch subscribers get a batch of one
+    if (table->batchTypeMask & typeBit(event.type)) {
+        std::vector<Event> batch(1, event);
+        for (const auto& subscription : table->batchHandlers) {
+            if (subscription.typeMask & typeBit(event.type)) {
+                subscription.handler(batch);
+            }
+        }
+    }
+}
+
+bool EventManager::drainQueue(BoundedMPSCQueue<Event>& queue, CoalescingBuffer& pending) {
+    Event event(EventType::TEMPERATURE_CHANGE, "");
+    if (!queue.tryPop(event)) {
+        return false;
+    }
+
+    auto table = std::atomic_load(&handlers_);
+    do {
+        // Per-event subscribers still see every event, in order
+        auto it = table->handlers.find(event.type);
+        if (it != table->handlers.end()) {
+            for (const auto& handler : it->second) {
+                handler(event);
+            }
+        }
+
+        if (table->batchTypeMask & typeBit(event.type)) {
+            auto key = std::make_pair(event.type, event.source);
+            auto found = pending.index.find(key);
+            if (found != pending.index.end()) {
+                pending.events[found->second] = event;
+                pending.lastSeen[found->second] = ++pending.sequence;
+            } else {
+                pending.index.emplace(std::move(key), pending.events.size());
+                pending.events.push_back(event);
+                pending.lastSeen.push_back(++pending.sequence);
+            }
+        }
+    } while (queue.tryPop(event));
+
+    return true;
+}
+
+void EventManager::flushBatches(CoalescingBuffer& pending) {
+    if (pending.events.empty()) {
+        return;
+    }
+
+    // Newest last, so handlers that apply a batch in order end on the latest
+    // reading even when several sources interleave
+    std::vector<size_t> order(pending.events.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(),
+              [&pending](size_t a, size_t b) { return pending.lastSeen[a] < pending.lastSeen[b]; });
+
+    auto table = std::atomic_load(&handlers_);
+    std::vector<Event> batch;
+    batch.reserve(pending.events.size());
+    for (const auto& subscription : table->batchHandlers) {
+        batch.clear();
+        for (size_t i : order) {
+            const Event& event = pending.events[i];
+            if (subscription.typeMask & typeBit(event.type)) {
+                batch.push_back(event);
+            }
+        }
+        if (!batch.empty()) {
+            subscription.handler(batch);
+        }
+    }
+
+    pending.events.clear();
+    pending.lastSeen.clear();
+    pending.index.clear();
+}
+
+void EventManager::dispatchLoop() {
+    dispatcherThreadId_.store(std::this_thread::get_id(), std::memory_order_release);
+    BoundedMPSCQueue<Event>* queue = queueStorage_.get();
+    CoalescingBuffer pending;
+
+    for (;;) {
+        if (drainQueue(*queue, pending)) {
+            // Keep gathering for the coalescing window before handing out batches
+            auto window = std::chrono::milliseconds(coalescingWindowMs_.load(std::memory_order_relaxed));
+            if (window.count() > 0 && !pending.events.empty() &&
+                dispatcherRunning_.load(std::memory_order_acquire)) {
+                std::this_thread::sleep_for(window);
+                drainQueue(*queue, pending);
+            }
+            flushBatches(pending);
+            continue;
+        }
+
+        if (!dispatcherRunning_.load(std::memory_order_acquire)) {
+            // Final drain for events pushed while stopping
+            drainQueue(*queue, pending);
+            flushBatches(pending);
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        dispatcherIdle_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (queue->empty() && dispatcherRunning_.load(std::memory_order_acquire)) {
+            // The timeout is only a safety net; publishers notify when we are idle
+            wakeCondition_.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        dispatcherIdle_.store(false, std::memory_order_relaxed);
+    }
 }
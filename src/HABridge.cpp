@@ -0,0 +1,343 @@
+#include "HABridge.h"
+#include "EventManager.h"
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+HABridge::HABridge(std::shared_ptr<HAIntegration> integration, const HABridgeConfig& config)
+    : integration_(integration), config_(config), inbox_(std::make_shared<Inbox>(config.queueCapacity)),
+      subscribed_(false), running_(false), tokens_(0.0), publishFailing_(false), statesCoalesced_(0),
+      statesPublished_(0), statesSuppressed_(0), statesFailed_(0), discoveryPublished_(0), batches_(0), entityCount_(0), pendingCount_(0) {
+    channels_[EventKey::TEMPERATURE] = {"sensor", "temperature", "Temperature", "°C", "temperature", 0.1};
+    channels_[EventKey::LOCATION] = {"", "", "", "", "", 0.0};
+    channels_[EventKey::PRODUCTION_KW] = {"sensor", "production", "Production", "kW", "power", 0.0};
+    channels_[EventKey::CONSUMPTION_KW] = {"sensor", "consumption", "Consumption", "kW", "power", 0.0};
+    channels_[EventKey::IS_CHARGING] = {"binary_sensor", "charging", "Charging", "", "battery_charging", 0.0};
+    channels_[EventKey::CHARGE_POWER_KW] = {"sensor", "charge_power", "Charge Power", "kW", "power", 0.0};
+    channels_[EventKey::COST_PER_KWH] = {"sensor", "cost", "Cost", "$/kWh", "monetary", 0.0};
+}
+
+HABridge::~HABridge() {
+    stop();
+}
+
+void HABridge::start() {
+    if (running_) {
+        return;
+    }
+
+    if (!subscribed_) {
+        // The handlers cannot be removed from the EventManager, so they only
+        // hold a weak reference and go quiet once the bridge is gone
+        std::weak_ptr<Inbox> weakInbox = inbox_;
+        for (EventType type : config_.eventTypes) {
+            EventManager::getInstance().subscribe(type, [weakInbox](const Event& event) {
+                std::shared_ptr<Inbox> inbox = weakInbox.lock();
+                if (!inbox || !inbox->open.load(std::memory_order_acquire)) {
+                    return;
+                }
+                inbox->received.fetch_add(1, std::memory_order_relaxed);
+                StampedEvent stamped(inbox->sequence.fetch_add(1, std::memory_order_relaxed) + 1, event);
+                if (!inbox->queue.tryPush(stamped)) {
+                    // Bursts beyond the queue keep only the newest event per sensor
+                    std::lock_guard<std::mutex> lock(inbox->overflowMutex);
+                    StampedEvent& slot = inbox->overflow[std::make_pair(event.type, event.source)];
+                    if (slot.sequence < stamped.sequence) {
+                        slot = stamped;
+                    }
+                    inbox->overflowed.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+        subscribed_ = true;
+    }
+
+    tokens_ = static_cast<double>(config_.maxBatchSize);
+    lastRefill_ = std::chrono::steady_clock::now();
+    inbox_->open = true;
+    running_ = true;
+    publishThread_ = std::thread(&HABridge::publishLoop, this);
+}
+
+void HABridge::stop() {
+    if (!running_) {
+        return;
+    }
+
+    inbox_->open = false;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        running_ = false;
+    }
+    wakeCondition_.notify_one();
+    if (publishThread_.joinable()) {
+        publishThread_.join();
+    }
+}
+
+void HABridge::setChannel(EventKey key, const HABridgeChannel& channel) {
+    std::lock_guard<std::mutex> lock(channelsMutex_);
+    channels_[key] = channel;
+}
+
+void HABridge::setObjectId(const std::string& sourceId, EventKey key, const std::string& objectId) {
+    std::lock_guard<std::mutex> lock(channelsMutex_);
+    objectIds_[std::make_pair(sourceId, key)] = toObjectId(objectId);
+}
+
+std::string HABridge::getEntityId(const std::string& sourceId, EventKey key) const {
+    HABridgeChannel channel = channelFor(key);
+    if (channel.component.empty()) {
+        return "";
+    }
+    return channel.component + "." + objectIdFor(sourceId, key, channel);
+}
+
+HABridgeStats HABridge::getStats() const {
+    HABridgeStats stats;
+    stats.eventsReceived = inbox_->received.load();
+    stats.eventsOverflowed = inbox_->overflowed.load();
+    stats.statesCoalesced = statesCoalesced_.load();
+    stats.statesPublished = statesPublished_.load();
+    stats.statesSuppressed = statesSuppressed_.load();
+    stats.statesFailed = statesFailed_.load();
+    stats.discoveryPublished = discoveryPublished_.load();
+    stats.batches = batches_.load();
+    stats.entities = entityCount_.load();
+    stats.pending = pendingCount_.load();
+    return stats;
+}
+
+void HABridge::publishLoop() {
+    const auto interval = std::chrono::milliseconds(std::max(1, config_.flushIntervalMs));
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wakeCondition_.wait_for(lock, interval, [this] { return !running_; });
+        }
+        if (!running_) {
+            break;
+        }
+
+        drainInbox();
+        size_t sent = flushPending(false);
+        if (config_.verboseLogging && sent > 0) {
+            std::cout << "HABridge: Flushed " << sent << " state(s), "
+                      << pendingOrder_.size() << " waiting" << std::endl;
+        }
+    }
+
+    // Final flush so nothing published before stop() is lost
+    drainInbox();
+    flushPending(true);
+}
+
+void HABridge::drainInbox() {
+    StampedEvent stamped;
+    while (inbox_->queue.tryPop(stamped)) {
+        addEvent(stamped);
+    }
+
+    std::map<std::pair<EventType, std::string>, StampedEvent> overflow;
+    {
+        std::lock_guard<std::mutex> lock(inbox_->overflowMutex);
+        overflow.swap(inbox_->overflow);
+    }
+    for (const auto& entry : overflow) {
+        addEvent(entry.second);
+    }
+    pendingCount_.store(pendingOrder_.size(), std::memory_order_relaxed);
+}
+
+void HABridge::addEvent(const StampedEvent& stamped) {
+    for (size_t i = 0; i < stamped.event.getDataCount(); ++i) {
+        const Event::DataEntry& entry = stamped.event.getDataEntry(i);
+        addValue(stamped.event.source, entry.key, entry.value, stamped.sequence);
+    }
+}
+
+void HABridge::addValue(const std::string& sourceId, EventKey key, double value, uint64_t sequence) {
+    Entity* entity;
+    auto it = entities_.find(std::make_pair(sourceId, key));
+    if (it != entities_.end()) {
+        entity = &it->second;
+    } else {
+        HABridgeChannel channel = channelFor(key);
+        if (channel.component.empty()) {
+            return;
+        }
+        entity = &createEntity(sourceId, key, channel);
+    }
+
+    if (sequence < entity->sequence) {
+        // Overtaken by a newer event that went through the other path
+        statesCoalesced_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    entity->value = value;
+    entity->sequence = sequence;
+    if (entity->pending) {
+        statesCoalesced_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    entity->pending = true;
+    pendingOrder_.push_back(entity);
+}
+
+HABridge::Entity& HABridge::createEntity(const std::string& sourceId, EventKey key, const HABridgeChannel& channel) {
+    std::string objectId = objectIdFor(sourceId, key, channel);
+
+    Entity& entity = entities_[std::make_pair(sourceId, key)];
+    entity.handle = integration_->registerEntity(channel.component + "." + objectId);
+    entity.binary = channel.component == "binary_sensor";
+    if (channel.deadband > 0.0) {
+        integration_->setDeadband(entity.handle, channel.deadband);
+    }
+    entityCount_.store(entities_.size(), std::memory_order_relaxed);
+
+    // Discovery config, generated once per entity
+    std::string config = "{\"name\": \"";
+    HAIntegration::appendJsonEscaped(config, toFriendlyName(sourceId) + " " + channel.label);
+    config += "\", \"object_id\": \"";
+    HAIntegration::appendJsonEscaped(config, objectId);   // HA derives the entity ID from it
+    config += "\", \"unique_id\": \"";
+    HAIntegration::appendJsonEscaped(config, config_.nodeId + "_" + objectId);
+    config += "\", \"state_topic\": \"";
+    HAIntegration::appendJsonEscaped(config, entity.handle->getStateTopic());
+    config += "\"";
+    if (!channel.unit.empty()) {
+        config += ", \"unit_of_measurement\": \"";
+        HAIntegration::appendJsonEscaped(config, channel.unit);
+        config += "\"";
+    }
+    if (!channel.deviceClass.empty()) {
+        config += ", \"device_class\": \"";
+        HAIntegration::appendJsonEscaped(config, channel.deviceClass);
+        config += "\"";
+    }
+    config += "}";
+
+    // Kept by HAIntegration even if MQTT is down now, and sent once it connects
+    if (integration_->publishDiscovery(channel.component, config_.nodeId, objectId, config)) {
+        discoveryPublished_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (config_.verboseLogging) {
+        std::cout << "HABridge: New entity " << entity.handle->getEntityId() << " for " << sourceId << std::endl;
+    }
+    return entity;
+}
+
+size_t HABridge::flushPending(bool ignoreRateLimit) {
+    auto now = std::chrono::steady_clock::now();
+    double burst = static_cast<double>(config_.maxBatchSize);
+    if (config_.maxPublishesPerSecond > 0.0) {
+        double elapsed = std::chrono::duration<double>(now - lastRefill_).count();
+        tokens_ = std::min(burst, tokens_ + elapsed * config_.maxPublishesPerSecond);
+    } else {
+        tokens_ = burst;
+    }
+    lastRefill_ = now;
+
+    size_t sent = 0;
+    while (!pendingOrder_.empty() && (ignoreRateLimit || (tokens_ >= 1.0 && sent < config_.maxBatchSize))) {
+        Entity* entity = pendingOrder_.front();
+        pendingOrder_.pop_front();
+        entity->pending = false;
+
+        if (entity->binary) {
+            stateBuffer_ = entity->value != 0.0 ? "ON" : "OFF";
+        } else {
+            // Up to three decimals without trailing zeros
+            char text[32];
+            int length = std::snprintf(text, sizeof(text), "%.3f", entity->value);
+            while (length > 1 && text[length - 1] == '0') {
+                --length;
+            }
+            if (length > 1 && text[length - 1] == '.') {
+                --length;
+            }
+            stateBuffer_.assign(text, static_cast<size_t>(length));
+        }
+
+        // Suppressed states never reach MQTT, so they cost no tokens
+        HAPublishResult result = integration_->tryPublishState(entity->handle, stateBuffer_);
+        if (result == HAPublishResult::FAILED) {
+            // Back to the front of the queue, where newer values still coalesce
+            // into it; the rest waits for the next flush
+            statesFailed_.fetch_add(1, std::memory_order_relaxed);
+            entity->pending = true;
+            pendingOrder_.push_front(entity);
+            if (!publishFailing_) {
+                std::cerr << "HABridge: Publishing failed, keeping " << pendingOrder_.size()
+                          << " state(s) for retry" << std::endl;
+            }
+            publishFailing_ = true;
+            break;
+        }
+        if (publishFailing_) {
+            std::cout << "HABridge: Publishing resumed" << std::endl;
+            publishFailing_ = false;
+        }
+        if (result == HAPublishResult::SENT) {
+            statesPublished_.fetch_add(1, std::memory_order_relaxed);
+            tokens_ -= 1.0;
+            ++sent;
+        } else {
+            statesSuppressed_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (sent > 0) {
+        batches_.fetch_add(1, std::memory_order_relaxed);
+    }
+    pendingCount_.store(pendingOrder_.size(), std::memory_order_relaxed);
+    return sent;
+}
+
+HABridgeChannel HABridge::channelFor(EventKey key) const {
+    std::lock_guard<std::mutex> lock(channelsMutex_);
+    auto it = channels_.find(key);
+    if (it != channels_.end()) {
+        return it->second;
+    }
+    std::string name = eventKeyName(key);
+    return {"sensor", name, toFriendlyName(name), "", "", 0.0};
+}
+
+std::string HABridge::objectIdFor(const std::string& sourceId, EventKey key, const HABridgeChannel& channel) const {
+    {
+        std::lock_guard<std::mutex> lock(channelsMutex_);
+        auto it = objectIds_.find(std::make_pair(sourceId, key));
+        if (it != objectIds_.end()) {
+            return it->second;
+        }
+    }
+    return toObjectId(sourceId + "_" + channel.suffix);
+}
+
+std::string HABridge::toObjectId(const std::string& text) {
+    std::string id;
+    id.reserve(text.size());
+    for (char c : text) {
+        unsigned char uc = static_cast<unsigned char>(c);
+        id += std::isalnum(uc) ? static_cast<char>(std::tolower(uc)) : '_';
+    }
+    return id;
+}
+
+std::string HABridge::toFriendlyName(const std::string& sourceId) {
+    // "temp_indoor_1" -> "Temp Indoor 1"
+    std::string name;
+    bool wordStart = true;
+    for (char c : sourceId) {
+        if (c == '_' || c == '-' || c == '.') {
+            name += ' ';
+            wordStart = true;
+            continue;
+        }
+        name += wordStart ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : c;
+        wordStart = false;
+    }
+    return name;
+}
@@ -0,0 +1,251 @@
+#include "HAHistoryBackfill.h"
+#include "HistoricalDataCollector.h"
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+
+namespace {
+
+const long SECONDS_PER_HOUR = 3600;
+
+// Numeric value of a state; NaN for "unavailable", "unknown", "on", ...
+double parseNumericState(const std::string& state) {
+    if (state.empty()) {
+        return NAN;
+    }
+    char* end = nullptr;
+    double value = std::strtod(state.c_str(), &end);
+    if (end != state.c_str() + state.size() || !std::isfinite(value)) {
+        return NAN;
+    }
+    return value;
+}
+
+} // namespace
+
+HAHistoryBackfill::HAHistoryBackfill(std::shared_ptr<HARestClient> client, const HistoryBackfillConfig& config)
+    : client_(client), config_(config) {
+    config_.windowHours = std::max(config_.windowHours, 1);
+    config_.maxParallelRequests = std::max<size_t>(config_.maxParallelRequests, 1);
+    config_.maxRetries = std::max(config_.maxRetries, 0);
+
+    entities_[0] = config_.outdoorTempEntity;
+    entities_[1] = config_.solarProductionEntity;
+    entities_[2] = config_.energyCostEntity;
+}
+
+int HAHistoryBackfill::columnFor(const std::string& entityId) const {
+    for (int column = 0; column < COLUMNS; ++column) {
+        if (!entities_[column].empty() && entities_[column] == entityId) {
+            return column;
+        }
+    }
+    return -1;
+}
+
+bool HAHistoryBackfill::fetchWindow(long windowStart, long windowEnd, WindowAccumulator& accumulator,
+                                    size_t& entries) {
+    size_t hours = accumulator.weightedSum.size() / COLUMNS;
+    std::fill(accumulator.weightedSum.begin(), accumulator.weightedSum.end(), 0.0);
+    std::fill(accumulator.coveredSeconds.begin(), accumulator.coveredSeconds.end(), 0.0);
+    entries = 0;
+
+    HAHistoryQuery query;
+    for (const auto& entity : entities_) {
+        if (!entity.empty()) {
+            query.entityIds.push_back(entity);
+        }
+    }
+    query.startTimestamp = windowStart;
+    query.endTimestamp = windowEnd;
+    query.minimalResponse = config_.minimalResponse;
+    query.noAttributes = config_.noAttributes;
+    query.timeoutSeconds = config_.requestTimeoutSeconds;
+
+    // Spread a constant value over [from, to) across the hour buckets
+    auto integrate = [&](int column, long from, long to, double value) {
+        while (from < to) {
+            size_t hour = static_cast<size_t>((from - windowStart) / SECONDS_PER_HOUR);
+            if (hour >= hours) {
+                break;
+            }
+            long segmentEnd = std::min(to, windowStart + static_cast<long>(hour + 1) * SECONDS_PER_HOUR);
+            accumulator.weightedSum[column * hours + hour] += value * (segmentEnd - from);
+            accumulator.coveredSeconds[column * hours + hour] += segmentEnd - from;
+            from = segmentEnd;
+        }
+    };
+
+    // Entries arrive grouped by entity and in time order; each state holds
+    // until the next change (or the end of the window)
+    std::string currentEntity;
+    int column = -1;
+    long previousTime = 0;
+    double previousValue = NAN;
+    auto closeEntity = [&]() {
+        if (column >= 0 && !std::isnan(previousValue)) {
+            integrate(column, previousTime, windowEnd, previousValue);
+        }
+    };
+
+    bool ok = client_->fetchHistory(query, [&](const HAHistoricalData& entry) {
+        ++entries;
+        if (entry.entityId != currentEntity) {
+            closeEntity();
+            currentEntity = entry.entityId;
+            column = columnFor(currentEntity);
+            previousValue = NAN;
+        }
+        if (column < 0) {
+            return;
+        }
+
+        long time = std::min(std::max(entry.timestamp, windowStart), windowEnd);
+        if (!std::isnan(previousValue)) {
+            integrate(column, previousTime, time, previousValue);
+        }
+        previousTime = time;
+        previousValue = parseNumericState(entry.state);
+    });
+    closeEntity();
+    return ok;
+}
+
+std::vector<HistoricalDataPoint> HAHistoryBackfill::run(long startTimestamp, long endTimestamp) {
+    auto started = std::chrono::steady_clock::now();
+    stats_ = HistoryBackfillStats();
+
+    startTimestamp -= startTimestamp % SECONDS_PER_HOUR;
+    if (endTimestamp <= startTimestamp) {
+        return {};
+    }
+    size_t totalHours = static_cast<size_t>((endTimestamp - startTimestamp + SECONDS_PER_HOUR - 1) / SECONDS_PER_HOUR);
+    endTimestamp = startTimestamp + static_cast<long>(totalHours) * SECONDS_PER_HOUR;
+    size_t windowCount = (totalHours + config_.windowHours - 1) / config_.windowHours;
+
+    std::cout << "HAHistoryBackfill: Fetching " << totalHours << " hours in " << windowCount
+              << " windows (" << std::min(config_.maxParallelRequests, windowCount) << " parallel)" << std::endl;
+
+    // Each window owns a disjoint hour range of these, so workers never contend
+    std::vector<double> weightedSum(COLUMNS * totalHours, 0.0);
+    std::vector<double> coveredSeconds(COLUMNS * totalHours, 0.0);
+
+    std::atomic<size_t> nextWindow(0);
+    std::atomic<size_t> failedWindows(0);
+    std::atomic<size_t> retries(0);
+    std::atomic<size_t> totalEntries(0);
+
+    auto worker = [&]() {
+        WindowAccumulator accumulator;
+        for (;;) {
+            size_t window = nextWindow.fetch_add(1);
+            if (window >= windowCount) {
+                return;
+            }
+            size_t firstHour = window * config_.windowHours;
+            size_t hours = std::min<size_t>(config_.windowHours, totalHours - firstHour);
+            long windowStart = startTimestamp + static_cast<long>(firstHour) * SECONDS_PER_HOUR;
+            long windowEnd = windowStart + static_cast<long>(hours) * SECONDS_PER_HOUR;
+            accumulator.weightedSum.assign(COLUMNS * hours, 0.0);
+            accumulator.coveredSeconds.assign(COLUMNS * hours, 0.0);
+
+            bool ok = false;
+            size_t entries = 0;
+            for (int attempt = 0; attempt <= config_.maxRetries && !ok; ++attempt) {
+                if (attempt > 0) {
+                    retries++;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(config_.retryDelayMs << (attempt - 1)));
+                }
+                ok = fetchWindow(windowStart, windowEnd, accumulator, entries);
+            }
+
+            if (!ok) {
+                failedWindows++;
+                std::cerr << "HAHistoryBackfill: Giving up on window " << window + 1 << "/" << windowCount
+                          << " after " << config_.maxRetries + 1 << " attempts" << std::endl;
+                continue;
+            }
+
+            totalEntries += entries;
+            for (int column = 0; column < COLUMNS; ++column) {
+                std::copy(accumulator.weightedSum.begin() + column * hours,
+                          accumulator.weightedSum.begin() + (column + 1) * hours,
+                          weightedSum.begin() + column * totalHours + firstHour);
+                std::copy(accumulator.coveredSeconds.begin() + column * hours,
+                          accumulator.coveredSeconds.begin() + (column + 1) * hours,
+                          coveredSeconds.begin() + column * totalHours + firstHour);
+            }
+            if (config_.verboseLogging) {
+                std::cout << "HAHistoryBackfill: Window " << window + 1 << "/" << windowCount
+                          << ": " << entries << " entries" << std::endl;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    size_t workerCount = std::min(config_.maxParallelRequests, windowCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    // Resample: one point per hour in which every configured column has data
+    std::vector<HistoricalDataPoint> points;
+    points.reserve(totalHours);
+    for (size_t hour = 0; hour < totalHours; ++hour) {
+        double values[COLUMNS] = {0.0, 0.0, 0.0};
+        bool complete = true;
+        for (int column = 0; column < COLUMNS && complete; ++column) {
+            if (entities_[column].empty()) {
+                continue;
+            }
+            double covered = coveredSeconds[column * totalHours + hour];
+            if (covered <= 0.0) {
+                complete = false;
+            } else {
+                values[column] = weightedSum[column * totalHours + hour] / covered;
+            }
+        }
+        if (!complete) {
+            continue;
+        }
+
+        std::time_t hourStart = startTimestamp + static_cast<long>(hour) * SECONDS_PER_HOUR;
+        std::tm localTime;
+        localtime_r(&hourStart, &localTime);
+
+        HistoricalDataPoint point;
+        point.hour = localTime.tm_hour;
+        point.dayOfWeek = localTime.tm_wday;
+        point.outdoorTemp = values[0];
+        point.solarProduction = values[1];
+        point.energyCost = values[2];
+        points.push_back(point);
+    }
+
+    stats_.windows = windowCount;
+    stats_.failedWindows = failedWindows;
+    stats_.retries = retries;
+    stats_.entries = totalEntries;
+    stats_.hoursProduced = points.size();
+    stats_.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+    std::cout << "HAHistoryBackfill: " << stats_.hoursProduced << " hourly points from " << stats_.entries
+              << " entries in " << stats_.elapsedMs << " ms (" << stats_.failedWindows << " failed windows, "
+              << stats_.retries << " retries)" << std::endl;
+    return points;
+}
+
+size_t HAHistoryBackfill::backfill(HistoricalDataCollector& collector, long startTimestamp, long endTimestamp) {
+    std::vector<HistoricalDataPoint> points = run(startTimestamp, endTimestamp);
+    for (const auto& point : points) {
+        collector.addDataPoint(point);
+    }
+    return points.size();
+}
@@ -1,26 +1,82 @@
 #include "HAIntegration.h"
 #include <iostream>
-#include <sstream>
-#include <iomanip>
+#include <cmath>
+#include <cstdlib>
 
-HAIntegration::HAIntegration(std::shared_ptr<MQTTClient> mqttClient, const std::string& haDiscoveryPrefix)
-    : mqttClient_(mqttClient), haDiscoveryPrefix_(haDiscoveryPrefix) {
+namespace {
+
+// Numeric value of a state string; false for "on", "unavailable", ...
+bool parseNumber(const std::string& state, double& value) {
+    if (state.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtod(state.c_str(), &end);
+    return end == state.c_str() + state.size() && std::isfinite(value);
+}
+
+} // namespace
+
+HAIntegration::HAIntegration(std::shared_ptr<MQTTClient> mqttClient, const std::string& haDiscoveryPrefix,
+                             const HAPublishConfig& publishConfig)
+    : mqttClient_(mqttClient), haDiscoveryPrefix_(haDiscoveryPrefix), statePrefix_(haDiscoveryPrefix + "/state/"),
+      publishConfig_(publishConfig), published_(0), suppressed_(0), heartbeats_(0), attributesPublished_(0),
+      failed_(0), discoveryPublished_(0), connectionCallbackId_(0) {
+    if (mqttClient_) {
+        connectionCallbackId_ = mqttClient_->addConnectionCallback([this](bool reconnected) {
+            onConnected(reconnected);
+        });
+    }
+}
+
+HAIntegration::~HAIntegration() {
+    if (mqttClient_) {
+        mqttClient_->removeConnectionCallback(connectionCallbackId_);
+    }
+}
+
+HAIntegration::EntityHandle HAIntegration::registerEntity(const std::string& entityId) {
+    std::lock_guard<std::mutex> lock(entitiesMutex_);
+    auto it = entities_.find(entityId);
+    if (it != entities_.end()) {
+        return it->second.get();
+    }
+    
+    std::string domain = extractDomain(entityId);
+    std::unique_ptr<HAEntity> entity(new HAEntity(entityId, domain, getStateTopic(entityId),
+                                                  getCommandTopic(entityId)));
+    auto domainIt = domainCallbacks_.find(domain);
+    if (domainIt != domainCallbacks_.end()) {
+        entity->domainCallback_ = domainIt->second;
+    }
+    EntityHandle handle = entity.get();
+    entities_.emplace(entityId, std::move(entity));
+    return handle;
 }
 
 void HAIntegration::subscribeToEntity(const std::string& entityId, StateCallback callback) {
+    subscribeToEntity(registerEntity(entityId), std::move(callback));
+}
+
+void HAIntegration::subscribeToEntity(EntityHandle entity, StateCallback callback) {
     if (!mqttClient_ || !mqttClient_->isConnected()) {
         std::cerr << "HAIntegration: MQTT client not connected" << std::endl;
         return;
     }
     
-    entityCallbacks_[entityId] = callback;
-    std::string topic = getStateTopic(entityId);
+    {
+        std::lock_guard<std::mutex> lock(entitiesMutex_);
+        callbackStore_.push_back(std::move(callback));
+        entity->callback_ = &callbackStore_.back();
+    }
     
-    mqttClient_->subscribe(topic, [this, entityId](const std::string& topic, const std::string& payload) {
-        handleStateMessage(topic, payload);
+    // The handle is bound into the subscription, so delivery needs no lookups
+    mqttClient_->subscribe(entity->stateTopic_, [this, entity](const std::string&, const std::string& payload) {
+        dispatchState(*entity, entity->callback_.load(std::memory_order_acquire), payload);
     });
     
-    std::cout << "HAIntegration: Subscribed to entity " << entityId << " on topic: " << topic << std::endl;
+    std::cout << "HAIntegration: Subscribed to entity " << entity->entityId_
+              << " on topic: " << entity->stateTopic_ << std::endl;
 }
 
 void HAIntegration::subscribeToDomain(const std::string& domain, StateCallback callback) {
@@ -29,42 +85,66 @@ void HAIntegration::subscribeToDomain(const std::string& domain, StateCallback c
         return;
     }
     
-    domainCallbacks_[domain] = callback;
-    // Topic pattern to match all entities in a domain
-    // Format: homeassistant/state/domain.*
-    std::string topic = haDiscoveryPrefix_ + "/state/" + domain + ".+";
- //twi   std::string topic = haDiscoveryPrefix_ + "/" + domain;
+    // One single-level wildcard serves every domain; handleStateMessage
+    // filters on the domain. (MQTT wildcards only match whole topic levels,
+    // so "<prefix>/state/switch.+" would match nothing.)
+    std::string topic = statePrefix_ + "+";
+    bool subscribe = false;
+    {
+        // Resolve the callback into every entity of the domain, now and when registered later
+        std::lock_guard<std::mutex> lock(entitiesMutex_);
+        callbackStore_.push_back(std::move(callback));
+        const StateCallback* stored = &callbackStore_.back();
+        domainCallbacks_[domain] = stored;
+        for (auto& entry : entities_) {
+            if (entry.second->domain_ == domain) {
+                entry.second->domainCallback_ = stored;
+            }
+        }
+        subscribe = !stateWildcardSubscribed_;
+        stateWildcardSubscribed_ = true;
+    }
     
-    mqttClient_->subscribe(topic, [this, domain](const std::string& topic, const std::string& payload) {
-        handleStateMessage(topic, payload);
-    });
+    if (subscribe) {
+        mqttClient_->subscribe(topic, [this](const std::string& topic, const std::string& payload) {
+            handleStateMessage(topic, payload);
+        });
+    }
     
     std::cout << "HAIntegration: Subscribed to domain " << domain << " on topic: " << topic << std::endl;
 }
 
-void HAIntegration::publishCommand(const std::string& entityId, const std::string& command) {
+bool HAIntegration::publishCommand(const std::string& entityId, const std::string& command) {
+    return publishCommand(registerEntity(entityId), command);
+}
+
+bool HAIntegration::publishCommand(EntityHandle entity, const std::string& command) {
     if (!mqttClient_ || !mqttClient_->isConnected()) {
         std::cerr << "HAIntegration: MQTT client not connected" << std::endl;
-        return;
+        return false;
     }
     
-    std::string topic = getCommandTopic(entityId);
-    mqttClient_->publish(topic, command);
+    if (!mqttClient_->publish(entity->commandTopic_, command)) {
+        return false;
+    }
     
-    std::cout << "HAIntegration: Published command '" << command << "' to " << entityId << std::endl;
+    std::cout << "HAIntegration: Published command '" << command << "' to " << entity->entityId_ << std::endl;
+    return true;
 }
 
-void HAIntegration::publishCommandWithData(const std::string& entityId, const std::string& command, const std::string& data) {
+bool HAIntegration::publishCommandWithData(const std::string& entityId, const std::string& command, const std::string& data) {
     if (!mqttClient_ || !mqttClient_->isConnected()) {
         std::cerr << "HAIntegration: MQTT client not connected" << std::endl;
-        return;
+        return false;
     }
     
-    std::string topic = getCommandTopic(entityId);
     std::string payload = createCommandPayload(command, data);
-    mqttClient_->publish(topic, payload);
+    if (!mqttClient_->publish(registerEntity(entityId)->commandTopic_, payload)) {
+        return false;
+    }
     
     std::cout << "HAIntegration: Published command '" << command << "' with data to " << entityId << std::endl;
+    return true;
 }
 
 void HAIntegration::requestState(const std::string& entityId) {
@@ -74,7 +154,7 @@ void HAIntegration::requestState(const std::string& entityId) {
     }
     
     // Request state by publishing to the state request topic
-    std::string topic = getStateTopic(entityId) + "/get";
+    std::string topic = registerEntity(entityId)->stateTopic_ + "/get";
     mqttClient_->publish(topic, "");
     
     std::cout << "HAIntegration: Requested state for " << entityId << std::endl;
@@ -96,40 +176,199 @@ void HAIntegration::subscribeToDiscovery(DiscoveryCallback callback) {
     std::cout << "HAIntegration: Subscribed to HA discovery on: " << topic << std::endl;
 }
 
-void HAIntegration::publishDiscovery(const std::string& component, const std::string& nodeId, 
+bool HAIntegration::publishDiscovery(const std::string& component, const std::string& nodeId, 
                                      const std::string& objectId, const std::string& config) {
+    std::string topic = getDiscoveryTopic(component, nodeId, objectId);
+    {
+        std::lock_guard<std::mutex> lock(discoveryMutex_);
+        discoveryConfigs_[topic] = config;
+    }
+    
     if (!mqttClient_ || !mqttClient_->isConnected()) {
-        std::cerr << "HAIntegration: MQTT client not connected" << std::endl;
-        return;
+        std::cerr << "HAIntegration: MQTT client not connected, discovery for " << component << "." << objectId
+                  << " is sent on connect" << std::endl;
+        return false;
     }
     
-    std::string topic = getDiscoveryTopic(component, nodeId, objectId);
-    mqttClient_->publish(topic, config);
+    // Retained, so Home Assistant finds the config again after it restarts
+    if (!mqttClient_->publish(topic, config, 1, true)) {
+        return false;
+    }
+    discoveryPublished_++;
     
-    std::cout << "HAIntegration: Published discovery for " << component << "." << objectId << std::endl;
+    if (publishConfig_.verboseLogging) {
+        std::cout << "HAIntegration: Published discovery for " << component << "." << objectId << std::endl;
+    }
+    return true;
 }
 
-void HAIntegration::publishState(const std::string& entityId, const std::string& state, const std::string& attributes) {
-    if (!mqttClient_ || !mqttClient_->isConnected()) {
+void HAIntegration::onConnected(bool reconnected) {
+    // A broker without persistence forgets retained configs when it restarts
+    size_t republished = 0;
+    {
+        std::lock_guard<std::mutex> lock(discoveryMutex_);
+        for (const auto& entry : discoveryConfigs_) {
+            if (mqttClient_->publish(entry.first, entry.second, 1, true)) {
+                discoveryPublished_++;
+                republished++;
+            }
+        }
+    }
+    
+    // Subscribers may have missed states while the connection was down
+    if (reconnected) {
+        resetPublishCache();
+    }
+    
+    if (republished > 0) {
+        std::cout << "HAIntegration: Republished " << republished << " discovery config(s)" << std::endl;
+    }
+}
+
+bool HAIntegration::publishState(const std::string& entityId, const std::string& state, const std::string& attributes) {
+    return publishState(registerEntity(entityId), state, attributes);
+}
+
+bool HAIntegration::publishState(EntityHandle entity, const std::string& state, const std::string& attributes) {
+    HAPublishResult result = tryPublishState(entity, state, attributes);
+    if (result == HAPublishResult::FAILED && (!mqttClient_ || !mqttClient_->isConnected())) {
         std::cerr << "HAIntegration: MQTT client not connected" << std::endl;
-        return;
+    }
+    if (result == HAPublishResult::SENT && publishConfig_.verboseLogging) {
+        std::cout << "HAIntegration: Published state for " << entity->entityId_ << ": " << state << std::endl;
+    }
+    return result == HAPublishResult::SENT;
+}
+
+HAPublishResult HAIntegration::tryPublishState(EntityHandle entity, const std::string& state,
+                                               const std::string& attributes) {
+    if (!mqttClient_ || !mqttClient_->isConnected()) {
+        failed_++;
+        return HAPublishResult::FAILED;
     }
     
-    std::string topic = getStateTopic(entityId);
-    std::string payload;
+    std::lock_guard<std::mutex> lock(publishMutex_);
+    HAEntity& entry = *entity;
+    auto now = std::chrono::steady_clock::now();
+    bool neverSent = entry.lastSent_ == std::chrono::steady_clock::time_point();
+    bool attributesChanged = !attributes.empty() && attributes != entry.publishedAttributes_;
+    bool heartbeatDue = publishConfig_.heartbeatSeconds > 0 &&
+                        now - entry.lastSent_ >= std::chrono::seconds(publishConfig_.heartbeatSeconds);
+    
+    // Numeric states compare against the last published value, so a slow
+    // drift is still published once it adds up to the deadband
+    bool changed = state != entry.publishedState_;
+    double value = 0.0;
+    double deadband = entry.deadband_ >= 0.0 ? entry.deadband_ : publishConfig_.deadband;
+    if (changed && deadband > 0.0 && entry.publishedNumeric_ && parseNumber(state, value)) {
+        changed = std::fabs(value - entry.publishedValue_) >= deadband;
+    }
+    
+    if (!neverSent && !changed && !attributesChanged && !heartbeatDue && publishConfig_.suppressUnchanged) {
+        suppressed_++;
+        return HAPublishResult::SUPPRESSED;
+    }
     
-    // If attributes provided, create JSON payload, otherwise just send state value
+    // Attributes go out when they change and with every heartbeat
+    bool heartbeat = !neverSent && !changed && !attributesChanged && heartbeatDue;
+    bool withAttributes = neverSent || attributesChanged || heartbeatDue;
+    const std::string& sentAttributes = attributes.empty() ? entry.publishedAttributes_ : attributes;
+    if (!sendState(entry, state, withAttributes ? sentAttributes : std::string())) {
+        failed_++;
+        return HAPublishResult::FAILED;
+    }
+    if (heartbeat) {
+        heartbeats_++;
+    }
+    return HAPublishResult::SENT;
+}
+
+bool HAIntegration::sendState(HAEntity& entity, const std::string& state, const std::string& attributes) {
+    // Reused per thread: once warmed up, building a payload does not allocate
+    thread_local std::string payload;
+    payload.clear();
     if (!attributes.empty()) {
-        std::ostringstream oss;
-        oss << "{\"state\": \"" << escapeJsonString(state) << "\", \"attributes\": " << attributes << "}";
-        payload = oss.str();
+        payload += "{\"state\": \"";
+        appendJsonEscaped(payload, state);
+        payload += "\", \"attributes\": ";
+        payload += attributes;
+        payload += '}';
     } else {
-        payload = state;
+        payload += state;
     }
     
-    mqttClient_->publish(topic, payload);
+    if (!mqttClient_->publish(entity.stateTopic_, payload)) {
+        return false;
+    }
     
-    std::cout << "HAIntegration: Published state for " << entityId << ": " << state << std::endl;
+    published_++;
+    if (!attributes.empty()) {
+        attributesPublished_++;
+        if (&attributes != &entity.publishedAttributes_) {
+            entity.publishedAttributes_ = attributes;
+        }
+    }
+    if (&state != &entity.publishedState_) {
+        entity.publishedState_ = state;
+    }
+    entity.publishedNumeric_ = parseNumber(state, entity.publishedValue_);
+    entity.lastSent_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+void HAIntegration::setDeadband(const std::string& entityId, double deadband) {
+    setDeadband(registerEntity(entityId), deadband);
+}
+
+void HAIntegration::setDeadband(EntityHandle entity, double deadband) {
+    std::lock_guard<std::mutex> lock(publishMutex_);
+    entity->deadband_ = deadband;
+}
+
+size_t HAIntegration::publishHeartbeats() {
+    if (publishConfig_.heartbeatSeconds <= 0 || !mqttClient_ || !mqttClient_->isConnected()) {
+        return 0;
+    }
+    
+    std::lock_guard<std::mutex> entitiesLock(entitiesMutex_);
+    std::lock_guard<std::mutex> lock(publishMutex_);
+    auto cutoff = std::chrono::steady_clock::now() - std::chrono::seconds(publishConfig_.heartbeatSeconds);
+    size_t sent = 0;
+    for (auto& entry : entities_) {
+        HAEntity& entity = *entry.second;
+        if (entity.lastSent_ == std::chrono::steady_clock::time_point() || entity.lastSent_ > cutoff) {
+            continue;
+        }
+        if (sendState(entity, entity.publishedState_, entity.publishedAttributes_)) {
+            heartbeats_++;
+            sent++;
+        }
+    }
+    return sent;
+}
+
+void HAIntegration::resetPublishCache() {
+    std::lock_guard<std::mutex> entitiesLock(entitiesMutex_);
+    std::lock_guard<std::mutex> lock(publishMutex_);
+    for (auto& entry : entities_) {
+        HAEntity& entity = *entry.second;
+        entity.publishedState_.clear();
+        entity.publishedValue_ = 0.0;
+        entity.publishedNumeric_ = false;
+        entity.publishedAttributes_.clear();
+        entity.lastSent_ = std::chrono::steady_clock::time_point();
+    }
+}
+
+HAPublishStats HAIntegration::getPublishStats() const {
+    HAPublishStats stats;
+    stats.published = published_;
+    stats.suppressed = suppressed_;
+    stats.heartbeats = heartbeats_;
+    stats.attributesPublished = attributesPublished_;
+    stats.failed = failed_;
+    stats.discoveryPublished = discoveryPublished_;
+    return stats;
 }
 
 bool HAIntegration::parseStateMessage(const std::string& payload, std::string& state, std::string& attributes) {
@@ -155,7 +394,7 @@ bool HAIntegration::parseStateMessage(const std::string& payload, std::string& s
             size_t quoteEnd = payload.find("\"", quoteStart + 1);
             
             if (quoteEnd != std::string::npos) {
-                state = payload.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
+                state.assign(payload, quoteStart + 1, quoteEnd - quoteStart - 1);
             }
         }
         
@@ -177,7 +416,7 @@ bool HAIntegration::parseStateMessage(const std::string& payload, std::string& s
                     pos++;
                 }
                 if (braceCount == 0) {
-                    attributes = payload.substr(braceStart, pos - braceStart);
+                    attributes.assign(payload, braceStart, pos - braceStart);
                 }
             }
         }
@@ -186,7 +425,7 @@ bool HAIntegration::parseStateMessage(const std::string& payload, std::string& s
     } else {
         // Plain text state
         state = payload;
-        attributes = "";
+        attributes.clear();
         return true;
     }
 }
@@ -197,16 +436,20 @@ std::string HAIntegration::createCommandPayload(const std::string& command, cons
     }
     
     // Create simple JSON payload
-    std::ostringstream oss;
-    oss << "{\"command\": \"" << command << "\", \"data\": " << data << "}";
-    return oss.str();
+    std::string payload;
+    payload.reserve(command.size() + data.size() + 32);
+    payload += "{\"command\": \"";
+    payload += command;
+    payload += "\", \"data\": ";
+    payload += data;
+    payload += '}';
+    return payload;
 }
 
 std::string HAIntegration::getStateTopic(const std::string& entityId) const {
     // HA state topic format: homeassistant/<domain>/<node_id>/<object_id>/state
     // or simpler: homeassistant/state/<entity_id>
     return haDiscoveryPrefix_ + "/state/" + entityId;
-//twi    return haDiscoveryPrefix_ + "/" + entityId;
 }
 
 std::string HAIntegration::getCommandTopic(const std::string& entityId) const {
@@ -218,7 +461,17 @@ std::string HAIntegration::getCommandTopic(const std::string& entityId) const {
 std::string HAIntegration::getDiscoveryTopic(const std::string& component, const std::string& nodeId, 
                                              const std::string& objectId) const {
     // HA discovery topic format: <discovery_prefix>/<component>/[<node_id>/]<object_id>/config
-    return haDiscoveryPrefix_ + "/" + component + "/" + nodeId + "/" + objectId + "/config";
+    std::string topic;
+    topic.reserve(haDiscoveryPrefix_.size() + component.size() + nodeId.size() + objectId.size() + 10);
+    topic += haDiscoveryPrefix_;
+    topic += '/';
+    topic += component;
+    topic += '/';
+    topic += nodeId;
+    topic += '/';
+    topic += objectId;
+    topic += "/config";
+    return topic;
 }
 
 std::string HAIntegration::extractDomain(const std::string& entityId) {
@@ -231,32 +484,49 @@ std::string HAIntegration::extractDomain(const std::string& entityId) {
 
 void HAIntegration::handleStateMessage(const std::string& topic, const std::string& payload) {
     // Validate topic starts with expected prefix
-    std::string expectedPrefix = haDiscoveryPrefix_ + "/state/";
-    if (topic.find(expectedPrefix) != 0) {
+    // Topic format: homeassistant/state/<entity_id>
+    if (topic.compare(0, statePrefix_.size(), statePrefix_) != 0) {
         return;
     }
     
-    // Extract entity ID from topic
-    // Topic format: homeassistant/state/<entity_id>
-    std::string entityId = topic.substr(expectedPrefix.length());
-    
-    // Parse the message
-    std::string state, attributes;
-    if (parseStateMessage(payload, state, attributes)) {
-        // Call entity-specific callback if registered
-        auto entityIt = entityCallbacks_.find(entityId);
-        if (entityIt != entityCallbacks_.end()) {
-            entityIt->second(entityId, state, attributes);
+    // Every entity's state arrives here; drop other domains before any
+    // registration or parsing
+    std::string_view entityId = std::string_view(topic).substr(statePrefix_.size());
+    std::string_view domain = entityId.substr(0, entityId.find('.'));
+    EntityHandle entity = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(entitiesMutex_);
+        auto it = entities_.find(entityId);
+        if (it != entities_.end()) {
+            entity = it->second.get();
+        } else if (domainCallbacks_.find(domain) == domainCallbacks_.end()) {
+            return;
         }
-        
-        // Call domain callback if registered
-        std::string domain = extractDomain(entityId);
-        auto domainIt = domainCallbacks_.find(domain);
-        if (domainIt != domainCallbacks_.end()) {
-            domainIt->second(entityId, state, attributes);
-        }
-        
-        std::cout << "HAIntegration: Received state update for " << entityId 
+    }
+    if (!entity) {
+        entity = registerEntity(std::string(entityId));   // First message from this entity
+    }
+    dispatchState(*entity, entity->domainCallback_.load(std::memory_order_acquire), payload);
+}
+
+void HAIntegration::dispatchState(const HAEntity& entity, const StateCallback* callback, const std::string& payload) {
+    if (!callback) {
+        return;
+    }
+    
+    // Parsed into per-thread buffers that keep their capacity between messages
+    thread_local std::string state;
+    thread_local std::string attributes;
+    state.clear();
+    attributes.clear();
+    if (!parseStateMessage(payload, state, attributes)) {
+        return;
+    }
+    
+    (*callback)(entity.entityId_, state, attributes);
+    
+    if (publishConfig_.verboseLogging) {
+        std::cout << "HAIntegration: Received state update for " << entity.entityId_ 
                   << ": state=" << state << std::endl;
     }
 }
@@ -287,25 +557,32 @@ void HAIntegration::handleDiscoveryMessage(const std::string& topic, const std::
 }
 
 std::string HAIntegration::escapeJsonString(const std::string& input) {
-    std::ostringstream escaped;
+    std::string escaped;
+    escaped.reserve(input.size());
+    appendJsonEscaped(escaped, input);
+    return escaped;
+}
+
+void HAIntegration::appendJsonEscaped(std::string& out, const std::string& input) {
+    static const char hex[] = "0123456789abcdef";
     for (char c : input) {
         switch (c) {
-            case '"': escaped << "\\\""; break;
-            case '\\': escaped << "\\\\"; break;
-            case '\b': escaped << "\\b"; break;
-            case '\f': escaped << "\\f"; break;
-            case '\n': escaped << "\\n"; break;
-            case '\r': escaped << "\\r"; break;
-            case '\t': escaped << "\\t"; break;
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
             default:
                 // Escape control characters
                 if (static_cast<unsigned char>(c) < 0x20) {
-                    escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') 
-                            << static_cast<int>(static_cast<unsigned char>(c));
+                    out += "\\u00";
+                    out += hex[static_cast<unsigned char>(c) >> 4];
+                    out += hex[static_cast<unsigned char>(c) & 0xF];
                 } else {
-                    escaped << c;
+                    out += c;
                 }
         }
     }
-    return escaped.str();
 }
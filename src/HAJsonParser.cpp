@@ -0,0 +1,844 @@
+#include "HAJsonParser.h"
+#include "HARestClient.h"
+#include <cstring>
+#include <algorithm>
+
+JsonTokenizer::JsonTokenizer(std::string_view json)
+    : json_(json),
+      pos_(0),
+      tokenStart_(0),
+      escaped_(false),
+      expectKey_(false),
+      failed_(false),
+      depth_(0),
+      objectBits_(0) {}
+
+bool JsonTokenizer::inObject() const {
+    return depth_ > 0 && ((objectBits_ >> (depth_ - 1)) & 1);
+}
+
+void JsonTokenizer::push(bool object) {
+    uint64_t bit = uint64_t(1) << depth_;
+    objectBits_ = object ? (objectBits_ | bit) : (objectBits_ & ~bit);
+    ++depth_;
+    expectKey_ = object;
+}
+
+void JsonTokenizer::finishValue() {
+    // Inside an object every value is followed by another key (or '}')
+    expectKey_ = inObject();
+}
+
+JsonTokenizer::Token JsonTokenizer::fail() {
+    failed_ = true;
+    pos_ = tokenStart_;
+    return Token::ERROR;
+}
+
+JsonTokenizer::Token JsonTokenizer::next() {
+    if (failed_) {
+        return Token::ERROR;
+    }
+
+    // Commas carry no information for a streaming reader; treat them as whitespace
+    size_t size = json_.size();
+    while (pos_ < size) {
+        char c = json_[pos_];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t' && c != ',') {
+            break;
+        }
+        ++pos_;
+    }
+    tokenStart_ = pos_;
+
+    if (pos_ >= size) {
+        return depth_ == 0 ? Token::END : fail();
+    }
+
+    char c = json_[pos_];
+    if (expectKey_ && c != '"' && c != '}') {
+        return fail();
+    }
+
+    switch (c) {
+    case '{':
+    case '[':
+        if (depth_ >= MAX_DEPTH) {
+            return fail();
+        }
+        ++pos_;
+        push(c == '{');
+        return c == '{' ? Token::BEGIN_OBJECT : Token::BEGIN_ARRAY;
+
+    case '}':
+    case ']':
+        if (depth_ == 0 || inObject() != (c == '}')) {
+            return fail();
+        }
+        ++pos_;
+        --depth_;
+        finishValue();
+        return c == '}' ? Token::END_OBJECT : Token::END_ARRAY;
+
+    case '"': {
+        size_t start = ++pos_;
+        escaped_ = false;
+        for (;;) {
+            if (pos_ >= size) {
+                return fail();
+            }
+            char ch = json_[pos_];
+            if (ch == '"') {
+                break;
+            }
+            if (ch == '\\') {
+                escaped_ = true;
+                pos_ += 2;
+            } else {
+                ++pos_;
+            }
+        }
+        value_ = json_.substr(start, pos_ - start);
+        ++pos_;
+
+        if (!expectKey_) {
+            finishValue();
+            return Token::STRING;
+        }
+
+        while (pos_ < size && (json_[pos_] == ' ' || json_[pos_] == '\n' ||
+                               json_[pos_] == '\r' || json_[pos_] == '\t')) {
+            ++pos_;
+        }
+        if (pos_ >= size || json_[pos_] != ':') {
+            return fail();
+        }
+        ++pos_;
+        expectKey_ = false;
+        return Token::KEY;
+    }
+
+    case 't':
+    case 'f':
+    case 'n': {
+        static const std::string_view literals[] = {"true", "false", "null"};
+        static const Token tokens[] = {Token::TRUE_VALUE, Token::FALSE_VALUE, Token::NULL_VALUE};
+        for (size_t i = 0; i < 3; ++i) {
+            if (json_.compare(pos_, literals[i].size(), literals[i]) == 0) {
+                value_ = json_.substr(pos_, literals[i].size());
+                pos_ += literals[i].size();
+                finishValue();
+                return tokens[i];
+            }
+        }
+        return fail();
+    }
+
+    default:
+        if (c != '-' && (c < '0' || c > '9')) {
+            return fail();
+        }
+        while (pos_ < size) {
+            char ch = json_[pos_];
+            if ((ch < '0' || ch > '9') && ch != '-' && ch != '+' && ch != '.' && ch != 'e' && ch != 'E') {
+                break;
+            }
+            ++pos_;
+        }
+        value_ = json_.substr(tokenStart_, pos_ - tokenStart_);
+        finishValue();
+        return Token::NUMBER;
+    }
+}
+
+bool JsonTokenizer::skipContainer() {
+    if (depth_ == 0) {
+        return false;
+    }
+    size_t target = depth_ - 1;
+    while (depth_ > target) {
+        Token token = next();
+        if (token == Token::ERROR || token == Token::END) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool JsonTokenizer::skipValue() {
+    switch (next()) {
+    case Token::BEGIN_OBJECT:
+    case Token::BEGIN_ARRAY:
+        return skipContainer();
+    case Token::STRING:
+    case Token::NUMBER:
+    case Token::TRUE_VALUE:
+    case Token::FALSE_VALUE:
+    case Token::NULL_VALUE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// HAJsonParser
+
+namespace {
+
+void appendUtf8(std::string& out, uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        out.push_back(static_cast<char>(codepoint));
+    } else if (codepoint < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else if (codepoint < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+}
+
+bool readHex4(std::string_view text, size_t pos, uint32_t& value) {
+    if (pos + 4 > text.size()) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = pos; i < pos + 4; ++i) {
+        char c = text[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') {
+            value |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            value |= c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            value |= c - 'A' + 10;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Parse exactly count digits starting at pos
+bool readDigits(std::string_view text, size_t pos, size_t count, int& value) {
+    if (pos + count > text.size()) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = pos; i < pos + count; ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+long daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long yearOfEra = year - era * 400;
+    long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+} // namespace
+
+bool HAJsonParser::unescape(std::string_view raw, std::string& out) {
+    size_t pos = 0;
+    while (pos < raw.size()) {
+        size_t backslash = raw.find('\\', pos);
+        if (backslash == std::string_view::npos) {
+            out.append(raw.data() + pos, raw.size() - pos);
+            break;
+        }
+        out.append(raw.data() + pos, backslash - pos);
+        if (backslash + 1 >= raw.size()) {
+            return false;
+        }
+
+        char c = raw[backslash + 1];
+        pos = backslash + 2;
+        switch (c) {
+        case '"':  out.push_back('"'); break;
+        case '\\': out.push_back('\\'); break;
+        case '/':  out.push_back('/'); break;
+        case 'b':  out.push_back('\b'); break;
+        case 'f':  out.push_back('\f'); break;
+        case 'n':  out.push_back('\n'); break;
+        case 'r':  out.push_back('\r'); break;
+        case 't':  out.push_back('\t'); break;
+        case 'u': {
+            uint32_t codepoint;
+            if (!readHex4(raw, pos, codepoint)) {
+                return false;
+            }
+            pos += 4;
+            // UTF-16 surrogate pair for characters outside the BMP
+            if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+                uint32_t low;
+                if (pos + 1 < raw.size() && raw[pos] == '\\' && raw[pos + 1] == 'u' &&
+                    readHex4(raw, pos + 2, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                    codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    pos += 6;
+                } else {
+                    codepoint = 0xFFFD;
+                }
+            } else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+                codepoint = 0xFFFD;
+            }
+            appendUtf8(out, codepoint);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+long HAJsonParser::parseTimestamp(std::string_view text) {
+    // YYYY-MM-DDTHH:MM:SS, then optional fraction and zone designator
+    int year, month, day, hour, minute, second;
+    if (!readDigits(text, 0, 4, year) || text.size() < 19 || text[4] != '-' ||
+        !readDigits(text, 5, 2, month) || text[7] != '-' ||
+        !readDigits(text, 8, 2, day) || (text[10] != 'T' && text[10] != ' ') ||
+        !readDigits(text, 11, 2, hour) || text[13] != ':' ||
+        !readDigits(text, 14, 2, minute) || text[16] != ':' ||
+        !readDigits(text, 17, 2, second)) {
+        return 0;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return 0;
+    }
+
+    size_t pos = 19;
+    if (pos < text.size() && text[pos] == '.') {
+        ++pos;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+            ++pos;   // Sub-second precision is dropped
+        }
+    }
+
+    long offsetSeconds = 0;
+    if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+        int offsetHours, offsetMinutes;
+        size_t minutesPos = pos + 3;
+        if (minutesPos < text.size() && text[minutesPos] == ':') {
+            ++minutesPos;
+        }
+        if (!readDigits(text, pos + 1, 2, offsetHours) || !readDigits(text, minutesPos, 2, offsetMinutes)) {
+            return 0;
+        }
+        offsetSeconds = offsetHours * 3600L + offsetMinutes * 60L;
+        if (text[pos] == '-') {
+            offsetSeconds = -offsetSeconds;
+        }
+    }
+
+    long days = daysFromCivil(year, month, day);
+    return days * 86400L + hour * 3600L + minute * 60L + second - offsetSeconds;
+}
+
+bool HAJsonParser::readString(JsonTokenizer& tokenizer, std::string& out) {
+    out.clear();
+    switch (tokenizer.next()) {
+    case JsonTokenizer::Token::STRING:
+        return unescape(tokenizer.value(), out);
+    case JsonTokenizer::Token::NUMBER:
+    case JsonTokenizer::Token::TRUE_VALUE:
+    case JsonTokenizer::Token::FALSE_VALUE:
+        out.assign(tokenizer.value().data(), tokenizer.value().size());
+        return true;
+    case JsonTokenizer::Token::NULL_VALUE:
+        return true;
+    case JsonTokenizer::Token::BEGIN_OBJECT:
+    case JsonTokenizer::Token::BEGIN_ARRAY:
+        return tokenizer.skipContainer();   // Not a string; leave it empty
+    default:
+        return false;
+    }
+}
+
+bool HAJsonParser::readTimestamp(JsonTokenizer& tokenizer, long& out) {
+    JsonTokenizer::Token token = tokenizer.next();
+    if (token == JsonTokenizer::Token::STRING) {
+        out = parseTimestamp(tokenizer.value());
+        return true;
+    }
+    if (token == JsonTokenizer::Token::BEGIN_OBJECT || token == JsonTokenizer::Token::BEGIN_ARRAY) {
+        return tokenizer.skipContainer();
+    }
+    return token != JsonTokenizer::Token::ERROR && token != JsonTokenizer::Token::END &&
+           token != JsonTokenizer::Token::END_OBJECT && token != JsonTokenizer::Token::END_ARRAY;
+}
+
+bool HAJsonParser::readState(JsonTokenizer& tokenizer, HASensorData& data) {
+    data.entityId.clear();
+    data.state.clear();
+    data.unitOfMeasurement.clear();
+    data.friendlyName.clear();
+    data.deviceClass.clear();
+    data.lastChanged = 0;
+    data.lastUpdated = 0;
+
+    for (;;) {
+        JsonTokenizer::Token token = tokenizer.next();
+        if (token == JsonTokenizer::Token::END_OBJECT) {
+            return true;
+        }
+        if (token != JsonTokenizer::Token::KEY) {
+            return false;
+        }
+
+        std::string_view key = tokenizer.value();
+        bool ok;
+        if (key == "entity_id") {
+            ok = readString(tokenizer, data.entityId);
+        } else if (key == "state") {
+            ok = readString(tokenizer, data.state);
+        } else if (key == "last_changed") {
+            ok = readTimestamp(tokenizer, data.lastChanged);
+        } else if (key == "last_updated") {
+            ok = readTimestamp(tokenizer, data.lastUpdated);
+        } else if (key == "attributes") {
+            token = tokenizer.next();
+            if (token == JsonTokenizer::Token::BEGIN_OBJECT) {
+                ok = true;
+                while (ok) {
+                    token = tokenizer.next();
+                    if (token == JsonTokenizer::Token::END_OBJECT) {
+                        break;
+                    }
+                    if (token != JsonTokenizer::Token::KEY) {
+                        return false;
+                    }
+                    std::string_view attribute = tokenizer.value();
+                    if (attribute == "unit_of_measurement") {
+                        ok = readString(tokenizer, data.unitOfMeasurement);
+                    } else if (attribute == "friendly_name") {
+                        ok = readString(tokenizer, data.friendlyName);
+                    } else if (attribute == "device_class") {
+                        ok = readString(tokenizer, data.deviceClass);
+                    } else {
+                        ok = tokenizer.skipValue();
+                    }
+                }
+            } else {
+                ok = token == JsonTokenizer::Token::BEGIN_ARRAY ? tokenizer.skipContainer()
+                                                                : token == JsonTokenizer::Token::NULL_VALUE;
+            }
+        } else {
+            ok = tokenizer.skipValue();   // context, last_reported, ...
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+}
+
+bool HAJsonParser::readHistoryEntry(JsonTokenizer& tokenizer, HAHistoricalData& entry) {
+    entry.entityId.clear();
+    entry.state.clear();
+    entry.timestamp = 0;
+    entry.attributes.clear();
+    long lastUpdated = 0;
+
+    for (;;) {
+        JsonTokenizer::Token token = tokenizer.next();
+        if (token == JsonTokenizer::Token::END_OBJECT) {
+            break;
+        }
+        if (token != JsonTokenizer::Token::KEY) {
+            return false;
+        }
+
+        std::string_view key = tokenizer.value();
+        bool ok;
+        if (key == "entity_id") {
+            ok = readString(tokenizer, entry.entityId);
+        } else if (key == "state") {
+            ok = readString(tokenizer, entry.state);
+        } else if (key == "last_changed") {
+            ok = readTimestamp(tokenizer, entry.timestamp);
+        } else if (key == "last_updated") {
+            ok = readTimestamp(tokenizer, lastUpdated);
+        } else if (key == "attributes") {
+            token = tokenizer.next();
+            if (token == JsonTokenizer::Token::BEGIN_OBJECT) {
+                ok = true;
+                std::string name;
+                while (ok) {
+                    token = tokenizer.next();
+                    if (token == JsonTokenizer::Token::END_OBJECT) {
+                        break;
+                    }
+                    if (token != JsonTokenizer::Token::KEY) {
+                        return false;
+                    }
+                    name.clear();
+                    if (!unescape(tokenizer.value(), name)) {
+                        return false;
+                    }
+
+                    // Scalars are stored decoded, nested values as their raw JSON text
+                    std::string& value = entry.attributes[name];
+                    token = tokenizer.next();
+                    switch (token) {
+                    case JsonTokenizer::Token::STRING:
+                        ok = unescape(tokenizer.value(), value);
+                        break;
+                    case JsonTokenizer::Token::NUMBER:
+                    case JsonTokenizer::Token::TRUE_VALUE:
+                    case JsonTokenizer::Token::FALSE_VALUE:
+                        value.assign(tokenizer.value().data(), tokenizer.value().size());
+                        break;
+                    case JsonTokenizer::Token::NULL_VALUE:
+                        break;
+                    case JsonTokenizer::Token::BEGIN_OBJECT:
+                    case JsonTokenizer::Token::BEGIN_ARRAY: {
+                        size_t start = tokenizer.tokenStart();
+                        ok = tokenizer.skipContainer();
+                        value.assign(tokenizer.input().substr(start, tokenizer.position() - start));
+                        break;
+                    }
+                    default:
+                        return false;
+                    }
+                }
+            } else {
+                ok = token == JsonTokenizer::Token::BEGIN_ARRAY ? tokenizer.skipContainer()
+                                                                : token == JsonTokenizer::Token::NULL_VALUE;
+            }
+        } else {
+            ok = tokenizer.skipValue();
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+
+    if (entry.timestamp == 0) {
+        entry.timestamp = lastUpdated;
+    }
+    return true;
+}
+
+bool HAJsonParser::parseState(std::string_view json, HASensorData& data) {
+    JsonTokenizer tokenizer(json);
+    return tokenizer.next() == JsonTokenizer::Token::BEGIN_OBJECT && readState(tokenizer, data);
+}
+
+bool HAJsonParser::parseHistoryEntry(std::string_view json, HAHistoricalData& entry) {
+    JsonTokenizer tokenizer(json);
+    return tokenizer.next() == JsonTokenizer::Token::BEGIN_OBJECT && readHistoryEntry(tokenizer, entry);
+}
+
+bool HAJsonParser::peekEntityId(std::string_view json, std::string_view& entityId) {
+    JsonTokenizer tokenizer(json);
+    if (tokenizer.next() != JsonTokenizer::Token::BEGIN_OBJECT) {
+        return false;
+    }
+
+    // Home Assistant writes entity_id first, so this rarely skips anything
+    for (;;) {
+        JsonTokenizer::Token token = tokenizer.next();
+        if (token != JsonTokenizer::Token::KEY) {
+            return false;
+        }
+        if (tokenizer.value() == "entity_id") {
+            if (tokenizer.next() != JsonTokenizer::Token::STRING) {
+                return false;
+            }
+            entityId = tokenizer.value();   // Entity ids never contain escapes
+            return true;
+        }
+        if (!tokenizer.skipValue()) {
+            return false;
+        }
+    }
+}
+
+bool HAJsonParser::parseStates(std::string_view json, std::vector<HASensorData>& states) {
+    JsonTokenizer tokenizer(json);
+    if (tokenizer.next() != JsonTokenizer::Token::BEGIN_ARRAY) {
+        return false;
+    }
+
+    for (;;) {
+        JsonTokenizer::Token token = tokenizer.next();
+        if (token == JsonTokenizer::Token::END_ARRAY) {
+            return true;
+        }
+        if (token == JsonTokenizer::Token::BEGIN_OBJECT) {
+            states.emplace_back();
+            if (!readState(tokenizer, states.back())) {
+                states.pop_back();
+                return false;
+            }
+            if (states.back().entityId.empty()) {
+                states.pop_back();
+            }
+        } else if (token == JsonTokenizer::Token::BEGIN_ARRAY) {
+            if (!tokenizer.skipContainer()) {
+                return false;
+            }
+        } else if (token == JsonTokenizer::Token::ERROR || token == JsonTokenizer::Token::END) {
+            return false;
+        }
+    }
+}
+
+bool HAJsonParser::parseHistory(std::string_view json, std::vector<HAHistoricalData>& history) {
+    JsonTokenizer tokenizer(json);
+    if (tokenizer.next() != JsonTokenizer::Token::BEGIN_ARRAY) {
+        return false;
+    }
+
+    // One inner array per entity
+    for (;;) {
+        JsonTokenizer::Token token = tokenizer.next();
+        if (token == JsonTokenizer::Token::END_ARRAY) {
+            return true;
+        }
+        if (token == JsonTokenizer::Token::ERROR || token == JsonTokenizer::Token::END) {
+            return false;
+        }
+        if (token == JsonTokenizer::Token::BEGIN_OBJECT) {
+            if (!tokenizer.skipContainer()) {
+                return false;
+            }
+            continue;
+        }
+        if (token != JsonTokenizer::Token::BEGIN_ARRAY) {
+            continue;
+        }
+
+        size_t firstInArray = history.size();
+        for (;;) {
+            token = tokenizer.next();
+            if (token == JsonTokenizer::Token::END_ARRAY) {
+                break;
+            }
+            if (token == JsonTokenizer::Token::BEGIN_OBJECT) {
+                history.emplace_back();
+                if (!readHistoryEntry(tokenizer, history.back())) {
+                    history.pop_back();
+                    return false;
+                }
+                // minimal_response: later entries inherit the first entry's entity_id
+                if (history.back().entityId.empty() && history.size() > firstInArray) {
+                    history.back().entityId = history[firstInArray].entityId;
+                }
+                if (history.back().entityId.empty()) {
+                    history.pop_back();
+                }
+            } else if (token == JsonTokenizer::Token::BEGIN_ARRAY) {
+                if (!tokenizer.skipContainer()) {
+                    return false;
+                }
+            } else if (token == JsonTokenizer::Token::ERROR || token == JsonTokenizer::Token::END) {
+                return false;
+            }
+        }
+    }
+}
+
+// JsonObjectStream
+
+JsonObjectStream::JsonObjectStream(size_t objectDepth, ObjectCallback callback)
+    : objectDepth_(objectDepth),
+      callback_(std::move(callback)) {
+    reset();
+}
+
+void JsonObjectStream::reset() {
+    pending_.clear();
+    depth_ = 0;
+    inString_ = false;
+    escape_ = false;
+    capturing_ = false;
+    started_ = false;
+    done_ = false;
+    failed_ = false;
+    bytesConsumed_ = 0;
+    peakBufferSize_ = 0;
+}
+
+bool JsonObjectStream::fail() {
+    failed_ = true;
+    pending_.clear();
+    return false;
+}
+
+bool JsonObjectStream::feed(const char* data, size_t length) {
+    if (failed_) {
+        return false;
+    }
+
+    // Only string/escape state and nesting depth are tracked here; each
+    // object is handed to the callback once its closing brace is seen
+    size_t captureFrom = 0;
+    for (size_t i = 0; i < length; ++i) {
+        char c = data[i];
+        if (inString_) {
+            if (escape_) {
+                escape_ = false;
+            } else if (c == '\\') {
+                escape_ = true;
+            } else if (c == '"') {
+                inString_ = false;
+            }
+            continue;
+        }
+
+        switch (c) {
+        case ' ':
+        case '\n':
+        case '\r':
+        case '\t':
+            break;
+        case '"':
+            inString_ = true;
+            break;
+        case '{':
+        case '[':
+            if (!started_) {
+                if (c != '[') {
+                    return fail();   // e.g. an error object instead of the expected array
+                }
+                started_ = true;
+            } else if (done_ || depth_ >= JsonTokenizer::MAX_DEPTH) {
+                return fail();
+            }
+            if (c == '{' && depth_ == objectDepth_ && !capturing_) {
+                capturing_ = true;
+                captureFrom = i;
+            }
+            ++depth_;
+            break;
+        case '}':
+        case ']':
+            if (depth_ == 0) {
+                return fail();
+            }
+            --depth_;
+            if (capturing_ && depth_ == objectDepth_) {
+                capturing_ = false;
+                bool ok;
+                if (pending_.empty()) {
+                    ok = callback_(std::string_view(data + captureFrom, i + 1 - captureFrom));
+                } else {
+                    pending_.append(data, i + 1);
+                    peakBufferSize_ = std::max(peakBufferSize_, pending_.size());
+                    ok = callback_(pending_);
+                    pending_.clear();
+                }
+                if (!ok) {
+                    return fail();
+                }
+            } else if (depth_ == 0) {
+                done_ = true;
+            }
+            break;
+        default:
+            if (!started_ || done_) {
+                return fail();
+            }
+            break;
+        }
+    }
+
+    // Keep the unfinished object for the next chunk
+    if (capturing_) {
+        if (pending_.empty()) {
+            pending_.assign(data + captureFrom, length - captureFrom);
+        } else {
+            pending_.append(data, length);
+        }
+    }
+    bytesConsumed_ += length;
+    return true;
+}
+
+bool JsonObjectStream::finish() const {
+    return !failed_ && done_;
+}
+
+// HAHistoryStreamParser
+
+HAHistoryStreamParser::HAHistoryStreamParser(EntryCallback callback)
+    : callback_(std::move(callback)),
+      entry_(new HAHistoricalData()),
+      stream_(2, [this](std::string_view object) { return emit(object); }),   // Inside the per-entity arrays
+      entryCount_(0) {}
+
+HAHistoryStreamParser::~HAHistoryStreamParser() = default;
+
+void HAHistoryStreamParser::reset() {
+    stream_.reset();
+    previousEntityId_.clear();
+    entryCount_ = 0;
+}
+
+bool HAHistoryStreamParser::emit(std::string_view object) {
+    // minimal_response only names the entity in its first entry, so an
+    // entry without entity_id belongs to the one before it
+    previousEntityId_.swap(entry_->entityId);
+    if (!HAJsonParser::parseHistoryEntry(object, *entry_)) {
+        return false;
+    }
+    if (entry_->entityId.empty()) {
+        entry_->entityId.swap(previousEntityId_);
+    }
+    if (!entry_->entityId.empty()) {
+        ++entryCount_;
+        callback_(*entry_);
+    }
+    return true;
+}
+
+// HAStateStreamParser
+
+HAStateStreamParser::HAStateStreamParser(StateCallback callback, const std::string& entityPrefix)
+    : callback_(std::move(callback)),
+      entityPrefix_(entityPrefix),
+      state_(new HASensorData()),
+      stream_(1, [this](std::string_view object) { return emit(object); }),
+      entryCount_(0),
+      skippedCount_(0) {}
+
+HAStateStreamParser::~HAStateStreamParser() = default;
+
+void HAStateStreamParser::reset() {
+    stream_.reset();
+    entryCount_ = 0;
+    skippedCount_ = 0;
+}
+
+bool HAStateStreamParser::emit(std::string_view object) {
+    if (!entityPrefix_.empty()) {
+        std::string_view entityId;
+        if (!HAJsonParser::peekEntityId(object, entityId) ||
+            entityId.compare(0, entityPrefix_.size(), entityPrefix_) != 0) {
+            ++skippedCount_;
+            return true;
+        }
+    }
+
+    if (!HAJsonParser::parseState(object, *state_)) {
+        return false;
+    }
+    if (!state_->entityId.empty()) {
+        ++entryCount_;
+        callback_(*state_);
+    }
+    return true;
+}
@@ -1,16 +1,37 @@
 #include "HARestClient.h"
+#include "HAJsonParser.h"
 #include <iostream>
 #include <sstream>
 #include <ctime>
+#include <algorithm>
 
 // Callback function for curl to write response data
-static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp) {
-    userp->append((char*)contents, size * nmemb);
+static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    static_cast<std::string*>(userp)->append((char*)contents, size * nmemb);
     return size * nmemb;
 }
 
-HARestClient::HARestClient(const std::string& baseUrl, const std::string& token)
-    : baseUrl_(baseUrl), token_(token) {
+// Callback feeding the response straight into a stream parser
+template <typename Parser>
+static size_t StreamCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    auto* parser = static_cast<Parser*>(userp);
+    if (!parser->feed(static_cast<const char*>(contents), size * nmemb)) {
+        return 0;   // Abort the transfer on malformed data
+    }
+    return size * nmemb;
+}
+
+HARestClient::HARestClient(const std::string& baseUrl, const std::string& token,
+                           const HARestClientConfig& config)
+    : baseUrl_(baseUrl),
+      token_(token),
+      config_(config),
+      share_(nullptr),
+      multi_(nullptr),
+      headers_(nullptr),
+      requests_(0),
+      connectionsOpened_(0),
+      handlesCreated_(0) {
     // Initialize curl globally (once per program)
     curl_global_init(CURL_GLOBAL_DEFAULT);
 
@@ -18,66 +39,284 @@ HARestClient::HARestClient(const std::string& baseUrl, const std::string& token)
     if (!baseUrl_.empty() && baseUrl_.back() == '/') {
         baseUrl_.pop_back();
     }
+
+    // Headers are identical for every request, build them once
+    std::string authHeader = "Authorization: Bearer " + token_;
+    headers_ = curl_slist_append(headers_, authHeader.c_str());
+    headers_ = curl_slist_append(headers_, "Content-Type: application/json");
+
+    share_ = curl_share_init();
+    if (share_) {
+        curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, lockShared);
+        curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, unlockShared);
+        curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    // Batched fetches reuse the multi handle's connection cache across calls
+    multi_ = curl_multi_init();
+    if (multi_) {
+        curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    }
 }
 
 HARestClient::~HARestClient() {
-        // Cleanup curl globally
-        curl_global_cleanup();
+    if (multi_) {
+        curl_multi_cleanup(multi_);
+    }
+    for (CURL* curl : idleHandles_) {
+        curl_easy_cleanup(curl);
+    }
+    idleHandles_.clear();
+    if (share_) {
+        curl_share_cleanup(share_);
+    }
+    curl_slist_free_all(headers_);
+
+    // Cleanup curl globally
+    curl_global_cleanup();
+}
+
+HARestClientStats HARestClient::getStats() const {
+    HARestClientStats stats;
+    stats.requests = requests_.load(std::memory_order_relaxed);
+    stats.connectionsOpened = connectionsOpened_.load(std::memory_order_relaxed);
+    stats.handlesCreated = handlesCreated_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    stats.idleHandles = idleHandles_.size();
+    return stats;
 }
 
 
 HASensorData HARestClient::getSensorState(const std::string& entityId) {
-    std::cout << "HARestClient: Fetching state for " << entityId << std::endl;
+    if (config_.verboseLogging) {
+        std::cout << "HARestClient: Fetching state for " << entityId << std::endl;
+    }
     
     std::string endpoint = baseUrl_ + "/api/states/" + entityId;
     std::string response = httpGet(endpoint);
     
-    return parseSensorData(response);
+    HASensorData data;
+    if (!response.empty() && !HAJsonParser::parseState(response, data)) {
+        std::cerr << "HARestClient: Malformed state response for " << entityId << std::endl;
+    }
+    return data;
 }
 
-std::vector<HASensorData> HARestClient::getAllSensors() {
-    std::cout << "HARestClient: Fetching all sensors" << std::endl;
+std::vector<HASensorData> HARestClient::getSensorStates(const std::vector<std::string>& entityIds,
+                                                        size_t maxConcurrent) {
+    maxConcurrent = std::max<size_t>(maxConcurrent, 1);
+    if (config_.verboseLogging) {
+        std::cout << "HARestClient: Fetching " << entityIds.size() << " states ("
+                  << maxConcurrent << " concurrent)" << std::endl;
+    }
     
-    std::string response = httpGet(baseUrl_ + "/api/states");
-    std::vector<HASensorData> allStates = parseMultipleSensors(response);
+    std::vector<HASensorData> states(entityIds.size());
+    if (entityIds.empty()) {
+        return states;
+    }
     
-    // Filter for sensors only
-    std::vector<HASensorData> sensors;
-    for (const auto& state : allStates) {
-        if (state.entityId.find("sensor.") == 0) {
-            sensors.push_back(state);
+    // One batch at a time owns the multi handle
+    std::lock_guard<std::mutex> multiLock(multiMutex_);
+    CURLM* multi = multi_;
+    if (!multi) {
+        std::cerr << "HARestClient: Could not create curl multi handle" << std::endl;
+        return states;
+    }
+    
+    // One slot per entity; the vector never reallocates, so CURLOPT_PRIVATE
+    // can point at the slot
+    struct Transfer {
+        std::string url;
+        std::string body;
+    };
+    std::vector<Transfer> transfers(entityIds.size());
+    size_t nextIndex = 0;
+    size_t active = 0;
+    
+    auto startNext = [&]() {
+        while (active < maxConcurrent && nextIndex < entityIds.size()) {
+            Transfer& transfer = transfers[nextIndex++];
+            CURL* curl = acquireHandle();
+            if (!curl) {
+                std::cerr << "HARestClient: Could not create curl handle" << std::endl;
+                continue;
+            }
+            transfer.url = baseUrl_ + "/api/states/" + entityIds[&transfer - transfers.data()];
+            prepareRequest(curl, transfer.url, nullptr, WriteCallback, &transfer.body);
+            curl_easy_setopt(curl, CURLOPT_PRIVATE, &transfer);
+            curl_multi_add_handle(multi, curl);
+            ++active;
+        }
+    };
+    
+    // Keep up to maxConcurrent transfers running, starting the next as each completes
+    startNext();
+    while (active > 0) {
+        int running = 0;
+        curl_multi_perform(multi, &running);
+        
+        int queued = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi, &queued)) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+            CURL* curl = message->easy_handle;
+            CURLcode result = message->data.result;
+            char* privateData = nullptr;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, &privateData);
+            Transfer* transfer = reinterpret_cast<Transfer*>(privateData);
+            size_t index = transfer - transfers.data();
+            
+            curl_multi_remove_handle(multi, curl);
+            long httpCode = finishRequest(curl, result);
+            releaseHandle(curl);
+            --active;
+            
+            if (httpCode == 200 && !HAJsonParser::parseState(transfer->body, states[index])) {
+                std::cerr << "HARestClient: Malformed state response for " << entityIds[index] << std::endl;
+            }
+            std::string().swap(transfer->body);
+        }
+        
+        startNext();
+        if (active > 0) {
+            curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
         }
     }
     
-    return sensors;
+    return states;
+}
+
+std::vector<HASensorData> HARestClient::getAllSensors() {
+    if (config_.verboseLogging) {
+        std::cout << "HARestClient: Fetching all sensors" << std::endl;
+    }
+    return streamStates("sensor.");
+}
+
+std::vector<HASensorData> HARestClient::getStatesByDomain(const std::string& domain) {
+    if (config_.verboseLogging) {
+        std::cout << "HARestClient: Fetching " << domain << " entities" << std::endl;
+    }
+    return streamStates(domain + ".");
+}
+
+std::vector<HASensorData> HARestClient::getStatesByPrefix(const std::string& prefix) {
+    if (config_.verboseLogging) {
+        std::cout << "HARestClient: Fetching entities matching " << prefix << "*" << std::endl;
+    }
+    return streamStates(prefix);
 }
 
 std::vector<HASensorData> HARestClient::getAllStates() {
-    std::cout << "HARestClient: Fetching all entity states" << std::endl;
-    
-    std::string response = httpGet(baseUrl_ + "/api/states");
-    return parseMultipleSensors(response);
+    if (config_.verboseLogging) {
+        std::cout << "HARestClient: Fetching all entity states" << std::endl;
+    }
+    return streamStates("");
+}
+
+std::vector<HASensorData> HARestClient::streamStates(const std::string& prefix) {
+    // Non-matching entities are dropped while downloading, after reading
+    // only their entity_id
+    std::vector<HASensorData> states;
+    HAStateStreamParser parser([&states](const HASensorData& state) {
+        states.push_back(state);
+    }, prefix);
+    
+    long httpCode = httpGetStreaming(baseUrl_ + "/api/states", StreamCallback<HAStateStreamParser>, &parser);
+    if (httpCode == 200 && !parser.finish()) {
+        std::cerr << "HARestClient: Malformed /api/states response, kept "
+                  << states.size() << " entities" << std::endl;
+    }
+    return states;
 }
 
 std::vector<HAHistoricalData> HARestClient::getHistory(const std::string& entityId, long startTimestamp) {
-    std::cout << "HARestClient: Fetching history for " << entityId << std::endl;
+    std::vector<HAHistoricalData> history;
+    getHistoryStreaming(entityId, startTimestamp, [&history](const HAHistoricalData& entry) {
+        history.push_back(entry);
+    });
+    return history;
+}
+
+size_t HARestClient::getHistoryStreaming(const std::string& entityId, long startTimestamp,
+                                         std::function<void(const HAHistoricalData&)> callback) {
+    if (config_.verboseLogging) {
+        std::cout << "HARestClient: Fetching history for " << entityId << std::endl;
+    }
     
-    // Convert timestamp to ISO format
-    char timeStr[100];
-    std::time_t t = startTimestamp;
-    std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%S+00:00", std::gmtime(&t));
+    HAHistoryQuery query;
+    query.entityIds.push_back(entityId);
+    query.startTimestamp = startTimestamp;
     
-    std::string endpoint = baseUrl_ + "/api/history/period/" + std::string(timeStr) + 
-                          "?filter_entity_id=" + entityId;
-    std::string response = httpGet(endpoint);
+    size_t entries = 0;
+    fetchHistory(query, [&entries, &callback](const HAHistoricalData& entry) {
+        ++entries;
+        callback(entry);
+    });
+    return entries;
+}
+
+bool HARestClient::fetchHistory(const HAHistoryQuery& query,
+                                std::function<void(const HAHistoricalData&)> callback) {
+    std::string endpoint = baseUrl_ + "/api/history/period/" + formatTimestamp(query.startTimestamp);
+    
+    char separator = '?';
+    if (!query.entityIds.empty()) {
+        endpoint += "?filter_entity_id=";
+        for (size_t i = 0; i < query.entityIds.size(); ++i) {
+            endpoint += (i ? "," : "") + query.entityIds[i];
+        }
+        separator = '&';
+    }
+    if (query.endTimestamp > 0) {
+        endpoint += separator;
+        endpoint += "end_time=" + formatTimestamp(query.endTimestamp);
+        separator = '&';
+    }
+    if (query.minimalResponse) {
+        endpoint += separator;
+        endpoint += "minimal_response";
+        separator = '&';
+    }
+    if (query.noAttributes) {
+        endpoint += separator;
+        endpoint += "no_attributes";
+    }
     
-    return parseHistoricalData(response);
+    // Entries are parsed while the response is still downloading
+    HAHistoryStreamParser parser(std::move(callback));
+    long httpCode = perform(endpoint, nullptr, StreamCallback<HAHistoryStreamParser>, &parser,
+                            query.timeoutSeconds);
+    if (httpCode != 200) {
+        return false;
+    }
+    if (!parser.finish()) {
+        std::cerr << "HARestClient: Malformed history response, kept "
+                  << parser.getEntryCount() << " entries" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// ISO 8601 in UTC; '+' is percent-encoded so the value also survives in a query string
+std::string HARestClient::formatTimestamp(long timestamp) {
+    std::time_t t = timestamp;
+    std::tm utc;
+    gmtime_r(&t, &utc);
+    char timeStr[64];
+    std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%S%%2B00:00", &utc);
+    return timeStr;
 }
 
 bool HARestClient::callService(const std::string& domain, const std::string& service,
                                const std::string& entityId, const std::string& data) {
-    std::cout << "HARestClient: Calling service " << domain << "." << service 
-              << " on " << entityId << std::endl;
+    if (config_.verboseLogging) {
+        std::cout << "HARestClient: Calling service " << domain << "." << service 
+                  << " on " << entityId << std::endl;
+    }
     
     std::string endpoint = baseUrl_ + "/api/services/" + domain + "/" + service;
     
@@ -95,7 +334,9 @@ bool HARestClient::callService(const std::string& domain, const std::string& ser
 }
 
 bool HARestClient::testConnection() {
-    std::cout << "HARestClient: Testing connection to Home Assistant" << std::endl;
+    if (config_.verboseLogging) {
+        std::cout << "HARestClient: Testing connection to Home Assistant" << std::endl;
+    }
     
     try {
         std::string url = baseUrl_+"/api/";
@@ -117,63 +358,22 @@ bool HARestClient::testConnection() {
  * @return Response body as string
  */
 std::string HARestClient::httpGet(const std::string& url) {
-    CURL* curl;
-    CURLcode res;
     std::string readBuffer;
-    long httpCode = 0;
-    
-    curl = curl_easy_init();
-    
-    if(curl) {
-        // Prepare authorization header
-        std::string authHeader = "Authorization: Bearer " + token_;
-        
-        struct curl_slist* headers = NULL;
-        headers = curl_slist_append(headers, authHeader.c_str());
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-        
-        // Set curl options
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-        
-        // Set timeouts
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);           // 10 second timeout
-        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);     // 5 second connect timeout
-        
-        // For HTTPS, verify SSL certificate (set to 0 to disable for self-signed certs)
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
-        
-        // Perform the request
-        res = curl_easy_perform(curl);
-        
-        // Check for errors
-        if(res != CURLE_OK) {
-            std::cerr << "curl_easy_perform() failed: " << curl_easy_strerror(res) << std::endl;
-        } else {
-            // Get HTTP response code
-            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
-            
-            if (httpCode == 200) {
-                // Success
-            } else if (httpCode == 401) {
-                std::cerr << "Authentication failed (401): Invalid token" << std::endl;
-            } else if (httpCode == 404) {
-                std::cerr << "Not found (404): Entity may not exist" << std::endl;
-            } else {
-                std::cerr << "HTTP error: " << httpCode << std::endl;
-            }
-        }
-        
-        // Cleanup
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
-    }
-    
+    perform(url, nullptr, WriteCallback, &readBuffer, -1);
     return readBuffer;
 }
+
+/**
+ * Perform HTTP GET request, handing the body to writeFunction as it arrives
+ * 
+ * @param url Full URL to request
+ * @param writeFunction curl write callback; returning less than the chunk size aborts
+ * @param userdata Passed to writeFunction
+ * @return HTTP status code, or 0 if the transfer failed
+ */
+long HARestClient::httpGetStreaming(const std::string& url, CurlWriteFunction writeFunction, void* userdata) {
+    return perform(url, nullptr, writeFunction, userdata, -1);
+}
     
 /**
  * Perform HTTP POST request
@@ -183,369 +383,143 @@ std::string HARestClient::httpGet(const std::string& url) {
  * @return Response body as string
  */
 std::string HARestClient::httpPost(const std::string& url, const std::string& data) {
-    CURL* curl;
-    CURLcode res;
     std::string readBuffer;
-    long httpCode = 0;
-    
-    curl = curl_easy_init();
-    
-    if(curl) {
-        // Prepare authorization header
-        std::string authHeader = "Authorization: Bearer " + token_;
-        
-        struct curl_slist* headers = NULL;
-        headers = curl_slist_append(headers, authHeader.c_str());
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-        
-        // Set curl options
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-        
-        // Set POST data
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data.c_str());
-        
-        // Set timeouts
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
-        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);
-        
-        // For HTTPS
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
-        
-        // Perform the request
-        res = curl_easy_perform(curl);
-        
-        // Check for errors
-        if(res != CURLE_OK) {
-            std::cerr << "curl_easy_perform() failed: " << curl_easy_strerror(res) << std::endl;
-        } else {
-            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
-            
-            if (httpCode == 200 || httpCode == 201) {
-                // Success
-            } else if (httpCode == 401) {
-                std::cerr << "Authentication failed (401): Invalid token" << std::endl;
-            } else {
-                std::cerr << "HTTP error: " << httpCode << std::endl;
-            }
-        }
-        
-        // Cleanup
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
-    }
-    
+    perform(url, &data, WriteCallback, &readBuffer, -1);
     return readBuffer;
 }
 
-
-#if 0
-std::string HARestClient::httpGet(const std::string& endpoint) {
-    // In production: Use libcurl to make actual HTTP GET request
-    // For simulation: Return mock data based on endpoint
-    
-    std::cout << "  HTTP GET: " << baseUrl_ << endpoint << std::endl;
-    std::cout << "  Authorization: Bearer " << token_.substr(0, 10) << "..." << std::endl;
-    
-    // Mock response based on endpoint
-    if (endpoint == "/api/") {
-        return R"({"message": "API running."})";
-    }
-    
-    if (endpoint == "/api/states") {
-        // Mock: Return multiple sensor states
-        return R"([
-            {
-                "entity_id": "sensor.living_room_temperature",
-                "state": "22.5",
-                "attributes": {
-                    "unit_of_measurement": "°C",
-                    "friendly_name": "Living Room Temperature",
-                    "device_class": "temperature"
-                },
-                "last_changed": "2024-01-15T10:30:00+00:00",
-                "last_updated": "2024-01-15T10:30:00+00:00"
-            },
-            {
-                "entity_id": "sensor.energy_consumption",
-                "state": "1250",
-                "attributes": {
-                    "unit_of_measurement": "W",
-                    "friendly_name": "Energy Consumption",
-                    "device_class": "power"
-                },
-                "last_changed": "2024-01-15T10:25:00+00:00",
-                "last_updated": "2024-01-15T10:25:00+00:00"
-            },
-            {
-                "entity_id": "sensor.solar_production",
-                "state": "3200",
-                "attributes": {
-                    "unit_of_measurement": "W",
-                    "friendly_name": "Solar Production",
-                    "device_class": "power"
-                },
-                "last_changed": "2024-01-15T10:28:00+00:00",
-                "last_updated": "2024-01-15T10:28:00+00:00"
-            },
-            {
-                "entity_id": "switch.heater",
-                "state": "off",
-                "attributes": {
-                    "friendly_name": "Heater Switch"
-                },
-                "last_changed": "2024-01-15T09:00:00+00:00",
-                "last_updated": "2024-01-15T09:00:00+00:00"
-            }
-        ])";
-    }
-    
-    if (endpoint.find("/api/states/") == 0) {
-        // Extract entity_id from endpoint
-        std::string entityId = endpoint.substr(12); // After "/api/states/"
-        
-        if (entityId == "sensor.living_room_temperature") {
-            return R"({
-                "entity_id": "sensor.living_room_temperature",
-                "state": "22.5",
-                "attributes": {
-                    "unit_of_measurement": "°C",
-                    "friendly_name": "Living Room Temperature",
-                    "device_class": "temperature"
-                },
-                "last_changed": "2024-01-15T10:30:00+00:00",
-                "last_updated": "2024-01-15T10:30:00+00:00"
-            })";
-        } else if (entityId == "sensor.energy_consumption") {
-            return R"({
-                "entity_id": "sensor.energy_consumption",
-                "state": "1250",
-                "attributes": {
-                    "unit_of_measurement": "W",
-                    "friendly_name": "Energy Consumption",
-                    "device_class": "power"
-                },
-                "last_changed": "2024-01-15T10:25:00+00:00",
-                "last_updated": "2024-01-15T10:25:00+00:00"
-            })";
-        } else if (entityId == "sensor.solar_production") {
-            return R"({
-                "entity_id": "sensor.solar_production",
-                "state": "3200",
-                "attributes": {
-                    "unit_of_measurement": "W",
-                    "friendly_name": "Solar Production",
-                    "device_class": "power"
-                },
-                "last_changed": "2024-01-15T10:28:00+00:00",
-                "last_updated": "2024-01-15T10:28:00+00:00"
-            })";
-        }
+/**
+ * Run one request on a pooled handle
+ * 
+ * @param url Full URL to request
+ * @param postData Request body for POST, nullptr for GET
+ * @param writeFunction curl write callback for the response body
+ * @param userdata Passed to writeFunction
+ * @param timeoutSeconds Transfer timeout, -1 for HARestClientConfig::timeoutSeconds
+ * @return HTTP status code, or 0 if the transfer failed
+ */
+long HARestClient::perform(const std::string& url, const std::string* postData,
+                           CurlWriteFunction writeFunction, void* userdata, long timeoutSeconds) {
+    CURL* curl = acquireHandle();
+    if (!curl) {
+        std::cerr << "HARestClient: Could not create curl handle" << std::endl;
+        return 0;
     }
     
-    if (endpoint.find("/api/history/period/") == 0) {
-        // Mock historical data
-        return R"([[
-            {
-                "entity_id": "sensor.energy_consumption",
-                "state": "1100",
-                "last_changed": "2024-01-15T08:00:00+00:00",
-                "attributes": {
-                    "unit_of_measurement": "W"
-                }
-            },
-            {
-                "entity_id": "sensor.energy_consumption",
-                "state": "1250",
-                "last_changed": "2024-01-15T09:00:00+00:00",
-                "attributes": {
-                    "unit_of_measurement": "W"
-                }
-            },
-            {
-                "entity_id": "sensor.energy_consumption",
-                "state": "1350",
-                "last_changed": "2024-01-15T10:00:00+00:00",
-                "attributes": {
-                    "unit_of_measurement": "W"
-                }
-            }
-        ]])";
+    prepareRequest(curl, url, postData, writeFunction, userdata);
+    if (timeoutSeconds >= 0) {
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeoutSeconds);
     }
-    
-    return "{}";
+    long httpCode = finishRequest(curl, curl_easy_perform(curl));
+    releaseHandle(curl);
+    return httpCode;
 }
 
-std::string HARestClient::httpPost(const std::string& endpoint, const std::string& data) {
-    // In production: Use libcurl to make actual HTTP POST request
-    // For simulation: Return success response
-    
-    std::cout << "  HTTP POST: " << baseUrl_ << endpoint << std::endl;
-    std::cout << "  Authorization: Bearer " << token_.substr(0, 10) << "..." << std::endl;
-    std::cout << "  Data: " << data << std::endl;
-    
-    // Mock: Return success for service calls
-    return R"([{"success": true}])";
-}
-
-#endif
-
-HASensorData HARestClient::parseSensorData(const std::string& jsonResponse) {
-    // In production: Use proper JSON library like nlohmann/json
-    // For simulation: Simple string parsing
-    
-    HASensorData data;
-    data.entityId = extractJsonValue(jsonResponse, "entity_id");
-    data.state = extractJsonValue(jsonResponse, "state");
-    
-    // Extract from attributes object
-    size_t attrStart = jsonResponse.find("\"attributes\"");
-    if (attrStart != std::string::npos) {
-        size_t attrEnd = jsonResponse.find("}", attrStart);
-        std::string attributes = jsonResponse.substr(attrStart, attrEnd - attrStart);
-        
-        data.unitOfMeasurement = extractJsonValue(attributes, "unit_of_measurement");
-        data.friendlyName = extractJsonValue(attributes, "friendly_name");
-        data.deviceClass = extractJsonValue(attributes, "device_class");
+void HARestClient::prepareRequest(CURL* curl, const std::string& url, const std::string* postData,
+                                  CurlWriteFunction writeFunction, void* userdata) {
+    // Only per-request options; everything else was set when the handle was created
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeFunction);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, userdata);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, config_.timeoutSeconds);
+    if (postData) {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(postData->size()));
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postData->c_str());
+    } else {
+        curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
     }
-    
-    // For simulation, use current time
-    data.lastChanged = std::time(nullptr);
-    data.lastUpdated = std::time(nullptr);
-    
-    return data;
 }
 
-std::vector<HASensorData> HARestClient::parseMultipleSensors(const std::string& jsonResponse) {
-    // In production: Use proper JSON library
-    // For simulation: Parse array of sensor objects
-    
-    std::vector<HASensorData> sensors;
-    
-    // Find each object in the array
-    size_t pos = 0;
-    while ((pos = jsonResponse.find("{", pos)) != std::string::npos) {
-        size_t endPos = jsonResponse.find("}", pos);
-        if (endPos == std::string::npos) break;
-        
-        // Find the complete object (handle nested braces)
-        int braceCount = 1;
-        size_t searchPos = pos + 1;
-        while (braceCount > 0 && searchPos < jsonResponse.length()) {
-            if (jsonResponse[searchPos] == '{') braceCount++;
-            else if (jsonResponse[searchPos] == '}') braceCount--;
-            searchPos++;
-        }
+long HARestClient::finishRequest(CURL* curl, CURLcode res) {
+    long httpCode = 0;
+    long newConnections = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &newConnections);
+    requests_.fetch_add(1, std::memory_order_relaxed);
+    connectionsOpened_.fetch_add(newConnections, std::memory_order_relaxed);
+    
+    // Check for errors
+    if (res != CURLE_OK) {
+        std::cerr << "curl_easy_perform() failed: " << curl_easy_strerror(res) << std::endl;
+    } else {
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
         
-        if (braceCount == 0) {
-            std::string objectStr = jsonResponse.substr(pos, searchPos - pos);
-            HASensorData data = parseSensorData(objectStr);
-            if (!data.entityId.empty()) {
-                sensors.push_back(data);
-            }
-            pos = searchPos;
+        if (httpCode == 200 || httpCode == 201) {
+            // Success
+        } else if (httpCode == 401) {
+            std::cerr << "Authentication failed (401): Invalid token" << std::endl;
+        } else if (httpCode == 404) {
+            std::cerr << "Not found (404): Entity may not exist" << std::endl;
         } else {
-            break;
+            std::cerr << "HTTP error: " << httpCode << std::endl;
         }
     }
-    
-    return sensors;
+    return httpCode;
 }
 
-std::vector<HAHistoricalData> HARestClient::parseHistoricalData(const std::string& jsonResponse) {
-    // In production: Use proper JSON library
-    // For simulation: Parse historical data array
-    
-    std::vector<HAHistoricalData> history;
-    
-    // Find each object in the nested array
-    size_t pos = 0;
-    while ((pos = jsonResponse.find("{", pos)) != std::string::npos) {
-        size_t endPos = jsonResponse.find("}", pos);
-        if (endPos == std::string::npos) break;
-        
-        // Find complete object
-        int braceCount = 1;
-        size_t searchPos = pos + 1;
-        while (braceCount > 0 && searchPos < jsonResponse.length()) {
-            if (jsonResponse[searchPos] == '{') braceCount++;
-            else if (jsonResponse[searchPos] == '}') braceCount--;
-            searchPos++;
-        }
-        
-        if (braceCount == 0) {
-            std::string objectStr = jsonResponse.substr(pos, searchPos - pos);
-            
-            HAHistoricalData data;
-            data.entityId = extractJsonValue(objectStr, "entity_id");
-            data.state = extractJsonValue(objectStr, "state");
-            data.timestamp = std::time(nullptr); // Simplified
-            
-            if (!data.entityId.empty()) {
-                history.push_back(data);
-            }
-            pos = searchPos;
-        } else {
-            break;
+CURL* HARestClient::acquireHandle() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex_);
+        if (!idleHandles_.empty()) {
+            CURL* curl = idleHandles_.back();
+            idleHandles_.pop_back();
+            return curl;
         }
     }
     
-    return history;
-}
-
-std::string HARestClient::extractJsonValue(const std::string& json, const std::string& key) {
-    // Simple JSON value extractor for simulation
-    // In production: Use proper JSON library
-    
-    std::string searchKey = "\"" + key + "\"";
-    size_t keyPos = json.find(searchKey);
-    
-    if (keyPos == std::string::npos) {
-        return "";
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        return nullptr;
     }
-    
-    // Find the colon after the key
-    size_t colonPos = json.find(":", keyPos);
-    if (colonPos == std::string::npos) {
-        return "";
+    handlesCreated_.fetch_add(1, std::memory_order_relaxed);
+    
+    // Shared DNS and TLS session caches across all handles. Each handle
+    // keeps its own connection cache: libcurl does not support sharing
+    // connections between threads that perform concurrently.
+    curl_easy_setopt(curl, CURLOPT_SHARE, share_);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers_);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");   // Any encoding curl supports
+    
+    // Keep idle connections open between polling cycles
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 30L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 15L);
+    
+    // Prefer HTTP/2 over TLS; concurrent requests wait to multiplex on one
+    // connection instead of opening new ones
+    if (config_.enableHttp2) {
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
     }
     
-    // Skip whitespace after colon
-    size_t valueStart = colonPos + 1;
-    while (valueStart < json.length() && 
-           (json[valueStart] == ' ' || json[valueStart] == '\t' || json[valueStart] == '\n')) {
-        valueStart++;
-    }
+    // Set timeouts
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, config_.timeoutSeconds);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, config_.connectTimeoutSeconds);
     
-    if (valueStart >= json.length()) {
-        return "";
-    }
+    // For HTTPS, verify SSL certificate (disable verifyPeer for self-signed certs)
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, config_.verifyPeer ? 1L : 0L);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, config_.verifyPeer ? 2L : 0L);
     
-    // Check if value is a string (starts with ")
-    if (json[valueStart] == '"') {
-        size_t valueEnd = json.find('"', valueStart + 1);
-        if (valueEnd != std::string::npos) {
-            return json.substr(valueStart + 1, valueEnd - valueStart - 1);
-        }
-    } else {
-        // Number or other value
-        size_t valueEnd = valueStart;
-        while (valueEnd < json.length() && 
-               json[valueEnd] != ',' && json[valueEnd] != '}' && 
-               json[valueEnd] != ']' && json[valueEnd] != '\n') {
-            valueEnd++;
-        }
-        
-        std::string value = json.substr(valueStart, valueEnd - valueStart);
-        // Trim trailing whitespace
-        while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
-            value.pop_back();
+    return curl;
+}
+
+void HARestClient::releaseHandle(CURL* curl) {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex_);
+        if (idleHandles_.size() < config_.maxIdleHandles) {
+            idleHandles_.push_back(curl);
+            return;
         }
-        return value;
     }
-    
-    return "";
+    curl_easy_cleanup(curl);
+}
+
+void HARestClient::lockShared(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    static_cast<HARestClient*>(userptr)->shareLocks_[data].lock();
+}
+
+void HARestClient::unlockShared(CURL*, curl_lock_data data, void* userptr) {
+    static_cast<HARestClient*>(userptr)->shareLocks_[data].unlock();
 }
@@ -0,0 +1,671 @@
+#include "HAStubServer.h"
+#include "HAJsonParser.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <algorithm>
+#include <cctype>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+namespace {
+
+constexpr int LISTEN_TOKEN = -1;
+constexpr int WAKE_TOKEN = -2;
+constexpr size_t MAX_HEADER_SIZE = 65536;
+constexpr long DEFAULT_HISTORY_SPAN = 86400;   // HA returns one day without end_time
+
+// Entity kinds cycled through the fixture, in the proportions of a typical install
+enum class EntityKind { TEMPERATURE, POWER, SWITCH, LIGHT, DOOR };
+
+EntityKind kindOf(size_t index) {
+    return static_cast<EntityKind>(index % 5);
+}
+
+std::string entityIdFor(size_t index) {
+    std::string n = std::to_string(index);
+    switch (kindOf(index)) {
+        case EntityKind::TEMPERATURE: return "sensor.room_" + n + "_temperature";
+        case EntityKind::POWER:       return "sensor.circuit_" + n + "_power";
+        case EntityKind::SWITCH:      return "switch.plug_" + n;
+        case EntityKind::LIGHT:       return "light.lamp_" + n;
+        case EntityKind::DOOR:        return "binary_sensor.door_" + n;
+    }
+    return "";
+}
+
+// State of an entity at sample step (0 = current state)
+std::string stateFor(size_t index, size_t step) {
+    char value[32];
+    switch (kindOf(index)) {
+        case EntityKind::TEMPERATURE:
+            std::snprintf(value, sizeof(value), "%.1f", 18.0 + (index + step) % 70 / 10.0);
+            return value;
+        case EntityKind::POWER:
+            return std::to_string(150 + (index * 37 + step * 11) % 2400);
+        case EntityKind::SWITCH:
+        case EntityKind::LIGHT:
+        case EntityKind::DOOR:
+            return (index + step) % 2 ? "on" : "off";
+    }
+    return "";
+}
+
+void appendAttributes(std::string& out, size_t index) {
+    std::string n = std::to_string(index);
+    switch (kindOf(index)) {
+        case EntityKind::TEMPERATURE:
+            out += "{\"state_class\":\"measurement\",\"unit_of_measurement\":\"\\u00b0C\","
+                   "\"device_class\":\"temperature\",\"friendly_name\":\"Room " + n + " Temperature\"}";
+            break;
+        case EntityKind::POWER:
+            out += "{\"state_class\":\"measurement\",\"unit_of_measurement\":\"W\","
+                   "\"device_class\":\"power\",\"friendly_name\":\"Circuit " + n + " Power\"}";
+            break;
+        case EntityKind::SWITCH:
+            out += "{\"friendly_name\":\"Plug " + n + "\"}";
+            break;
+        case EntityKind::LIGHT:
+            out += "{\"min_color_temp_kelvin\":2202,\"max_color_temp_kelvin\":6535,"
+                   "\"supported_color_modes\":[\"color_temp\",\"xy\"],\"color_mode\":\"color_temp\","
+                   "\"brightness\":180,\"color_temp_kelvin\":2700,\"xy_color\":[0.459,0.41],"
+                   "\"friendly_name\":\"Lamp " + n + "\",\"supported_features\":40}";
+            break;
+        case EntityKind::DOOR:
+            out += "{\"device_class\":\"door\",\"friendly_name\":\"Door " + n + "\"}";
+            break;
+    }
+}
+
+void appendTimestamp(std::string& out, long timestamp) {
+    std::time_t t = timestamp;
+    std::tm utc;
+    gmtime_r(&t, &utc);
+    char text[40];
+    std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S.000000+00:00", &utc);
+    out += text;
+}
+
+int fromHex(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string percentDecode(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '%' && i + 2 < text.size() && fromHex(text[i + 1]) >= 0 && fromHex(text[i + 2]) >= 0) {
+            out += static_cast<char>(fromHex(text[i + 1]) * 16 + fromHex(text[i + 2]));
+            i += 2;
+        } else {
+            out += text[i];
+        }
+    }
+    return out;
+}
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return text;
+}
+
+const char* reasonFor(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default:  return "Error";
+    }
+}
+
+} // namespace
+
+HAStubServer::HAStubServer(const HAStubServerConfig& config)
+    : config_(config), port_(0), listenFd_(-1), epollFd_(-1), wakeFd_(-1),
+      running_(false), requests_(0), bytesSent_(0), connectionsAccepted_(0) {
+    config_.historyEntries = std::max<size_t>(config_.historyEntries, 1);
+    config_.latencyMs = std::max(config_.latencyMs, 0);
+    buildFixtures();
+}
+
+HAStubServer::~HAStubServer() {
+    stop();
+}
+
+void HAStubServer::buildFixtures() {
+    // /api/states as Home Assistant serializes it; single-entity requests
+    // are served from spans of the same buffer
+    statesBody_ = "[";
+    for (size_t i = 0; i < config_.entityCount; ++i) {
+        if (i) {
+            statesBody_ += ',';
+        }
+        size_t offset = statesBody_.size();
+        appendState(statesBody_, i);
+        stateSpans_.emplace_back(offset, statesBody_.size() - offset);
+        entityIds_.push_back(entityIdFor(i));
+        entityIndex_[entityIds_.back()] = i;
+    }
+    statesBody_ += "]";
+
+    servicesBody_ = "[";
+    const char* domains[] = {"homeassistant", "switch", "light", "climate", "input_number"};
+    for (size_t d = 0; d < sizeof(domains) / sizeof(domains[0]); ++d) {
+        std::string domain = domains[d];
+        servicesBody_ += (d ? "," : "") + std::string("{\"domain\":\"") + domain + "\",\"services\":{";
+        const char* services[] = {"turn_on", "turn_off", "toggle"};
+        for (size_t s = 0; s < 3; ++s) {
+            servicesBody_ += (s ? "," : "") + std::string("\"") + services[s] + "\":{\"name\":\"" + services[s] +
+                             "\",\"description\":\"" + services[s] + " for " + domain + " entities\","
+                             "\"fields\":{},\"target\":{\"entity\":[{\"domain\":[\"" + domain + "\"]}]}}";
+        }
+        servicesBody_ += "}}";
+    }
+    servicesBody_ += "]";
+}
+
+void HAStubServer::appendState(std::string& out, size_t index) const {
+    out += "{\"entity_id\":\"" + entityIdFor(index) + "\",\"state\":\"" + stateFor(index, 0) + "\",\"attributes\":";
+    appendAttributes(out, index);
+    out += ",\"last_changed\":\"2024-01-15T10:30:00.123456+00:00\","
+           "\"last_reported\":\"2024-01-15T10:31:00.123456+00:00\","
+           "\"last_updated\":\"2024-01-15T10:31:00.123456+00:00\","
+           "\"context\":{\"id\":\"01HM8Z4Q" + std::to_string(index) + "\",\"parent_id\":null,\"user_id\":null}}";
+}
+
+std::string HAStubServer::renderHistory(const Request& request) const {
+    long start = 0;
+    const std::string prefix = "/api/history/period/";
+    if (request.path.compare(0, prefix.size(), prefix) == 0) {
+        start = HAJsonParser::parseTimestamp(request.path.substr(prefix.size()));
+    }
+    if (start == 0) {
+        start = static_cast<long>(std::time(nullptr)) - DEFAULT_HISTORY_SPAN;
+    }
+    long end = start + DEFAULT_HISTORY_SPAN;
+    auto endTime = request.query.find("end_time");
+    if (endTime != request.query.end()) {
+        end = HAJsonParser::parseTimestamp(endTime->second);
+    }
+    bool minimal = request.query.count("minimal_response") > 0;
+    bool noAttributes = request.query.count("no_attributes") > 0;
+
+    // Entities in the filter; unknown ids are left out like HA does
+    std::vector<size_t> entities;
+    auto filter = request.query.find("filter_entity_id");
+    if (filter == request.query.end()) {
+        for (size_t i = 0; i < config_.entityCount; ++i) {
+            entities.push_back(i);
+        }
+    } else {
+        size_t begin = 0;
+        while (begin <= filter->second.size()) {
+            size_t comma = std::min(filter->second.find(',', begin), filter->second.size());
+            auto it = entityIndex_.find(filter->second.substr(begin, comma - begin));
+            if (it != entityIndex_.end()) {
+                entities.push_back(it->second);
+            }
+            begin = comma + 1;
+        }
+    }
+
+    std::string body = "[";
+    long step = std::max<long>((end - start) / static_cast<long>(config_.historyEntries), 1);
+    for (size_t e = 0; e < entities.size(); ++e) {
+        size_t index = entities[e];
+        body += e ? ",[" : "[";
+        size_t count = 0;
+        for (long time = start; time < end && count < config_.historyEntries; time += step, ++count) {
+            body += count ? "," : "";
+            if (minimal && count > 0) {
+                // minimal_response: only state and last_changed after the first entry
+                body += "{\"state\":\"" + stateFor(index, count) + "\",\"last_changed\":\"";
+                appendTimestamp(body, time);
+                body += "\"}";
+                continue;
+            }
+            body += "{\"entity_id\":\"" + entityIds_[index] + "\",\"state\":\"" + stateFor(index, count) + "\"";
+            if (!noAttributes) {
+                body += ",\"attributes\":";
+                appendAttributes(body, index);
+            }
+            body += ",\"last_changed\":\"";
+            appendTimestamp(body, time);
+            body += "\",\"last_updated\":\"";
+            appendTimestamp(body, time);
+            body += "\"}";
+        }
+        body += "]";
+    }
+    body += "]";
+    return body;
+}
+
+bool HAStubServer::start() {
+    if (running_) {
+        return true;
+    }
+
+    listenFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        std::cerr << "HAStubServer: socket() failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    int one = 1;
+    ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(config_.port));
+    socklen_t length = sizeof(address);
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listenFd_, 128) != 0 ||
+        ::getsockname(listenFd_, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        std::cerr << "HAStubServer: Failed to listen on port " << config_.port
+                  << ": " << std::strerror(errno) << std::endl;
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    port_ = ntohs(address.sin_port);
+
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = LISTEN_TOKEN;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event);
+    event.data.fd = WAKE_TOKEN;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+
+    running_ = true;
+    thread_ = std::thread(&HAStubServer::run, this);
+
+    std::cout << "HAStubServer: Serving " << config_.entityCount << " entities on " << getBaseUrl()
+              << " (" << statesBody_.size() / 1024 << " KB /api/states, "
+              << config_.latencyMs << " ms latency)" << std::endl;
+    return true;
+}
+
+void HAStubServer::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    uint64_t one = 1;
+    ssize_t ignored = ::write(wakeFd_, &one, sizeof(one));
+    (void)ignored;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    ::close(listenFd_);
+    ::close(epollFd_);
+    ::close(wakeFd_);
+    listenFd_ = epollFd_ = wakeFd_ = -1;
+    std::cout << "HAStubServer: Stopped after " << requests_ << " requests" << std::endl;
+}
+
+int HAStubServer::getPort() const {
+    return port_;
+}
+
+std::string HAStubServer::getBaseUrl() const {
+    return "http://127.0.0.1:" + std::to_string(port_.load());
+}
+
+HAStubServerStats HAStubServer::getStats() const {
+    HAStubServerStats stats;
+    stats.requests = requests_;
+    stats.bytesSent = bytesSent_;
+    stats.connectionsAccepted = connectionsAccepted_;
+    return stats;
+}
+
+void HAStubServer::setResponse(const std::string& path, const std::string& body) {
+    std::lock_guard<std::mutex> lock(overridesMutex_);
+    overrides_[path] = body;
+}
+
+void HAStubServer::failRequests(const std::string& path, size_t count, int status) {
+    std::lock_guard<std::mutex> lock(overridesMutex_);
+    failures_[path] = std::make_pair(count, status);
+}
+
+void HAStubServer::run() {
+    epoll_event events[64];
+    while (running_) {
+        int count = ::epoll_wait(epollFd_, events, 64, nextTimeoutMs());
+        for (int i = 0; i < count; ++i) {
+            int token = events[i].data.fd;
+            if (token == LISTEN_TOKEN) {
+                acceptClients();
+            } else if (token == WAKE_TOKEN) {
+                uint64_t value;
+                ssize_t ignored = ::read(wakeFd_, &value, sizeof(value));
+                (void)ignored;
+            } else {
+                auto it = sessions_.find(token);
+                if (it == sessions_.end()) {
+                    continue;
+                }
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    handleReadable(it->second);
+                }
+            }
+        }
+
+        // Release delayed responses and write out whatever the socket accepts
+        std::vector<int> closed;
+        for (auto& entry : sessions_) {
+            Session& session = entry.second;
+            releaseReady(session);
+            flush(session);
+            bool drained = session.writeBuffer.empty() && session.pending.empty();
+            if (session.fd < 0 || (session.closeAfterWrite && drained)) {
+                closed.push_back(entry.first);
+            }
+        }
+        for (int fd : closed) {
+            closeSession(fd);
+        }
+    }
+    closeAllSessions();
+}
+
+int HAStubServer::nextTimeoutMs() const {
+    int timeout = 100;
+    auto now = Clock::now();
+    for (const auto& entry : sessions_) {
+        if (entry.second.pending.empty()) {
+            continue;
+        }
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+            entry.second.pending.front().readyAt - now).count();
+        timeout = std::min<int>(timeout, static_cast<int>(std::max<long long>(wait, 0)));
+    }
+    return timeout;
+}
+
+void HAStubServer::acceptClients() {
+    for (;;) {
+        int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event);
+
+        Session& session = sessions_[fd];
+        session.fd = fd;
+        connectionsAccepted_++;
+    }
+}
+
+void HAStubServer::handleReadable(Session& session) {
+    char buffer[16384];
+    for (;;) {
+        ssize_t received = ::recv(session.fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            session.readBuffer.append(buffer, static_cast<size_t>(received));
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        closeSession(session.fd);
+        return;
+    }
+
+    // Requests may be pipelined; answer each complete one in order
+    size_t pos = 0;
+    while (pos < session.readBuffer.size() && !session.closeAfterWrite) {
+        size_t consumed = 0;
+        Request request;
+        if (!parseRequest(std::string_view(session.readBuffer).substr(pos), consumed, request)) {
+            queueResponse(session, 400, "{\"message\": \"Bad request\"}", true);
+            break;
+        }
+        if (consumed == 0) {
+            break;
+        }
+        pos += consumed;
+        respond(session, request);
+    }
+    session.readBuffer.erase(0, pos);
+}
+
+bool HAStubServer::parseRequest(std::string_view buffer, size_t& consumed, Request& request) {
+    consumed = 0;
+    size_t headerEnd = buffer.find("\r\n\r\n");
+    if (headerEnd == std::string_view::npos) {
+        return buffer.size() <= MAX_HEADER_SIZE;
+    }
+
+    size_t lineEnd = buffer.find("\r\n");
+    std::string_view requestLine = buffer.substr(0, lineEnd);
+    size_t firstSpace = requestLine.find(' ');
+    size_t secondSpace = requestLine.find(' ', firstSpace + 1);
+    if (firstSpace == std::string_view::npos || secondSpace == std::string_view::npos) {
+        return false;
+    }
+    request.method = std::string(requestLine.substr(0, firstSpace));
+    std::string target(requestLine.substr(firstSpace + 1, secondSpace - firstSpace - 1));
+    request.keepAlive = requestLine.substr(secondSpace + 1) != "HTTP/1.0";
+
+    size_t contentLength = 0;
+    size_t pos = lineEnd + 2;
+    while (pos < headerEnd) {
+        size_t end = buffer.find("\r\n", pos);
+        size_t colon = buffer.find(':', pos);
+        if (colon != std::string_view::npos && colon < end) {
+            std::string name = toLower(std::string(buffer.substr(pos, colon - pos)));
+            size_t valueStart = buffer.find_first_not_of(' ', colon + 1);
+            std::string value = valueStart < end ? std::string(buffer.substr(valueStart, end - valueStart)) : "";
+            if (name == "content-length") {
+                contentLength = std::strtoul(value.c_str(), nullptr, 10);
+            } else if (name == "authorization") {
+                request.authorization = value;
+            } else if (name == "connection") {
+                std::string lowered = toLower(value);
+                request.keepAlive = lowered == "close" ? false : (lowered == "keep-alive" || request.keepAlive);
+            }
+        }
+        pos = end + 2;
+    }
+
+    size_t bodyStart = headerEnd + 4;
+    if (buffer.size() < bodyStart + contentLength) {
+        return true;   // Body still arriving
+    }
+    request.body = std::string(buffer.substr(bodyStart, contentLength));
+    consumed = bodyStart + contentLength;
+
+    size_t question = target.find('?');
+    request.path = percentDecode(target.substr(0, question));
+    if (question != std::string::npos) {
+        std::string query = target.substr(question + 1);
+        size_t begin = 0;
+        while (begin < query.size()) {
+            size_t amp = std::min(query.find('&', begin), query.size());
+            std::string pair = query.substr(begin, amp - begin);
+            size_t equals = pair.find('=');
+            if (equals == std::string::npos) {
+                request.query[percentDecode(pair)] = "";
+            } else {
+                request.query[percentDecode(pair.substr(0, equals))] = percentDecode(pair.substr(equals + 1));
+            }
+            begin = amp + 1;
+        }
+    }
+    return true;
+}
+
+void HAStubServer::respond(Session& session, const Request& request) {
+    requests_++;
+    bool close = !request.keepAlive;
+    if (config_.verboseLogging) {
+        std::cout << "HAStubServer: " << request.method << " " << request.path << std::endl;
+    }
+
+    if (!config_.token.empty() && request.authorization != "Bearer " + config_.token) {
+        queueResponse(session, 401, "401: Unauthorized", close);
+        return;
+    }
+
+    if (request.method == "GET") {
+        {
+            std::lock_guard<std::mutex> lock(overridesMutex_);
+            auto failure = failures_.find(request.path);
+            if (failure != failures_.end() && failure->second.first > 0) {
+                failure->second.first--;
+                queueResponse(session, failure->second.second, "{\"message\":\"Injected failure\"}", close);
+                return;
+            }
+            auto it = overrides_.find(request.path);
+            if (it != overrides_.end()) {
+                queueResponse(session, 200, it->second, close);
+                return;
+            }
+        }
+
+        const std::string statePrefix = "/api/states/";
+        if (request.path == "/api/" || request.path == "/api") {
+            queueResponse(session, 200, "{\"message\":\"API running.\"}", close);
+        } else if (request.path == "/api/states") {
+            queueResponse(session, 200, statesBody_, close);
+        } else if (request.path.compare(0, statePrefix.size(), statePrefix) == 0) {
+            auto it = entityIndex_.find(request.path.substr(statePrefix.size()));
+            if (it == entityIndex_.end()) {
+                queueResponse(session, 404, "{\"message\":\"Entity not found.\"}", close);
+            } else {
+                const auto& span = stateSpans_[it->second];
+                queueResponse(session, 200, statesBody_.substr(span.first, span.second), close);
+            }
+        } else if (request.path.compare(0, 19, "/api/history/period") == 0) {
+            queueResponse(session, 200, renderHistory(request), close);
+        } else if (request.path == "/api/services") {
+            queueResponse(session, 200, servicesBody_, close);
+        } else {
+            queueResponse(session, 404, "{\"message\":\"Not found\"}", close);
+        }
+        return;
+    }
+
+    if (request.method == "POST" && request.path.compare(0, 14, "/api/services/") == 0) {
+        // HA answers a service call with the states it changed
+        queueResponse(session, 200, "[]", close);
+        return;
+    }
+    queueResponse(session, 405, "{\"message\":\"Method not allowed\"}", close);
+}
+
+void HAStubServer::queueResponse(Session& session, int status, const std::string& body, bool close) {
+    std::string data = "HTTP/1.1 " + std::to_string(status) + " " + reasonFor(status) +
+                       "\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) +
+                       (close ? "\r\nConnection: close" : "") + "\r\n\r\n";
+    data += body;
+    bytesSent_ += body.size();
+
+    PendingResponse response;
+    response.readyAt = Clock::now() + std::chrono::milliseconds(config_.latencyMs);
+    response.data = std::move(data);
+    session.pending.push_back(std::move(response));
+    if (close) {
+        session.closeAfterWrite = true;   // Ignore anything pipelined after it
+    }
+}
+
+void HAStubServer::releaseReady(Session& session) {
+    auto now = Clock::now();
+    while (!session.pending.empty() && session.pending.front().readyAt <= now) {
+        session.writeBuffer += session.pending.front().data;
+        session.pending.pop_front();
+    }
+}
+
+void HAStubServer::flush(Session& session) {
+    while (session.fd >= 0 && session.writeOffset < session.writeBuffer.size()) {
+        ssize_t sent = ::send(session.fd, session.writeBuffer.data() + session.writeOffset,
+                              session.writeBuffer.size() - session.writeOffset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            session.writeOffset += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, session.fd, nullptr);
+        ::close(session.fd);
+        session.fd = -1;   // Removed from sessions_ by the caller
+        return;
+    }
+
+    if (session.fd < 0) {
+        return;
+    }
+    if (session.writeOffset == session.writeBuffer.size()) {
+        session.writeBuffer.clear();
+        session.writeOffset = 0;
+    }
+
+    bool want = session.writeOffset < session.writeBuffer.size();
+    if (want != session.wantWrite) {
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = want ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        event.data.fd = session.fd;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, session.fd, &event);
+        session.wantWrite = want;
+    }
+}
+
+void HAStubServer::closeSession(int fd) {
+    auto it = sessions_.find(fd);
+    if (it == sessions_.end()) {
+        return;
+    }
+    if (it->second.fd >= 0) {
+        ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+    }
+    sessions_.erase(it);
+}
+
+void HAStubServer::closeAllSessions() {
+    while (!sessions_.empty()) {
+        closeSession(sessions_.begin()->first);
+    }
+}
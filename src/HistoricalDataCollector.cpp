@@ -1,40 +1,107 @@
 #include "HistoricalDataCollector.h"
+#include "TimeSlots.h"
 #include <sstream>
 #include <algorithm>
+#include <cstdio>
+#include <unistd.h>
+
+namespace {
+
+// Collectors from before binary persistence kept the same data in CSV:
+// historical_data.bin replaces historical_data.csv
+std::string legacyCsvPath(const std::string& file) {
+    size_t dot = file.find_last_of('.');
+    size_t slash = file.find_last_of('/');
+    bool hasExtension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+    return (hasExtension ? file.substr(0, dot) : file) + ".csv";
+}
+
+bool isCsvFile(const std::string& file) {
+    std::ifstream in(file);
+    std::string line;
+    return in.is_open() && std::getline(in, line) && line.compare(0, 5, "hour,") == 0;
+}
+
+}
 
 HistoricalDataCollector::HistoricalDataCollector(const DataCollectionConfig& config)
-    : config_(config) {
+    : config_(config), unsavedCount_(0) {
     
     std::cout << "HistoricalDataCollector: Initialized" << std::endl;
     std::cout << "  Max retention: " << config_.maxDaysToRetain << " days" << std::endl;
-    std::cout << "  Persistence: " << (config_.enablePersistence ? "enabled" : "disabled") << std::endl;
+    std::cout << "  Persistence: " << (config_.enablePersistence ? "enabled" : "disabled");
+    if (config_.enablePersistence) {
+        std::cout << " (" << (config_.persistenceFormat == PersistenceFormat::BINARY ? "binary" : "CSV") << ")";
+    }
+    std::cout << std::endl;
     
     // Try to load existing data if persistence is enabled
     if (config_.enablePersistence) {
         loadFromFile(config_.persistenceFile);
+        
+        if (config_.enableJournal && config_.persistenceFormat == PersistenceFormat::BINARY) {
+            openJournal();
+        }
     }
 }
 
+void HistoricalDataCollector::openJournal() {
+    JournalConfig journalConfig = config_.journal;
+    journalConfig.maxStoreRecords = config_.maxDaysToRetain * pointsPerDay();
+    
+    if (!store_) {
+        store_ = std::make_shared<HistoricalDataStore>(config_.persistenceFile);
+    }
+    journal_.reset(new DataJournal(store_, config_.persistenceFile + ".wal", journalConfig));
+    
+    std::deque<HistoricalDataPoint> recovered;
+    if (!journal_->open(recovered)) {
+        std::cerr << "HistoricalDataCollector: Journal unavailable, using periodic saves" << std::endl;
+        journal_.reset();
+        return;
+    }
+    
+    dataPoints_.insert(dataPoints_.end(), recovered.begin(), recovered.end());
+    unsavedCount_ = 0;
+    cleanupOldData();
+    
+    std::cout << "  Journal: " << journal_->getPath() << " (group commit every " 
+              << journalConfig.groupCommitSize << " points / " 
+              << journalConfig.groupCommitIntervalMs << " ms)" << std::endl;
+}
+
 void HistoricalDataCollector::addDataPoint(const HistoricalDataPoint& dataPoint) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     dataPoints_.push_back(dataPoint);
     
+    if (journal_) {
+        journal_->append(dataPoint);
+    } else {
+        ++unsavedCount_;
+    }
+    
+    if (onlinePredictor_) {
+        onlinePredictor_->update(dataPoint);
+    }
+    
     // Cleanup old data if we exceed retention limit
-    if (dataPoints_.size() > static_cast<size_t>(config_.maxDaysToRetain * 24)) {
+    if (dataPoints_.size() > config_.maxDaysToRetain * pointsPerDay()) {
         cleanupOldData();
     }
     
-    // Auto-save if persistence is enabled (save every 24 data points to avoid excessive I/O)
-    if (config_.enablePersistence && dataPoints_.size() % 24 == 0) {
+    // Auto-save if persistence is enabled (save every 24 new data points to avoid excessive I/O)
+    if (config_.enablePersistence && !journal_ && unsavedCount_ >= 24) {
         saveToFile(config_.persistenceFile);
     }
 }
 
 void HistoricalDataCollector::recordCurrentState(double outdoorTemp, double solarProduction, double energyCost) {
-    int hour, dayOfWeek;
-    getCurrentTimeInfo(hour, dayOfWeek);
+    int hour, minute, dayOfWeek;
+    getCurrentTimeInfo(hour, minute, dayOfWeek);
     
     HistoricalDataPoint point;
     point.hour = hour;
+    point.minute = minute;
     point.dayOfWeek = dayOfWeek;
     point.outdoorTemp = outdoorTemp;
     point.solarProduction = solarProduction;
@@ -51,11 +118,23 @@ void HistoricalDataCollector::recordCurrentState(double outdoorTemp, double sola
 }
 
 std::vector<HistoricalDataPoint> HistoricalDataCollector::getAllData() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     return std::vector<HistoricalDataPoint>(dataPoints_.begin(), dataPoints_.end());
 }
 
+HistoricalDataset HistoricalDataCollector::getDataset() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    HistoricalDataset dataset;
+    dataset.reserve(dataPoints_.size());
+    for (const auto& point : dataPoints_) {
+        dataset.append(point);
+    }
+    return dataset;
+}
+
 std::vector<HistoricalDataPoint> HistoricalDataCollector::getRecentData(int numDays) const {
-    size_t numPoints = std::min(static_cast<size_t>(numDays * 24), dataPoints_.size());
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    size_t numPoints = std::min(std::max(numDays, 0) * pointsPerDay(), dataPoints_.size());
     
     if (numPoints == 0) {
         return std::vector<HistoricalDataPoint>();
@@ -67,10 +146,12 @@ std::vector<HistoricalDataPoint> HistoricalDataCollector::getRecentData(int numD
 }
 
 size_t HistoricalDataCollector::getDataPointCount() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     return dataPoints_.size();
 }
 
 void HistoricalDataCollector::cleanupOldData() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     size_t removed = removeOldDataPoints();
     if (removed > 0) {
         std::cout << "HistoricalDataCollector: Removing " << removed 
@@ -79,27 +160,158 @@ void HistoricalDataCollector::cleanupOldData() {
 }
 
 size_t HistoricalDataCollector::removeOldDataPoints() {
-    size_t maxPoints = config_.maxDaysToRetain * 24;
+    size_t maxPoints = config_.maxDaysToRetain * pointsPerDay();
     size_t originalSize = dataPoints_.size();
     
     if (dataPoints_.size() > maxPoints) {
         dataPoints_.erase(dataPoints_.begin(), dataPoints_.begin() + (dataPoints_.size() - maxPoints));
     }
+    unsavedCount_ = std::min(unsavedCount_, dataPoints_.size());
     
     return originalSize - dataPoints_.size();
 }
 
 bool HistoricalDataCollector::saveToFile(const std::string& filename) const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::string file = filename.empty() ? config_.persistenceFile : filename;
+    
+    if (journal_ && file == config_.persistenceFile) {
+        return journal_->sync();
+    }
+    
+    if (config_.persistenceFormat == PersistenceFormat::CSV) {
+        if (!exportToCsv(file)) {
+            return false;
+        }
+        if (file == config_.persistenceFile) {
+            unsavedCount_ = 0;
+        }
+        return true;
+    }
+    
+    // Snapshot to some other file: write everything, leave the log alone
+    if (file != config_.persistenceFile) {
+        HistoricalDataStore snapshot(file);
+        if (!snapshot.rewrite(dataPoints_)) {
+            std::cerr << "HistoricalDataCollector: Failed to write file: " << file << std::endl;
+            return false;
+        }
+        std::cout << "HistoricalDataCollector: Saved " << dataPoints_.size() 
+                  << " data points to " << file << std::endl;
+        return true;
+    }
+    
+    if (!store_) {
+        store_ = std::make_shared<HistoricalDataStore>(file);
+    }
+    
+    // Rewrite when nothing in memory is in the log yet (fresh file, CSV import)
+    // or once the log holds more than twice what we retain; otherwise append
+    // only the points added since the last save
+    size_t maxPoints = config_.maxDaysToRetain * pointsPerDay();
+    bool compact = unsavedCount_ >= dataPoints_.size() ||
+                   store_->getRecordCount() + unsavedCount_ > 2 * maxPoints;
+    bool ok = compact ? store_->rewrite(dataPoints_) 
+                      : store_->append(dataPoints_, unsavedCount_);
+    if (!ok) {
+        std::cerr << "HistoricalDataCollector: Failed to write file: " << file << std::endl;
+        return false;
+    }
+    
+    if (config_.verboseLogging) {
+        std::cout << "HistoricalDataCollector: " << (compact ? "Rewrote " : "Appended ")
+                  << (compact ? dataPoints_.size() : unsavedCount_) 
+                  << " data points to " << file << std::endl;
+    }
+    unsavedCount_ = 0;
+    return true;
+}
+
+bool HistoricalDataCollector::loadFromFile(const std::string& filename) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::string file = filename.empty() ? config_.persistenceFile : filename;
     
-    std::ofstream outFile(file);
+    if (config_.persistenceFormat == PersistenceFormat::CSV) {
+        return importFromCsv(file);
+    }
+    
+    // The journal owns the persistence file's store; bring it up to date
+    // and read through a separate handle
+    if (journal_ && file == config_.persistenceFile) {
+        journal_->sync();
+    }
+    
+    if (file == config_.persistenceFile && !journal_ && migrateCsv(file)) {
+        return true;
+    }
+    
+    auto store = std::make_shared<HistoricalDataStore>(file);
+    if (!store->load(dataPoints_)) {
+        if (!store->getCorruptPath().empty()) {
+            std::cerr << "HistoricalDataCollector: " << file << " was unreadable and is kept as "
+                      << store->getCorruptPath() << std::endl;
+        } else if (!store->isWritable()) {
+            std::cerr << "HistoricalDataCollector: " << file << " is unreadable; it will not be overwritten"
+                      << std::endl;
+        } else {
+            std::cout << "HistoricalDataCollector: No existing data file found: " << file << std::endl;
+        }
+        return false;
+    }
+    
+    std::cout << "HistoricalDataCollector: Loaded " << dataPoints_.size() 
+              << " data points from " << file << std::endl;
+    
+    if (file == config_.persistenceFile && !journal_) {
+        store_ = store;
+    }
+    unsavedCount_ = 0;
+    
+    // Cleanup old data after loading
+    cleanupOldData();
+    
+    return true;
+}
+
+bool HistoricalDataCollector::migrateCsv(const std::string& file) {
+    // The persistence file itself may still be a CSV from an older build;
+    // otherwise look for the CSV next to a binary file that does not exist yet
+    std::string csv;
+    std::string backup;
+    if (isCsvFile(file)) {
+        csv = file;
+        backup = file + ".csv.bak";
+    } else if (::access(file.c_str(), F_OK) != 0 && isCsvFile(legacyCsvPath(file))) {
+        csv = legacyCsvPath(file);
+    } else {
+        return false;
+    }
+    
+    if (!importFromCsv(csv)) {
+        return false;
+    }
+    if (!backup.empty() && std::rename(file.c_str(), backup.c_str()) != 0) {
+        std::cerr << "HistoricalDataCollector: Could not move " << file << " aside; keeping CSV data in memory"
+                  << std::endl;
+        return true;
+    }
+    if (saveToFile(file)) {
+        std::cout << "HistoricalDataCollector: Migrated " << dataPoints_.size() << " data points from "
+                  << csv << " to " << file << std::endl;
+    }
+    return true;
+}
+
+bool HistoricalDataCollector::exportToCsv(const std::string& filename) const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::ofstream outFile(filename);
     if (!outFile.is_open()) {
-        std::cerr << "HistoricalDataCollector: Failed to open file for writing: " << file << std::endl;
+        std::cerr << "HistoricalDataCollector: Failed to open file for writing: " << filename << std::endl;
         return false;
     }
     
     // Write CSV header
-    outFile << "hour,dayOfWeek,outdoorTemp,solarProduction,energyCost\n";
+    outFile << "hour,dayOfWeek,outdoorTemp,solarProduction,energyCost,minute\n";
     
     // Write data points
     for (const auto& point : dataPoints_) {
@@ -107,21 +319,21 @@ bool HistoricalDataCollector::saveToFile(const std::string& filename) const {
                 << point.dayOfWeek << ","
                 << point.outdoorTemp << ","
                 << point.solarProduction << ","
-                << point.energyCost << "\n";
+                << point.energyCost << ","
+                << point.minute << "\n";
     }
     
     outFile.close();
     std::cout << "HistoricalDataCollector: Saved " << dataPoints_.size() 
-              << " data points to " << file << std::endl;
+              << " data points to " << filename << std::endl;
     return true;
 }
 
-bool HistoricalDataCollector::loadFromFile(const std::string& filename) {
-    std::string file = filename.empty() ? config_.persistenceFile : filename;
-    
-    std::ifstream inFile(file);
+bool HistoricalDataCollector::importFromCsv(const std::string& filename) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::ifstream inFile(filename);
     if (!inFile.is_open()) {
-        std::cout << "HistoricalDataCollector: No existing data file found: " << file << std::endl;
+        std::cout << "HistoricalDataCollector: No existing data file found: " << filename << std::endl;
         return false;
     }
     
@@ -142,17 +354,29 @@ bool HistoricalDataCollector::loadFromFile(const std::string& filename) {
             >> point.outdoorTemp >> comma 
             >> point.solarProduction >> comma 
             >> point.energyCost) {
+            // Files written before sub-hourly readings have no minute column
+            if (!(iss >> comma >> point.minute)) {
+                point.minute = 0;
+            }
             dataPoints_.push_back(point);
         }
     }
     
     inFile.close();
     std::cout << "HistoricalDataCollector: Loaded " << dataPoints_.size() 
-              << " data points from " << file << std::endl;
+              << " data points from " << filename << std::endl;
     
     // Cleanup old data after loading
     cleanupOldData();
     
+    // Imported points are not in the binary log yet
+    if (journal_) {
+        journal_->replaceStore(dataPoints_);
+        unsavedCount_ = 0;
+    } else {
+        unsavedCount_ = config_.persistenceFormat == PersistenceFormat::BINARY ? dataPoints_.size() : 0;
+    }
+    
     return true;
 }
 
@@ -163,10 +387,29 @@ void HistoricalDataCollector::subscribeToSensorEvents() {
     std::cout << "HistoricalDataCollector: Sensor event subscription configured" << std::endl;
 }
 
-void HistoricalDataCollector::getCurrentTimeInfo(int& hour, int& dayOfWeek) const {
+void HistoricalDataCollector::attachPredictor(std::shared_ptr<MLPredictor> predictor, bool seedFromHistory) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (predictor && seedFromHistory && !predictor->isTrained() && !dataPoints_.empty()) {
+        predictor->train(getDataset());
+    }
+    onlinePredictor_ = predictor;
+    
+    std::cout << "HistoricalDataCollector: " << (predictor ? "Attached" : "Detached") 
+              << " predictor for incremental updates" << std::endl;
+}
+
+void HistoricalDataCollector::getCurrentTimeInfo(int& hour, int& minute, int& dayOfWeek) const {
     std::time_t now = std::time(nullptr);
     std::tm* localTime = std::localtime(&now);
     
     hour = localTime->tm_hour;
+    minute = localTime->tm_min;
     dayOfWeek = localTime->tm_wday;  // 0 = Sunday, 6 = Saturday
 }
+
+size_t HistoricalDataCollector::pointsPerDay() const {
+    // Retention, the journal's store size and getRecentData() count points,
+    // so a day is 96 of them at 15-minute collection, not 24
+    int interval = std::max(1, std::min(config_.collectionIntervalMinutes, TimeSlots::MINUTES_PER_DAY));
+    return static_cast<size_t>(TimeSlots::MINUTES_PER_DAY / interval);
+}
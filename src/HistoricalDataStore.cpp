@@ -0,0 +1,354 @@
+#include "HistoricalDataStore.h"
+#include <cstring>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+const char STORE_MAGIC[8] = {'H', 'D', 'C', 'S', 'T', 'O', 'R', 'E'};
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+bool writeAll(int fd, const void* data, size_t length, off_t offset) {
+    const char* p = static_cast<const char*>(data);
+    while (length > 0) {
+        ssize_t written = ::pwrite(fd, p, length, offset);
+        if (written < 0) {
+            return false;
+        }
+        p += written;
+        offset += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Make a rename in path's directory durable
+bool syncParentDirectory(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+} // namespace
+
+HistoricalDataStore::HistoricalDataStore(const std::string& path)
+    : path_(path), recordCount_(0), checksum_(CHECKSUM_SEED), journalSequence_(0), headerKnown_(false),
+      writable_(true) {}
+
+bool HistoricalDataStore::load(std::deque<HistoricalDataPoint>& out) {
+    Header header;
+    std::deque<HistoricalDataPoint> loaded;
+    FileState state = inspect(header, &loaded);
+    if (state == FileState::CORRUPT) {
+        setAside();
+    }
+    if (state != FileState::VALID) {
+        return false;
+    }
+
+    out.swap(loaded);
+    recordCount_ = header.recordCount;
+    checksum_ = header.checksum;
+    journalSequence_ = header.journalSequence;
+    headerKnown_ = true;
+    return true;
+}
+
+bool HistoricalDataStore::append(const std::deque<HistoricalDataPoint>& data, size_t count) {
+    if (count > data.size()) {
+        count = data.size();
+    }
+
+    std::vector<Record> records;
+    records.reserve(count);
+    for (size_t i = data.size() - count; i < data.size(); ++i) {
+        records.push_back(toRecord(data[i]));
+    }
+    return appendRecords(records);
+}
+
+bool HistoricalDataStore::appendJournaled(const std::vector<Record>& records, uint64_t journalSequence) {
+    uint64_t previous = journalSequence_;
+    journalSequence_ = journalSequence;
+    if (!appendRecords(records)) {
+        journalSequence_ = previous;
+        return false;
+    }
+    return true;
+}
+
+bool HistoricalDataStore::rewrite(const std::deque<HistoricalDataPoint>& data) {
+    std::vector<Record> records;
+    records.reserve(data.size());
+    for (const auto& point : data) {
+        records.push_back(toRecord(point));
+    }
+    return writeFile(records);
+}
+
+bool HistoricalDataStore::retainLast(size_t keep) {
+    std::deque<HistoricalDataPoint> data;
+    if (!load(data)) {
+        return false;
+    }
+    if (data.size() <= keep) {
+        return true;
+    }
+    data.erase(data.begin(), data.begin() + (data.size() - keep));
+    return rewrite(data);
+}
+
+bool HistoricalDataStore::isWritable() const {
+    return writable_;
+}
+
+const std::string& HistoricalDataStore::getCorruptPath() const {
+    return corruptPath_;
+}
+
+uint64_t HistoricalDataStore::getRecordCount() const {
+    return recordCount_;
+}
+
+uint64_t HistoricalDataStore::getJournalSequence() const {
+    return journalSequence_;
+}
+
+const std::string& HistoricalDataStore::getPath() const {
+    return path_;
+}
+
+HistoricalDataStore::Record HistoricalDataStore::toRecord(const HistoricalDataPoint& point) {
+    Record record;
+    std::memset(&record, 0, sizeof(Record));
+    record.hour = static_cast<uint8_t>(point.hour);
+    record.dayOfWeek = static_cast<uint8_t>(point.dayOfWeek);
+    record.minute = static_cast<uint8_t>(point.minute);
+    record.outdoorTemp = point.outdoorTemp;
+    record.solarProduction = point.solarProduction;
+    record.energyCost = point.energyCost;
+    return record;
+}
+
+HistoricalDataPoint HistoricalDataStore::fromRecord(const Record& record) {
+    HistoricalDataPoint point;
+    point.hour = record.hour;
+    point.dayOfWeek = record.dayOfWeek;
+    point.minute = record.minute;
+    point.outdoorTemp = record.outdoorTemp;
+    point.solarProduction = record.solarProduction;
+    point.energyCost = record.energyCost;
+    return point;
+}
+
+uint64_t HistoricalDataStore::checksum(uint64_t seed, const void* data, size_t length) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= p[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+HistoricalDataStore::Header HistoricalDataStore::makeHeader(uint64_t recordCount, uint64_t checksum) const {
+    Header header;
+    std::memset(&header, 0, sizeof(Header));
+    std::memcpy(header.magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+    header.version = SCHEMA_VERSION;
+    header.recordSize = sizeof(Record);
+    header.recordCount = recordCount;
+    header.checksum = checksum;
+    header.journalSequence = journalSequence_;
+    return header;
+}
+
+HistoricalDataStore::FileState HistoricalDataStore::inspect(Header& header,
+                                                            std::deque<HistoricalDataPoint>* out) const {
+    int fd = ::open(path_.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return FileState::MISSING;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return FileState::CORRUPT;
+    }
+    size_t fileSize = static_cast<size_t>(st.st_size);
+    if (fileSize == 0) {
+        ::close(fd);
+        return FileState::MISSING;
+    }
+    if (fileSize < sizeof(Header)) {
+        ::close(fd);
+        std::cerr << "HistoricalDataStore: Truncated header in " << path_ << std::endl;
+        return FileState::CORRUPT;
+    }
+
+    void* mapping = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return FileState::CORRUPT;
+    }
+
+    const char* base = static_cast<const char*>(mapping);
+    std::memcpy(&header, base, sizeof(Header));
+    const char* records = base + sizeof(Header);
+
+    FileState state = FileState::VALID;
+    if (std::memcmp(header.magic, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0 ||
+        header.version != SCHEMA_VERSION || header.recordSize != sizeof(Record)) {
+        std::cerr << "HistoricalDataStore: Unrecognized header in " << path_ << std::endl;
+        state = FileState::CORRUPT;
+    } else if (header.recordCount > (fileSize - sizeof(Header)) / sizeof(Record)) {
+        std::cerr << "HistoricalDataStore: " << path_ << " is truncated (" << header.recordCount
+                  << " records committed, " << (fileSize - sizeof(Header)) / sizeof(Record) << " present)"
+                  << std::endl;
+        state = FileState::CORRUPT;
+    } else if (checksum(CHECKSUM_SEED, records, static_cast<size_t>(header.recordCount) * sizeof(Record)) !=
+               header.checksum) {
+        std::cerr << "HistoricalDataStore: Checksum mismatch in " << path_ << std::endl;
+        state = FileState::CORRUPT;
+    }
+
+    if (state == FileState::VALID && out) {
+        for (uint64_t i = 0; i < header.recordCount; ++i) {
+            Record record;
+            std::memcpy(&record, records + i * sizeof(Record), sizeof(Record));
+            out->push_back(fromRecord(record));
+        }
+    }
+
+    ::munmap(mapping, fileSize);
+    return state;
+}
+
+bool HistoricalDataStore::setAside() {
+    // Never reuse a name: an older .corrupt file may hold other lost data
+    std::string target = path_ + ".corrupt";
+    for (int i = 1; ::access(target.c_str(), F_OK) == 0; ++i) {
+        target = path_ + ".corrupt." + std::to_string(i);
+    }
+
+    if (std::rename(path_.c_str(), target.c_str()) != 0) {
+        std::cerr << "HistoricalDataStore: Could not move " << path_ << " aside; refusing to write to it"
+                  << std::endl;
+        writable_ = false;
+        return false;
+    }
+    syncParentDirectory(path_);
+    std::cerr << "HistoricalDataStore: Moved unreadable " << path_ << " to " << target
+              << " and starting a new file" << std::endl;
+    corruptPath_ = target;
+    headerKnown_ = false;
+    recordCount_ = 0;
+    checksum_ = CHECKSUM_SEED;
+    return true;
+}
+
+bool HistoricalDataStore::appendRecords(const std::vector<Record>& records) {
+    if (!writable_) {
+        return false;
+    }
+    if (!headerKnown_) {
+        Header header;
+        FileState state = inspect(header, nullptr);
+        if (state == FileState::CORRUPT && !setAside()) {
+            return false;
+        }
+        if (state != FileState::VALID) {
+            // No usable file yet: start a fresh one
+            return writeFile(records);
+        }
+        recordCount_ = header.recordCount;
+        checksum_ = header.checksum;
+        journalSequence_ = std::max(journalSequence_, header.journalSequence);
+        headerKnown_ = true;
+    }
+
+    if (records.empty()) {
+        return true;
+    }
+
+    int fd = ::open(path_.c_str(), O_WRONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    size_t bytes = records.size() * sizeof(Record);
+    off_t offset = static_cast<off_t>(sizeof(Header) + recordCount_ * sizeof(Record));
+    uint64_t newChecksum = checksum(checksum_, records.data(), bytes);
+    Header header = makeHeader(recordCount_ + records.size(), newChecksum);
+
+    // Records first, header last: the header is the commit point
+    bool ok = writeAll(fd, records.data(), bytes, offset) &&
+              ::fdatasync(fd) == 0 &&
+              writeAll(fd, &header, sizeof(Header), 0) &&
+              ::fdatasync(fd) == 0;
+    ::close(fd);
+
+    if (ok) {
+        recordCount_ = header.recordCount;
+        checksum_ = newChecksum;
+    } else {
+        headerKnown_ = false;
+    }
+    return ok;
+}
+
+bool HistoricalDataStore::writeFile(const std::vector<Record>& records) {
+    if (!writable_) {
+        return false;
+    }
+    // Replacing a file we never read: keep it if it holds data we cannot read
+    if (!headerKnown_) {
+        Header existing;
+        if (inspect(existing, nullptr) == FileState::CORRUPT && !setAside()) {
+            return false;
+        }
+    }
+
+    size_t bytes = records.size() * sizeof(Record);
+    uint64_t newChecksum = checksum(CHECKSUM_SEED, records.data(), bytes);
+    Header header = makeHeader(records.size(), newChecksum);
+
+    // Write a temporary file and rename it over the old one
+    std::string tmpPath = path_ + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool ok = writeAll(fd, &header, sizeof(Header), 0) &&
+              writeAll(fd, records.data(), bytes, sizeof(Header)) &&
+              ::fdatasync(fd) == 0;
+    ::close(fd);
+
+    if (!ok || std::rename(tmpPath.c_str(), path_.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        headerKnown_ = false;
+        return false;
+    }
+    // Until the directory entry is on disk a crash can bring back the old file
+    if (!syncParentDirectory(path_)) {
+        std::cerr << "HistoricalDataStore: Failed to sync directory of " << path_ << std::endl;
+    }
+
+    recordCount_ = header.recordCount;
+    checksum_ = newChecksum;
+    headerKnown_ = true;
+    return true;
+}
@@ -0,0 +1,221 @@
+#include "HistoricalDataset.h"
+
+namespace {
+
+constexpr int HOURS = HistoricalAggregates::HOURS_PER_DAY;
+constexpr int NUM_BUCKETS = HistoricalAggregates::HOURS_PER_DAY * HistoricalAggregates::DAYS_PER_WEEK;
+constexpr int NUM_SLOTS = static_cast<int>(TimeSlots::FINEST_SLOTS_PER_DAY);
+constexpr int SLOTS_PER_HOUR = static_cast<int>(TimeSlots::FINEST_SLOTS_PER_HOUR);
+constexpr int SLOT_MINUTES = TimeSlots::minutes(TimeSlots::FINEST);
+constexpr size_t CHUNK_SIZE = 256;
+
+// Per-bucket sums for one series: values in the first pass, squared
+// deviations from the bucket mean in the second
+template <int Buckets>
+struct SeriesSums {
+    std::array<double, Buckets + 1> mean{};   // Holds the plain sum until computeMeans()
+    std::array<double, Buckets + 1> m2{};
+};
+
+// Count and series sums per bucket; index Buckets is the sink for rows
+// that do not belong in this table
+template <int Buckets>
+struct BucketTable {
+    std::array<double, Buckets + 1> count{};
+    SeriesSums<Buckets> cost, solar, temp;
+
+    void add(int32_t b, double c, double s, double t) {
+        count[b] += 1.0;
+        cost.mean[b] += c;
+        solar.mean[b] += s;
+        temp.mean[b] += t;
+    }
+
+    void computeMeans() {
+        for (int b = 0; b < Buckets; ++b) {
+            double scale = count[b] > 0.0 ? 1.0 / count[b] : 0.0;
+            cost.mean[b] *= scale;
+            solar.mean[b] *= scale;
+            temp.mean[b] *= scale;
+        }
+    }
+
+    void addDeviation(int32_t b, double c, double s, double t) {
+        double dc = c - cost.mean[b];
+        double ds = s - solar.mean[b];
+        double dt = t - temp.mean[b];
+        cost.m2[b] += dc * dc;
+        solar.m2[b] += ds * ds;
+        temp.m2[b] += dt * dt;
+    }
+
+    BucketStats finalize(int b) const {
+        BucketStats stats;
+        stats.count = count[b];
+        if (count[b] > 0.0) {
+            stats.cost = {cost.mean[b], cost.m2[b] / count[b]};
+            stats.solar = {solar.mean[b], solar.m2[b] / count[b]};
+            stats.temp = {temp.mean[b], temp.m2[b] / count[b]};
+        }
+        return stats;
+    }
+};
+
+// Bucket indices for one chunk of rows. A bad hour discards the row
+// everywhere; a bad weekday or minute only keeps it out of that table.
+struct ChunkIndex {
+    int32_t hour[CHUNK_SIZE];
+    int32_t weekday[CHUNK_SIZE];
+    int32_t slot[CHUNK_SIZE];
+
+    void compute(const int32_t* hours, const int32_t* minutes, const int32_t* days, size_t len) {
+        // Branch-free, so it vectorizes
+        for (size_t i = 0; i < len; ++i) {
+            int32_t h = hours[i];
+            int32_t m = minutes[i];
+            int32_t d = days[i];
+            bool hourValid = (h >= 0) & (h < HOURS);
+            bool dayValid = hourValid & (d >= 0) & (d < HistoricalAggregates::DAYS_PER_WEEK);
+            bool minuteValid = hourValid & (m >= 0) & (m < TimeSlots::MINUTES_PER_HOUR);
+            hour[i] = hourValid ? h : HOURS;
+            weekday[i] = dayValid ? d * HOURS + h : NUM_BUCKETS;
+            slot[i] = minuteValid ? h * SLOTS_PER_HOUR + m / SLOT_MINUTES : NUM_SLOTS;
+        }
+    }
+};
+
+} // namespace
+
+HistoricalDataset::HistoricalDataset(const std::vector<HistoricalDataPoint>& points) {
+    reserve(points.size());
+    for (const auto& point : points) {
+        append(point);
+    }
+}
+
+void HistoricalDataset::reserve(size_t capacity) {
+    hours_.reserve(capacity);
+    minutes_.reserve(capacity);
+    daysOfWeek_.reserve(capacity);
+    outdoorTemps_.reserve(capacity);
+    solarProduction_.reserve(capacity);
+    energyCosts_.reserve(capacity);
+}
+
+void HistoricalDataset::append(const HistoricalDataPoint& point) {
+    hours_.push_back(point.hour);
+    minutes_.push_back(point.minute);
+    daysOfWeek_.push_back(point.dayOfWeek);
+    outdoorTemps_.push_back(point.outdoorTemp);
+    solarProduction_.push_back(point.solarProduction);
+    energyCosts_.push_back(point.energyCost);
+}
+
+void HistoricalDataset::clear() {
+    hours_.clear();
+    minutes_.clear();
+    daysOfWeek_.clear();
+    outdoorTemps_.clear();
+    solarProduction_.clear();
+    energyCosts_.clear();
+}
+
+size_t HistoricalDataset::size() const {
+    return hours_.size();
+}
+
+bool HistoricalDataset::empty() const {
+    return hours_.empty();
+}
+
+HistoricalDataPoint HistoricalDataset::at(size_t index) const {
+    HistoricalDataPoint point;
+    point.hour = hours_[index];
+    point.minute = minutes_[index];
+    point.dayOfWeek = daysOfWeek_[index];
+    point.outdoorTemp = outdoorTemps_[index];
+    point.solarProduction = solarProduction_[index];
+    point.energyCost = energyCosts_[index];
+    return point;
+}
+
+const HistoricalDataset::Column<int32_t>& HistoricalDataset::getHours() const {
+    return hours_;
+}
+
+const HistoricalDataset::Column<int32_t>& HistoricalDataset::getMinutes() const {
+    return minutes_;
+}
+
+const HistoricalDataset::Column<int32_t>& HistoricalDataset::getDaysOfWeek() const {
+    return daysOfWeek_;
+}
+
+const HistoricalDataset::Column<double>& HistoricalDataset::getOutdoorTemps() const {
+    return outdoorTemps_;
+}
+
+const HistoricalDataset::Column<double>& HistoricalDataset::getSolarProduction() const {
+    return solarProduction_;
+}
+
+const HistoricalDataset::Column<double>& HistoricalDataset::getEnergyCosts() const {
+    return energyCosts_;
+}
+
+HistoricalAggregates HistoricalDataset::aggregate() const {
+    // Two passes (sums, then squared deviations from the mean) rather than
+    // sum of squares minus squared mean, which cancels badly for large values
+    BucketTable<HOURS> hourly;
+    BucketTable<NUM_BUCKETS> weekday;
+    BucketTable<NUM_SLOTS> slots;
+
+    const size_t n = size();
+    const int32_t* hours = hours_.data();
+    const int32_t* minutes = minutes_.data();
+    const int32_t* days = daysOfWeek_.data();
+    const double* costs = energyCosts_.data();
+    const double* solars = solarProduction_.data();
+    const double* temps = outdoorTemps_.data();
+
+    ChunkIndex index;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t base = 0; base < n; base += CHUNK_SIZE) {
+            const size_t len = (n - base < CHUNK_SIZE) ? n - base : CHUNK_SIZE;
+            index.compute(hours + base, minutes + base, days + base, len);
+
+            // Scatter into the cache-resident bucket tables
+            for (size_t i = 0; i < len; ++i) {
+                const double c = costs[base + i];
+                const double s = solars[base + i];
+                const double t = temps[base + i];
+                if (pass == 0) {
+                    hourly.add(index.hour[i], c, s, t);
+                    weekday.add(index.weekday[i], c, s, t);
+                    slots.add(index.slot[i], c, s, t);
+                } else {
+                    hourly.addDeviation(index.hour[i], c, s, t);
+                    weekday.addDeviation(index.weekday[i], c, s, t);
+                    slots.addDeviation(index.slot[i], c, s, t);
+                }
+            }
+        }
+        if (pass == 0) {
+            hourly.computeMeans();
+            weekday.computeMeans();
+            slots.computeMeans();
+        }
+    }
+
+    HistoricalAggregates result;
+    for (int hour = 0; hour < HOURS; ++hour) {
+        result.hourly[hour] = hourly.finalize(hour);
+    }
+    for (int b = 0; b < NUM_BUCKETS; ++b) {
+        result.hourlyByWeekday[b] = weekday.finalize(b);
+    }
+    for (int slot = 0; slot < NUM_SLOTS; ++slot) {
+        result.bySlot[slot] = slots.finalize(slot);
+    }
+    return result;
+}
@@ -0,0 +1,456 @@
+#include "LinearProgram.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double PRIMAL_TOLERANCE = 1e-7;
+const double PIVOT_TOLERANCE = 1e-7;
+const double DUAL_TOLERANCE = 1e-9;
+const double DROP_TOLERANCE = 1e-12;     // Tableau entries below this are treated as zero
+const double BOX_BOUND = 1e9;            // Stands in for +inf on variables with negative cost
+const size_t REFRESH_INTERVAL = 100;     // Pivots between recomputing the basic values
+
+} // namespace
+
+int LinearProgram::addVariable(double cost, double lower, double upper) {
+    cost_.push_back(cost);
+    lower_.push_back(lower);
+    upper_.push_back(upper);
+    return static_cast<int>(cost_.size() - 1);
+}
+
+void LinearProgram::addConstraint(const LinearConstraint& constraint) {
+    constraints_.push_back(constraint);
+}
+
+size_t LinearProgram::getVariableCount() const {
+    return cost_.size();
+}
+
+size_t LinearProgram::getConstraintCount() const {
+    return constraints_.size();
+}
+
+double LinearProgram::getCost(int variable) const {
+    return cost_[variable];
+}
+
+double LinearProgram::getLower(int variable) const {
+    return lower_[variable];
+}
+
+double LinearProgram::getUpper(int variable) const {
+    return upper_[variable];
+}
+
+const std::vector<LinearConstraint>& LinearProgram::getConstraints() const {
+    return constraints_;
+}
+
+SimplexTableau::SimplexTableau(const LinearProgram& lp) : iterations_(0) {
+    const auto& constraints = lp.getConstraints();
+    size_t variables = lp.getVariableCount();
+    size_t columns = variables + constraints.size();
+
+    cost_.assign(columns, 0.0);
+    lower_.assign(columns, 0.0);
+    upper_.assign(columns, 0.0);
+    value_.assign(columns, 0.0);
+    atUpper_.assign(columns, 0);
+    boxed_.assign(columns, 0);
+    basicRow_.assign(columns, -1);
+
+    for (size_t j = 0; j < variables; ++j) {
+        int variable = static_cast<int>(j);
+        variableColumn_.push_back(j);
+        cost_[j] = lp.getCost(variable);
+        lower_[j] = lp.getLower(variable);
+        upper_[j] = lp.getUpper(variable);
+        if (cost_[j] < 0.0 && upper_[j] == LinearProgram::INF) {
+            upper_[j] = BOX_BOUND;
+            boxed_[j] = 1;
+        }
+        // Resting on the bound the cost prefers makes the slack basis dual feasible
+        atUpper_[j] = cost_[j] < 0.0 ? 1 : 0;
+        value_[j] = atUpper_[j] ? upper_[j] : lower_[j];
+    }
+    reducedCost_ = cost_;
+
+    rows_.assign(constraints.size(), std::vector<double>(columns, 0.0));
+    basis_.resize(constraints.size());
+    for (size_t i = 0; i < constraints.size(); ++i) {
+        const LinearConstraint& constraint = constraints[i];
+        size_t slack = variables + i;
+        double activity = 0.0;
+        for (const auto& term : constraint.terms) {
+            rows_[i][term.first] += term.second;
+            activity += term.second * value_[term.first];
+        }
+        rows_[i][slack] = 1.0;
+
+        // a'x + s = rhs, so the sense becomes the sign of the slack
+        lower_[slack] = constraint.sense == ConstraintSense::GREATER_EQUAL ? -LinearProgram::INF : 0.0;
+        upper_[slack] = constraint.sense == ConstraintSense::LESS_EQUAL ? LinearProgram::INF : 0.0;
+        atUpper_[slack] = constraint.sense == ConstraintSense::LESS_EQUAL ? 0 : 1;
+        value_[slack] = constraint.rhs - activity;
+        rhs_.push_back(constraint.rhs);
+        slackColumn_.push_back(slack);
+        basis_[i] = slack;
+        basicRow_[slack] = static_cast<int>(i);
+    }
+}
+
+LPStatus SimplexTableau::solve() {
+    size_t columns = cost_.size();
+    size_t limit = iterations_ + 50 * (rows_.size() + columns) + 1000;
+    if (isPrimalFeasible()) {
+        LPStatus status = primalSimplex(limit);
+        if (status != LPStatus::OPTIMAL) {
+            return status;
+        }
+    }
+    makeDualFeasible();
+
+    size_t refreshed = iterations_;
+    for (;;) {
+        // Leaving row: the basic variable furthest outside its bounds
+        size_t leave = rows_.size();
+        double worst = PRIMAL_TOLERANCE;
+        for (size_t r = 0; r < rows_.size(); ++r) {
+            size_t basic = basis_[r];
+            double infeasibility = std::max(lower_[basic] - value_[basic], value_[basic] - upper_[basic]);
+            if (infeasibility > worst) {
+                worst = infeasibility;
+                leave = r;
+            }
+        }
+        if (leave == rows_.size() && refreshed == iterations_) {
+            break;
+        }
+        if (leave == rows_.size() || iterations_ - refreshed >= REFRESH_INTERVAL) {
+            // Incremental updates drift over many pivots; check against b before trusting them
+            recomputeBasicValues();
+            refreshed = iterations_;
+            continue;
+        }
+        if (iterations_ >= limit) {
+            return LPStatus::ITERATION_LIMIT;
+        }
+
+        const std::vector<double>& row = rows_[leave];
+        size_t leaving = basis_[leave];
+        bool toLower = value_[leaving] < lower_[leaving];
+        double target = toLower ? lower_[leaving] : upper_[leaving];
+        double delta = value_[leaving] - target;
+
+        // Dual ratio test; ties go to the largest pivot for stability
+        size_t enter = columns;
+        double bestRatio = LinearProgram::INF;
+        double bestPivot = 0.0;
+        for (size_t j = 0; j < columns; ++j) {
+            double alpha = row[j];
+            if (basicRow_[j] >= 0 || std::fabs(alpha) <= PIVOT_TOLERANCE || !(upper_[j] > lower_[j])) {
+                continue;
+            }
+            bool increase = (delta > 0.0) == (alpha > 0.0);
+            if (increase == (atUpper_[j] != 0)) {
+                continue;
+            }
+            double ratio = std::fabs(reducedCost_[j]) / std::fabs(alpha);
+            if (ratio < bestRatio - 1e-12 || (ratio <= bestRatio + 1e-12 && std::fabs(alpha) > bestPivot)) {
+                enter = j;
+                bestRatio = ratio;
+                bestPivot = std::fabs(alpha);
+            }
+        }
+        if (enter == columns) {
+            return LPStatus::INFEASIBLE;
+        }
+
+        double step = delta / row[enter];
+        for (size_t r = 0; r < rows_.size(); ++r) {
+            value_[basis_[r]] -= rows_[r][enter] * step;
+        }
+        value_[enter] += step;
+        value_[leaving] = target;
+        atUpper_[leaving] = toLower ? 0 : 1;
+        pivot(leave, enter);
+        ++iterations_;
+    }
+
+    for (size_t j = 0; j < columns; ++j) {
+        if (boxed_[j] && std::fabs(value_[j]) >= BOX_BOUND * 0.5) {
+            return LPStatus::UNBOUNDED;
+        }
+    }
+    return LPStatus::OPTIMAL;
+}
+
+bool SimplexTableau::isPrimalFeasible() const {
+    for (size_t basic : basis_) {
+        if (value_[basic] < lower_[basic] - PRIMAL_TOLERANCE || value_[basic] > upper_[basic] + PRIMAL_TOLERANCE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+LPStatus SimplexTableau::primalSimplex(size_t limit) {
+    size_t columns = cost_.size();
+    for (;;) {
+        // Entering column: the reduced cost that improves the objective most
+        size_t enter = columns;
+        double best = DUAL_TOLERANCE;
+        for (size_t j = 0; j < columns; ++j) {
+            if (basicRow_[j] >= 0 || !(upper_[j] > lower_[j])) {
+                continue;
+            }
+            double gain = atUpper_[j] ? reducedCost_[j] : -reducedCost_[j];
+            if (gain > best) {
+                best = gain;
+                enter = j;
+            }
+        }
+        if (enter == columns) {
+            return LPStatus::OPTIMAL;
+        }
+        if (iterations_ >= limit) {
+            return LPStatus::ITERATION_LIMIT;
+        }
+
+        // Ratio test; the entering column's own range may block first (a bound flip)
+        double direction = atUpper_[enter] ? -1.0 : 1.0;
+        double step = upper_[enter] - lower_[enter];
+        size_t leave = rows_.size();
+        for (size_t r = 0; r < rows_.size(); ++r) {
+            double alpha = rows_[r][enter];
+            if (std::fabs(alpha) <= PIVOT_TOLERANCE) {
+                continue;
+            }
+            size_t basic = basis_[r];
+            double room = alpha * direction < 0.0 ? upper_[basic] - value_[basic] : value_[basic] - lower_[basic];
+            if (room == LinearProgram::INF) {
+                continue;
+            }
+            double ratio = std::max(0.0, room) / std::fabs(alpha);
+            if (ratio < step - 1e-12 ||
+                (leave < rows_.size() && ratio <= step + 1e-12 && std::fabs(alpha) > std::fabs(rows_[leave][enter]))) {
+                step = ratio;
+                leave = r;
+            }
+        }
+        if (step == LinearProgram::INF) {
+            return LPStatus::UNBOUNDED;
+        }
+
+        for (size_t r = 0; r < rows_.size(); ++r) {
+            value_[basis_[r]] -= rows_[r][enter] * direction * step;
+        }
+        value_[enter] += direction * step;
+        ++iterations_;
+        if (leave == rows_.size()) {
+            atUpper_[enter] = atUpper_[enter] ? 0 : 1;
+            value_[enter] = atUpper_[enter] ? upper_[enter] : lower_[enter];
+            continue;
+        }
+
+        size_t leaving = basis_[leave];
+        bool toUpper = rows_[leave][enter] * direction < 0.0;
+        value_[leaving] = toUpper ? upper_[leaving] : lower_[leaving];
+        atUpper_[leaving] = toUpper ? 1 : 0;
+        pivot(leave, enter);
+    }
+}
+
+void SimplexTableau::makeDualFeasible() {
+    // Nonbasic columns whose reduced cost favours the other bound move there;
+    // an infinite bound is replaced by BOX_BOUND for the purpose
+    for (size_t j = 0; j < cost_.size(); ++j) {
+        if (basicRow_[j] >= 0 || !(upper_[j] > lower_[j])) {
+            continue;
+        }
+        if (!atUpper_[j] && reducedCost_[j] < -DUAL_TOLERANCE) {
+            if (upper_[j] == LinearProgram::INF) {
+                upper_[j] = BOX_BOUND;
+                boxed_[j] = 1;
+            }
+            atUpper_[j] = 1;
+            shiftNonbasic(j, upper_[j]);
+        } else if (atUpper_[j] && reducedCost_[j] > DUAL_TOLERANCE) {
+            if (lower_[j] == -LinearProgram::INF) {
+                lower_[j] = -BOX_BOUND;
+                boxed_[j] = 1;
+            }
+            atUpper_[j] = 0;
+            shiftNonbasic(j, lower_[j]);
+        }
+    }
+}
+
+void SimplexTableau::recomputeBasicValues() {
+    // x_B = B^-1 b - B^-1 N x_N, with B^-1 held in the slack columns
+    std::vector<double> nonbasic;
+    std::vector<size_t> columns;
+    for (size_t j = 0; j < value_.size(); ++j) {
+        if (basicRow_[j] < 0 && value_[j] != 0.0) {
+            columns.push_back(j);
+            nonbasic.push_back(value_[j]);
+        }
+    }
+    for (size_t r = 0; r < rows_.size(); ++r) {
+        const std::vector<double>& row = rows_[r];
+        double value = 0.0;
+        for (size_t i = 0; i < rhs_.size(); ++i) {
+            value += row[slackColumn_[i]] * rhs_[i];
+        }
+        for (size_t k = 0; k < columns.size(); ++k) {
+            value -= row[columns[k]] * nonbasic[k];
+        }
+        value_[basis_[r]] = value;
+    }
+}
+
+void SimplexTableau::shiftNonbasic(size_t column, double value) {
+    double shift = value - value_[column];
+    if (shift == 0.0) {
+        return;
+    }
+    for (size_t r = 0; r < rows_.size(); ++r) {
+        value_[basis_[r]] -= rows_[r][column] * shift;
+    }
+    value_[column] = value;
+}
+
+void SimplexTableau::pivot(size_t row, size_t column) {
+    std::vector<double>& pivotRow = rows_[row];
+    double inverse = 1.0 / pivotRow[column];
+
+    // Only the pivot row's nonzeros take part in the elimination
+    std::vector<size_t> nonzeros;
+    for (size_t j = 0; j < pivotRow.size(); ++j) {
+        if (pivotRow[j] != 0.0) {
+            pivotRow[j] *= inverse;
+            nonzeros.push_back(j);
+        }
+    }
+    pivotRow[column] = 1.0;
+
+    // A mostly dense pivot row is cheaper to sweep in full than through the index
+    bool dense = nonzeros.size() * 2 > pivotRow.size();
+    for (size_t i = 0; i < rows_.size(); ++i) {
+        double factor = rows_[i][column];
+        if (i == row || factor == 0.0) {
+            continue;
+        }
+        std::vector<double>& current = rows_[i];
+        if (dense) {
+            const double* source = pivotRow.data();
+            double* target = current.data();
+            for (size_t j = 0; j < current.size(); ++j) {
+                double updated = target[j] - factor * source[j];
+                target[j] = std::fabs(updated) < DROP_TOLERANCE ? 0.0 : updated;
+            }
+        } else {
+            for (size_t j : nonzeros) {
+                double updated = current[j] - factor * pivotRow[j];
+                current[j] = std::fabs(updated) < DROP_TOLERANCE ? 0.0 : updated;
+            }
+        }
+        current[column] = 0.0;
+    }
+
+    double factor = reducedCost_[column];
+    if (factor != 0.0) {
+        for (size_t j : nonzeros) {
+            reducedCost_[j] -= factor * pivotRow[j];
+        }
+        reducedCost_[column] = 0.0;
+    }
+
+    basicRow_[basis_[row]] = -1;
+    basis_[row] = column;
+    basicRow_[column] = static_cast<int>(row);
+}
+
+void SimplexTableau::setBounds(int variable, double lower, double upper) {
+    size_t j = variableColumn_[variable];
+    lower_[j] = lower;
+    upper_[j] = upper;
+    if (upper != LinearProgram::INF && upper < BOX_BOUND) {
+        boxed_[j] = 0;
+    }
+    // A basic variable's violation is repaired by the dual simplex
+    if (basicRow_[j] < 0) {
+        shiftNonbasic(j, atUpper_[j] ? upper : lower);
+    }
+}
+
+int SimplexTableau::addVariable(double cost, double lower, double upper,
+                                const std::vector<std::pair<int, double>>& column) {
+    size_t j = cost_.size();
+    cost_.push_back(cost);
+    lower_.push_back(lower);
+    upper_.push_back(upper);
+    value_.push_back(lower);
+    atUpper_.push_back(0);
+    boxed_.push_back(0);
+    basicRow_.push_back(-1);
+
+    // Tableau column B^-1 a and reduced cost c - y'a, both from the slack columns
+    double reducedCost = cost;
+    std::vector<double> entries(rows_.size(), 0.0);
+    for (const auto& term : column) {
+        size_t slack = slackColumn_[term.first];
+        reducedCost += reducedCost_[slack] * term.second;
+        for (size_t r = 0; r < rows_.size(); ++r) {
+            entries[r] += rows_[r][slack] * term.second;
+        }
+    }
+    for (size_t r = 0; r < rows_.size(); ++r) {
+        rows_[r].push_back(entries[r]);
+        value_[basis_[r]] -= entries[r] * lower;
+    }
+    reducedCost_.push_back(reducedCost);
+
+    variableColumn_.push_back(j);
+    return static_cast<int>(variableColumn_.size() - 1);
+}
+
+double SimplexTableau::getObjective() const {
+    double objective = 0.0;
+    for (size_t j : variableColumn_) {
+        objective += cost_[j] * value_[j];
+    }
+    return objective;
+}
+
+std::vector<double> SimplexTableau::getValues() const {
+    std::vector<double> values;
+    values.reserve(variableColumn_.size());
+    for (size_t j : variableColumn_) {
+        values.push_back(value_[j]);
+    }
+    return values;
+}
+
+std::vector<double> SimplexTableau::getDuals() const {
+    std::vector<double> duals;
+    duals.reserve(slackColumn_.size());
+    for (size_t slack : slackColumn_) {
+        duals.push_back(-reducedCost_[slack]);
+    }
+    return duals;
+}
+
+double SimplexTableau::getLower(int variable) const {
+    return lower_[variableColumn_[variable]];
+}
+
+double SimplexTableau::getUpper(int variable) const {
+    return upper_[variableColumn_[variable]];
+}
+
+size_t SimplexTableau::getIterations() const {
+    return iterations_;
+}
@@ -1,114 +1,257 @@
 #include "MLPredictor.h"
 
-MLPredictor::MLPredictor() : trained_(false) {}
+namespace {
+
+const double TRAINED_CONFIDENCE = 0.75;
+const double NO_DATA_CONFIDENCE = 0.5;
+const double DEFAULT_CONFIDENCE = 0.6;
+const double MIN_WEEKDAY_WEIGHT = 3.0;   // Readings a (weekday, hour) bucket needs before it is trusted
+
+bool isWeekday(int dayOfWeek) {
+    return dayOfWeek >= 1 && dayOfWeek <= 5;
+}
+
+}
+
+MLPredictor::MLPredictor() : trained_(false), forgettingFactor_(0.98) {}
 
 void MLPredictor::train(const std::vector<HistoricalDataPoint>& historicalData) {
-    historicalData_ = historicalData;
+    train(HistoricalDataset(historicalData));
+}
+
+void MLPredictor::train(const HistoricalDataset& dataset) {
+    // One pass over the columns yields every per-hour and per-weekday statistic
+    HistoricalAggregates aggregates = dataset.aggregate();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = aggregates;
+    for (size_t i = 0; i < hourlyRunning_.size(); ++i) {
+        seedBucket(hourlyRunning_[i], stats_.hourly[i]);
+    }
+    for (size_t i = 0; i < weekdayRunning_.size(); ++i) {
+        seedBucket(weekdayRunning_[i], stats_.hourlyByWeekday[i]);
+    }
+    for (size_t i = 0; i < slotRunning_.size(); ++i) {
+        seedBucket(slotRunning_[i], stats_.bySlot[i]);
+    }
     trained_ = true;
-    
-    // Calculate statistics for each hour
-    for (int hour = 0; hour < 24; hour++) {
-        std::vector<double> costs, solar, temps;
-        
-        for (const auto& point : historicalData) {
-            if (point.hour == hour) {
-                costs.push_back(point.energyCost);
-                solar.push_back(point.solarProduction);
-                temps.push_back(point.outdoorTemp);
-            }
-        }
-        
-        if (!costs.empty()) {
-            hourlyStats_[hour].avgCost = average(costs);
-            hourlyStats_[hour].avgSolar = average(solar);
-            hourlyStats_[hour].avgTemp = average(temps);
-        }
+}
+
+void MLPredictor::update(const HistoricalDataPoint& point) {
+    // Same bucketing as HistoricalDataset::aggregate(): a bad day or minute
+    // only keeps the reading out of the weekday or slot buckets
+    if (point.hour < 0 || point.hour >= HistoricalAggregates::HOURS_PER_DAY) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    updateBucket(hourlyRunning_[point.hour], stats_.hourly[point.hour], point);
+
+    if (point.dayOfWeek >= 0 && point.dayOfWeek < HistoricalAggregates::DAYS_PER_WEEK) {
+        int index = point.dayOfWeek * HistoricalAggregates::HOURS_PER_DAY + point.hour;
+        updateBucket(weekdayRunning_[index], stats_.hourlyByWeekday[index], point);
     }
+
+    if (point.minute >= 0 && point.minute < TimeSlots::MINUTES_PER_HOUR) {
+        size_t slot = TimeSlots::slotOfDay(TimeSlots::FINEST, point.hour, point.minute);
+        updateBucket(slotRunning_[slot], stats_.bySlot[slot], point);
+    }
+    trained_ = true;
 }
 
-std::vector<HourlyForecast> MLPredictor::predictNext24Hours(int currentHour, int currentDayOfWeek) {
-    if (!trained_) {
-        return generateDefaultForecasts(currentHour);
+void MLPredictor::setForgettingFactor(double lambda) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (lambda > 0.0 && lambda <= 1.0) {
+        forgettingFactor_ = lambda;
     }
+}
 
-    std::vector<HourlyForecast> forecasts;
-    
-    for (int i = 0; i < 24; i++) {
-        int hour = (currentHour + i) % 24;
-        int dayOfWeek = currentDayOfWeek;
-        
-        // Adjust day if we cross midnight
-        if (currentHour + i >= 24) {
-            dayOfWeek = (dayOfWeek + 1) % 7;
+double MLPredictor::getForgettingFactor() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return forgettingFactor_;
+}
+
+void MLPredictor::seedBucket(RunningBucket& bucket, const BucketStats& stats) {
+    bucket.weight = stats.count;
+    bucket.cost.mean = stats.cost.mean;
+    bucket.cost.m2 = stats.cost.variance * stats.count;
+    bucket.solar.mean = stats.solar.mean;
+    bucket.solar.m2 = stats.solar.variance * stats.count;
+    bucket.temp.mean = stats.temp.mean;
+    bucket.temp.m2 = stats.temp.variance * stats.count;
+}
+
+void MLPredictor::updateSeries(RunningSeries& series, double value, double lambda, double weight) {
+    // Weighted Welford step: weight already includes the new sample
+    double delta = value - series.mean;
+    series.mean += delta / weight;
+    series.m2 = lambda * series.m2 + delta * (value - series.mean);
+}
+
+BucketStats MLPredictor::toStats(const RunningBucket& bucket) {
+    BucketStats stats;
+    stats.count = bucket.weight;
+    if (bucket.weight > 0.0) {
+        stats.cost.mean = bucket.cost.mean;
+        stats.cost.variance = bucket.cost.m2 / bucket.weight;
+        stats.solar.mean = bucket.solar.mean;
+        stats.solar.variance = bucket.solar.m2 / bucket.weight;
+        stats.temp.mean = bucket.temp.mean;
+        stats.temp.variance = bucket.temp.m2 / bucket.weight;
+    }
+    return stats;
+}
+
+void MLPredictor::updateBucket(RunningBucket& running, BucketStats& stats, const HistoricalDataPoint& point) {
+    running.weight = forgettingFactor_ * running.weight + 1.0;
+    updateSeries(running.cost, point.energyCost, forgettingFactor_, running.weight);
+    updateSeries(running.solar, point.solarProduction, forgettingFactor_, running.weight);
+    updateSeries(running.temp, point.outdoorTemp, forgettingFactor_, running.weight);
+    stats = toStats(running);
+}
+
+std::vector<HourlyForecast> MLPredictor::predictNext24Hours(int currentHour, int currentDayOfWeek) {
+    return predictNextDay(SlotLength::ONE_HOUR, currentHour, currentDayOfWeek);
+}
+
+std::vector<HourlyForecast> MLPredictor::predictNextDay(SlotLength length, int currentHour, int currentDayOfWeek,
+                                                        int currentMinute) {
+    int minuteOfDay = currentHour * TimeSlots::MINUTES_PER_HOUR + currentMinute;
+    minuteOfDay = (minuteOfDay % TimeSlots::MINUTES_PER_DAY + TimeSlots::MINUTES_PER_DAY) % TimeSlots::MINUTES_PER_DAY;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return TimeSlots::dispatch(length, [&](auto fixed) {
+        return forecastFrom<decltype(fixed)::value>(minuteOfDay, currentDayOfWeek);
+    });
+}
+
+template <SlotLength Length>
+SlotProfile<Length> MLPredictor::predictProfile(int dayOfWeek) {
+    SlotProfile<Length> profile;
+    std::lock_guard<std::mutex> lock(mutex_);
+    fillProfile(dayOfWeek, profile);
+    return profile;
+}
+
+template <SlotLength Length>
+void MLPredictor::fillProfile(int dayOfWeek, SlotProfile<Length>& profile) const {
+    constexpr int minutes = TimeSlots::minutes(Length);
+    constexpr size_t fineSlots = static_cast<size_t>(minutes / TimeSlots::minutes(TimeSlots::FINEST));
+
+    for (size_t slot = 0; slot < profile.cost.size(); slot++) {
+        int start = static_cast<int>(slot) * minutes;
+        int hour = start / TimeSlots::MINUTES_PER_HOUR;
+        double time = start / static_cast<double>(TimeSlots::MINUTES_PER_HOUR);
+
+        if (!trained_) {
+            // Default pattern: high cost during day, low at night
+            if (hour >= 8 && hour <= 20) {
+                profile.cost[slot] = 0.15 + (0.03 * (hour % 4));
+            } else {
+                profile.cost[slot] = 0.08;
+            }
+
+            // Solar production during daylight
+            if (time >= 6.0 && time <= 18.0) {
+                profile.solar[slot] = 5.0 * std::sin((time - 6) * 3.14159 / 12.0);
+            } else {
+                profile.solar[slot] = 0.0;
+            }
+
+            // Temperature variation
+            profile.temp[slot] = 15.0 + 8.0 * std::sin((time - 6) * 3.14159 / 12.0);
+            profile.confidence[slot] = DEFAULT_CONFIDENCE;
+            continue;
         }
-        
-        HourlyForecast forecast;
-        forecast.hour = hour;
-        
-        // Use simple pattern matching from historical data
-        if (hourlyStats_.find(hour) != hourlyStats_.end()) {
-            const auto& stats = hourlyStats_[hour];
-            
-            // Add some variation based on day of week
-            double weekdayFactor = (dayOfWeek >= 1 && dayOfWeek <= 5) ? 1.1 : 0.9;
-            
-            forecast.predictedEnergyCost = stats.avgCost * weekdayFactor;
-            forecast.predictedSolarProduction = stats.avgSolar;
-            forecast.predictedOutdoorTemp = stats.avgTemp;
-            forecast.confidenceScore = 0.75; // Moderate confidence
+
+        // Sub-hourly slots pool the 5-minute buckets they cover
+        BucketStats stats = stats_.hourly[hour];
+        if (fineSlots < TimeSlots::FINEST_SLOTS_PER_HOUR) {
+            BucketStats pooled;
+            for (size_t fine = slot * fineSlots; fine < (slot + 1) * fineSlots; fine++) {
+                const BucketStats& bucket = stats_.bySlot[fine];
+                pooled.count += bucket.count;
+                pooled.cost.mean += bucket.cost.mean * bucket.count;
+                pooled.solar.mean += bucket.solar.mean * bucket.count;
+                pooled.temp.mean += bucket.temp.mean * bucket.count;
+            }
+            if (pooled.count > 0.0) {
+                pooled.cost.mean /= pooled.count;
+                pooled.solar.mean /= pooled.count;
+                pooled.temp.mean /= pooled.count;
+                stats = pooled;
+            }
+        }
+
+        if (stats.count > 0.0) {
+            profile.cost[slot] = stats.cost.mean * weekdayCostFactor(dayOfWeek, hour);
+            profile.solar[slot] = stats.solar.mean;
+            profile.temp[slot] = stats.temp.mean;
+            profile.confidence[slot] = TRAINED_CONFIDENCE;
         } else {
             // Use defaults if no data available
-            forecast.predictedEnergyCost = 0.12;
-            forecast.predictedSolarProduction = (hour >= 6 && hour <= 18) ? 3.0 : 0.0;
-            forecast.predictedOutdoorTemp = 20.0;
-            forecast.confidenceScore = 0.5; // Low confidence
+            profile.cost[slot] = 0.12;
+            profile.solar[slot] = (hour >= 6 && hour <= 18) ? 3.0 : 0.0;
+            profile.temp[slot] = 20.0;
+            profile.confidence[slot] = NO_DATA_CONFIDENCE;
         }
-        
-        forecasts.push_back(forecast);
     }
-    
-    return forecasts;
 }
 
-bool MLPredictor::isTrained() const { 
-    return trained_; 
+double MLPredictor::weekdayCostFactor(int dayOfWeek, int hour) const {
+    // Learned from the (weekday, hour) bucket once it has enough readings
+    if (dayOfWeek >= 0 && dayOfWeek < HistoricalAggregates::DAYS_PER_WEEK) {
+        const BucketStats& weekday = stats_.forWeekday(dayOfWeek, hour);
+        const BucketStats& hourly = stats_.hourly[hour];
+        if (weekday.count >= MIN_WEEKDAY_WEIGHT && hourly.cost.mean > 0.0) {
+            return weekday.cost.mean / hourly.cost.mean;
+        }
+    }
+    // Otherwise a fixed weekday premium / weekend discount
+    return isWeekday(dayOfWeek) ? 1.1 : 0.9;
 }
 
-double MLPredictor::average(const std::vector<double>& values) {
-    if (values.empty()) return 0.0;
-    double sum = 0.0;
-    for (double v : values) sum += v;
-    return sum / values.size();
-}
+template <SlotLength Length>
+std::vector<HourlyForecast> MLPredictor::forecastFrom(int minuteOfDay, int dayOfWeek) {
+    constexpr int minutes = TimeSlots::minutes(Length);
+    constexpr size_t slots = TimeSlots::slotsPerDay(Length);
+
+    // Today's profile up to midnight, then tomorrow's
+    SlotProfile<Length> today;
+    SlotProfile<Length> tomorrow;
+    fillProfile(dayOfWeek, today);
+    fillProfile((dayOfWeek + 1) % 7, tomorrow);
 
-std::vector<HourlyForecast> MLPredictor::generateDefaultForecasts(int currentHour) {
     std::vector<HourlyForecast> forecasts;
-    
-    for (int i = 0; i < 24; i++) {
-        int hour = (currentHour + i) % 24;
+    forecasts.reserve(slots);
+    size_t first = static_cast<size_t>(minuteOfDay / minutes);
+    for (size_t i = 0; i < slots; i++) {
+        size_t slot = (first + i) % slots;
+        const SlotProfile<Length>& profile = first + i < slots ? today : tomorrow;
+        int start = static_cast<int>(slot) * minutes;
+
         HourlyForecast forecast;
-        forecast.hour = hour;
-        
-        // Default pattern: high cost during day, low at night
-        if (hour >= 8 && hour <= 20) {
-            forecast.predictedEnergyCost = 0.15 + (0.03 * (hour % 4));
-        } else {
-            forecast.predictedEnergyCost = 0.08;
-        }
-        
-        // Solar production during daylight
-        if (hour >= 6 && hour <= 18) {
-            forecast.predictedSolarProduction = 5.0 * std::sin((hour - 6) * 3.14159 / 12.0);
-        } else {
-            forecast.predictedSolarProduction = 0.0;
-        }
-        
-        // Temperature variation
-        forecast.predictedOutdoorTemp = 15.0 + 8.0 * std::sin((hour - 6) * 3.14159 / 12.0);
-        forecast.confidenceScore = 0.6;
-        
+        forecast.hour = start / TimeSlots::MINUTES_PER_HOUR;
+        forecast.minute = start % TimeSlots::MINUTES_PER_HOUR;
+        forecast.predictedEnergyCost = profile.cost[slot];
+        forecast.predictedSolarProduction = profile.solar[slot];
+        forecast.predictedOutdoorTemp = profile.temp[slot];
+        forecast.confidenceScore = profile.confidence[slot];
         forecasts.push_back(forecast);
     }
-    
     return forecasts;
 }
+
+template SlotProfile<SlotLength::FIVE_MINUTES> MLPredictor::predictProfile<SlotLength::FIVE_MINUTES>(int);
+template SlotProfile<SlotLength::FIFTEEN_MINUTES> MLPredictor::predictProfile<SlotLength::FIFTEEN_MINUTES>(int);
+template SlotProfile<SlotLength::ONE_HOUR> MLPredictor::predictProfile<SlotLength::ONE_HOUR>(int);
+
+bool MLPredictor::isTrained() const { 
+    std::lock_guard<std::mutex> lock(mutex_);
+    return trained_; 
+}
+
+HistoricalAggregates MLPredictor::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
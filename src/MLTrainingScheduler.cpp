@@ -13,6 +13,12 @@ MLTrainingScheduler::MLTrainingScheduler(std::shared_ptr<MLPredictor> predictor,
     std::cout << "  Retraining interval: " << config_.retrainingIntervalHours << " hours" << std::endl;
     std::cout << "  Minimum data points: " << config_.minDataPointsForTraining << std::endl;
     std::cout << "  Auto retrain: " << (config_.autoRetrain ? "enabled" : "disabled") << std::endl;
+    std::cout << "  Incremental learning: " << (config_.incrementalLearning ? "enabled" : "disabled") << std::endl;
+    
+    // In incremental mode every collected point refines the model directly
+    if (config_.incrementalLearning) {
+        collector_->attachPredictor(predictor_);
+    }
 }
 
 MLTrainingScheduler::~MLTrainingScheduler() {
@@ -30,6 +36,11 @@ void MLTrainingScheduler::startAutoTraining() {
         return;
     }
     
+    if (config_.incrementalLearning) {
+        std::cout << "MLTrainingScheduler: Incremental learning active - periodic retraining not needed" << std::endl;
+        return;
+    }
+    
     autoTrainingActive_ = true;
     trainingThread_ = std::thread(&MLTrainingScheduler::trainingLoop, this);
     
@@ -111,8 +122,8 @@ bool MLTrainingScheduler::performTraining() {
         return false;
     }
     
-    // Get all historical data
-    auto historicalData = collector_->getAllData();
+    // Get all historical data in columnar form
+    auto historicalData = collector_->getDataset();
     
     std::cout << "MLTrainingScheduler: Starting training with " << historicalData.size() 
               << " data points" << std::endl;
@@ -1,127 +1,773 @@
-// MQTTClient.cpp - Mock Implementation for Simulation
 #include "MQTTClient.h"
-#include <sstream>
-#include <vector>
 #include <iostream>
 #include <cstring>
+#include <cerrno>
+#include <random>
+#include <algorithm>
+#include <unistd.h>
+#include <netdb.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
-MQTTClient::MQTTClient(const std::string& brokerAddress, int port)
-    : brokerAddress_(brokerAddress), port_(port), connected_(false), mosq_(nullptr) {
-    std::cout << "MQTTClient: Initialized (mock mode - no real broker connection)" << std::endl;
+namespace {
+
+constexpr uint64_t WAKE_TOKEN = 0;
+constexpr uint64_t SOCKET_TOKEN = 1;
+constexpr size_t MAX_WRITE_BACKLOG = 256 * 1024;   // Stop pulling from outbound_ past this
+constexpr int MAX_POLL_MS = 1000;
+
+std::atomic<int> clientInstances(0);
+
+} // namespace
+
+MQTTClient::MQTTClient(const std::string& brokerAddress, int port, const MQTTClientConfig& config)
+    : brokerAddress_(brokerAddress), port_(port), config_(config),
+      connected_(false), running_(false), epollFd_(-1), wakeFd_(-1),
+      backlogBytes_(0), nextPacketId_(1), writeIdle_(true), nextConnectionCallbackId_(1),
+      state_(ConnectionState::DISCONNECTED), socketFd_(-1), wantWrite_(false), writeOffset_(0),
+      reconnectDelayMs_(config.reconnectMinDelayMs), pingOutstanding_(false), everConnected_(false),
+      messagesPublished_(0), messagesReceived_(0), messagesDropped_(0),
+      bytesSent_(0), bytesReceived_(0), writeCalls_(0), reconnects_(0) {
+    if (config_.clientId.empty()) {
+        config_.clientId = "home_automation_" + std::to_string(::getpid()) + "_" +
+                           std::to_string(clientInstances.fetch_add(1));
+    }
+    std::cout << "MQTTClient: Initialized" << std::endl;
     std::cout << "  Broker: " << brokerAddress << ":" << port << std::endl;
 }
 
 MQTTClient::~MQTTClient() {
-    if (connected_) {
-        disconnect();
-    }
+    disconnect();
 }
 
 bool MQTTClient::connect() {
-    std::cout << "MQTTClient: Connected to mock MQTT broker at " 
-              << brokerAddress_ << ":" << port_ << std::endl;
-    connected_ = true;
-    return true;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_) {
+        epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd_ < 0 || wakeFd_ < 0) {
+            std::cerr << "MQTTClient: Failed to create event loop: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.u64 = WAKE_TOKEN;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+
+        running_ = true;
+        networkThread_ = std::thread(&MQTTClient::networkLoop, this);
+    }
+
+    stateCondition_.wait_for(lock, std::chrono::milliseconds(config_.connectTimeoutMs),
+                             [this] { return connected_.load(); });
+    lock.unlock();
+
+    if (connected_) {
+        std::cout << "MQTTClient: Connected to MQTT broker at "
+                  << brokerAddress_ << ":" << port_ << std::endl;
+    } else {
+        std::cerr << "MQTTClient: Broker at " << brokerAddress_ << ":" << port_
+                  << " not reachable yet, retrying in background" << std::endl;
+    }
+    return connected_;
 }
 
 void MQTTClient::disconnect() {
-    if (connected_) {
-        std::cout << "MQTTClient: Disconnected from mock MQTT broker" << std::endl;
-        connected_ = false;
-        subscriptions_.clear();
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    wakeLoop();
+    if (networkThread_.joinable()) {
+        networkThread_.join();
     }
+    ::close(epollFd_);
+    ::close(wakeFd_);
+    epollFd_ = -1;
+    wakeFd_ = -1;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscriptionTrie_.clear();
+        subscribedFilters_.clear();
+        outbound_.clear();
+        queuedPublishIds_.clear();
+        inflight_.clear();
+        inflightBacklog_.clear();
+        backlogBytes_ = 0;
+        inbound_.clear();
+        writeIdle_ = true;
+    }
+    stateCondition_.notify_all();
+    std::cout << "MQTTClient: Disconnected from MQTT broker" << std::endl;
 }
 
 bool MQTTClient::isConnected() const {
     return connected_;
 }
 
-void MQTTClient::subscribe(const std::string& topic, MessageCallback callback) {
-    if (connected_) {
-        subscriptions_[topic] = callback;
+size_t MQTTClient::addConnectionCallback(ConnectionCallback callback) {
+    std::lock_guard<std::mutex> lock(connectionCallbacksMutex_);
+    size_t id = nextConnectionCallbackId_++;
+    connectionCallbacks_[id] = std::move(callback);
+    return id;
+}
+
+void MQTTClient::removeConnectionCallback(size_t id) {
+    std::lock_guard<std::mutex> lock(connectionCallbacksMutex_);
+    connectionCallbacks_.erase(id);
+}
+
+void MQTTClient::subscribe(const std::string& topic, MessageCallback callback, int qos) {
+    qos = std::min(std::max(qos, 0), 1);
+    auto shared = std::make_shared<const MessageCallback>(std::move(callback));
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscriptionTrie_.insert(topic, std::move(shared));
+
+        // The broker only needs to hear about new filters or a QoS upgrade;
+        // while offline the subscription is sent after the next CONNACK
+        auto it = subscribedFilters_.find(topic);
+        bool changed = it == subscribedFilters_.end() || it->second < qos;
+        if (changed) {
+            subscribedFilters_[topic] = qos;
+        }
+        if (changed && connected_) {
+            wake = outbound_.empty();
+            MQTTCodec::appendSubscribe(outbound_, allocatePacketId(), {{topic, qos}});
+            writeIdle_ = false;
+        }
+    }
+    if (wake) {
+        wakeLoop();
+    }
+    if (config_.verboseLogging) {
         std::cout << "MQTTClient: Subscribed to topic: " << topic << std::endl;
     }
 }
 
-void MQTTClient::publish(const std::string& topic, const std::string& payload) {
-    if (connected_) {
-        std::cout << "MQTTClient: Published to topic '" << topic << "': " << payload << std::endl;
-    } else {
+bool MQTTClient::publish(const std::string& topic, const std::string& payload, int qos, bool retain) {
+    if (!running_) {
         std::cerr << "MQTTClient: Cannot publish - not connected" << std::endl;
+        return false;
     }
+
+    qos = qos > 0 ? 1 : 0;
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (outbound_.size() + backlogBytes_ + topic.size() + payload.size() > config_.maxQueuedBytes) {
+            messagesDropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // Only the first packet into an empty buffer needs to wake the loop
+        wake = outbound_.empty() && connected_;
+        if (qos > 0 && (inflight_.size() >= config_.maxInflight || !inflightBacklog_.empty())) {
+            // Window full: sent from the network thread as PUBACKs come in
+            inflightBacklog_.push_back(PendingPublish{topic, payload, retain});
+            backlogBytes_ += topic.size() + payload.size();
+            wake = false;
+        } else if (qos > 0) {
+            uint16_t packetId = allocatePacketId();
+            InflightPublish entry;
+            MQTTCodec::appendPublish(entry.packet, topic, payload, qos, retain, packetId);
+            entry.transmitted = false;
+            outbound_.append(entry.packet);
+            inflight_.emplace(packetId, std::move(entry));
+            queuedPublishIds_.push_back(packetId);
+        } else {
+            MQTTCodec::appendPublish(outbound_, topic, payload, qos, retain, 0);
+        }
+        writeIdle_ = false;
+    }
+
+    messagesPublished_.fetch_add(1, std::memory_order_relaxed);
+    if (config_.verboseLogging) {
+        std::cout << "MQTTClient: Published to topic '" << topic << "': " << payload << std::endl;
+    }
+    if (wake) {
+        wakeLoop();
+    }
+    return true;
 }
 
 void MQTTClient::processMessages() {
-    // In mock mode, messages are handled by simulateMessage()
-    // This method is kept for interface compatibility
+    std::deque<std::pair<std::string, std::string>> messages;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        messages.swap(inbound_);
+    }
+    for (const auto& message : messages) {
+        deliver(message.first, message.second);
+    }
 }
 
 void MQTTClient::simulateMessage(const std::string& topic, const std::string& payload) {
-    if (!connected_) {
+    if (config_.verboseLogging) {
+        std::cout << "MQTTClient: Simulating message on topic '" << topic << "'" << std::endl;
+    }
+    deliver(topic, payload);
+}
+
+bool MQTTClient::waitForDelivery(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return stateCondition_.wait_for(lock, timeout, [this] {
+        return outbound_.empty() && writeIdle_ && inflight_.empty() && inflightBacklog_.empty();
+    });
+}
+
+MQTTClientStats MQTTClient::getStats() const {
+    MQTTClientStats stats;
+    stats.messagesPublished = messagesPublished_.load(std::memory_order_relaxed);
+    stats.messagesReceived = messagesReceived_.load(std::memory_order_relaxed);
+    stats.messagesDropped = messagesDropped_.load(std::memory_order_relaxed);
+    stats.bytesSent = bytesSent_.load(std::memory_order_relaxed);
+    stats.bytesReceived = bytesReceived_.load(std::memory_order_relaxed);
+    stats.writeCalls = writeCalls_.load(std::memory_order_relaxed);
+    stats.reconnects = reconnects_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.inflight = inflight_.size();
+    return stats;
+}
+
+void MQTTClient::networkLoop() {
+    nextReconnect_ = std::chrono::steady_clock::now();
+    epoll_event events[16];
+
+    while (running_) {
+        auto now = std::chrono::steady_clock::now();
+        checkTimers(now);
+
+        int count = ::epoll_wait(epollFd_, events, 16, computeTimeout(now));
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.u64 == WAKE_TOKEN) {
+                uint64_t value;
+                ssize_t ignored = ::read(wakeFd_, &value, sizeof(value));
+                (void)ignored;
+                continue;
+            }
+            if (socketFd_ < 0) {
+                continue;
+            }
+
+            uint32_t flags = events[i].events;
+            if (state_ == ConnectionState::CONNECTING) {
+                if (flags & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+                    onConnectComplete();
+                }
+                continue;
+            }
+            if (flags & EPOLLIN) {
+                handleReadable();
+            }
+            if (socketFd_ >= 0 && (flags & (EPOLLERR | EPOLLHUP))) {
+                closeSocket("Connection lost");
+            }
+        }
+
+        // Write everything queued since the last iteration in one go
+        if (state_ == ConnectionState::CONNECTED) {
+            takeOutbound();
+        }
+        flushWrites();
+    }
+
+    // Drain what is queued and say goodbye, but don't hang on a dead broker
+    if (state_ == ConnectionState::CONNECTED) {
+        takeOutbound();
+        MQTTCodec::appendEmpty(writeBuffer_, MQTTPacketType::DISCONNECT);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        flushWrites();
+        while (socketFd_ >= 0 && writeOffset_ < writeBuffer_.size() &&
+               std::chrono::steady_clock::now() < deadline) {
+            pollfd pfd;
+            pfd.fd = socketFd_;
+            pfd.events = POLLOUT;
+            ::poll(&pfd, 1, 50);
+            flushWrites();
+        }
+    }
+    closeSocket(nullptr);
+}
+
+void MQTTClient::startConnect() {
+    connectStarted_ = std::chrono::steady_clock::now();
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* results = nullptr;
+    std::string service = std::to_string(port_);
+    if (::getaddrinfo(brokerAddress_.c_str(), service.c_str(), &hints, &results) != 0 || !results) {
+        socketFd_ = -1;
+        state_ = ConnectionState::CONNECTING;
+        closeSocket("Cannot resolve broker address");
         return;
     }
-    
-    std::cout << "MQTTClient: Simulating message on topic '" << topic << "'" << std::endl;
-    
-    // Find matching subscriptions and call their callbacks
-    for (const auto& sub : subscriptions_) {
-        if (topicMatches(sub.first, topic)) {
-            sub.second(topic, payload);
+
+    int fd = -1;
+    bool immediate = false;
+    for (addrinfo* address = results; address; address = address->ai_next) {
+        fd = ::socket(address->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            continue;
         }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+            immediate = true;
+            break;
+        }
+        if (errno == EINPROGRESS) {
+            break;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    ::freeaddrinfo(results);
+
+    if (fd < 0) {
+        // Nothing to close; go straight to the backoff path
+        state_ = ConnectionState::CONNECTING;
+        socketFd_ = -1;
+        closeSocket("Connection refused");
+        return;
+    }
+
+    socketFd_ = fd;
+    state_ = ConnectionState::CONNECTING;
+    wantWrite_ = true;
+
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.u64 = SOCKET_TOKEN;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, socketFd_, &event);
+
+    if (immediate) {
+        onConnectComplete();
+    }
+}
+
+void MQTTClient::onConnectComplete() {
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (::getsockopt(socketFd_, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+        closeSocket("Connection refused");
+        return;
     }
+
+    state_ = ConnectionState::AWAITING_CONNACK;
+    writeBuffer_.clear();
+    writeOffset_ = 0;
+    readBuffer_.clear();
+    MQTTCodec::appendConnect(writeBuffer_, config_.clientId, static_cast<uint16_t>(config_.keepAliveSeconds),
+                             true, config_.username, config_.password);
+    flushWrites();
 }
 
-bool MQTTClient::topicMatches(const std::string& pattern, const std::string& topic) const {
-    // Simple MQTT topic matching with + and # wildcards
-    // + matches a single level
-    // # matches multiple levels (must be at end)
-    
-    if (pattern == topic) {
-        return true;
+void MQTTClient::onConnack(const MQTTPacket& packet) {
+    uint8_t returnCode = packet.body.size() >= 2 ? static_cast<uint8_t>(packet.body[1]) : 0xFF;
+    if (returnCode != 0) {
+        std::cerr << "MQTTClient: Broker refused connection (code " << static_cast<int>(returnCode) << ")" << std::endl;
+        closeSocket("Connection refused");
+        return;
     }
-    
-    // Check for # wildcard (matches everything after this point)
-    size_t hashPos = pattern.find('#');
-    if (hashPos != std::string::npos) {
-        // # must be at the end
-        if (hashPos == pattern.length() - 1) {
-            std::string prefix = pattern.substr(0, hashPos);
-            return topic.find(prefix) == 0;
+
+    state_ = ConnectionState::CONNECTED;
+    reconnectDelayMs_ = config_.reconnectMinDelayMs;
+    pingOutstanding_ = false;
+    lastSend_ = std::chrono::steady_clock::now();
+
+    bool reconnected = everConnected_;
+    everConnected_ = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Clean session: restore every subscription in one SUBSCRIBE
+        if (!subscribedFilters_.empty()) {
+            std::vector<std::pair<std::string, int>> filters(subscribedFilters_.begin(), subscribedFilters_.end());
+            MQTTCodec::appendSubscribe(writeBuffer_, allocatePacketId(), filters);
         }
-        // Invalid pattern if # is not at the end
-        return false;
+
+        // Retransmit QoS 1 publishes the previous connection may have lost;
+        // ones still in outbound_ go out with it
+        for (auto& entry : inflight_) {
+            if (entry.second.transmitted) {
+                MQTTCodec::markDuplicate(entry.second.packet);
+                writeBuffer_.append(entry.second.packet);
+            }
+        }
+        connected_ = true;
     }
-    
-    // Check for + wildcard (single level match)
-    size_t plusPos = pattern.find('+');
-    if (plusPos != std::string::npos) {
-        // Split both pattern and topic by '/'
-        std::vector<std::string> patternParts;
-        std::vector<std::string> topicParts;
-        
-        std::stringstream patternStream(pattern);
-        std::stringstream topicStream(topic);
-        std::string part;
-        
-        while (std::getline(patternStream, part, '/')) {
-            patternParts.push_back(part);
-        }
-        while (std::getline(topicStream, part, '/')) {
-            topicParts.push_back(part);
-        }
-        
-        if (patternParts.size() != topicParts.size()) {
-            return false;
+    stateCondition_.notify_all();
+
+    if (reconnected) {
+        reconnects_.fetch_add(1, std::memory_order_relaxed);
+        std::cout << "MQTTClient: Reconnected to MQTT broker at "
+                  << brokerAddress_ << ":" << port_ << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(connectionCallbacksMutex_);
+    for (auto& entry : connectionCallbacks_) {
+        entry.second(reconnected);
+    }
+}
+
+void MQTTClient::handleReadable() {
+    char buffer[16384];
+    for (;;) {
+        ssize_t received = ::recv(socketFd_, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            readBuffer_.append(buffer, static_cast<size_t>(received));
+            bytesReceived_.fetch_add(static_cast<uint64_t>(received), std::memory_order_relaxed);
+            continue;
+        }
+        if (received == 0) {
+            closeSocket("Connection closed by broker");
+            return;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        closeSocket("Read failed");
+        return;
+    }
+
+    size_t pos = 0;
+    MQTTPacket packet;
+    while (pos < readBuffer_.size()) {
+        size_t consumed = 0;
+        auto result = MQTTCodec::parse(readBuffer_.data() + pos, readBuffer_.size() - pos, consumed, packet);
+        if (result == MQTTCodec::ParseResult::INCOMPLETE) {
+            break;
+        }
+        if (result == MQTTCodec::ParseResult::MALFORMED) {
+            closeSocket("Malformed packet from broker");
+            return;
         }
-        
-        for (size_t i = 0; i < patternParts.size(); ++i) {
-            if (patternParts[i] != "+" && patternParts[i] != topicParts[i]) {
-                return false;
+        pos += consumed;
+        handlePacket(packet);
+        if (socketFd_ < 0) {
+            return;
+        }
+    }
+    readBuffer_.erase(0, pos);
+}
+
+void MQTTClient::handlePacket(const MQTTPacket& packet) {
+    switch (packet.type) {
+        case MQTTPacketType::CONNACK:
+            if (state_ == ConnectionState::AWAITING_CONNACK) {
+                onConnack(packet);
+            }
+            break;
+
+        case MQTTPacketType::PUBLISH: {
+            MQTTPublishMessage message;
+            if (!MQTTCodec::decodePublish(packet, message)) {
+                closeSocket("Malformed PUBLISH from broker");
+                return;
+            }
+            if (message.qos == 1) {
+                MQTTCodec::appendAck(writeBuffer_, MQTTPacketType::PUBACK, message.packetId);
+            } else if (message.qos == 2) {
+                MQTTCodec::appendAck(writeBuffer_, MQTTPacketType::PUBREC, message.packetId);
+            }
+            messagesReceived_.fetch_add(1, std::memory_order_relaxed);
+            if (config_.verboseLogging) {
+                std::cout << "MQTTClient: Received message on topic '" << message.topic << "'" << std::endl;
+            }
+
+            if (config_.deliverInProcessMessages) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                inbound_.emplace_back(std::move(message.topic), std::move(message.payload));
+            } else {
+                deliver(message.topic, message.payload);
+            }
+            break;
+        }
+
+        case MQTTPacketType::PUBACK: {
+            uint16_t packetId;
+            if (MQTTCodec::decodePacketId(packet, packetId)) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                inflight_.erase(packetId);
+                releaseBacklog();
+                if (inflight_.empty()) {
+                    stateCondition_.notify_all();
+                }
+            }
+            break;
+        }
+
+        case MQTTPacketType::PUBREL: {
+            uint16_t packetId;
+            if (MQTTCodec::decodePacketId(packet, packetId)) {
+                MQTTCodec::appendAck(writeBuffer_, MQTTPacketType::PUBCOMP, packetId);
             }
+            break;
+        }
+
+        case MQTTPacketType::SUBACK:
+            for (size_t i = 2; i < packet.body.size(); ++i) {
+                if (static_cast<uint8_t>(packet.body[i]) == 0x80) {
+                    std::cerr << "MQTTClient: Broker rejected a subscription" << std::endl;
+                }
+            }
+            break;
+
+        case MQTTPacketType::PINGRESP:
+            pingOutstanding_ = false;
+            break;
+
+        default:
+            break;
+    }
+}
+
+void MQTTClient::takeOutbound() {
+    // Leave data in outbound_ while the socket is backed up so
+    // maxQueuedBytes keeps applying
+    if (writeBuffer_.size() - writeOffset_ >= MAX_WRITE_BACKLOG) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (outbound_.empty()) {
+        return;
+    }
+
+    if (writeOffset_ == writeBuffer_.size()) {
+        writeBuffer_.swap(outbound_);   // Keeps both buffers' capacity around
+        writeOffset_ = 0;
+    } else {
+        writeBuffer_.append(outbound_);
+    }
+    outbound_.clear();
+
+    for (uint16_t packetId : queuedPublishIds_) {
+        auto it = inflight_.find(packetId);
+        if (it != inflight_.end()) {
+            it->second.transmitted = true;
         }
-        
-        return true;
     }
-    
-    return false;
+    queuedPublishIds_.clear();
+}
+
+void MQTTClient::flushWrites() {
+    if (socketFd_ < 0 || state_ == ConnectionState::CONNECTING) {
+        return;
+    }
+
+    while (writeOffset_ < writeBuffer_.size()) {
+        ssize_t sent = ::send(socketFd_, writeBuffer_.data() + writeOffset_,
+                              writeBuffer_.size() - writeOffset_, MSG_NOSIGNAL);
+        writeCalls_.fetch_add(1, std::memory_order_relaxed);
+        if (sent > 0) {
+            writeOffset_ += static_cast<size_t>(sent);
+            bytesSent_.fetch_add(static_cast<uint64_t>(sent), std::memory_order_relaxed);
+            lastSend_ = std::chrono::steady_clock::now();
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        closeSocket("Write failed");
+        return;
+    }
+
+    bool drained = writeOffset_ == writeBuffer_.size();
+    if (drained) {
+        writeBuffer_.clear();
+        writeOffset_ = 0;
+    }
+    updateWriteInterest();
+
+    bool idle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        writeIdle_ = drained;
+        idle = drained && outbound_.empty();
+    }
+    if (idle) {
+        stateCondition_.notify_all();
+    }
+}
+
+void MQTTClient::updateWriteInterest() {
+    bool want = writeOffset_ < writeBuffer_.size();
+    if (socketFd_ < 0 || want == wantWrite_) {
+        return;
+    }
+
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = want ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.u64 = SOCKET_TOKEN;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, socketFd_, &event);
+    wantWrite_ = want;
+}
+
+void MQTTClient::closeSocket(const char* reason) {
+    if (socketFd_ >= 0) {
+        ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, socketFd_, nullptr);
+        ::close(socketFd_);
+        socketFd_ = -1;
+    } else if (state_ == ConnectionState::DISCONNECTED) {
+        return;
+    }
+
+    state_ = ConnectionState::DISCONNECTED;
+    wantWrite_ = false;
+    writeBuffer_.clear();
+    writeOffset_ = 0;
+    readBuffer_.clear();
+    pingOutstanding_ = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connected_ = false;
+    }
+
+    if (!running_) {
+        return;
+    }
+
+    // Exponential backoff with +/-20% jitter so a fleet doesn't reconnect in lockstep
+    static thread_local std::mt19937 rng(std::random_device{}());
+    std::uniform_real_distribution<double> jitter(0.8, 1.2);
+    int delayMs = static_cast<int>(reconnectDelayMs_ * jitter(rng));
+    nextReconnect_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs);
+    reconnectDelayMs_ = std::min(reconnectDelayMs_ * 2, config_.reconnectMaxDelayMs);
+
+    if (reason) {
+        std::cerr << "MQTTClient: " << reason << " (" << brokerAddress_ << ":" << port_
+                  << "), reconnecting in " << delayMs << " ms" << std::endl;
+    }
+}
+
+void MQTTClient::checkTimers(std::chrono::steady_clock::time_point now) {
+    switch (state_) {
+        case ConnectionState::DISCONNECTED:
+            if (now >= nextReconnect_) {
+                startConnect();
+            }
+            break;
+
+        case ConnectionState::CONNECTING:
+        case ConnectionState::AWAITING_CONNACK:
+            if (now - connectStarted_ > std::chrono::milliseconds(config_.connectTimeoutMs)) {
+                closeSocket("Connect timed out");
+            }
+            break;
+
+        case ConnectionState::CONNECTED: {
+            if (config_.keepAliveSeconds <= 0) {
+                break;
+            }
+            auto keepAlive = std::chrono::seconds(config_.keepAliveSeconds);
+            if (pingOutstanding_ && now - pingSent_ > keepAlive) {
+                closeSocket("Keep-alive timed out");
+            } else if (!pingOutstanding_ && now - lastSend_ >= keepAlive) {
+                MQTTCodec::appendEmpty(writeBuffer_, MQTTPacketType::PINGREQ);
+                pingOutstanding_ = true;
+                pingSent_ = now;
+                flushWrites();
+            }
+            break;
+        }
+    }
+}
+
+int MQTTClient::computeTimeout(std::chrono::steady_clock::time_point now) const {
+    std::chrono::steady_clock::time_point deadline;
+    switch (state_) {
+        case ConnectionState::DISCONNECTED:
+            deadline = nextReconnect_;
+            break;
+        case ConnectionState::CONNECTING:
+        case ConnectionState::AWAITING_CONNACK:
+            deadline = connectStarted_ + std::chrono::milliseconds(config_.connectTimeoutMs);
+            break;
+        case ConnectionState::CONNECTED:
+            if (config_.keepAliveSeconds <= 0) {
+                return MAX_POLL_MS;
+            }
+            deadline = (pingOutstanding_ ? pingSent_ : lastSend_) + std::chrono::seconds(config_.keepAliveSeconds);
+            break;
+    }
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+    return static_cast<int>(std::max<long long>(0, std::min<long long>(remaining + 1, MAX_POLL_MS)));
+}
+
+void MQTTClient::wakeLoop() {
+    if (wakeFd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wakeFd_, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void MQTTClient::deliver(const std::string& topic, const std::string& payload) {
+    // Collect matches under the lock, run them without it. The scratch
+    // vector is reused across messages; a callback that delivers again
+    // appends past our range and trims back to it.
+    static thread_local std::vector<CallbackPtr> matched;
+    size_t first = matched.size();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscriptionTrie_.match(topic, [](const CallbackPtr& callback) {
+            matched.push_back(callback);
+        });
+    }
+    size_t last = matched.size();
+    for (size_t i = first; i < last; ++i) {
+        CallbackPtr callback = matched[i];
+        (*callback)(topic, payload);
+    }
+    matched.resize(first);
+}
+
+void MQTTClient::releaseBacklog() {
+    // Runs on the network thread while connected, so the packets can go
+    // straight into the write buffer
+    while (!inflightBacklog_.empty() && inflight_.size() < config_.maxInflight) {
+        PendingPublish& pending = inflightBacklog_.front();
+        uint16_t packetId = allocatePacketId();
+        InflightPublish entry;
+        MQTTCodec::appendPublish(entry.packet, pending.topic, pending.payload, 1, pending.retain, packetId);
+        entry.transmitted = true;
+        writeBuffer_.append(entry.packet);
+        inflight_.emplace(packetId, std::move(entry));
+        backlogBytes_ -= pending.topic.size() + pending.payload.size();
+        inflightBacklog_.pop_front();
+    }
+}
+
+uint16_t MQTTClient::allocatePacketId() {
+    uint16_t packetId;
+    do {
+        packetId = nextPacketId_++;
+        if (nextPacketId_ == 0) {
+            nextPacketId_ = 1;
+        }
+    } while (inflight_.count(packetId) > 0);
+    return packetId;
 }
@@ -0,0 +1,412 @@
+#include "MQTTLoopbackBroker.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+namespace {
+
+constexpr int LISTEN_TOKEN = -1;
+constexpr int WAKE_TOKEN = -2;
+
+} // namespace
+
+MQTTLoopbackBroker::MQTTLoopbackBroker(int port)
+    : requestedPort_(port), port_(0), listenFd_(-1), epollFd_(-1), wakeFd_(-1),
+      running_(false), dropRequested_(false), forgetRetained_(false), connectionCount_(0), publishCount_(0) {}
+
+MQTTLoopbackBroker::~MQTTLoopbackBroker() {
+    stop();
+}
+
+bool MQTTLoopbackBroker::start() {
+    if (running_) {
+        return true;
+    }
+
+    listenFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        std::cerr << "MQTTLoopbackBroker: socket() failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    int one = 1;
+    ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(requestedPort_));
+    socklen_t length = sizeof(address);
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listenFd_, 64) != 0 ||
+        ::getsockname(listenFd_, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        std::cerr << "MQTTLoopbackBroker: Failed to listen on port " << requestedPort_
+                  << ": " << std::strerror(errno) << std::endl;
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    port_ = ntohs(address.sin_port);
+
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = LISTEN_TOKEN;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event);
+    event.data.fd = WAKE_TOKEN;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+
+    running_ = true;
+    thread_ = std::thread(&MQTTLoopbackBroker::run, this);
+
+    std::cout << "MQTTLoopbackBroker: Listening on 127.0.0.1:" << port_ << std::endl;
+    return true;
+}
+
+void MQTTLoopbackBroker::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    uint64_t one = 1;
+    ssize_t ignored = ::write(wakeFd_, &one, sizeof(one));
+    (void)ignored;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    ::close(listenFd_);
+    ::close(epollFd_);
+    ::close(wakeFd_);
+    listenFd_ = epollFd_ = wakeFd_ = -1;
+    std::cout << "MQTTLoopbackBroker: Stopped" << std::endl;
+}
+
+int MQTTLoopbackBroker::getPort() const {
+    return port_;
+}
+
+size_t MQTTLoopbackBroker::getConnectionCount() const {
+    return connectionCount_;
+}
+
+uint64_t MQTTLoopbackBroker::getPublishCount() const {
+    return publishCount_;
+}
+
+void MQTTLoopbackBroker::dropConnections(bool forgetRetained) {
+    if (forgetRetained) {
+        forgetRetained_ = true;
+    }
+    dropRequested_ = true;
+    uint64_t one = 1;
+    ssize_t ignored = ::write(wakeFd_, &one, sizeof(one));
+    (void)ignored;
+}
+
+void MQTTLoopbackBroker::run() {
+    epoll_event events[64];
+    while (running_) {
+        int count = ::epoll_wait(epollFd_, events, 64, 100);
+        for (int i = 0; i < count; ++i) {
+            int token = events[i].data.fd;
+            if (token == LISTEN_TOKEN) {
+                acceptClients();
+            } else if (token == WAKE_TOKEN) {
+                uint64_t value;
+                ssize_t ignored = ::read(wakeFd_, &value, sizeof(value));
+                (void)ignored;
+            } else {
+                auto it = sessions_.find(token);
+                if (it == sessions_.end()) {
+                    continue;
+                }
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    handleReadable(it->second);
+                }
+            }
+        }
+
+        if (dropRequested_.exchange(false)) {
+            closeAllSessions();
+            if (forgetRetained_.exchange(false)) {
+                retained_.clear();
+            }
+        }
+
+        // Routing only appends to write buffers; write them out once per pass
+        std::vector<int> closed;
+        for (auto& entry : sessions_) {
+            flush(entry.second);
+            if (entry.second.fd < 0) {
+                closed.push_back(entry.first);
+            }
+        }
+        for (int fd : closed) {
+            closeSession(fd);
+        }
+    }
+    closeAllSessions();
+}
+
+void MQTTLoopbackBroker::acceptClients() {
+    for (;;) {
+        int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event);
+
+        Session& session = sessions_[fd];
+        session.fd = fd;
+        connectionCount_ = sessions_.size();
+    }
+}
+
+void MQTTLoopbackBroker::handleReadable(Session& session) {
+    char buffer[16384];
+    for (;;) {
+        ssize_t received = ::recv(session.fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            session.readBuffer.append(buffer, static_cast<size_t>(received));
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        closeSession(session.fd);
+        return;
+    }
+
+    size_t pos = 0;
+    MQTTPacket packet;
+    while (pos < session.readBuffer.size()) {
+        size_t consumed = 0;
+        auto result = MQTTCodec::parse(session.readBuffer.data() + pos, session.readBuffer.size() - pos,
+                                       consumed, packet);
+        if (result == MQTTCodec::ParseResult::INCOMPLETE) {
+            break;
+        }
+        pos += consumed;
+        if (result == MQTTCodec::ParseResult::MALFORMED || !handlePacket(session, packet)) {
+            closeSession(session.fd);
+            return;
+        }
+    }
+    session.readBuffer.erase(0, pos);
+}
+
+bool MQTTLoopbackBroker::handlePacket(Session& session, const MQTTPacket& packet) {
+    if (!session.connected && packet.type != MQTTPacketType::CONNECT) {
+        return false;
+    }
+
+    switch (packet.type) {
+        case MQTTPacketType::CONNECT: {
+            uint16_t keepAlive;
+            if (session.connected || !MQTTCodec::decodeConnect(packet, session.clientId, keepAlive)) {
+                return false;
+            }
+            session.connected = true;
+            MQTTCodec::appendConnack(session.writeBuffer, false, 0);
+            return true;
+        }
+
+        case MQTTPacketType::PUBLISH: {
+            MQTTPublishMessage message;
+            if (!MQTTCodec::decodePublish(packet, message)) {
+                return false;
+            }
+            publishCount_.fetch_add(1, std::memory_order_relaxed);
+            if (message.qos == 1) {
+                MQTTCodec::appendAck(session.writeBuffer, MQTTPacketType::PUBACK, message.packetId);
+            } else if (message.qos == 2) {
+                MQTTCodec::appendAck(session.writeBuffer, MQTTPacketType::PUBREC, message.packetId);
+            }
+
+            if (message.retain) {
+                if (message.payload.empty()) {
+                    retained_.erase(message.topic);
+                } else {
+                    retained_[message.topic] = message.payload;
+                }
+            }
+            route(message);
+            return true;
+        }
+
+        case MQTTPacketType::PUBREL: {
+            uint16_t packetId;
+            if (MQTTCodec::decodePacketId(packet, packetId)) {
+                MQTTCodec::appendAck(session.writeBuffer, MQTTPacketType::PUBCOMP, packetId);
+            }
+            return true;
+        }
+
+        case MQTTPacketType::SUBSCRIBE: {
+            uint16_t packetId;
+            std::vector<std::pair<std::string, int>> filters;
+            if (!MQTTCodec::decodeSubscribe(packet, packetId, filters)) {
+                return false;
+            }
+
+            std::vector<uint8_t> granted;
+            for (auto& filter : filters) {
+                filter.second = std::min(filter.second, 1);
+                granted.push_back(static_cast<uint8_t>(filter.second));
+
+                auto existing = std::find_if(session.subscriptions.begin(), session.subscriptions.end(),
+                    [&filter](const std::pair<std::string, int>& s) { return s.first == filter.first; });
+                if (existing != session.subscriptions.end()) {
+                    existing->second = filter.second;
+                } else {
+                    session.subscriptions.push_back(filter);
+                }
+            }
+            MQTTCodec::appendSuback(session.writeBuffer, packetId, granted);
+
+            // New subscriptions receive matching retained messages
+            for (const auto& filter : filters) {
+                for (const auto& retained : retained_) {
+                    if (MQTTCodec::topicMatches(filter.first, retained.first)) {
+                        uint16_t id = filter.second > 0 ? session.nextPacketId++ : 0;
+                        if (session.nextPacketId == 0) {
+                            session.nextPacketId = 1;
+                        }
+                        MQTTCodec::appendPublish(session.writeBuffer, retained.first, retained.second,
+                                                 filter.second, true, id);
+                    }
+                }
+            }
+            return true;
+        }
+
+        case MQTTPacketType::UNSUBSCRIBE: {
+            uint16_t packetId;
+            if (MQTTCodec::decodePacketId(packet, packetId)) {
+                MQTTCodec::appendAck(session.writeBuffer, MQTTPacketType::UNSUBACK, packetId);
+            }
+            return true;
+        }
+
+        case MQTTPacketType::PINGREQ:
+            MQTTCodec::appendEmpty(session.writeBuffer, MQTTPacketType::PINGRESP);
+            return true;
+
+        case MQTTPacketType::DISCONNECT:
+            return false;
+
+        default:
+            // PUBACK/PUBCOMP from clients: nothing is retransmitted, so nothing to track
+            return true;
+    }
+}
+
+void MQTTLoopbackBroker::route(const MQTTPublishMessage& message) {
+    for (auto& entry : sessions_) {
+        Session& session = entry.second;
+        if (!session.connected) {
+            continue;
+        }
+
+        // Deliver once per session at the highest matching QoS
+        int qos = -1;
+        for (const auto& filter : session.subscriptions) {
+            if (MQTTCodec::topicMatches(filter.first, message.topic)) {
+                qos = std::max(qos, filter.second);
+            }
+        }
+        if (qos < 0) {
+            continue;
+        }
+
+        qos = std::min(qos, std::min(message.qos, 1));
+        uint16_t packetId = 0;
+        if (qos > 0) {
+            packetId = session.nextPacketId++;
+            if (session.nextPacketId == 0) {
+                session.nextPacketId = 1;
+            }
+        }
+        MQTTCodec::appendPublish(session.writeBuffer, message.topic, message.payload, qos, false, packetId);
+    }
+}
+
+void MQTTLoopbackBroker::flush(Session& session) {
+    while (session.fd >= 0 && session.writeOffset < session.writeBuffer.size()) {
+        ssize_t sent = ::send(session.fd, session.writeBuffer.data() + session.writeOffset,
+                              session.writeBuffer.size() - session.writeOffset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            session.writeOffset += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, session.fd, nullptr);
+        ::close(session.fd);
+        session.fd = -1;   // Removed from sessions_ by the caller
+        return;
+    }
+
+    if (session.fd < 0) {
+        return;
+    }
+    if (session.writeOffset == session.writeBuffer.size()) {
+        session.writeBuffer.clear();
+        session.writeOffset = 0;
+    }
+
+    bool want = session.writeOffset < session.writeBuffer.size();
+    if (want != session.wantWrite) {
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = want ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        event.data.fd = session.fd;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, session.fd, &event);
+        session.wantWrite = want;
+    }
+}
+
+void MQTTLoopbackBroker::closeSession(int fd) {
+    auto it = sessions_.find(fd);
+    if (it == sessions_.end()) {
+        return;
+    }
+    if (it->second.fd >= 0) {
+        ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+    }
+    sessions_.erase(it);
+    connectionCount_ = sessions_.size();
+}
+
+void MQTTLoopbackBroker::closeAllSessions() {
+    while (!sessions_.empty()) {
+        closeSession(sessions_.begin()->first);
+    }
+}
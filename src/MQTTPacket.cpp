@@ -0,0 +1,270 @@
+#include "MQTTPacket.h"
+
+MQTTCodec::ParseResult MQTTCodec::parse(const char* data, size_t length, size_t& consumed, MQTTPacket& packet) {
+    if (length < 2) {
+        return ParseResult::INCOMPLETE;
+    }
+
+    // Remaining length: up to four 7-bit groups, least significant first
+    size_t remaining = 0;
+    size_t multiplier = 1;
+    size_t pos = 1;
+    for (;;) {
+        if (pos >= length) {
+            return ParseResult::INCOMPLETE;
+        }
+        uint8_t byte = static_cast<uint8_t>(data[pos++]);
+        remaining += (byte & 0x7F) * multiplier;
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+        multiplier *= 128;
+        if (pos > 4) {
+            return ParseResult::MALFORMED;
+        }
+    }
+
+    if (length - pos < remaining) {
+        return ParseResult::INCOMPLETE;
+    }
+
+    uint8_t header = static_cast<uint8_t>(data[0]);
+    uint8_t type = header >> 4;
+    if (type < static_cast<uint8_t>(MQTTPacketType::CONNECT) ||
+        type > static_cast<uint8_t>(MQTTPacketType::DISCONNECT)) {
+        return ParseResult::MALFORMED;
+    }
+
+    packet.type = static_cast<MQTTPacketType>(type);
+    packet.flags = header & 0x0F;
+    packet.body.assign(data + pos, remaining);
+    consumed = pos + remaining;
+    return ParseResult::COMPLETE;
+}
+
+void MQTTCodec::appendConnect(std::string& out, const std::string& clientId, uint16_t keepAliveSeconds,
+                              bool cleanSession, const std::string& username, const std::string& password) {
+    uint8_t connectFlags = cleanSession ? 0x02 : 0x00;
+    size_t length = 10 + 2 + clientId.size();
+    if (!username.empty()) {
+        connectFlags |= 0x80;
+        length += 2 + username.size();
+        if (!password.empty()) {
+            connectFlags |= 0x40;
+            length += 2 + password.size();
+        }
+    }
+
+    appendFixedHeader(out, MQTTPacketType::CONNECT, 0, length);
+    appendString(out, "MQTT");
+    out.push_back(4);   // Protocol level 3.1.1
+    out.push_back(static_cast<char>(connectFlags));
+    appendUint16(out, keepAliveSeconds);
+    appendString(out, clientId);
+    if (!username.empty()) {
+        appendString(out, username);
+        if (!password.empty()) {
+            appendString(out, password);
+        }
+    }
+}
+
+void MQTTCodec::appendConnack(std::string& out, bool sessionPresent, uint8_t returnCode) {
+    appendFixedHeader(out, MQTTPacketType::CONNACK, 0, 2);
+    out.push_back(sessionPresent ? 1 : 0);
+    out.push_back(static_cast<char>(returnCode));
+}
+
+void MQTTCodec::appendPublish(std::string& out, const std::string& topic, const std::string& payload,
+                              int qos, bool retain, uint16_t packetId, bool dup) {
+    uint8_t flags = static_cast<uint8_t>((qos & 0x03) << 1);
+    if (retain) {
+        flags |= 0x01;
+    }
+    if (dup) {
+        flags |= 0x08;
+    }
+
+    size_t length = 2 + topic.size() + (qos > 0 ? 2 : 0) + payload.size();
+    out.reserve(out.size() + length + 5);
+    appendFixedHeader(out, MQTTPacketType::PUBLISH, flags, length);
+    appendString(out, topic);
+    if (qos > 0) {
+        appendUint16(out, packetId);
+    }
+    out.append(payload);
+}
+
+void MQTTCodec::appendSubscribe(std::string& out, uint16_t packetId,
+                                const std::vector<std::pair<std::string, int>>& filters) {
+    size_t length = 2;
+    for (const auto& filter : filters) {
+        length += 2 + filter.first.size() + 1;
+    }
+
+    // SUBSCRIBE requires flags 0010
+    appendFixedHeader(out, MQTTPacketType::SUBSCRIBE, 0x02, length);
+    appendUint16(out, packetId);
+    for (const auto& filter : filters) {
+        appendString(out, filter.first);
+        out.push_back(static_cast<char>(filter.second & 0x03));
+    }
+}
+
+void MQTTCodec::appendSuback(std::string& out, uint16_t packetId, const std::vector<uint8_t>& grantedQos) {
+    appendFixedHeader(out, MQTTPacketType::SUBACK, 0, 2 + grantedQos.size());
+    appendUint16(out, packetId);
+    for (uint8_t qos : grantedQos) {
+        out.push_back(static_cast<char>(qos));
+    }
+}
+
+void MQTTCodec::appendAck(std::string& out, MQTTPacketType type, uint16_t packetId) {
+    appendFixedHeader(out, type, type == MQTTPacketType::PUBREL ? 0x02 : 0, 2);
+    appendUint16(out, packetId);
+}
+
+void MQTTCodec::appendEmpty(std::string& out, MQTTPacketType type) {
+    appendFixedHeader(out, type, 0, 0);
+}
+
+bool MQTTCodec::decodePublish(const MQTTPacket& packet, MQTTPublishMessage& message) {
+    size_t pos = 0;
+    message.qos = (packet.flags >> 1) & 0x03;
+    message.retain = (packet.flags & 0x01) != 0;
+    message.dup = (packet.flags & 0x08) != 0;
+    if (message.qos > 2 || !readString(packet.body, pos, message.topic)) {
+        return false;
+    }
+
+    message.packetId = 0;
+    if (message.qos > 0 && !readUint16(packet.body, pos, message.packetId)) {
+        return false;
+    }
+
+    message.payload.assign(packet.body, pos, std::string::npos);
+    return true;
+}
+
+bool MQTTCodec::decodeConnect(const MQTTPacket& packet, std::string& clientId, uint16_t& keepAliveSeconds) {
+    size_t pos = 0;
+    std::string protocol;
+    if (!readString(packet.body, pos, protocol) || protocol != "MQTT" || pos + 2 > packet.body.size()) {
+        return false;
+    }
+    pos += 2;   // Protocol level and connect flags
+    return readUint16(packet.body, pos, keepAliveSeconds) && readString(packet.body, pos, clientId);
+}
+
+bool MQTTCodec::decodeSubscribe(const MQTTPacket& packet, uint16_t& packetId,
+                                std::vector<std::pair<std::string, int>>& filters) {
+    size_t pos = 0;
+    if (!readUint16(packet.body, pos, packetId)) {
+        return false;
+    }
+
+    filters.clear();
+    while (pos < packet.body.size()) {
+        std::string filter;
+        if (!readString(packet.body, pos, filter) || pos >= packet.body.size()) {
+            return false;
+        }
+        int qos = static_cast<uint8_t>(packet.body[pos++]) & 0x03;
+        filters.emplace_back(std::move(filter), qos);
+    }
+    return !filters.empty();
+}
+
+bool MQTTCodec::decodePacketId(const MQTTPacket& packet, uint16_t& packetId) {
+    size_t pos = 0;
+    return readUint16(packet.body, pos, packetId);
+}
+
+void MQTTCodec::markDuplicate(std::string& encodedPublish) {
+    if (!encodedPublish.empty()) {
+        encodedPublish[0] = static_cast<char>(static_cast<uint8_t>(encodedPublish[0]) | 0x08);
+    }
+}
+
+bool MQTTCodec::topicMatches(const std::string& filter, const std::string& topic) {
+    size_t f = 0;
+    size_t t = 0;
+
+    // Walk both strings one level at a time
+    for (;;) {
+        size_t filterEnd = filter.find('/', f);
+        if (filterEnd == std::string::npos) {
+            filterEnd = filter.size();
+        }
+
+        if (filter.compare(f, filterEnd - f, "#") == 0) {
+            return true;   // Matches this level and everything below (including the parent)
+        }
+
+        size_t topicEnd = topic.find('/', t);
+        if (topicEnd == std::string::npos) {
+            topicEnd = topic.size();
+        }
+
+        bool levelMatches = filter.compare(f, filterEnd - f, "+") == 0 ||
+                            (filterEnd - f == topicEnd - t &&
+                             filter.compare(f, filterEnd - f, topic, t, topicEnd - t) == 0);
+        if (!levelMatches) {
+            return false;
+        }
+
+        bool filterDone = filterEnd == filter.size();
+        bool topicDone = topicEnd == topic.size();
+        if (filterDone || topicDone) {
+            if (filterDone && topicDone) {
+                return true;
+            }
+            // "a/#" also matches "a"
+            return topicDone && filter.compare(filterEnd, std::string::npos, "/#") == 0;
+        }
+
+        f = filterEnd + 1;
+        t = topicEnd + 1;
+    }
+}
+
+void MQTTCodec::appendFixedHeader(std::string& out, MQTTPacketType type, uint8_t flags, size_t remainingLength) {
+    out.push_back(static_cast<char>((static_cast<uint8_t>(type) << 4) | (flags & 0x0F)));
+    do {
+        uint8_t byte = remainingLength % 128;
+        remainingLength /= 128;
+        if (remainingLength > 0) {
+            byte |= 0x80;
+        }
+        out.push_back(static_cast<char>(byte));
+    } while (remainingLength > 0);
+}
+
+void MQTTCodec::appendUint16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value >> 8));
+    out.push_back(static_cast<char>(value & 0xFF));
+}
+
+void MQTTCodec::appendString(std::string& out, const std::string& value) {
+    appendUint16(out, static_cast<uint16_t>(value.size()));
+    out.append(value);
+}
+
+bool MQTTCodec::readUint16(const std::string& data, size_t& pos, uint16_t& value) {
+    if (pos + 2 > data.size()) {
+        return false;
+    }
+    value = static_cast<uint16_t>((static_cast<uint8_t>(data[pos]) << 8) | static_cast<uint8_t>(data[pos + 1]));
+    pos += 2;
+    return true;
+}
+
+bool MQTTCodec::readString(const std::string& data, size_t& pos, std::string& value) {
+    uint16_t length;
+    if (!readUint16(data, pos, length) || pos + length > data.size()) {
+        return false;
+    }
+    value.assign(data, pos, length);
+    pos += length;
+    return true;
+}
@@ -0,0 +1,245 @@
+#include "RecedingHorizonPlanner.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+std::vector<double> tail(const std::vector<double>& series, size_t from) {
+    if (from >= series.size()) {
+        return {};
+    }
+    return std::vector<double>(series.begin() + from, series.end());
+}
+
+// The plan from slot `from` on
+ScheduleSolution suffixPlan(const ScheduleSolution& plan, size_t from) {
+    ScheduleSolution suffix;
+    for (const auto& power : plan.powerKw) {
+        suffix.powerKw.push_back(tail(power, from));
+    }
+    suffix.batteryKw = tail(plan.batteryKw, from);
+    return suffix;
+}
+
+// Stored energy may have fallen below what the battery can still make up
+void capBatteryTarget(ScheduleProblem& problem) {
+    ScheduleBattery& battery = problem.battery;
+    if (battery.capacityKwh <= 0.0) {
+        return;
+    }
+    double reachable = battery.initialKwh +
+                       battery.efficiency * battery.maxChargeKw * problem.slotHours * problem.getSlotCount();
+    battery.finalKwh = std::min(battery.getTargetKwh(), std::min(reachable, battery.capacityKwh));
+}
+
+// The problem from slot `from` on, starting in the state the plan leaves
+// behind: indoor temperatures, energy still to deliver, battery charge
+ScheduleProblem suffixProblem(const ScheduleProblem& problem, const ScheduleSolution& plan, size_t from) {
+    if (from == 0) {
+        return problem;
+    }
+
+    ScheduleProblem suffix = problem;
+    suffix.prices = tail(problem.prices, from);
+    suffix.solarKw = tail(problem.solarKw, from);
+    suffix.baseLoadKw = tail(problem.baseLoadKw, from);
+    suffix.outdoorTemp = tail(problem.outdoorTemp, from);
+
+    int shift = static_cast<int>(from);
+    for (size_t d = 0; d < problem.devices.size(); ++d) {
+        const ScheduleDevice& device = problem.devices[d];
+        ScheduleDevice& moved = suffix.devices[d];
+        if (device.thermal) {
+            moved.initialTemp = ScheduleSolver::simulateTemperature(problem, device, plan.powerKw[d])[from - 1];
+            continue;
+        }
+
+        double delivered = 0.0;
+        for (size_t t = 0; t < from; ++t) {
+            delivered += plan.powerKw[d][t] * problem.slotHours;
+        }
+        moved.energyKwh = std::max(0.0, device.energyKwh - delivered);
+        moved.earliestSlot = std::max(0, device.earliestSlot - shift);
+        int deadline = problem.getDeadline(device) - shift;
+        if (deadline <= 0) {
+            moved.energyKwh = 0.0;   // Too late to make up for
+            moved.deadlineSlot = 0;
+        } else if (device.deadlineSlot >= 0) {
+            moved.deadlineSlot = deadline;
+        }
+    }
+
+    if (problem.battery.capacityKwh > 0.0) {
+        suffix.battery.finalKwh = problem.battery.getTargetKwh();
+        suffix.battery.initialKwh = ScheduleSolver::simulateBattery(problem, plan.batteryKw)[from - 1];
+        capBatteryTarget(suffix);
+    }
+    return suffix;
+}
+
+} // namespace
+
+RecedingHorizonPlanner::RecedingHorizonPlanner(std::shared_ptr<ScheduleSolver> solver,
+                                               const RecedingHorizonConfig& config)
+    : solver_(solver), config_(config), startSlot_(0) {}
+
+void RecedingHorizonPlanner::setSolver(std::shared_ptr<ScheduleSolver> solver) {
+    solver_ = solver;
+}
+
+const ScheduleSolution& RecedingHorizonPlanner::start(const ScheduleProblem& problem) {
+    problem_ = problem;
+    startSlot_ = 0;
+    deliveredKwh_.assign(problem.devices.size(), 0.0);
+    plan_ = solver_->solve(problem_);
+
+    lastStats_ = ReplanStats();
+    lastStats_.resolvedSlots = problem_.getSlotCount();
+    lastStats_.feasible = plan_.feasible;
+    lastStats_.solveMs = plan_.solveMs;
+    return plan_;
+}
+
+const ScheduleSolution& RecedingHorizonPlanner::update(size_t slot, const ScheduleProblem& latest,
+                                                       const ScheduleMeasurement& measured) {
+    size_t end = startSlot_ + problem_.getSlotCount();
+    slot = std::min(std::max(slot, startSlot_), end);
+    lastStats_ = ReplanStats();
+    lastStats_.slot = slot;
+    lastStats_.fromSlot = slot;
+    advance(slot - startSlot_);
+
+    lastStats_.stateDiverged = applyMeasurement(measured);
+    size_t slots = problem_.getSlotCount();
+    size_t from = lastStats_.stateDiverged ? 0 : firstChangedSlot(latest);
+
+    // Take over the latest forecasts; changes below the tolerances included
+    auto refresh = [&](std::vector<double>& series, const std::vector<double>& update) {
+        if (update.size() <= startSlot_) {
+            return;
+        }
+        series.resize(slots, 0.0);
+        for (size_t t = 0; t < slots && startSlot_ + t < update.size(); ++t) {
+            series[t] = update[startSlot_ + t];
+        }
+    };
+    refresh(problem_.prices, latest.prices);
+    refresh(problem_.solarKw, latest.solarKw);
+    refresh(problem_.baseLoadKw, latest.baseLoadKw);
+    refresh(problem_.outdoorTemp, latest.outdoorTemp);
+
+    if (from < slots) {
+        ScheduleSolution suffix =
+            solver_->solveWithWarmStart(suffixProblem(problem_, plan_, from), suffixPlan(plan_, from));
+        lastStats_.fromSlot = startSlot_ + from;
+        lastStats_.resolvedSlots = slots - from;
+        lastStats_.feasible = suffix.feasible;
+        lastStats_.solveMs = suffix.solveMs;
+
+        if (suffix.feasible) {
+            for (size_t d = 0; d < plan_.powerKw.size(); ++d) {
+                std::copy(suffix.powerKw[d].begin(), suffix.powerKw[d].end(), plan_.powerKw[d].begin() + from);
+            }
+            std::copy(suffix.batteryKw.begin(), suffix.batteryKw.end(), plan_.batteryKw.begin() + from);
+            ScheduleSolver::evaluate(problem_, plan_);
+
+            // The kept prefix is fixed, so the suffix's bound carries over
+            plan_.optimal = suffix.optimal;
+            plan_.lowerBound = plan_.cost - suffix.cost + suffix.lowerBound;
+            plan_.solveMs = suffix.solveMs;
+            plan_.iterations = suffix.iterations;
+            plan_.nodes = suffix.nodes;
+            plan_.columns = suffix.columns;
+            return plan_;
+        }
+    }
+
+    ScheduleSolver::evaluate(problem_, plan_);
+    return plan_;
+}
+
+const ScheduleProblem& RecedingHorizonPlanner::getProblem() const {
+    return problem_;
+}
+
+const ScheduleSolution& RecedingHorizonPlanner::getPlan() const {
+    return plan_;
+}
+
+size_t RecedingHorizonPlanner::getStartSlot() const {
+    return startSlot_;
+}
+
+const ReplanStats& RecedingHorizonPlanner::getLastStats() const {
+    return lastStats_;
+}
+
+void RecedingHorizonPlanner::advance(size_t slots) {
+    if (slots == 0) {
+        return;
+    }
+    for (size_t d = 0; d < problem_.devices.size(); ++d) {
+        for (size_t t = 0; t < slots; ++t) {
+            deliveredKwh_[d] += plan_.powerKw[d][t] * problem_.slotHours;
+        }
+    }
+    problem_ = suffixProblem(problem_, plan_, slots);
+    plan_ = suffixPlan(plan_, slots);
+    startSlot_ += slots;
+}
+
+bool RecedingHorizonPlanner::applyMeasurement(const ScheduleMeasurement& measured) {
+    bool diverged = false;
+    for (size_t d = 0; d < problem_.devices.size(); ++d) {
+        ScheduleDevice& device = problem_.devices[d];
+        if (device.thermal) {
+            auto temp = measured.indoorTemp.find(device.id);
+            if (temp != measured.indoorTemp.end() &&
+                std::fabs(temp->second - device.initialTemp) > config_.temperatureTolerance) {
+                device.initialTemp = temp->second;
+                diverged = true;
+            }
+            continue;
+        }
+
+        auto delivered = measured.deliveredKwh.find(device.id);
+        if (delivered != measured.deliveredKwh.end() &&
+            std::fabs(delivered->second - deliveredKwh_[d]) > config_.energyToleranceKwh) {
+            device.energyKwh = std::max(0.0, device.energyKwh - (delivered->second - deliveredKwh_[d]));
+            deliveredKwh_[d] = delivered->second;
+            diverged = true;
+        }
+    }
+
+    ScheduleBattery& battery = problem_.battery;
+    if (battery.capacityKwh > 0.0 && measured.batteryKwh >= 0.0 &&
+        std::fabs(measured.batteryKwh - battery.initialKwh) > config_.batteryToleranceKwh) {
+        battery.finalKwh = battery.getTargetKwh();
+        battery.initialKwh = measured.batteryKwh;
+        capBatteryTarget(problem_);
+        diverged = true;
+    }
+    return diverged;
+}
+
+size_t RecedingHorizonPlanner::firstChangedSlot(const ScheduleProblem& latest) const {
+    auto differs = [&](const std::vector<double>& planned, const std::vector<double>& update, size_t t,
+                       double tolerance) {
+        size_t slot = startSlot_ + t;
+        if (slot >= update.size()) {
+            return false;
+        }
+        double before = t < planned.size() ? planned[t] : 0.0;
+        return std::fabs(update[slot] - before) > tolerance;
+    };
+
+    for (size_t t = 0; t < problem_.getSlotCount(); ++t) {
+        if (differs(problem_.prices, latest.prices, t, config_.priceTolerance) ||
+            differs(problem_.solarKw, latest.solarKw, t, config_.solarToleranceKw) ||
+            differs(problem_.baseLoadKw, latest.baseLoadKw, t, config_.loadToleranceKw) ||
+            differs(problem_.outdoorTemp, latest.outdoorTemp, t, config_.outdoorTolerance)) {
+            return t;
+        }
+    }
+    return problem_.getSlotCount();
+}
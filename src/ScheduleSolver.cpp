@@ -0,0 +1,1099 @@
+#include "ScheduleSolver.h"
+#include "LinearProgram.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+
+namespace {
+
+const double INF = std::numeric_limits<double>::infinity();
+const double CHECK_TOLERANCE = 1e-4;     // Used by evaluate()
+const double ENERGY_PENALTY = 1e-6;      // $/kWh on device plans; avoids burning free solar for nothing
+const double OVERFLOW_PRICE = 1000.0;    // $/kWh the master LP pays for import beyond the limit
+const double TRANSITION_WORK = 10.0;     // Tableau entry updates a DP transition costs about as much as
+const double ASCENT_DEFLECTION = 0.7;    // Share of its last direction a subgradient step keeps
+
+// Cost of running at powerKw in one slot; INF if not allowed
+using SlotCost = std::function<double(size_t slot, double powerKw)>;
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+double batteryDelta(const ScheduleBattery& battery, double powerKw, double hours) {
+    return hours * (powerKw > 0.0 ? battery.efficiency * powerKw : powerKw / battery.efficiency);
+}
+
+std::vector<double> powerLevels(double maxPowerKw, bool onOff, int steps) {
+    std::vector<double> levels;
+    int count = onOff ? 1 : std::max(1, steps);
+    for (int i = 0; i <= count; ++i) {
+        levels.push_back(maxPowerKw * i / count);
+    }
+    return levels;
+}
+
+struct DPResult {
+    bool feasible = false;
+    double cost = INF;
+    std::vector<double> powerKw;
+    size_t transitions = 0;
+};
+
+// Cheapest power sequence for one device
+// States are bucketed by stateStep; each bucket keeps its cheapest path and
+// that path's exact state, so state limits are checked without rounding.
+// Outside [firstSlot, endSlot) only levels[zeroLevel] is allowed. stateCost
+// is paid for the state each slot ends in.
+template <typename Next, typename StateCost>
+DPResult solveStateDP(size_t slots, double initialState, double minState, double maxState, double stateStep,
+                      const std::vector<double>& levels, size_t zeroLevel, size_t firstSlot, size_t endSlot,
+                      double finalMinState, const SlotCost& slotCost, Next next, StateCost stateCost) {
+    DPResult result;
+    size_t buckets = static_cast<size_t>(std::floor((maxState - minState) / stateStep + 0.5)) + 1;
+    // Nearest bucket, in the inner loop: a multiply instead of a divide, and
+    // truncating a positive index floors it without a libm call
+    double perStep = 1.0 / stateStep;
+    auto bucketOf = [&](double state) {
+        double index = (state - minState) * perStep + 0.5;
+        return index < 1.0 ? 0 : std::min(buckets - 1, static_cast<size_t>(index));
+    };
+
+    std::vector<double> stepCost(slots * levels.size(), INF);
+    for (size_t t = 0; t < slots; ++t) {
+        bool inWindow = t >= firstSlot && t < endSlot;
+        for (size_t l = 0; l < levels.size(); ++l) {
+            if (inWindow || l == zeroLevel) {
+                stepCost[t * levels.size() + l] = slotCost(t, levels[l]);
+            }
+        }
+    }
+
+    std::vector<double> cost(buckets, INF), state(buckets, 0.0);
+    std::vector<double> nextCost(buckets), nextState(buckets);
+    std::vector<int32_t> previous(slots * buckets, -1);
+    std::vector<uint8_t> chosen(slots * buckets, 0);
+
+    for (size_t t = 0; t < slots; ++t) {
+        std::fill(nextCost.begin(), nextCost.end(), INF);
+        const double* costs = &stepCost[t * levels.size()];
+        size_t sources = t == 0 ? 1 : buckets;
+        for (size_t b = 0; b < sources; ++b) {
+            double fromCost = t == 0 ? 0.0 : cost[b];
+            double fromState = t == 0 ? initialState : state[b];
+            if (fromCost == INF) {
+                continue;
+            }
+            for (size_t l = 0; l < levels.size(); ++l) {
+                if (costs[l] == INF) {
+                    continue;
+                }
+                ++result.transitions;
+                double to = next(fromState, levels[l], t);
+                if (to < minState - 1e-9 || to > maxState + 1e-9) {
+                    continue;
+                }
+                size_t target = bucketOf(to);
+                double total = fromCost + costs[l] + stateCost(to);
+                if (total < nextCost[target] - 1e-12) {
+                    nextCost[target] = total;
+                    nextState[target] = to;
+                    previous[t * buckets + target] = t == 0 ? -1 : static_cast<int32_t>(b);
+                    chosen[t * buckets + target] = static_cast<uint8_t>(l);
+                }
+            }
+        }
+        cost.swap(nextCost);
+        state.swap(nextState);
+    }
+
+    size_t best = buckets;
+    for (size_t b = 0; b < buckets; ++b) {
+        if (cost[b] < INF && state[b] >= finalMinState - 1e-9 && (best == buckets || cost[b] < cost[best])) {
+            best = b;
+        }
+    }
+    if (slots == 0 || best == buckets) {
+        return result;
+    }
+
+    result.feasible = true;
+    result.cost = cost[best];
+    result.powerKw.assign(slots, 0.0);
+    int32_t bucket = static_cast<int32_t>(best);
+    for (size_t t = slots; t-- > 0;) {
+        result.powerKw[t] = levels[chosen[t * buckets + bucket]];
+        bucket = previous[t * buckets + bucket];
+    }
+    return result;
+}
+
+double noStateCost(double) {
+    return 0.0;
+}
+
+// Degrees outside the comfort band
+double discomfort(const ScheduleDevice& device, double temp) {
+    return std::max(0.0, device.minTemp - temp) + std::max(0.0, temp - device.maxTemp);
+}
+
+// Penalty a thermal device with a soft comfort band pays for a plan
+double comfortCost(const ScheduleProblem& problem, const ScheduleDevice& device, const std::vector<double>& power) {
+    if (!device.thermal || device.comfortPenalty <= 0.0) {
+        return 0.0;
+    }
+    double cost = 0.0;
+    for (double temp : ScheduleSolver::simulateTemperature(problem, device, power)) {
+        cost += device.comfortPenalty * problem.slotHours * discomfort(device, temp);
+    }
+    return cost;
+}
+
+// Plans one device on its own; dispatches on the device model
+DPResult planDevice(const ScheduleProblem& problem, const ScheduleDevice& device,
+                    const DPScheduleSolverConfig& config, const SlotCost& slotCost) {
+    size_t slots = problem.getSlotCount();
+    double hours = problem.slotHours;
+    std::vector<double> levels = powerLevels(device.maxPowerKw, device.onOff, config.powerLevels);
+
+    if (device.thermal) {
+        auto next = [&](double temp, double power, size_t t) {
+            double outdoor = t < problem.outdoorTemp.size() ? problem.outdoorTemp[t] : temp;
+            return temp + hours * (device.degreesPerKwh * power - device.lossPerHour * (temp - outdoor));
+        };
+        if (device.comfortPenalty <= 0.0) {
+            return solveStateDP(slots, device.initialTemp, device.minTemp, device.maxTemp, config.temperatureStep,
+                                levels, 0, 0, slots, -INF, slotCost, next, noStateCost);
+        }
+        // A soft band lets the room go wherever the outdoors can drag it
+        double low = std::min(device.minTemp, device.initialTemp);
+        double high = std::max(device.maxTemp, device.initialTemp);
+        for (size_t t = 0; t < slots && t < problem.outdoorTemp.size(); ++t) {
+            low = std::min(low, problem.outdoorTemp[t]);
+            high = std::max(high, problem.outdoorTemp[t]);
+        }
+        auto penalty = [&](double temp) {
+            return device.comfortPenalty * hours * discomfort(device, temp);
+        };
+        return solveStateDP(slots, device.initialTemp, low, high, config.temperatureStep, levels, 0, 0, slots, -INF,
+                            slotCost, next, penalty);
+    }
+
+    size_t first = static_cast<size_t>(std::max(0, device.earliestSlot));
+    size_t end = static_cast<size_t>(problem.getDeadline(device));
+    if (device.energyKwh <= 0.0 || device.maxPowerKw <= 0.0 || first >= end) {
+        DPResult idle;
+        idle.feasible = device.energyKwh <= 0.0;
+        idle.cost = 0.0;
+        idle.powerKw.assign(slots, 0.0);
+        return idle;
+    }
+
+    // Energy in whole level steps, so the grid is exact
+    double unit = levels[1] * hours;
+    double full = std::ceil(device.energyKwh / unit - 1e-9) * unit;
+    auto next = [&](double energy, double power, size_t) {
+        return std::min(full, energy + power * hours);
+    };
+    return solveStateDP(slots, 0.0, 0.0, full, unit, levels, 0, first, end, full - unit * 1e-6, slotCost, next,
+                        noStateCost);
+}
+
+DPResult planBattery(const ScheduleProblem& problem, const DPScheduleSolverConfig& config, const SlotCost& slotCost) {
+    const ScheduleBattery& battery = problem.battery;
+    std::vector<double> levels;
+    int steps = std::max(1, config.powerLevels);
+    for (int i = steps; i > 0; --i) {
+        levels.push_back(-battery.maxDischargeKw * i / steps);
+    }
+    size_t zero = levels.size();
+    for (int i = 0; i <= steps; ++i) {
+        levels.push_back(battery.maxChargeKw * i / steps);
+    }
+
+    double hours = problem.slotHours;
+    auto next = [&](double stored, double power, size_t) {
+        return stored + batteryDelta(battery, power, hours);
+    };
+    size_t slots = problem.getSlotCount();
+    return solveStateDP(slots, battery.initialKwh, battery.minKwh, battery.capacityKwh, config.batteryStepKwh,
+                        levels, zero, 0, slots, battery.getTargetKwh(), slotCost, next, noStateCost);
+}
+
+// Power a device cannot do without in each slot: its average over the window
+// for an energy target, or what holds the comfort edge against the outdoors
+std::vector<double> reservedPower(const ScheduleProblem& problem, const ScheduleDevice& device) {
+    size_t slots = problem.getSlotCount();
+    std::vector<double> reserved(slots, 0.0);
+    if (device.thermal) {
+        if (device.degreesPerKwh == 0.0) {
+            return reserved;
+        }
+        double edge = device.degreesPerKwh > 0.0 ? device.minTemp : device.maxTemp;
+        for (size_t t = 0; t < slots && t < problem.outdoorTemp.size(); ++t) {
+            double hold = device.lossPerHour * (edge - problem.outdoorTemp[t]) / device.degreesPerKwh;
+            reserved[t] = std::min(device.maxPowerKw, std::max(0.0, hold));
+        }
+        return reserved;
+    }
+
+    int first = std::max(0, device.earliestSlot);
+    int end = problem.getDeadline(device);
+    if (end > first && device.energyKwh > 0.0) {
+        double average = std::min(device.maxPowerKw, device.energyKwh / ((end - first) * problem.slotHours));
+        std::fill(reserved.begin() + first, reserved.begin() + end, average);
+    }
+    return reserved;
+}
+
+double planCost(const SlotCost& slotCost, const std::vector<double>& power) {
+    double cost = 0.0;
+    for (size_t t = 0; t < power.size(); ++t) {
+        cost += slotCost(t, power[t]);
+    }
+    return cost;
+}
+
+void applyPlan(std::vector<double>& residual, const std::vector<double>& power, double sign) {
+    for (size_t t = 0; t < residual.size() && t < power.size(); ++t) {
+        residual[t] += sign * power[t];
+    }
+}
+
+// Search decision: one member's power in one slot kept above zero (running,
+// charging) or at most zero (off, discharging)
+struct SlotBranch {
+    size_t member;
+    size_t slot;
+    bool positive;
+};
+
+// The battery may idle on either side of a branch
+bool allows(const std::vector<SlotBranch>& branches, size_t member, size_t slot, double powerKw, bool battery) {
+    for (const auto& branch : branches) {
+        if (branch.member != member || branch.slot != slot) {
+            continue;
+        }
+        bool fits = branch.positive ? powerKw > (battery ? -1e-9 : 1e-9) : powerKw <= 1e-9;
+        if (!fits) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Master LP of the column generation with its pool of device plans
+// Rows: grid import per slot, then one convexity row per member. A member is
+// a device with work to do, or the battery (device -1).
+class MasterProblem {
+public:
+    MasterProblem(const ScheduleProblem& problem, const DPScheduleSolverConfig& pricing)
+        : transitions(0), columns(0), work(0.0), problem_(&problem), pricing_(pricing),
+          members_(makeMembers(problem)), tableau_(makeLP(problem, members_.size())) {}
+
+    size_t getMemberCount() const {
+        return members_.size();
+    }
+
+    void addPlan(size_t m, const std::vector<double>& plan) {
+        size_t slots = problem_->getSlotCount();
+        std::vector<std::pair<int, double>> column;
+        double energy = 0.0;
+        for (size_t t = 0; t < slots; ++t) {
+            if (plan[t] != 0.0) {
+                column.emplace_back(static_cast<int>(t), -plan[t]);
+                energy += plan[t] * problem_->slotHours;
+            }
+        }
+        column.emplace_back(static_cast<int>(slots + m), 1.0);
+        double cost = 0.0;
+        if (members_[m].device >= 0) {
+            cost = ENERGY_PENALTY * energy + comfortCost(*problem_, problem_->devices[members_[m].device], plan);
+        }
+        members_[m].plans.push_back(plan);
+        members_[m].variables.push_back(tableau_.addVariable(cost, 0.0, 1.0, column));
+        ++columns;
+    }
+
+    // Cheapest plan for a member at slot prices, within the branches
+    DPResult price(size_t m, const std::vector<double>& slotPrices, const std::vector<SlotBranch>& branches) {
+        bool battery = members_[m].device < 0;
+        double penalty = battery ? 0.0 : ENERGY_PENALTY * problem_->slotHours;
+        SlotCost cost = [&](size_t t, double power) {
+            return allows(branches, m, t, power, battery) ? (slotPrices[t] + penalty) * power : INF;
+        };
+        DPResult plan = battery ? planBattery(*problem_, pricing_, cost)
+                                : planDevice(*problem_, problem_->devices[members_[m].device], pricing_, cost);
+        transitions += plan.transitions;
+        work += TRANSITION_WORK * plan.transitions;
+        return plan;
+    }
+
+    // Starts a member from its plan in seed if that stands on its own,
+    // otherwise from its cheapest plan at the tariff; false if it has none
+    bool addSeed(size_t m, const ScheduleSolution& seed) {
+        const std::vector<double>& plan = members_[m].device < 0 ? seed.batteryKw : seed.powerKw[members_[m].device];
+        ScheduleProblem single;
+        single.slotHours = problem_->slotHours;
+        single.prices = problem_->prices;
+        single.outdoorTemp = problem_->outdoorTemp;
+        ScheduleSolution alone;
+        if (members_[m].device < 0) {
+            single.battery = problem_->battery;
+            alone.batteryKw = plan;
+        } else {
+            single.devices.push_back(problem_->devices[members_[m].device]);
+            alone.powerKw.push_back(plan);
+        }
+        if (ScheduleSolver::evaluate(single, alone)) {
+            addPlan(m, plan);
+            return true;
+        }
+        DPResult cheapest = price(m, getTariff(), {});
+        if (cheapest.feasible) {
+            addPlan(m, cheapest.powerKw);
+        }
+        return cheapest.feasible;
+    }
+
+    // Fixes the plans that break a new branch to zero; false if the member
+    // has no plan left within the branches
+    bool branch(const SlotBranch& branch, const std::vector<SlotBranch>& branches) {
+        // Plans added since the last solve are priced in first, while the
+        // basis is still primal feasible; the dual simplex would have to
+        // start them all at their upper bound
+        solveLP();
+        Member& member = members_[branch.member];
+        bool battery = member.device < 0;
+        bool anyLeft = false;
+        for (size_t k = 0; k < member.plans.size(); ++k) {
+            bool fits = allows(branches, branch.member, branch.slot, member.plans[k][branch.slot], battery);
+            if (!fits) {
+                tableau_.setBounds(member.variables[k], 0.0, 0.0);
+            }
+            anyLeft = anyLeft || (fits && tableau_.getUpper(member.variables[k]) > 0.0);
+        }
+        if (anyLeft) {
+            return true;
+        }
+        DPResult plan = price(branch.member, getTariff(), branches);
+        if (plan.feasible) {
+            addPlan(branch.member, plan.powerKw);
+        }
+        return plan.feasible;
+    }
+
+    // Lagrangian bound with the import rows relaxed at slotPrices: the import
+    // variables and each member's cheapest plan within the branches are
+    // priced separately. Fills the plans and how far each relaxed row is from
+    // holding, the bound's subgradient.
+    double relax(const std::vector<double>& slotPrices, const std::vector<SlotBranch>& branches,
+                 std::vector<DPResult>& plans, std::vector<double>& excess) {
+        size_t slots = problem_->getSlotCount();
+        bool limited = problem_->importLimitKw > 0.0;
+        double bound = 0.0;
+        excess.assign(slots, 0.0);
+        for (size_t t = 0; t < slots; ++t) {
+            double gridCost = problem_->prices[t] * problem_->slotHours - slotPrices[t];
+            bound += problem_->getNetLoad(t) * slotPrices[t];
+            excess[t] = problem_->getNetLoad(t);
+            if (gridCost < 0.0) {
+                bound += limited ? gridCost * problem_->importLimitKw : -INF;
+                excess[t] -= limited ? problem_->importLimitKw : 0.0;
+            }
+        }
+        plans.clear();
+        for (size_t m = 0; m < members_.size(); ++m) {
+            plans.push_back(price(m, slotPrices, branches));
+            if (!plans.back().feasible) {
+                bound = -INF;
+                continue;
+            }
+            bound += plans.back().cost;
+            applyPlan(excess, plans.back().powerKw, 1.0);
+        }
+        return bound;
+    }
+
+    // Column generation until no plan prices out, rounds run out or another
+    // round as costly as the last would take the work past workLimit. Returns
+    // the best Lagrangian bound found at the duals.
+    double generate(const std::vector<SlotBranch>& branches, int maxRounds, double workLimit) {
+        size_t slots = problem_->getSlotCount();
+        double bound = -INF;
+        std::vector<DPResult> plans;
+        std::vector<double> excess;
+        for (int round = 0; round < maxRounds; ++round) {
+            double roundStart = work;
+            if (solveLP() != LPStatus::OPTIMAL) {
+                return INF;
+            }
+            std::vector<double> duals = tableau_.getDuals();
+            bound = std::max(bound, relax(duals, branches, plans, excess));
+            size_t added = 0;
+            for (size_t m = 0; m < members_.size(); ++m) {
+                if (plans[m].feasible && plans[m].cost - duals[slots + m] < -1e-7) {
+                    addPlan(m, plans[m].powerKw);
+                    ++added;
+                }
+            }
+            if (added == 0) {
+                return std::max(bound, tableau_.getObjective());
+            }
+            if (work + (work - roundStart) > workLimit) {
+                break;
+            }
+        }
+        return bound;
+    }
+
+    // The plans mixed by the LP weights, on top of base for the rest
+    ScheduleSolution mix(const ScheduleSolution& base) const {
+        ScheduleSolution mixed = base;
+        std::vector<double> weights = tableau_.getValues();
+        for (const auto& member : members_) {
+            std::vector<double> plan(problem_->getSlotCount(), 0.0);
+            for (size_t k = 0; k < member.plans.size(); ++k) {
+                double weight = weights[member.variables[k]];
+                for (size_t t = 0; t < plan.size() && weight > 1e-9; ++t) {
+                    plan[t] += weight * member.plans[k][t];
+                }
+            }
+            (member.device < 0 ? mixed.batteryKw : mixed.powerKw[member.device]) = plan;
+        }
+        return mixed;
+    }
+
+    // The most undecided slot of an on/off device, or a battery slot the LP
+    // both charges and discharges in, on the side the LP leans to; false if
+    // there is none
+    bool pickBranch(SlotBranch& branch) const {
+        std::vector<double> weights = tableau_.getValues();
+        double best = 1e-6;
+        bool found = false;
+        for (size_t m = 0; m < members_.size(); ++m) {
+            const Member& member = members_[m];
+            if (!member.integer) {
+                continue;
+            }
+            for (size_t t = 0; t < problem_->getSlotCount(); ++t) {
+                double up = 0.0, down = 0.0;
+                for (size_t k = 0; k < member.plans.size(); ++k) {
+                    double weight = weights[member.variables[k]];
+                    double power = member.plans[k][t];
+                    up += power > 1e-9 ? weight : 0.0;
+                    down += (member.device < 0 ? power < -1e-9 : power <= 1e-9) ? weight : 0.0;
+                }
+                double undecided = std::min(up, down);
+                if (undecided > best) {
+                    best = undecided;
+                    branch = SlotBranch{m, t, up >= down};
+                    found = true;
+                }
+            }
+        }
+        return found;
+    }
+
+    size_t getPivots() const {
+        return tableau_.getIterations();
+    }
+
+    size_t transitions;   // DP transitions spent on pricing and on plans guided by it
+    size_t columns;       // Plans added
+    double work;          // Tableau entries updated by simplex pivots, plus pricing
+
+private:
+    struct Member {
+        int device;
+        bool integer;                             // Must end up on a single plan
+        std::vector<std::vector<double>> plans;
+        std::vector<int> variables;               // Tableau column of each plan
+    };
+
+    static std::vector<Member> makeMembers(const ScheduleProblem& problem) {
+        std::vector<Member> members;
+        for (size_t d = 0; d < problem.devices.size(); ++d) {
+            const ScheduleDevice& device = problem.devices[d];
+            if (device.thermal || device.energyKwh > 0.0) {
+                members.push_back(Member{static_cast<int>(d), device.onOff, {}, {}});
+            }
+        }
+        if (problem.battery.capacityKwh > 0.0) {
+            members.push_back(Member{-1, true, {}, {}});
+        }
+        return members;
+    }
+
+    // Import beyond the limit is allowed at a prohibitive price, so the LP
+    // stays feasible whatever plans it holds
+    static LinearProgram makeLP(const ScheduleProblem& problem, size_t memberCount) {
+        bool limited = problem.importLimitKw > 0.0;
+        LinearProgram lp;
+        for (size_t t = 0; t < problem.getSlotCount(); ++t) {
+            LinearConstraint row;
+            row.sense = ConstraintSense::GREATER_EQUAL;
+            row.rhs = problem.getNetLoad(t);
+            row.terms.emplace_back(lp.addVariable(problem.prices[t] * problem.slotHours, 0.0,
+                                                  limited ? problem.importLimitKw : LinearProgram::INF), 1.0);
+            if (limited) {
+                row.terms.emplace_back(lp.addVariable(OVERFLOW_PRICE * problem.slotHours), 1.0);
+            }
+            lp.addConstraint(row);
+        }
+        for (size_t m = 0; m < memberCount; ++m) {
+            LinearConstraint row;
+            row.sense = ConstraintSense::EQUAL;
+            row.rhs = 1.0;
+            lp.addConstraint(row);
+        }
+        return lp;
+    }
+
+    // Pivots cost a sweep over the tableau, which grows with every plan
+    LPStatus solveLP() {
+        size_t pivots = tableau_.getIterations();
+        LPStatus status = tableau_.solve();
+        size_t rows = problem_->getSlotCount() + members_.size();
+        size_t imports = problem_->getSlotCount() * (problem_->importLimitKw > 0.0 ? 2 : 1);
+        work += static_cast<double>(tableau_.getIterations() - pivots) * rows * (rows + imports + columns);
+        return status;
+    }
+
+    std::vector<double> getTariff() const {
+        std::vector<double> tariff(problem_->prices);
+        for (double& value : tariff) {
+            value *= problem_->slotHours;
+        }
+        return tariff;
+    }
+
+    const ScheduleProblem* problem_;
+    DPScheduleSolverConfig pricing_;
+    std::vector<Member> members_;
+    SimplexTableau tableau_;
+};
+
+// Subgradient ascent on the root's Lagrangian bound, without the LP
+// A step costs one pricing round, where a column generation round on a large
+// tableau costs many pivots more. The slot prices start at the tariff where
+// best imports and take Polyak steps toward the cheapest plan's cost, along
+// the import rows' excess plus a share of the last direction, which damps
+// the zigzag of plain subgradient steps; the step halves after three steps
+// without a better bound. Prices above the tariff mark the slots where the
+// import limit is scarce: every other step the DP's first pass plans with
+// that surcharge, and a first pass cheaper than the earlier ones gets the
+// improvement rounds and replaces best if it beats it. Stops after maxSteps,
+// or once another step would take the root's work past workLimit. Returns
+// the best bound found.
+double ascend(MasterProblem& root, const ScheduleProblem& problem, const DPScheduleSolverConfig& pricing,
+              ScheduleSolution& best, int maxSteps, double workLimit) {
+    size_t slots = problem.getSlotCount();
+    double hours = problem.slotHours;
+    bool limited = problem.importLimitKw > 0.0;
+    std::vector<double> prices(slots), ceiling(slots);
+    for (size_t t = 0; t < slots; ++t) {
+        double tariff = problem.prices[t] * hours;
+        prices[t] = !best.feasible || best.gridImportKw[t] > 1e-9 ? tariff : 0.0;
+        // Beyond these the relaxed import, or the overflow, is unbounded
+        ceiling[t] = limited ? OVERFLOW_PRICE * hours : tariff;
+    }
+
+    DPScheduleSolverConfig firstPass = pricing;
+    firstPass.improvementRounds = 0;
+    DPScheduleSolver guide(firstPass);
+    DPScheduleSolver polish(pricing);
+    ScheduleSolution guided;
+    double bound = -INF;
+    double scale = 1.0;
+    int stalled = 0;
+    std::vector<DPResult> plans;
+    std::vector<double> excess, direction(slots, 0.0), surcharge(slots);
+    for (int step = 0; step < maxSteps; ++step) {
+        double stepStart = root.work;
+        double value = root.relax(prices, {}, plans, excess);
+        if (value > bound + 1e-9) {
+            bound = value;
+            stalled = 0;
+        } else if (++stalled == 3) {
+            scale /= 2.0;
+            stalled = 0;
+        }
+
+        bool scarce = false;
+        for (size_t t = 0; t < slots; ++t) {
+            surcharge[t] = std::max(0.0, prices[t] / hours - problem.prices[t]);
+            scarce = scarce || surcharge[t] > 0.0;
+        }
+        if (scarce && step % 2 == 0) {
+            ScheduleSolution plan = guide.solveWithSurcharge(problem, surcharge);
+            root.transitions += plan.iterations;
+            root.work += TRANSITION_WORK * plan.iterations;
+            if (plan.feasible && (!guided.feasible || plan.cost < guided.cost)) {
+                guided = plan;
+                ScheduleSolution polished = polish.solveWithWarmStart(problem, plan);
+                root.transitions += polished.iterations;
+                root.work += TRANSITION_WORK * polished.iterations;
+                if (polished.feasible && (!best.feasible || polished.cost < best.cost)) {
+                    best = polished;
+                }
+            }
+        }
+
+        double norm = 0.0;
+        for (size_t t = 0; t < slots; ++t) {
+            direction[t] = excess[t] + ASCENT_DEFLECTION * direction[t];
+            norm += direction[t] * direction[t];
+        }
+        // Aim at the cheapest plan so far, or a tenth above the bound without one
+        double target = best.feasible ? best.cost : INF;
+        target = guided.feasible ? std::min(target, guided.cost) : target;
+        if (bound == -INF || norm < 1e-12 || bound >= target) {
+            break;
+        }
+        target = target < INF ? target : value + 0.1 * std::fabs(value) + 1e-3;
+        double length = scale * (target - value) / norm;
+        for (size_t t = 0; t < slots; ++t) {
+            prices[t] = std::min(ceiling[t], std::max(0.0, prices[t] + length * direction[t]));
+        }
+        if (root.work + (root.work - stepStart) > workLimit) {
+            break;
+        }
+    }
+
+    return bound;
+}
+
+} // namespace
+
+double ScheduleBattery::getTargetKwh() const {
+    return std::max(finalKwh < 0.0 ? initialKwh : finalKwh, minKwh);
+}
+
+size_t ScheduleProblem::getSlotCount() const {
+    return prices.size();
+}
+
+double ScheduleProblem::getNetLoad(size_t slot) const {
+    double base = slot < baseLoadKw.size() ? baseLoadKw[slot] : 0.0;
+    double solar = slot < solarKw.size() ? solarKw[slot] : 0.0;
+    return base - solar;
+}
+
+int ScheduleProblem::getDeadline(const ScheduleDevice& device) const {
+    int slots = static_cast<int>(getSlotCount());
+    return device.deadlineSlot < 0 || device.deadlineSlot > slots ? slots : device.deadlineSlot;
+}
+
+ScheduleSolution ScheduleSolver::solveWithWarmStart(const ScheduleProblem& problem,
+                                                    const ScheduleSolution& warmStart) {
+    ScheduleSolution solution = solve(problem);
+    ScheduleSolution warm = warmStart;
+    if (evaluate(problem, warm) && (!solution.feasible || warm.cost < solution.cost)) {
+        warm.optimal = false;
+        warm.lowerBound = std::min(solution.lowerBound, warm.cost);
+        warm.solveMs = solution.solveMs;
+        warm.iterations = solution.iterations;
+        warm.nodes = solution.nodes;
+        warm.columns = solution.columns;
+        return warm;
+    }
+    return solution;
+}
+
+bool ScheduleSolver::evaluate(const ScheduleProblem& problem, ScheduleSolution& solution, std::string* violation) {
+    size_t slots = problem.getSlotCount();
+    double hours = problem.slotHours;
+    auto fail = [&](const std::string& message) {
+        solution.feasible = false;
+        if (violation) {
+            *violation = message;
+        }
+        return false;
+    };
+
+    solution.cost = 0.0;
+    solution.comfortCost = 0.0;
+    solution.gridImportKw.assign(slots, 0.0);
+    if (solution.powerKw.size() != problem.devices.size()) {
+        return fail("Plan has " + std::to_string(solution.powerKw.size()) + " devices, problem has " +
+                    std::to_string(problem.devices.size()));
+    }
+    if (solution.batteryKw.empty()) {
+        solution.batteryKw.assign(slots, 0.0);
+    }
+
+    for (size_t d = 0; d < problem.devices.size(); ++d) {
+        const ScheduleDevice& device = problem.devices[d];
+        const std::vector<double>& power = solution.powerKw[d];
+        if (power.size() != slots) {
+            return fail(device.id + ": plan does not cover the horizon");
+        }
+        double energy = 0.0;
+        for (size_t t = 0; t < slots; ++t) {
+            int slot = static_cast<int>(t);
+            bool inWindow = device.thermal || (slot >= device.earliestSlot && slot < problem.getDeadline(device));
+            double limit = inWindow ? device.maxPowerKw : 0.0;
+            if (power[t] < -CHECK_TOLERANCE || power[t] > limit + CHECK_TOLERANCE) {
+                return fail(device.id + ": " + std::to_string(power[t]) + " kW in slot " + std::to_string(t));
+            }
+            if (device.onOff && power[t] > CHECK_TOLERANCE && power[t] < device.maxPowerKw - CHECK_TOLERANCE) {
+                return fail(device.id + ": on/off device at part load in slot " + std::to_string(t));
+            }
+            energy += power[t] * hours;
+        }
+        if (device.thermal && device.comfortPenalty > 0.0) {
+            solution.comfortCost += comfortCost(problem, device, power);
+        } else if (device.thermal) {
+            std::vector<double> temps = simulateTemperature(problem, device, power);
+            for (size_t t = 0; t < slots; ++t) {
+                if (temps[t] < device.minTemp - CHECK_TOLERANCE || temps[t] > device.maxTemp + CHECK_TOLERANCE) {
+                    return fail(device.id + ": " + std::to_string(temps[t]) + " °C after slot " + std::to_string(t));
+                }
+            }
+        } else if (energy < device.energyKwh - CHECK_TOLERANCE) {
+            return fail(device.id + ": " + std::to_string(energy) + " of " + std::to_string(device.energyKwh) +
+                        " kWh by the deadline");
+        }
+    }
+
+    const ScheduleBattery& battery = problem.battery;
+    double stored = battery.initialKwh;
+    for (size_t t = 0; t < slots; ++t) {
+        double power = solution.batteryKw[t];
+        if (battery.capacityKwh <= 0.0) {
+            if (std::fabs(power) > CHECK_TOLERANCE) {
+                return fail("Battery power without a battery");
+            }
+            continue;
+        }
+        if (power > battery.maxChargeKw + CHECK_TOLERANCE || power < -battery.maxDischargeKw - CHECK_TOLERANCE) {
+            return fail("Battery at " + std::to_string(power) + " kW in slot " + std::to_string(t));
+        }
+        stored += batteryDelta(battery, power, hours);
+        if (stored < battery.minKwh - CHECK_TOLERANCE || stored > battery.capacityKwh + CHECK_TOLERANCE) {
+            return fail("Battery at " + std::to_string(stored) + " kWh after slot " + std::to_string(t));
+        }
+    }
+    if (battery.capacityKwh > 0.0 && stored < battery.getTargetKwh() - CHECK_TOLERANCE) {
+        return fail("Battery ends at " + std::to_string(stored) + " kWh");
+    }
+
+    for (size_t t = 0; t < slots; ++t) {
+        double load = problem.getNetLoad(t) + solution.batteryKw[t];
+        for (const auto& power : solution.powerKw) {
+            load += power[t];
+        }
+        solution.gridImportKw[t] = std::max(0.0, load);
+        if (problem.importLimitKw > 0.0 && solution.gridImportKw[t] > problem.importLimitKw + CHECK_TOLERANCE) {
+            return fail("Import of " + std::to_string(solution.gridImportKw[t]) + " kW in slot " + std::to_string(t));
+        }
+        solution.cost += problem.prices[t] * hours * solution.gridImportKw[t];
+    }
+    solution.cost += solution.comfortCost;
+
+    solution.feasible = true;
+    return true;
+}
+
+std::vector<double> ScheduleSolver::simulateTemperature(const ScheduleProblem& problem, const ScheduleDevice& device,
+                                                        const std::vector<double>& powerKw) {
+    std::vector<double> temps;
+    double temp = device.initialTemp;
+    for (size_t t = 0; t < problem.getSlotCount(); ++t) {
+        double outdoor = t < problem.outdoorTemp.size() ? problem.outdoorTemp[t] : temp;
+        double power = t < powerKw.size() ? powerKw[t] : 0.0;
+        temp += problem.slotHours * (device.degreesPerKwh * power - device.lossPerHour * (temp - outdoor));
+        temps.push_back(temp);
+    }
+    return temps;
+}
+
+std::vector<double> ScheduleSolver::simulateBattery(const ScheduleProblem& problem,
+                                                    const std::vector<double>& batteryKw) {
+    std::vector<double> stored;
+    double energy = problem.battery.initialKwh;
+    for (size_t t = 0; t < problem.getSlotCount(); ++t) {
+        double power = t < batteryKw.size() ? batteryKw[t] : 0.0;
+        energy += batteryDelta(problem.battery, power, problem.slotHours);
+        stored.push_back(energy);
+    }
+    return stored;
+}
+
+DPScheduleSolver::DPScheduleSolver(const DPScheduleSolverConfig& config) : config_(config) {}
+
+const char* DPScheduleSolver::getName() const {
+    return "dp";
+}
+
+ScheduleSolution DPScheduleSolver::solve(const ScheduleProblem& problem) {
+    return plan(problem, nullptr, nullptr);
+}
+
+ScheduleSolution DPScheduleSolver::solveWithWarmStart(const ScheduleProblem& problem,
+                                                      const ScheduleSolution& warmStart) {
+    ScheduleSolution warm = warmStart;
+    return plan(problem, evaluate(problem, warm) ? &warm : nullptr, nullptr);
+}
+
+ScheduleSolution DPScheduleSolver::solveWithSurcharge(const ScheduleProblem& problem,
+                                                      const std::vector<double>& surcharge) {
+    return plan(problem, nullptr, &surcharge);
+}
+
+ScheduleSolution DPScheduleSolver::plan(const ScheduleProblem& problem, const ScheduleSolution* warmStart,
+                                        const std::vector<double>* surcharge) {
+    auto start = Clock::now();
+    size_t slots = problem.getSlotCount();
+    ScheduleSolution solution;
+    solution.powerKw.assign(problem.devices.size(), std::vector<double>(slots, 0.0));
+    solution.batteryKw.assign(slots, 0.0);
+    if (warmStart) {
+        solution.powerKw = warmStart->powerKw;
+        solution.batteryKw = warmStart->batteryKw;
+    }
+
+    std::vector<double> residual(slots);
+    for (size_t t = 0; t < slots; ++t) {
+        residual[t] = problem.getNetLoad(t);
+    }
+    for (const auto& power : solution.powerKw) {
+        applyPlan(residual, power, 1.0);
+    }
+    applyPlan(residual, solution.batteryKw, 1.0);
+
+    // Until a device is planned, the import it cannot do without is held back
+    bool limited = problem.importLimitKw > 0.0;
+    std::vector<std::vector<double>> reserved(problem.devices.size());
+    std::vector<double> reservedTotal(slots, 0.0);
+    if (limited && !warmStart) {
+        for (size_t d = 0; d < problem.devices.size(); ++d) {
+            reserved[d] = reservedPower(problem, problem.devices[d]);
+            applyPlan(reservedTotal, reserved[d], 1.0);
+        }
+    }
+    std::vector<double> limit(slots, limited ? problem.importLimitKw : INF);
+    std::vector<double> price(problem.prices);
+    if (surcharge && !warmStart) {
+        for (size_t t = 0; t < slots && t < surcharge->size(); ++t) {
+            price[t] += (*surcharge)[t];
+        }
+    }
+    SlotCost marginal = [&](size_t t, double power) {
+        double after = residual[t] + power;
+        if (power > 0.0 && after > limit[t] + 1e-9) {
+            return INF;
+        }
+        return price[t] * problem.slotHours * (std::max(0.0, after) - std::max(0.0, residual[t]));
+    };
+    // Other devices may be counting on the battery's discharge to stay within
+    // the limit, so it may not stop discharging there either
+    SlotCost batteryMarginal = [&](size_t t, double power) {
+        return residual[t] + power > limit[t] + 1e-9 ? INF : marginal(t, power);
+    };
+
+    // Comfort first, then the energy targets with the least room to move
+    std::vector<std::pair<double, size_t>> order;
+    for (size_t d = 0; d < problem.devices.size(); ++d) {
+        const ScheduleDevice& device = problem.devices[d];
+        double slack = -1.0;
+        if (!device.thermal) {
+            double window = problem.getDeadline(device) - std::max(0, device.earliestSlot);
+            double needed = device.maxPowerKw > 0.0 ? device.energyKwh / (device.maxPowerKw * problem.slotHours) : 0.0;
+            slack = window - needed;
+        }
+        order.emplace_back(slack, d);
+    }
+    std::stable_sort(order.begin(), order.end());
+
+    // A warm start already is a first pass
+    for (int round = warmStart ? 1 : 0; round <= config_.improvementRounds; ++round) {
+        bool first = round == 0;
+        for (const auto& entry : order) {
+            const ScheduleDevice& device = problem.devices[entry.second];
+            std::vector<double>& current = solution.powerKw[entry.second];
+            applyPlan(residual, current, -1.0);
+            if (first && limited) {
+                applyPlan(reservedTotal, reserved[entry.second], -1.0);
+                for (size_t t = 0; t < slots; ++t) {
+                    limit[t] = problem.importLimitKw - reservedTotal[t];
+                }
+            }
+
+            DPResult plan = planDevice(problem, device, config_, marginal);
+            if (!plan.feasible && first && limited) {
+                // The reservations were too cautious; plan against the plain limit
+                std::fill(limit.begin(), limit.end(), problem.importLimitKw);
+                DPResult retry = planDevice(problem, device, config_, marginal);
+                retry.transitions += plan.transitions;
+                plan = retry;
+            }
+            solution.iterations += plan.transitions;
+            double currentCost = planCost(marginal, current) + comfortCost(problem, device, current);
+            if (plan.feasible && (first || plan.cost < currentCost - 1e-9)) {
+                current = plan.powerKw;
+            }
+            applyPlan(residual, current, 1.0);
+        }
+        std::fill(limit.begin(), limit.end(), limited ? problem.importLimitKw : INF);
+
+        if (problem.battery.capacityKwh > 0.0) {
+            applyPlan(residual, solution.batteryKw, -1.0);
+            DPResult plan = planBattery(problem, config_, batteryMarginal);
+            solution.iterations += plan.transitions;
+            if (plan.feasible && (first || plan.cost < planCost(batteryMarginal, solution.batteryKw) - 1e-9)) {
+                solution.batteryKw = plan.powerKw;
+            }
+            applyPlan(residual, solution.batteryKw, 1.0);
+        }
+        // Only the first pass pays the surcharge
+        price = problem.prices;
+    }
+
+    evaluate(problem, solution);
+    solution.solveMs = elapsedMs(start);
+    return solution;
+}
+
+MILPScheduleSolver::MILPScheduleSolver(const MILPScheduleSolverConfig& config) : config_(config) {}
+
+const char* MILPScheduleSolver::getName() const {
+    return "milp";
+}
+
+ScheduleSolution MILPScheduleSolver::solve(const ScheduleProblem& problem) {
+    return search(problem, nullptr);
+}
+
+ScheduleSolution MILPScheduleSolver::solveWithWarmStart(const ScheduleProblem& problem,
+                                                        const ScheduleSolution& warmStart) {
+    return search(problem, &warmStart);
+}
+
+ScheduleSolution MILPScheduleSolver::search(const ScheduleProblem& problem, const ScheduleSolution* warmStart) {
+    auto start = Clock::now();
+
+    DPScheduleSolver dp(config_.pricing);
+    ScheduleSolution best = warmStart ? dp.solveWithWarmStart(problem, *warmStart) : dp.solve(problem);
+    size_t transitions = best.iterations;
+
+    MasterProblem root(problem, config_.pricing);
+    for (size_t m = 0; m < root.getMemberCount(); ++m) {
+        if (!root.addSeed(m, best)) {
+            best.solveMs = elapsedMs(start);
+            return best;   // This device cannot meet its constraints at all
+        }
+    }
+    // Half the work goes to the root bound at most: the ascent first, then
+    // column generation with what the ascent left of it
+    double rootBound = ascend(root, problem, config_.pricing, best, config_.maxAscentSteps, config_.maxWork / 2.0);
+    rootBound = std::max(rootBound, root.generate({}, config_.maxPricingRounds, config_.maxWork / 2.0));
+
+    // Depth-first search: dive toward the side the LP leans to and restart
+    // the other sides from the root with their branches applied
+    struct OpenNode {
+        std::vector<SlotBranch> branches;
+        double bound;
+    };
+    std::vector<OpenNode> open;
+    MasterProblem node = root;
+    std::vector<SlotBranch> branches;
+    double bound = rootBound;
+    double closedBound = INF;   // Lowest bound of the nodes finished so far
+    size_t nodes = 0;
+    size_t pivots = root.getPivots();
+    double work = root.work;
+    transitions += root.transitions;
+    auto retire = [&](const MasterProblem& finished) {
+        pivots += finished.getPivots() - root.getPivots();
+        transitions += finished.transitions - root.transitions;
+        work += finished.work - root.work;
+    };
+    // The current node's own count, plus what the search has left
+    auto workLimit = [&]() {
+        return node.work + std::max(0.0, config_.maxWork - (work + node.work - root.work));
+    };
+    auto outOfBudget = [&]() {
+        return nodes >= config_.maxNodes || workLimit() <= node.work;
+    };
+
+    for (;;) {
+        ++nodes;
+        double cutoff = best.feasible ? best.cost - config_.relativeGap * std::fabs(best.cost) : INF;
+        SlotBranch branch;
+        bool finished = bound >= cutoff;
+        if (!finished) {
+            ScheduleSolution mixed = node.mix(best);
+            if (evaluate(problem, mixed)) {
+                if (!best.feasible || mixed.cost < best.cost) {
+                    best = mixed;
+                }
+                finished = true;
+            } else {
+                finished = !node.pickBranch(branch);
+            }
+        }
+
+        if (!finished) {
+            if (outOfBudget()) {
+                open.push_back(OpenNode{branches, bound});
+                break;
+            }
+            SlotBranch other = branch;
+            other.positive = !branch.positive;
+            open.push_back(OpenNode{branches, bound});
+            open.back().branches.push_back(other);
+            branches.push_back(branch);
+            bound = node.branch(branch, branches)
+                        ? std::max(bound, node.generate(branches, config_.maxPricingRounds, workLimit()))
+                        : INF;
+            continue;
+        }
+
+        closedBound = std::min(closedBound, bound);
+        if (open.empty() || outOfBudget()) {
+            break;
+        }
+        retire(node);
+        node = root;
+        branches = open.back().branches;
+        bound = open.back().bound;
+        open.pop_back();
+        bool feasible = true;
+        for (const auto& applied : branches) {
+            feasible = feasible && node.branch(applied, branches);
+        }
+        bound = feasible
+                    ? std::max(bound, node.generate(branches, config_.maxPricingRounds, workLimit()))
+                    : INF;
+    }
+    retire(node);
+
+    // Every plan lies under a finished node, an open one or the incumbent
+    double lowerBound = closedBound;
+    for (const auto& waiting : open) {
+        lowerBound = std::min(lowerBound, waiting.bound);
+    }
+    if (best.feasible) {
+        lowerBound = std::min(lowerBound, best.cost);
+    }
+    best.lowerBound = std::max(0.0, std::max(rootBound, lowerBound == INF ? rootBound : lowerBound));
+    if (best.feasible) {
+        // The LP prices energy with a tiny tie-break penalty the true cost lacks
+        best.lowerBound = std::min(best.lowerBound, best.cost);
+    }
+    best.optimal = best.feasible &&
+                   best.cost - best.lowerBound <= std::max(1e-6, config_.relativeGap * std::fabs(best.cost));
+    best.iterations = transitions + pivots;
+    best.nodes = nodes;
+    best.columns = node.columns;
+    best.solveMs = elapsedMs(start);
+    return best;
+}
@@ -5,7 +5,7 @@ SolarSensor::SolarSensor(const std::string& id, const std::string& name)
 
 void SolarSensor::update() {
     Event event(EventType::SOLAR_PRODUCTION_UPDATE, id_);
-    event.addData("production_kw", currentProduction_);
+    event.addData(EventKey::PRODUCTION_KW, currentProduction_);
     publishEvent(event);
 }
 
@@ -6,8 +6,8 @@ TemperatureSensor::TemperatureSensor(const std::string& id, const std::string& n
 void TemperatureSensor::update() {
     // Simulate reading from MQTT or actual sensor
     Event event(EventType::TEMPERATURE_CHANGE, id_);
-    event.addData("temperature", currentTemp_);
-    event.addData("location", static_cast<double>(location_));
+    event.addData(EventKey::TEMPERATURE, currentTemp_);
+    event.addData(EventKey::LOCATION, static_cast<double>(location_));
     publishEvent(event);
 }
 
@@ -0,0 +1,133 @@
+#include "WorkStealingPool.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(size_t threadCount)
+    : generation_(0), active_(0), stopping_(false), task_(nullptr) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        ranges_.push_back(std::unique_ptr<Range>(new Range()));
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        threads_.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+size_t WorkStealingPool::getThreadCount() const {
+    return threads_.size();
+}
+
+void WorkStealingPool::parallelFor(size_t count, const Task& task) {
+    const size_t workers = ranges_.size();
+
+    // Equal contiguous shares; the first count % workers get one more
+    size_t begin = 0;
+    for (size_t i = 0; i < workers; ++i) {
+        Range& range = *ranges_[i];
+        size_t share = count / workers + (i < count % workers ? 1 : 0);
+        std::lock_guard<std::mutex> lock(range.mutex);
+        range.begin = begin;
+        range.end = begin + share;
+        range.completed = 0;
+        range.steals = 0;
+        begin += share;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_ = &task;
+    active_ = workers;
+    ++generation_;
+    wake_.notify_all();
+    done_.wait(lock, [this] { return active_ == 0; });
+    task_ = nullptr;
+
+    stats_ = WorkStealingStats();
+    stats_.tasks = count;
+    for (const auto& range : ranges_) {
+        stats_.steals += range->steals;
+        stats_.tasksPerWorker.push_back(range->completed);
+    }
+}
+
+const WorkStealingStats& WorkStealingPool::getLastStats() const {
+    return stats_;
+}
+
+void WorkStealingPool::workerLoop(size_t worker) {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) {
+                return;
+            }
+            seen = generation_;
+        }
+
+        do {
+            runRange(worker);
+        } while (steal(worker));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--active_ == 0) {
+            done_.notify_one();
+        }
+    }
+}
+
+void WorkStealingPool::runRange(size_t worker) {
+    Range& own = *ranges_[worker];
+    for (;;) {
+        size_t index;
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (own.begin >= own.end) {
+                return;
+            }
+            index = own.begin++;
+        }
+        (*task_)(worker, index);
+        ++own.completed;
+    }
+}
+
+bool WorkStealingPool::steal(size_t thief) {
+    const size_t workers = ranges_.size();
+    for (size_t offset = 1; offset < workers; ++offset) {
+        Range& victim = *ranges_[(thief + offset) % workers];
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.begin >= victim.end) {
+                continue;
+            }
+            // Back half, or the last index if only one is left
+            end = victim.end;
+            begin = victim.begin + (victim.end - victim.begin) / 2;
+            victim.end = begin;
+        }
+
+        // Stolen indices are invisible to other thieves until they land in
+        // our range, but we run them ourselves, so none is lost
+        Range& own = *ranges_[thief];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.begin = begin;
+        own.end = end;
+        ++own.steals;
+        return true;
+    }
+    return false;
+}
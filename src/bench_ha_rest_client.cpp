@@ -0,0 +1,216 @@
+// Load benchmark for HARestClient against the in-process HAStubServer
+// Reports requests/s, parse throughput and heap allocations per entity so
+// connection and parser changes can be compared without a live Home Assistant.
+#include "HARestClient.h"
+#include "HAJsonParser.h"
+#include "HAStubServer.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <new>
+#include <cstdlib>
+
+// Allocations made by the calling thread only, so the server thread's own
+// allocations do not count against the client
+thread_local size_t threadAllocations = 0;
+
+void* operator new(size_t size) {
+    ++threadAllocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "✓ " : "✗ ") << description << std::endl;
+    failures += condition ? 0 : 1;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+HARestClientConfig quietConfig() {
+    HARestClientConfig config;
+    config.verboseLogging = false;
+    return config;
+}
+
+int main() {
+    printSeparator("HARestClient Benchmark");
+    std::cout << std::fixed << std::setprecision(1);
+
+    // Step 1: Polling single entities over one keep-alive connection
+    printSeparator("Step 1: Single-State Polling");
+
+    HAStubServerConfig serverConfig;
+    serverConfig.token = "benchmark-token";
+    HAStubServer server(serverConfig);
+    if (!server.start()) {
+        std::cerr << "✗ Could not start stub server" << std::endl;
+        return 1;
+    }
+
+    HARestClient client(server.getBaseUrl(), serverConfig.token, quietConfig());
+    check(client.testConnection(), "Connected to stub server");
+
+    const auto& ids = server.getEntityIds();
+    const size_t polls = 2000;
+    size_t valid = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < polls; ++i) {
+        HASensorData data = client.getSensorState(ids[i % ids.size()]);
+        valid += data.entityId == ids[i % ids.size()] ? 1 : 0;
+    }
+    double ms = elapsedMs(start);
+    check(valid == polls, std::to_string(valid) + "/" + std::to_string(polls) + " states parsed");
+    std::cout << "  " << polls / (ms / 1000.0) << " requests/s, "
+              << client.getStats().connectionsOpened << " connection(s) opened" << std::endl;
+
+    // Step 2: Batched fetch when every request waits on the server
+    printSeparator("Step 2: Batched Fetch with 20 ms Latency");
+
+    HAStubServerConfig slowConfig;
+    slowConfig.latencyMs = 20;
+    HAStubServer slowServer(slowConfig);
+    slowServer.start();
+    HARestClient slowClient(slowServer.getBaseUrl(), "token", quietConfig());
+
+    std::vector<std::string> batch(slowServer.getEntityIds().begin(), slowServer.getEntityIds().begin() + 50);
+    start = std::chrono::steady_clock::now();
+    for (const auto& id : batch) {
+        slowClient.getSensorState(id);
+    }
+    double sequentialMs = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    auto states = slowClient.getSensorStates(batch, 8);
+    double batchedMs = elapsedMs(start);
+    size_t fetched = 0;
+    for (const auto& state : states) {
+        fetched += state.entityId.empty() ? 0 : 1;
+    }
+    check(fetched == batch.size(), std::to_string(fetched) + " states fetched in the batch");
+    std::cout << "  Sequential: " << sequentialMs << " ms, getSensorStates(8): " << batchedMs << " ms" << std::endl;
+    slowServer.stop();
+
+    // Step 3: Full /api/states download
+    printSeparator("Step 3: /api/states with 10000 Entities");
+
+    HAStubServerConfig largeConfig;
+    largeConfig.entityCount = 10000;
+    HAStubServer largeServer(largeConfig);
+    largeServer.start();
+    HARestClient largeClient(largeServer.getBaseUrl(), "token", quietConfig());
+
+    const size_t rounds = 5;
+    const double bodyMB = largeServer.getStatesBody().size() / 1048576.0;
+    size_t entities = 0;
+    size_t allocationsBefore = threadAllocations;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i) {
+        entities += largeClient.getAllStates().size();
+    }
+    ms = elapsedMs(start);
+    size_t allocations = threadAllocations - allocationsBefore;
+    check(entities == rounds * largeConfig.entityCount, std::to_string(entities) + " entities received");
+    std::cout << "  " << rounds * bodyMB / (ms / 1000.0) << " MB/s end to end, "
+              << std::setprecision(2) << static_cast<double>(allocations) / entities
+              << " allocations/entity" << std::setprecision(1) << std::endl;
+
+    std::vector<HASensorData> parsed;
+    parsed.reserve(largeConfig.entityCount);
+    allocationsBefore = threadAllocations;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i) {
+        parsed.clear();
+        HAJsonParser::parseStates(largeServer.getStatesBody(), parsed);
+    }
+    ms = elapsedMs(start);
+    allocations = threadAllocations - allocationsBefore;
+    std::cout << "  Parser only: " << rounds * bodyMB / (ms / 1000.0) << " MB/s, " << std::setprecision(2)
+              << static_cast<double>(allocations) / (rounds * parsed.size()) << " allocations/entity"
+              << std::setprecision(1) << std::endl;
+    largeServer.stop();
+
+    // Step 4: Streaming history
+    printSeparator("Step 4: /api/history/period Streaming");
+
+    HAStubServerConfig historyConfig;
+    historyConfig.entityCount = 20;
+    historyConfig.historyEntries = 8640;   // 30 s samples over three days
+    HAStubServer historyServer(historyConfig);
+    historyServer.start();
+    HARestClient historyClient(historyServer.getBaseUrl(), "token", quietConfig());
+
+    for (bool minimal : {false, true}) {
+        HAHistoryQuery query;
+        query.entityIds.assign(historyServer.getEntityIds().begin(), historyServer.getEntityIds().begin() + 5);
+        query.startTimestamp = 1705276800;   // 2024-01-15
+        query.endTimestamp = query.startTimestamp + 3 * 86400;
+        query.minimalResponse = minimal;
+        query.noAttributes = minimal;
+
+        size_t entries = 0;
+        uint64_t bytesBefore = historyServer.getStats().bytesSent;
+        allocationsBefore = threadAllocations;
+        start = std::chrono::steady_clock::now();
+        bool ok = historyClient.fetchHistory(query, [&entries](const HAHistoricalData&) { ++entries; });
+        ms = elapsedMs(start);
+        allocations = threadAllocations - allocationsBefore;
+        double mb = (historyServer.getStats().bytesSent - bytesBefore) / 1048576.0;
+
+        check(ok && entries == query.entityIds.size() * historyConfig.historyEntries,
+              std::string(minimal ? "minimal_response" : "Full entries") + ": " + std::to_string(entries) +
+              " entries, " + std::to_string(mb).substr(0, 5) + " MB");
+        std::cout << "  " << mb / (ms / 1000.0) << " MB/s, " << entries / (ms / 1000.0) << " entries/s, "
+                  << std::setprecision(2) << static_cast<double>(allocations) / entries
+                  << " allocations/entry" << std::setprecision(1) << std::endl;
+    }
+    historyServer.stop();
+
+    // Step 5: Service calls
+    printSeparator("Step 5: Service Calls");
+
+    const size_t calls = 1000;
+    size_t succeeded = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        succeeded += client.callService("switch", i % 2 ? "turn_on" : "turn_off", ids[2]) ? 1 : 0;
+    }
+    ms = elapsedMs(start);
+    check(succeeded == calls, std::to_string(succeeded) + "/" + std::to_string(calls) + " service calls accepted");
+    std::cout << "  " << calls / (ms / 1000.0) << " requests/s" << std::endl;
+
+    HAStubServerStats stats = server.getStats();
+    std::cout << "  Stub server: " << stats.requests << " requests on "
+              << stats.connectionsAccepted << " connection(s)" << std::endl;
+    server.stop();
+
+    printSeparator("Benchmark Summary");
+    if (failures == 0) {
+        std::cout << "✓ All benchmark checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// Standalone Home Assistant REST stand-in for running HARestClient offline
+//
+// Usage: ha_stub_server [--port N] [--entities N] [--history N] [--latency-ms N]
+//                       [--token TOKEN] [--fixture PATH=FILE]... [--verbose]
+//
+// --fixture serves a recorded response body (e.g. a saved /api/states dump)
+// for every GET of PATH instead of the generated fixture.
+#include "HAStubServer.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+
+namespace {
+
+std::atomic<bool> stopRequested(false);
+
+void handleSignal(int) {
+    stopRequested = true;
+}
+
+void printUsage() {
+    std::cerr << "Usage: ha_stub_server [--port N] [--entities N] [--history N] [--latency-ms N]\n"
+              << "                      [--token TOKEN] [--fixture PATH=FILE]... [--verbose]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    HAStubServerConfig config;
+    config.port = 8123;
+    std::vector<std::pair<std::string, std::string>> fixtures;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--port" && hasValue) {
+            config.port = std::atoi(argv[++i]);
+        } else if (arg == "--entities" && hasValue) {
+            config.entityCount = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--history" && hasValue) {
+            config.historyEntries = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--latency-ms" && hasValue) {
+            config.latencyMs = std::atoi(argv[++i]);
+        } else if (arg == "--token" && hasValue) {
+            config.token = argv[++i];
+        } else if (arg == "--fixture" && hasValue) {
+            std::string spec = argv[++i];
+            size_t equals = spec.find('=');
+            if (equals == std::string::npos) {
+                printUsage();
+                return 1;
+            }
+            fixtures.emplace_back(spec.substr(0, equals), spec.substr(equals + 1));
+        } else if (arg == "--verbose") {
+            config.verboseLogging = true;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    HAStubServer server(config);
+    for (const auto& fixture : fixtures) {
+        std::ifstream file(fixture.second);
+        if (!file) {
+            std::cerr << "Cannot read fixture " << fixture.second << std::endl;
+            return 1;
+        }
+        std::ostringstream body;
+        body << file.rdbuf();
+        server.setResponse(fixture.first, body.str());
+        std::cout << "Serving " << fixture.second << " for " << fixture.first << std::endl;
+    }
+
+    if (!server.start()) {
+        return 1;
+    }
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    std::cout << "Press Ctrl+C to stop" << std::endl;
+    while (!stopRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    server.stop();
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include "EventManager.h"
 #include "MQTTClient.h"
+#include "MQTTLoopbackBroker.h"
 #include "HTTPClient.h"
 #include "EnergyOptimizer.h"
 #include "TemperatureSensor.h"
@@ -15,38 +16,59 @@
 #include "DayAheadOptimizer.h"
 #include "HistoricalDataGenerator.h"
 #include "HAIntegration.h"
+#include "HABridge.h"
 #include "HARestClient.h"
 #include "DeferrableLoadController.h"
+#include "CommandDispatcher.h"
 #include <iostream>
 #include <memory>
 #include <thread>
 #include <chrono>
 #include <ctime>
-#include <sstream>
+#include <cstdlib>
+#include <vector>
 #include <iomanip>
 
-// Helper function to create sensor attributes JSON
-// Uses HAIntegration::escapeJsonString for proper escaping
-std::string createSensorAttributes(const std::string& name, const std::string& unit, const std::string& deviceClass) {
-    std::ostringstream attrs;
-    attrs << "{\"unit_of_measurement\": \"" << HAIntegration::escapeJsonString(unit) << "\", "
-          << "\"friendly_name\": \"" << HAIntegration::escapeJsonString(name) << "\", "
-          << "\"device_class\": \"" << HAIntegration::escapeJsonString(deviceClass) << "\"}";
-    return attrs.str();
-}
-
 int main() {
     std::cout << "\n=== Home Assistant Sensor State Publishing Demo ===" << std::endl;
     std::cout << "This demonstrates automatic publishing of ALL local sensor states to MQTT/Home Assistant\n" << std::endl;
     
     // Setup MQTT and HA Integration
-    // Note: For production, use environment variables or config files for broker address
-    // Example: const char* brokerAddr = std::getenv("MQTT_BROKER") ? std::getenv("MQTT_BROKER") : "localhost";
-    auto mqttClient = std::make_shared<MQTTClient>("10.0.0.59", 1883);
+    // Set MQTT_BROKER (and optionally MQTT_PORT) to use a real broker; otherwise
+    // the demo runs against an in-process loopback broker
+    MQTTLoopbackBroker loopbackBroker;
+    std::string brokerAddress = std::getenv("MQTT_BROKER") ? std::getenv("MQTT_BROKER") : "";
+    int brokerPort = std::getenv("MQTT_PORT") ? std::atoi(std::getenv("MQTT_PORT")) : 1883;
+    if (brokerAddress.empty() && loopbackBroker.start()) {
+        brokerAddress = "127.0.0.1";
+        brokerPort = loopbackBroker.getPort();
+    }
+    auto mqttClient = std::make_shared<MQTTClient>(brokerAddress, brokerPort);
     mqttClient->connect();
     
+    // Unchanged values are not republished and a heartbeat refreshes every
+    // entity every 5 minutes
     auto haIntegration = std::make_shared<HAIntegration>(mqttClient);
     
+    // The bridge mirrors every sensor event into HA: discovery configs are
+    // generated on a sensor's first update, states go out from a rate-limited
+    // publish thread, and temperatures ignore jitter below 0.1 °C
+    HABridge haBridge(haIntegration);
+    
+    // Keep the entity IDs earlier versions announced, so HA history, dashboards
+    // and automations stay attached; other sensors get <source>_<suffix>
+    haBridge.setObjectId("temp_indoor_1", EventKey::TEMPERATURE, "local_temp_indoor");
+    haBridge.setObjectId("temp_outdoor_1", EventKey::TEMPERATURE, "local_temp_outdoor");
+    haBridge.setObjectId("energy_meter_1", EventKey::CONSUMPTION_KW, "local_energy_consumption");
+    haBridge.setObjectId("solar_1", EventKey::PRODUCTION_KW, "local_solar_production");
+    haBridge.setObjectId("ev_charger_1", EventKey::CHARGE_POWER_KW, "local_ev_charger_power");
+    haBridge.start();
+    
+    // Sensor events only record readings in the optimizer; it runs one pass
+    // per update round below
+    auto httpClient = std::make_shared<HTTPClient>("https://api.energyprices.example/v1");
+    EnergyOptimizer energyOptimizer(httpClient);
+    
     std::cout << "=== Step 1: Creating Local Sensors ===" << std::endl;
     
     // Create multiple local sensors
@@ -65,34 +87,14 @@ int main() {
     auto evChargerSensor = std::make_shared<EVChargerSensor>(
         "ev_charger_1", "EV Charger Status");
     
-    std::cout << "Created 5 local sensors\n" << std::endl;
-    
-    std::cout << "=== Step 2: Publishing Discovery Configs to HA ===" << std::endl;
-    
-    // Publish discovery configs for all sensors so they appear in HA automatically
-    haIntegration->publishDiscovery("sensor", "home_automation", "local_temp_indoor",
-        "{\"name\": \"Local Indoor Temperature\", \"state_topic\": \"homeassistant/state/sensor.local_temp_indoor\", "
-        "\"unit_of_measurement\": \"°C\", \"device_class\": \"temperature\"}");
-    
-    haIntegration->publishDiscovery("sensor", "home_automation", "local_temp_outdoor",
-        "{\"name\": \"Local Outdoor Temperature\", \"state_topic\": \"homeassistant/state/sensor.local_temp_outdoor\", "
-        "\"unit_of_measurement\": \"°C\", \"device_class\": \"temperature\"}");
-    
-    haIntegration->publishDiscovery("sensor", "home_automation", "local_energy_consumption",
-        "{\"name\": \"Local Energy Consumption\", \"state_topic\": \"homeassistant/state/sensor.local_energy_consumption\", "
-        "\"unit_of_measurement\": \"kW\", \"device_class\": \"power\"}");
+    // Adding a sensor here is all it takes to see it in HA
+    std::vector<std::shared_ptr<Sensor>> sensors = {
+        indoorTempSensor, outdoorTempSensor, energyMeter, solarSensor, evChargerSensor
+    };
     
-    haIntegration->publishDiscovery("sensor", "home_automation", "local_solar_production",
-        "{\"name\": \"Local Solar Production\", \"state_topic\": \"homeassistant/state/sensor.local_solar_production\", "
-        "\"unit_of_measurement\": \"kW\", \"device_class\": \"power\"}");
+    std::cout << "Created " << sensors.size() << " local sensors\n" << std::endl;
     
-    haIntegration->publishDiscovery("sensor", "home_automation", "local_ev_charger_power",
-        "{\"name\": \"Local EV Charger Power\", \"state_topic\": \"homeassistant/state/sensor.local_ev_charger_power\", "
-        "\"unit_of_measurement\": \"kW\", \"device_class\": \"power\"}");
-    
-    std::cout << "Published 5 discovery configs\n" << std::endl;
-    
-    std::cout << "=== Step 3: Setting Initial Sensor Values ===" << std::endl;
+    std::cout << "=== Step 2: Setting Initial Sensor Values ===" << std::endl;
     
     // Set initial sensor values
     indoorTempSensor->setTemperature(22.5);
@@ -103,53 +105,23 @@ int main() {
     
     std::cout << "Set initial values for all sensors\n" << std::endl;
     
-    std::cout << "=== Step 4: Publishing ALL Sensor States to MQTT ===" << std::endl;
-    
-    // Publish all sensor states to MQTT/HA
-    // This shows how to publish sensor data WITH attributes for richer information
-    
-    // Indoor Temperature with attributes
-    std::string indoorAttrs = createSensorAttributes(indoorTempSensor->getName(), "°C", "temperature");
-    haIntegration->publishState("sensor.local_temp_indoor", 
-                                std::to_string(indoorTempSensor->getTemperature()),
-                                indoorAttrs);
-    
-    // Outdoor Temperature with attributes
-    std::string outdoorAttrs = createSensorAttributes(outdoorTempSensor->getName(), "°C", "temperature");
-    haIntegration->publishState("sensor.local_temp_outdoor", 
-                                std::to_string(outdoorTempSensor->getTemperature()),
-                                outdoorAttrs);
-    
-    // Energy Consumption with attributes
-    std::string energyAttrs = createSensorAttributes(energyMeter->getName(), "kW", "power");
-    haIntegration->publishState("sensor.local_energy_consumption", 
-                                std::to_string(energyMeter->getConsumption()),
-                                energyAttrs);
-    
-    // Solar Production with attributes
-    std::string solarAttrs = createSensorAttributes(solarSensor->getName(), "kW", "power");
-    haIntegration->publishState("sensor.local_solar_production", 
-                                std::to_string(solarSensor->getProduction()),
-                                solarAttrs);
-    
-    // EV Charger Power with attributes and additional info
-    std::ostringstream evAttrs;
-    evAttrs << "{\"unit_of_measurement\": \"" << HAIntegration::escapeJsonString("kW") << "\", "
-            << "\"friendly_name\": \"" << HAIntegration::escapeJsonString(evChargerSensor->getName()) << "\", "
-            << "\"device_class\": \"" << HAIntegration::escapeJsonString("power") << "\", "
-            << "\"charging\": " << (evChargerSensor->isCharging() ? "true" : "false") << "}";
-    haIntegration->publishState("sensor.local_ev_charger_power", 
-                                std::to_string(evChargerSensor->getChargePower()),
-                                evAttrs.str());
-    
-    std::cout << "\nAll sensor states published!" << std::endl;
+    std::cout << "=== Step 3: Publishing ALL Sensor States to MQTT ===" << std::endl;
+    
+    // Each update() publishes an event; the bridge announces the sensor to HA
+    // via discovery the first time and then publishes its state
+    for (const auto& sensor : sensors) {
+        sensor->update();
+    }
+    energyOptimizer.processPendingUpdates();
+    
+    std::cout << "\nAll sensor states queued for publishing!" << std::endl;
     std::cout << "  - Indoor Temperature: " << indoorTempSensor->getTemperature() << " °C" << std::endl;
     std::cout << "  - Outdoor Temperature: " << outdoorTempSensor->getTemperature() << " °C" << std::endl;
     std::cout << "  - Energy Consumption: " << energyMeter->getConsumption() << " kW" << std::endl;
     std::cout << "  - Solar Production: " << solarSensor->getProduction() << " kW" << std::endl;
     std::cout << "  - EV Charger Power: " << evChargerSensor->getChargePower() << " kW" << std::endl;
     
-    std::cout << "\n=== Step 5: Automatic Updates - Publishing Changes ===" << std::endl;
+    std::cout << "\n=== Step 4: Automatic Updates - Publishing Changes ===" << std::endl;
     std::cout << "Simulating sensor updates and automatically publishing to MQTT...\n" << std::endl;
     
     // Simulate automatic updates every 5 seconds
@@ -169,35 +141,36 @@ int main() {
         energyMeter->setConsumption(newEnergy);
         solarSensor->setProduction(newSolar);
         
-        // Publish updated states to MQTT/HA
-        haIntegration->publishState("sensor.local_temp_indoor", 
-                                    std::to_string(newIndoorTemp),
-                                    indoorAttrs);
-        
-        haIntegration->publishState("sensor.local_temp_outdoor", 
-                                    std::to_string(newOutdoorTemp),
-                                    outdoorAttrs);
-        
-        haIntegration->publishState("sensor.local_energy_consumption", 
-                                    std::to_string(newEnergy),
-                                    energyAttrs);
-        
-        haIntegration->publishState("sensor.local_solar_production", 
-                                    std::to_string(newSolar),
-                                    solarAttrs);
+        for (const auto& sensor : sensors) {
+            sensor->update();
+        }
+        energyOptimizer.processPendingUpdates();
         
-        std::cout << "Published updated states:" << std::endl;
+        std::cout << "Updated sensors:" << std::endl;
         std::cout << "  - Indoor Temperature: " << newIndoorTemp << " °C" << std::endl;
         std::cout << "  - Outdoor Temperature: " << newOutdoorTemp << " °C" << std::endl;
         std::cout << "  - Energy Consumption: " << newEnergy << " kW" << std::endl;
         std::cout << "  - Solar Production: " << newSolar << " kW" << std::endl;
     }
     
+    // Flush whatever is still queued
+    haBridge.stop();
+    HABridgeStats bridgeStats = haBridge.getStats();
+    std::cout << "\nBridge: " << bridgeStats.eventsReceived << " sensor events, " << bridgeStats.entities
+              << " entities discovered, " << bridgeStats.batches << " batches" << std::endl;
+    std::cout << "Energy optimizer: " << energyOptimizer.getOptimizationRunCount()
+              << " optimization passes for " << bridgeStats.eventsReceived << " sensor events" << std::endl;
+    
+    HAPublishStats publishStats = haIntegration->getPublishStats();
+    std::cout << "\nPublish cache: " << publishStats.published << " sent, " << publishStats.suppressed
+              << " suppressed, " << publishStats.failed << " failed, " << publishStats.attributesPublished
+              << " with attributes" << std::endl;
+    
     std::cout << "\n=== Demo Complete ===" << std::endl;
     std::cout << "\nThis demonstrates how to:" << std::endl;
     std::cout << "  1. Create local sensors" << std::endl;
-    std::cout << "  2. Publish discovery configs to HA (sensors auto-appear in HA)" << std::endl;
-    std::cout << "  3. Publish ALL sensor states to MQTT with attributes" << std::endl;
+    std::cout << "  2. Generate discovery configs automatically (sensors auto-appear in HA)" << std::endl;
+    std::cout << "  3. Publish ALL sensor states to MQTT through HABridge" << std::endl;
     std::cout << "  4. Automatically publish sensor updates" << std::endl;
     std::cout << "\nAll sensor states are now available in Home Assistant via MQTT!" << std::endl;
     
@@ -340,6 +313,17 @@ int main() {
     std::cout << "=== Step 2: Setting Up Deferrable Load Controller ===" << std::endl;
     auto deferrableController = std::make_shared<DeferrableLoadController>(mlPredictor);
     
+    // Switch decisions are also sent to HA through a queued, rate-limited
+    // dispatcher, so a burst of decisions never blocks the controller
+    auto commandDispatcher = std::make_shared<CommandDispatcher>();
+    commandDispatcher->addTransport("mqtt", [haIntegration](const DeviceCommand& command) {
+        return command.data.empty()
+            ? haIntegration->publishCommand(command.deviceId, command.command)
+            : haIntegration->publishCommandWithData(command.deviceId, command.command, command.data);
+    });
+    commandDispatcher->start();
+    deferrableController->setCommandDispatcher(commandDispatcher, "mqtt");
+    
     // Configure thresholds
     deferrableController->setPriceThreshold(0.15);     // $0.15/kWh - switch off above this
     deferrableController->setBusyHourThreshold(0.13);  // $0.13/kWh - identify busy hours
@@ -409,6 +393,11 @@ int main() {
     std::cout << "  Essential Lights status: " << (light2->isOn() ? "ON" : "OFF") << " (not affected - not deferrable)" << std::endl;
     std::cout << "  Heater status: " << (heater->isOn() ? "ON" : "OFF") << " (not affected - not deferrable)" << std::endl;
     
+    commandDispatcher->waitUntilIdle(std::chrono::seconds(2));
+    CommandDispatcherStats commandStats = commandDispatcher->getStats();
+    std::cout << "  HA commands: " << commandStats.sent << " sent, " << commandStats.superseded
+              << " superseded" << std::endl;
+    
     // Day-ahead recommendations
     std::cout << "\n=== Step 6: Day-Ahead Recommendations ===" << std::endl;
     int currentHour = 8;  // 8 AM
@@ -418,9 +407,10 @@ int main() {
     
     std::cout << "\nSample recommendations for key hours:" << std::endl;
     for (int hour : {8, 12, 18, 22}) {
-        if (recommendations.find(hour) != recommendations.end()) {
+        const auto& hourRecommendations = recommendations.at(hour);
+        if (!hourRecommendations.empty()) {
             std::cout << "\nHour " << hour << ":00" << std::endl;
-            for (const auto& rec : recommendations[hour]) {
+            for (const auto& rec : hourRecommendations) {
                 std::cout << "  - " << rec << std::endl;
             }
         }
@@ -437,8 +427,8 @@ int main() {
     auto schedule = dayAheadOptimizer->generateSchedule(currentHour, currentDayOfWeek);
     
     std::cout << "\n=== Generated Day-Ahead Schedule (with Deferrable Load Control) ===" << std::endl;
-    std::cout << "Total estimated cost: $" << schedule.estimatedCost << std::endl;
-    std::cout << "Total estimated consumption: " << schedule.estimatedConsumption << " kWh\n" << std::endl;
+    std::cout << "Total estimated cost: $" << schedule.getEstimatedCost() << std::endl;
+    std::cout << "Total estimated consumption: " << schedule.getEstimatedConsumption() << " kWh\n" << std::endl;
     
     // Show sample hours from schedule
     std::cout << "Sample schedule for key hours:" << std::endl;
@@ -447,15 +437,29 @@ int main() {
         if (!actions.empty()) {
             std::cout << "\nHour " << hour << ":00" << std::endl;
             for (const auto& action : actions) {
-                std::cout << "  - " << action.applianceId << ": " << action.action;
+                std::cout << "  - " << schedule.getApplianceId(action.appliance) << ": " << toString(action.type);
                 if (action.value != 0.0) {
                     std::cout << " (" << action.value << ")";
                 }
-                std::cout << " - " << action.reason << std::endl;
+                std::cout << " - " << schedule.formatReason(action) << std::endl;
             }
         }
     }
-    
+
+    // Two hours later the evening prices come in higher and the room is cooler
+    // than planned; only the rest of the day is re-planned
+    auto latestForecasts = mlPredictor->predictNext24Hours(currentHour, currentDayOfWeek);
+    for (auto& forecast : latestForecasts) {
+        if (forecast.hour >= 17 && forecast.hour < 20) {
+            forecast.predictedEnergyCost *= 1.5;
+        }
+    }
+    ScheduleMeasurement measured;
+    measured.indoorTemp["heater_1"] = 21.2;
+    auto updatedSchedule = dayAheadOptimizer->updateSchedule(2, latestForecasts, measured);
+    std::cout << "Remaining hours: " << 24 - dayAheadOptimizer->getLastReplanStats().slot
+              << ", estimated cost $" << updatedSchedule.getEstimatedCost() << std::endl;
+
     std::cout << "\n=== Deferrable Load Control Demo Summary ===" << std::endl;
     std::cout << "\nThis demonstration showed how to:" << std::endl;
     std::cout << "  1. ✓ Mark appliances as deferrable or non-deferrable" << std::endl;
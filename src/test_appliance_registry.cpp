@@ -0,0 +1,120 @@
+// Test program for the type-indexed ApplianceRegistry
+#include "ApplianceRegistry.h"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "✓ " : "✗ ") << description << std::endl;
+    failures += condition ? 0 : 1;
+}
+
+// A device that is both kinds: heats in winter, cools in summer
+class HeatPump : public Heater, public AirConditioner {
+public:
+    HeatPump(const std::string& id, const std::string& name, double power)
+        : Heater(id, name, power), AirConditioner(id, name, power) {}
+};
+
+// A subclass of a single kind
+class DimmableLight : public Light {
+public:
+    DimmableLight(const std::string& id, const std::string& name, double power)
+        : Light(id, name, power) {}
+};
+
+template <typename T>
+bool contains(const std::vector<T*>& list, const T* item) {
+    return std::find(list.begin(), list.end(), item) != list.end();
+}
+
+template <typename T>
+std::string ids(const std::vector<T*>& list) {
+    std::string text;
+    for (const T* item : list) {
+        text += (text.empty() ? "" : ", ") + item->getId();
+    }
+    return text;
+}
+
+int main() {
+    printSeparator("ApplianceRegistry Test");
+
+    ApplianceRegistry registry;
+    check(registry.empty() && registry.getHeaters().empty(), "A new registry is empty");
+
+    auto heater = std::make_shared<Heater>("heater_1", "Living Room Heater", 2.0);
+    auto ac = std::make_shared<AirConditioner>("ac_1", "Bedroom AC", 1.5);
+    auto light = std::make_shared<Light>("light_1", "Kitchen Light", 0.1);
+    auto dimmable = std::make_shared<DimmableLight>("light_2", "Hall Light", 0.05);
+    auto curtain = std::make_shared<Curtain>("curtain_1", "Living Room Curtain");
+    auto ev = std::make_shared<EVCharger>("ev_1", "Garage Charger", 11.0);
+    auto pump = std::make_shared<HeatPump>("heat_pump_1", "Heat Pump", 3.0);
+
+    registry.add(heater);
+    registry.add(ac);
+    registry.add(light);
+    registry.add(dimmable);
+    registry.add(curtain);
+    registry.add(ev);
+    registry.add(std::shared_ptr<Heater>(pump));
+    registry.add(nullptr);
+
+    // Step 1: Typed lists
+    printSeparator("Step 1: Typed Lists");
+
+    check(registry.size() == 7 && registry.getAll().size() == 7,
+          "7 appliances owned, the null one ignored (" + std::to_string(registry.size()) + ")");
+    check(registry.getEVChargers().size() == 1 && registry.getEVChargers()[0] == ev.get(),
+          "EV chargers: " + ids(registry.getEVChargers()));
+    check(registry.getCurtains().size() == 1 && registry.getCurtains()[0] == curtain.get(),
+          "Curtains: " + ids(registry.getCurtains()));
+    check(registry.getLights().size() == 2 && contains<Light>(registry.getLights(), light.get()) &&
+          contains<Light>(registry.getLights(), dimmable.get()),
+          "Lights, including the Light subclass: " + ids(registry.getLights()));
+    check(registry.getHeaters().size() == 2 && registry.getHeaters()[0] == heater.get(),
+          "Heaters in registration order: " + ids(registry.getHeaters()));
+    check(registry.getAirConditioners().size() == 2 && registry.getAirConditioners()[0] == ac.get(),
+          "Air conditioners in registration order: " + ids(registry.getAirConditioners()));
+
+    // Step 2: Several kinds
+    printSeparator("Step 2: Appliance of Several Kinds");
+
+    check(contains<Heater>(registry.getHeaters(), pump.get()), "The heat pump is listed as a heater");
+    check(contains<AirConditioner>(registry.getAirConditioners(), pump.get()),
+          "The heat pump is also listed as an air conditioner");
+    size_t listed = registry.getEVChargers().size() + registry.getHeaters().size() +
+                    registry.getAirConditioners().size() + registry.getLights().size() +
+                    registry.getCurtains().size();
+    check(listed == 8, "7 appliances fill 8 typed slots, so it is in no other list (" +
+          std::to_string(listed) + ")");
+
+    // Step 3: Pointers stay valid and owned
+    printSeparator("Step 3: Ownership");
+
+    long heaterUses = heater.use_count();
+    registry.getHeaters()[0]->turnOn();
+    check(heater->isOn(), "The typed pointer controls the registered appliance");
+    check(heater.use_count() == heaterUses, "Walking a typed list does not touch the refcount");
+    Heater* pumpHeater = registry.getHeaters()[1];
+    pump.reset();
+    check(pumpHeater->getId() == "heat_pump_1", "The registry keeps an appliance alive after the caller drops it");
+
+    printSeparator("Test Summary");
+    if (failures == 0) {
+        std::cout << "✓ All appliance registry checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
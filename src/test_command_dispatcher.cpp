@@ -0,0 +1,277 @@
+// Test program for CommandDispatcher priorities, debouncing and rate limits
+#include "CommandDispatcher.h"
+#include "DeferrableLoadController.h"
+#include "EVCharger.h"
+#include "Light.h"
+#include "MLPredictor.h"
+#include "HistoricalDataGenerator.h"
+#include <iostream>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "✓ " : "✗ ") << description << std::endl;
+    failures += condition ? 0 : 1;
+}
+
+// Records what a transport was asked to send
+struct RecordingTransport {
+    std::mutex mutex;
+    std::vector<DeviceCommand> sent;
+    std::vector<std::chrono::steady_clock::time_point> times;
+    int delayMs = 0;
+
+    CommandDispatcher::Transport transport() {
+        return [this](const DeviceCommand& command) {
+            if (delayMs > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            sent.push_back(command);
+            times.push_back(std::chrono::steady_clock::now());
+            return command.command != "FAIL";
+        };
+    }
+
+    std::vector<DeviceCommand> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sent;
+    }
+};
+
+DeviceCommand makeCommand(const std::string& transport, const std::string& deviceId, const std::string& command,
+                          CommandPriority priority) {
+    DeviceCommand result;
+    result.transport = transport;
+    result.deviceId = deviceId;
+    result.command = command;
+    result.priority = priority;
+    return result;
+}
+
+int main() {
+    printSeparator("CommandDispatcher Test");
+
+    // Step 1: Priority classes
+    printSeparator("Step 1: Safety Before Comfort Before Economy");
+
+    CommandDispatcherConfig config;
+    config.debounceMs = 0;
+    CommandDispatcher dispatcher(config);
+    RecordingTransport mqtt;
+    dispatcher.addTransport("mqtt", mqtt.transport());
+
+    // Queued before start(), so the order is decided by priority alone
+    for (int i = 0; i < 3; ++i) {
+        dispatcher.submit(makeCommand("mqtt", "switch.economy_" + std::to_string(i), "OFF", CommandPriority::ECONOMY));
+        dispatcher.submit(makeCommand("mqtt", "climate.comfort_" + std::to_string(i), "ON", CommandPriority::COMFORT));
+    }
+    dispatcher.submit(makeCommand("mqtt", "switch.boiler", "OFF", CommandPriority::SAFETY));
+    dispatcher.start();
+    check(dispatcher.waitUntilIdle(std::chrono::milliseconds(2000)), "All 7 commands completed");
+
+    auto sent = mqtt.snapshot();
+    bool ordered = sent.size() == 7 && sent[0].deviceId == "switch.boiler";
+    for (size_t i = 1; ordered && i < sent.size(); ++i) {
+        ordered = sent[i - 1].priority <= sent[i].priority;
+    }
+    check(ordered, "Sent in priority order, FIFO within a class");
+
+    // Step 2: Debouncing
+    printSeparator("Step 2: Superseded Commands Are Dropped");
+
+    CommandDispatcherConfig debounceConfig;
+    debounceConfig.debounceMs = 50;
+    CommandDispatcher debounced(debounceConfig);
+    RecordingTransport switches;
+    debounced.addTransport("mqtt", switches.transport());
+    debounced.start();
+
+    std::atomic<int> supersededCallbacks(0);
+    std::atomic<int> sentCallbacks(0);
+    auto onComplete = [&](const DeviceCommand&, CommandStatus status) {
+        supersededCallbacks += status == CommandStatus::SUPERSEDED ? 1 : 0;
+        sentCallbacks += status == CommandStatus::SENT ? 1 : 0;
+    };
+    for (const char* command : {"ON", "OFF", "ON", "OFF", "ON"}) {
+        debounced.submit(makeCommand("mqtt", "switch.ev_charger", command, CommandPriority::ECONOMY), onComplete);
+    }
+    debounced.waitUntilIdle(std::chrono::milliseconds(2000));
+    sent = switches.snapshot();
+    check(sent.size() == 1 && sent[0].command == "ON", "Five flapping decisions produced one command: " +
+          (sent.empty() ? std::string("none") : sent[0].command));
+    check(supersededCallbacks == 4 && sentCallbacks == 1, "Four SUPERSEDED and one SENT completion");
+
+    debounced.submit(makeCommand("mqtt", "switch.heater", "OFF", CommandPriority::COMFORT));
+    bool rejected = !debounced.submit(makeCommand("mqtt", "switch.heater", "ON", CommandPriority::ECONOMY));
+    check(rejected, "Economy decision cannot override a queued comfort command");
+    debounced.waitUntilIdle(std::chrono::milliseconds(2000));
+    sent = switches.snapshot();
+    check(sent.back().deviceId == "switch.heater" && sent.back().command == "OFF", "Comfort command sent");
+
+    std::atomic<int> failed(0);
+    debounced.submit(makeCommand("mqtt", "switch.broken", "FAIL", CommandPriority::SAFETY),
+                     [&](const DeviceCommand&, CommandStatus status) {
+                         failed += status == CommandStatus::FAILED ? 1 : 0;
+                     });
+    debounced.waitUntilIdle(std::chrono::milliseconds(2000));
+    check(failed == 1 && debounced.getStats().failed == 1, "Transport errors reported as FAILED");
+
+    // Step 3: Token bucket per transport
+    printSeparator("Step 3: Rate Limits per Transport");
+
+    CommandDispatcher limited(config);
+    RecordingTransport rest;
+    RecordingTransport fast;
+    rest.delayMs = 20;   // A slow HTTP round trip
+    TransportRateLimit restLimit;
+    restLimit.commandsPerSecond = 50.0;
+    restLimit.burst = 5.0;
+    TransportRateLimit fastLimit;
+    fastLimit.commandsPerSecond = 0.0;
+    limited.addTransport("rest", rest.transport(), restLimit);
+    limited.addTransport("fast", fast.transport(), fastLimit);
+    limited.start();
+
+    const int burst = 30;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < burst; ++i) {
+        limited.submit(makeCommand("rest", "light.room_" + std::to_string(i), "turn_on", CommandPriority::COMFORT));
+        limited.submit(makeCommand("fast", "light.room_" + std::to_string(i), "ON", CommandPriority::COMFORT));
+    }
+    double submitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    check(submitMs < 50.0, "60 submits returned in " + std::to_string(submitMs).substr(0, 5) + " ms");
+
+    bool fastDone = false;
+    for (int i = 0; i < 200 && !fastDone; ++i) {
+        fastDone = fast.snapshot().size() == static_cast<size_t>(burst);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    size_t restSoFar = rest.snapshot().size();
+    check(fastDone && restSoFar < static_cast<size_t>(burst),
+          "Unlimited transport finished while the slow one sent " + std::to_string(restSoFar));
+
+    limited.waitUntilIdle(std::chrono::milliseconds(5000));
+    double restSeconds = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(rest.mutex);
+        restSeconds = std::chrono::duration<double>(rest.times.back() - start).count();
+    }
+    double minimum = (burst - restLimit.burst) / restLimit.commandsPerSecond;
+    check(restSeconds >= minimum * 0.9, std::to_string(burst) + " REST calls took " +
+          std::to_string(restSeconds).substr(0, 4) + " s (bucket allows no less than " +
+          std::to_string(minimum).substr(0, 4) + " s)");
+
+    // Step 4: Deferrable loads through the dispatcher
+    printSeparator("Step 4: DeferrableLoadController");
+
+    auto loadDispatcher = std::make_shared<CommandDispatcher>(debounceConfig);
+    RecordingTransport haSwitches;
+    loadDispatcher->addTransport("mqtt", haSwitches.transport());
+    loadDispatcher->start();
+
+    auto predictor = std::make_shared<MLPredictor>();
+    predictor->train(HistoricalDataGenerator::generateSampleData(7));
+    auto controller = std::make_shared<DeferrableLoadController>(predictor);
+    controller->setCommandDispatcher(loadDispatcher, "mqtt");
+
+    auto evCharger = std::make_shared<EVCharger>("ev_1", "EV Charger", 11.0);
+    auto lights = std::make_shared<Light>("light_1", "Decorative Lights", 0.3);
+    evCharger->setDeferrable(true);
+    lights->setDeferrable(true);
+    controller->addDeferrableLoad(evCharger);
+    controller->addDeferrableLoad(lights);
+    evCharger->turnOn();
+    lights->turnOn();
+
+    controller->controlLoadsByPrice(0.20);
+    loadDispatcher->waitUntilIdle(std::chrono::milliseconds(2000));
+    sent = haSwitches.snapshot();
+    check(sent.size() == 2 && sent[0].deviceId == "switch.ev_1" && sent[0].command == "OFF",
+          "High price switched both loads off in HA");
+
+    // Price hovering around the threshold within the debounce window
+    for (double price : {0.10, 0.20, 0.10}) {
+        controller->controlLoadsByPrice(price);
+    }
+    loadDispatcher->waitUntilIdle(std::chrono::milliseconds(2000));
+    sent = haSwitches.snapshot();
+    check(sent.size() == 4 && sent[2].command == "ON" && sent[3].command == "ON",
+          "Flapping price produced only the final ON commands (" + std::to_string(sent.size() - 2) + " sent)");
+    check(evCharger->isOn() && lights->isOn(), "Local appliance state follows every decision");
+
+    loadDispatcher->stop();
+    limited.stop();
+    debounced.stop();
+
+    // Step 5: Submitting after stop()
+    printSeparator("Step 5: Rejected After Stop");
+
+    dispatcher.stop();
+    CommandStatus lateStatus = CommandStatus::SENT;
+    bool lateAccepted = dispatcher.submit(makeCommand("mqtt", "switch.late", "ON", CommandPriority::SAFETY),
+        [&lateStatus](const DeviceCommand&, CommandStatus status) { lateStatus = status; });
+    check(!lateAccepted && lateStatus == CommandStatus::REJECTED, "submit() after stop() is rejected");
+    check(dispatcher.getStats().queued == 0 && dispatcher.waitUntilIdle(std::chrono::milliseconds(100)),
+          "Nothing is left queued, so waitUntilIdle() returns");
+
+    size_t sentBefore = mqtt.snapshot().size();
+    dispatcher.start();
+    check(dispatcher.submit(makeCommand("mqtt", "switch.late", "ON", CommandPriority::SAFETY)) &&
+          dispatcher.waitUntilIdle(std::chrono::milliseconds(2000)) && mqtt.snapshot().size() == sentBefore + 1,
+          "A restarted dispatcher accepts and sends again");
+    dispatcher.stop();
+
+    // Step 6: Stopped without ever starting
+    printSeparator("Step 6: Stop Before Start");
+
+    std::vector<CommandStatus> unstartedStatus;
+    {
+        CommandDispatcher unstarted(config);
+        RecordingTransport idle;
+        unstarted.addTransport("mqtt", idle.transport());
+        for (int i = 0; i < 3; ++i) {
+            unstarted.submit(makeCommand("mqtt", "switch.unstarted_" + std::to_string(i), "ON",
+                                         CommandPriority::COMFORT),
+                [&unstartedStatus](const DeviceCommand&, CommandStatus status) { unstartedStatus.push_back(status); });
+        }
+        unstarted.stop();
+        check(unstartedStatus.size() == 3 &&
+              std::count(unstartedStatus.begin(), unstartedStatus.end(), CommandStatus::REJECTED) == 3,
+              "stop() completes the 3 commands queued before start() as REJECTED");
+        check(unstarted.waitUntilIdle(std::chrono::milliseconds(100)) && unstarted.getStats().rejected == 3 &&
+              idle.snapshot().empty(), "waitUntilIdle() succeeds and nothing was sent");
+    }
+
+    {
+        CommandDispatcher dropped(config);
+        RecordingTransport idle;
+        dropped.addTransport("mqtt", idle.transport());
+        dropped.submit(makeCommand("mqtt", "switch.dropped", "ON", CommandPriority::ECONOMY),
+            [&unstartedStatus](const DeviceCommand&, CommandStatus status) { unstartedStatus.push_back(status); });
+    }
+    check(unstartedStatus.size() == 4 && unstartedStatus.back() == CommandStatus::REJECTED,
+          "Destroying a dispatcher that never started completes its queued command");
+
+    printSeparator("Test Summary");
+    if (failures == 0) {
+        std::cout << "✓ All dispatcher checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
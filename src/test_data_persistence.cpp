@@ -0,0 +1,352 @@
+// Test program for binary persistence of historical data
+#include "HistoricalDataStore.h"
+#include "HistoricalDataCollector.h"
+#include "DataJournal.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "✓ " : "✗ ") << description << std::endl;
+    failures += condition ? 0 : 1;
+}
+
+std::deque<HistoricalDataPoint> makePoints(size_t count, double offset = 0.0) {
+    std::deque<HistoricalDataPoint> points;
+    for (size_t i = 0; i < count; i++) {
+        HistoricalDataPoint point;
+        point.hour = static_cast<int>(i % 24);
+        point.minute = static_cast<int>((i * 5) % 60);
+        point.dayOfWeek = static_cast<int>((i / 24) % 7);
+        point.outdoorTemp = 10.0 + 0.1 * i + offset;
+        point.solarProduction = 0.05 * i;
+        point.energyCost = 0.10 + 0.001 * i;
+        points.push_back(point);
+    }
+    return points;
+}
+
+bool samePoints(const std::deque<HistoricalDataPoint>& a, const std::deque<HistoricalDataPoint>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].hour != b[i].hour || a[i].minute != b[i].minute || a[i].dayOfWeek != b[i].dayOfWeek ||
+            a[i].outdoorTemp != b[i].outdoorTemp || a[i].solarProduction != b[i].solarProduction ||
+            a[i].energyCost != b[i].energyCost) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool fileExists(const std::string& path) {
+    return ::access(path.c_str(), F_OK) == 0;
+}
+
+long fileSize(const std::string& path) {
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 ? static_cast<long>(st.st_size) : -1;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+void waitForDurable(const DataJournal& journal, uint64_t sequence) {
+    while (journal.getDurableSequence() < sequence) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// Run body in a child process that exits without running destructors, so
+// the journal is never closed or compacted: the same state a crash leaves
+bool runAndCrash(void (*body)(const std::string&, const std::deque<HistoricalDataPoint>&),
+                 const std::string& path, const std::deque<HistoricalDataPoint>& points) {
+    std::cout.flush();
+    pid_t child = ::fork();
+    if (child == 0) {
+        body(path, points);
+        std::_Exit(0);
+    }
+    int status = 0;
+    return child > 0 && ::waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+JournalConfig crashJournalConfig() {
+    JournalConfig config;
+    config.groupCommitSize = 4;
+    config.groupCommitIntervalMs = 10;
+    config.compactionThreshold = 1000;   // Nothing is folded into the store on its own
+    return config;
+}
+
+// Journal every point, wait until all are durable, crash
+void journalAll(const std::string& path, const std::deque<HistoricalDataPoint>& points) {
+    auto store = std::make_shared<HistoricalDataStore>(path);
+    DataJournal journal(store, path + ".wal", crashJournalConfig());
+    std::deque<HistoricalDataPoint> recovered;
+    if (!journal.open(recovered)) {
+        std::_Exit(2);
+    }
+    for (const auto& point : points) {
+        journal.append(point);
+    }
+    waitForDurable(journal, points.size());
+    std::_Exit(0);
+}
+
+// Journal the first 6 points and fold them into the store, but keep a
+// copy of the journal from before the fold; journal the rest, crash
+void journalAcrossCompaction(const std::string& path, const std::deque<HistoricalDataPoint>& points) {
+    auto store = std::make_shared<HistoricalDataStore>(path);
+    DataJournal journal(store, path + ".wal", crashJournalConfig());
+    std::deque<HistoricalDataPoint> recovered;
+    if (!journal.open(recovered)) {
+        std::_Exit(2);
+    }
+    for (size_t i = 0; i < 6; i++) {
+        journal.append(points[i]);
+    }
+    waitForDurable(journal, 6);
+    std::ofstream(path + ".wal.before", std::ios::binary) << readFile(path + ".wal");
+    if (!journal.sync()) {
+        std::_Exit(3);
+    }
+    for (size_t i = 6; i < points.size(); i++) {
+        journal.append(points[i]);
+    }
+    waitForDurable(journal, points.size());
+    std::_Exit(0);
+}
+
+void removeFiles(const std::vector<std::string>& paths) {
+    for (const auto& path : paths) {
+        std::remove(path.c_str());
+    }
+}
+
+int main() {
+    printSeparator("Historical Data Persistence Test");
+
+    const std::string roundTrip = "persistence_test_roundtrip.bin";
+    const std::string corrupt = "persistence_test_corrupt.bin";
+    const std::string truncated = "persistence_test_truncated.bin";
+    const std::string migrated = "persistence_test_migrated.bin";
+    const std::string legacyCsv = "persistence_test_migrated.csv";
+    const std::string inPlaceCsv = "persistence_test_inplace.dat";
+    const std::string crashed = "persistence_test_crashed.bin";
+    const std::string dedup = "persistence_test_dedup.bin";
+    removeFiles({roundTrip, corrupt, corrupt + ".corrupt", truncated, truncated + ".corrupt",
+                 truncated + ".corrupt.1", migrated, legacyCsv, inPlaceCsv, inPlaceCsv + ".csv.bak",
+                 crashed, crashed + ".wal", dedup, dedup + ".wal", dedup + ".wal.before"});
+
+    DataCollectionConfig collectorConfig;
+    collectorConfig.maxDaysToRetain = 30;
+
+    // Step 1: Round trip
+    printSeparator("Step 1: Round Trip");
+
+    std::deque<HistoricalDataPoint> points = makePoints(100);
+    HistoricalDataStore writer(roundTrip);
+    check(writer.rewrite(points), "Wrote 100 points");
+    std::deque<HistoricalDataPoint> more = makePoints(10, 100.0);
+    check(writer.append(more, more.size()), "Appended 10 more");
+    points.insert(points.end(), more.begin(), more.end());
+
+    std::deque<HistoricalDataPoint> loaded;
+    HistoricalDataStore reader(roundTrip);
+    check(reader.load(loaded) && reader.getRecordCount() == 110, "Reloaded 110 committed records");
+    check(samePoints(points, loaded), "Every field, including minutes, survives the round trip");
+
+    // Step 2: Corrupt file
+    printSeparator("Step 2: Corrupt File Is Kept");
+
+    HistoricalDataStore(corrupt).rewrite(makePoints(50));
+    long corruptSize = fileSize(corrupt);
+    {
+        // Flip one byte inside a record; the header still looks fine
+        std::fstream file(corrupt, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(sizeof(HistoricalDataStore::Header) + 10 * sizeof(HistoricalDataStore::Record) + 12);
+        file.put('\x7f');
+    }
+
+    {
+        collectorConfig.persistenceFile = corrupt;
+        HistoricalDataCollector collector(collectorConfig);
+        check(collector.getDataPointCount() == 0, "The collector starts empty on a bad checksum");
+        check(fileExists(corrupt + ".corrupt") && fileSize(corrupt + ".corrupt") == corruptSize,
+              "The bad file was moved to .corrupt intact");
+
+        // 24 points trigger the periodic save that used to overwrite the file
+        std::deque<HistoricalDataPoint> fresh = makePoints(24);
+        for (const auto& point : fresh) {
+            collector.addDataPoint(point);
+        }
+    }
+    loaded.clear();
+    bool reloaded = HistoricalDataStore(corrupt).load(loaded);
+    check(reloaded && loaded.size() == 24,
+          "New points went to a new file (" + std::to_string(loaded.size()) + " records)");
+    check(fileSize(corrupt + ".corrupt") == corruptSize, "The .corrupt file was not touched by the save");
+
+    // Step 3: Truncated file
+    printSeparator("Step 3: Truncated File Is Kept");
+
+    HistoricalDataStore(truncated).rewrite(makePoints(100));
+    long cut = static_cast<long>(sizeof(HistoricalDataStore::Header) +
+                                 50 * sizeof(HistoricalDataStore::Record) + 7);
+    check(::truncate(truncated.c_str(), cut) == 0, "Cut the file to 50.2 of 100 records");
+    HistoricalDataStore truncatedStore(truncated);
+    loaded.clear();
+    check(!truncatedStore.load(loaded) && loaded.empty(), "Loading a truncated file fails");
+    check(truncatedStore.getCorruptPath() == truncated + ".corrupt" && fileSize(truncated + ".corrupt") == cut,
+          "It was kept as .corrupt");
+
+    // An appending writer that never loaded must not write over it either
+    HistoricalDataStore(truncated).rewrite(makePoints(10));
+    check(::truncate(truncated.c_str(), 40) == 0, "Cut the next file inside its header");
+    HistoricalDataStore appender(truncated);
+    std::deque<HistoricalDataPoint> tail = makePoints(5);
+    check(appender.append(tail, tail.size()) && appender.getCorruptPath() == truncated + ".corrupt.1" &&
+              fileSize(truncated + ".corrupt.1") == 40,
+          "append() moved the broken file to .corrupt.1 without reusing .corrupt");
+    loaded.clear();
+    check(HistoricalDataStore(truncated).load(loaded) && loaded.size() == 5,
+          "The new file holds the 5 appended points");
+
+    // Step 4: CSV migration
+    printSeparator("Step 4: CSV Migration");
+
+    {
+        // Written by a build before minutes and binary persistence
+        std::ofstream csv(legacyCsv);
+        csv << "hour,dayOfWeek,outdoorTemp,solarProduction,energyCost\n";
+        for (int i = 0; i < 30; i++) {
+            csv << i % 24 << "," << i / 24 << "," << 10 + i << ",0.5,0.12\n";
+        }
+    }
+    {
+        collectorConfig.persistenceFile = migrated;
+        HistoricalDataCollector collector(collectorConfig);
+        check(collector.getDataPointCount() == 30, "The CSV next to the missing .bin was imported");
+    }
+    loaded.clear();
+    check(HistoricalDataStore(migrated).load(loaded) && loaded.size() == 30 && loaded[29].outdoorTemp == 39.0,
+          "The imported points were written to the binary file");
+    check(fileExists(legacyCsv), "The CSV is left in place");
+    {
+        HistoricalDataCollector collector(collectorConfig);
+        check(collector.getDataPointCount() == 30, "The next start loads the binary file, not the CSV again");
+    }
+
+    {
+        // The persistence file itself still holds CSV
+        std::ofstream csv(inPlaceCsv);
+        csv << "hour,dayOfWeek,outdoorTemp,solarProduction,energyCost,minute\n";
+        for (int i = 0; i < 12; i++) {
+            csv << i << ",3,20,1.0,0.2," << 15 * (i % 4) << "\n";
+        }
+    }
+    {
+        collectorConfig.persistenceFile = inPlaceCsv;
+        HistoricalDataCollector collector(collectorConfig);
+        check(collector.getDataPointCount() == 12, "A CSV at the persistence path was imported");
+    }
+    loaded.clear();
+    check(HistoricalDataStore(inPlaceCsv).load(loaded) && loaded.size() == 12 && loaded[3].minute == 45,
+          "It was replaced by a binary file with the same points");
+    check(fileExists(inPlaceCsv + ".csv.bak") && !fileExists(inPlaceCsv + ".corrupt"),
+          "The CSV was kept as .csv.bak, not treated as corrupt");
+
+    // Step 5: Journal replay after a crash
+    printSeparator("Step 5: Journal Replay After a Crash");
+
+    std::deque<HistoricalDataPoint> journalPoints = makePoints(10, 50.0);
+    check(runAndCrash(journalAll, crashed, journalPoints), "A child journaled 10 points and died without closing");
+    loaded.clear();
+    check(!HistoricalDataStore(crashed).load(loaded) && fileSize(crashed + ".wal") > 0,
+          "Only the journal holds them");
+    {
+        auto store = std::make_shared<HistoricalDataStore>(crashed);
+        store->load(loaded);
+        DataJournal journal(store, crashed + ".wal", crashJournalConfig());
+        std::deque<HistoricalDataPoint> recovered;
+        check(journal.open(recovered) && samePoints(recovered, journalPoints),
+              "Reopening replays all 10 points in order");
+        check(store->getRecordCount() == 10 && store->getJournalSequence() == 10,
+              "Replay folded them into the store up to journal sequence 10");
+        journal.close();
+    }
+    {
+        auto store = std::make_shared<HistoricalDataStore>(crashed);
+        loaded.clear();
+        store->load(loaded);
+        DataJournal journal(store, crashed + ".wal", crashJournalConfig());
+        std::deque<HistoricalDataPoint> recovered;
+        check(journal.open(recovered) && recovered.empty() && samePoints(loaded, journalPoints),
+              "A second start replays nothing and the store holds each point once");
+    }
+
+    // Step 6: Sequence dedup
+    printSeparator("Step 6: Entries Already in the Store Are Skipped");
+
+    check(runAndCrash(journalAcrossCompaction, dedup, journalPoints),
+          "A child folded points 1-6 into the store, journaled 7-10 and died");
+    {
+        // A crash after the fold but before the journal was truncated leaves
+        // entries 1-6 in the journal and in the store
+        std::string before = readFile(dedup + ".wal.before");
+        std::string after = readFile(dedup + ".wal");
+        const size_t journalHeader = 16;
+        std::ofstream(dedup + ".wal", std::ios::binary | std::ios::trunc) << before << after.substr(journalHeader);
+    }
+    {
+        auto store = std::make_shared<HistoricalDataStore>(dedup);
+        loaded.clear();
+        check(store->load(loaded) && loaded.size() == 6 && store->getJournalSequence() == 6,
+              "The store holds 6 points and journal sequence 6");
+        DataJournal journal(store, dedup + ".wal", crashJournalConfig());
+        std::deque<HistoricalDataPoint> recovered;
+        bool opened = journal.open(recovered);
+        check(opened && recovered.size() == 4 && recovered.front().outdoorTemp == journalPoints[6].outdoorTemp,
+              "Replay skipped sequences 1-6 and recovered 7-10 (" + std::to_string(recovered.size()) + " points)");
+        journal.close();
+    }
+    loaded.clear();
+    check(HistoricalDataStore(dedup).load(loaded) && samePoints(loaded, journalPoints),
+          "The store ends with all 10 points, none duplicated");
+
+    removeFiles({roundTrip, corrupt, corrupt + ".corrupt", truncated, truncated + ".corrupt",
+                 truncated + ".corrupt.1", migrated, legacyCsv, inPlaceCsv, inPlaceCsv + ".csv.bak",
+                 crashed, crashed + ".wal", dedup, dedup + ".wal", dedup + ".wal.before"});
+
+    printSeparator("Test Summary");
+    if (failures == 0) {
+        std::cout << "✓ All persistence checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
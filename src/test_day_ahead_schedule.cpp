@@ -0,0 +1,138 @@
+// Test program for the slot-indexed day-ahead schedule
+#include "DayAheadSchedule.h"
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+// Every heap allocation in the program is counted
+static size_t allocations = 0;
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "✓ " : "✗ ") << description << std::endl;
+    failures += condition ? 0 : 1;
+}
+
+int main() {
+    printSeparator("Day-Ahead Schedule Test");
+
+    // Step 1: Slot buckets
+    printSeparator("Step 1: Slot Buckets and Hour Lookup");
+
+    DayAheadSchedule schedule(22 * 60, 60, 4);
+    ApplianceHandle ev = schedule.internAppliance("ev_1");
+    ApplianceHandle heater = schedule.internAppliance("heater_1");
+    check(schedule.internAppliance("ev_1") == ev && ev != heater, "Appliance IDs interned once");
+
+    schedule.addAction(0, ev, ActionType::CHARGE, 11.0, ActionReason::PLANNED_CHARGE, 0.08, 0.0);
+    schedule.addAction(0, heater, ActionType::OFF, 0.0, ActionReason::NO_HEATING_NEEDED, 0.08);
+    schedule.addAction(2, ev, ActionType::DEFER, 0.0, ActionReason::CHARGE_DEFERRED, 0.21);
+    check(schedule.getActionsForSlot(0).size() == 2 && schedule.getActionsForSlot(1).empty() &&
+              schedule.getActionsForSlot(2).size() == 1 && schedule.getActionsForSlot(3).empty(),
+          "Slots hold 2, 0, 1 and 0 actions");
+    check(schedule.getActionsForHour(0).size() == 1 && schedule.getActionsForHour(0)[0].type == ActionType::DEFER,
+          "Hour 0:00 maps to the third slot");
+    check(schedule.getActionsForHour(12).empty() && schedule.getActionsForSlot(9).empty(),
+          "Unknown hours and slots are empty");
+    check(schedule.getActionsAt(22, 45).size() == 2 && schedule.getSlotLabel(2) == "0:00",
+          "22:45 falls in the first slot, the third starts at 0:00");
+    check(!schedule.addAction(1, heater, ActionType::ON, 2.0, ActionReason::HEATING, 0.2, 21.0),
+          "Adding to an earlier slot is rejected");
+    schedule.addAction(3, heater, ActionType::ON, 2.5, ActionReason::HEATING, 0.19, 21.5);
+    check(schedule.getActionsForSlot(2).size() == 1 && schedule.getActionsForSlot(3).size() == 1 &&
+              schedule.getActionCount() == 4,
+          "Slot 2 closed when slot 3 was opened");
+
+    // Step 2: Reasons
+    printSeparator("Step 2: Lazily Formatted Reasons");
+
+    const ScheduledAction& charge = schedule.getActionsForSlot(0)[0];
+    check(schedule.getApplianceId(charge.appliance) == "ev_1" && std::string(toString(charge.type)) == "charge",
+          "ev_1: charge");
+    std::string reason = schedule.formatReason(charge);
+    check(reason == "Planned at $0.080000/kWh", "Reason: " + reason);
+    reason = schedule.formatReason(schedule.getActionsForSlot(3)[0]);
+    check(reason == "Indoor 21.500000°C, heating at $0.190000/kWh", "Reason: " + reason);
+    ScheduledAction sunny = charge;
+    sunny.detail = 6.5f;
+    reason = schedule.formatReason(sunny);
+    check(reason == "Planned at $0.080000/kWh, high solar (6.500000 kW)", "Reason: " + reason);
+
+    // Step 3: Hundreds of appliances
+    printSeparator("Step 3: 500 Appliances over 96 Slots");
+
+    const size_t slots = 96;
+    const size_t appliances = 500;
+    std::vector<std::string> ids;
+    for (size_t a = 0; a < appliances; ++a) {
+        ids.push_back("appliance_" + std::to_string(a));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    DayAheadSchedule large(0, 15, slots, slots * appliances);
+    std::vector<ApplianceHandle> handles;
+    handles.reserve(appliances);
+    for (const auto& id : ids) {
+        handles.push_back(large.internAppliance(id));
+    }
+    size_t before = allocations;
+    for (size_t slot = 0; slot < slots; ++slot) {
+        for (size_t a = 0; a < appliances; ++a) {
+            bool on = (slot + a) % 3 == 0;
+            large.addAction(slot, handles[a], on ? ActionType::ON : ActionType::OFF, on ? 1.5 : 0.0,
+                            on ? ActionReason::HEATING : ActionReason::NO_HEATING_NEEDED, 0.15, 21.0);
+        }
+    }
+    size_t added = allocations - before;
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    size_t found = 0;
+    for (int hour = 0; hour < 24; ++hour) {
+        found += large.getActionsForHour(hour).size();
+    }
+    for (size_t slot = 0; slot < slots; ++slot) {
+        found += large.getActionsForSlot(slot).size();
+    }
+    std::cout << "  " << large.getActionCount() << " actions built in " << buildMs << " ms" << std::endl;
+    check(added == 0, "No allocation while adding " + std::to_string(slots * appliances) + " actions");
+    check(found == 24 * appliances + slots * appliances, "Every slot holds all 500 appliances");
+    check(large.getApplianceId(large.getActionsForSlot(95)[499].appliance) == "appliance_499",
+          "Last action belongs to appliance_499");
+    check(large.getActionsAt(8, 20).begin() == large.getActionsForSlot(33).begin() &&
+              large.getSlotLabel(33) == "8:15",
+          "8:20 maps to the 8:15 slot");
+
+    printSeparator("Test Summary");
+    if (failures == 0) {
+        std::cout << "✓ All day-ahead schedule checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
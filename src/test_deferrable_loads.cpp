@@ -107,9 +107,10 @@ int main() {
     
     std::cout << "\nSample recommendations for key hours:" << std::endl;
     for (int hour : {8, 12, 18, 22}) {
-        if (recommendations.find(hour) != recommendations.end()) {
+        const auto& hourRecommendations = recommendations.at(hour);
+        if (!hourRecommendations.empty()) {
             std::cout << "\nHour " << hour << ":00" << std::endl;
-            for (const auto& rec : recommendations[hour]) {
+            for (const auto& rec : hourRecommendations) {
                 std::cout << "  - " << rec << std::endl;
             }
         }
@@ -126,8 +127,8 @@ int main() {
     auto schedule = dayAheadOptimizer->generateSchedule(currentHour, currentDayOfWeek);
     
     std::cout << "\n=== Generated Day-Ahead Schedule (with Deferrable Load Control) ===" << std::endl;
-    std::cout << "Total estimated cost: $" << schedule.estimatedCost << std::endl;
-    std::cout << "Total estimated consumption: " << schedule.estimatedConsumption << " kWh\n" << std::endl;
+    std::cout << "Total estimated cost: $" << schedule.getEstimatedCost() << std::endl;
+    std::cout << "Total estimated consumption: " << schedule.getEstimatedConsumption() << " kWh\n" << std::endl;
     
     // Show sample hours from schedule
     std::cout << "Sample schedule for key hours:" << std::endl;
@@ -136,11 +137,11 @@ int main() {
         if (!actions.empty()) {
             std::cout << "\nHour " << hour << ":00" << std::endl;
             for (const auto& action : actions) {
-                std::cout << "  - " << action.applianceId << ": " << action.action;
+                std::cout << "  - " << schedule.getApplianceId(action.appliance) << ": " << toString(action.type);
                 if (action.value != 0.0) {
                     std::cout << " (" << action.value << ")";
                 }
-                std::cout << " - " << action.reason << std::endl;
+                std::cout << " - " << schedule.formatReason(action) << std::endl;
             }
         }
     }
@@ -0,0 +1,88 @@
+// Test program for EnergyOptimizer event coalescing
+#include "EnergyOptimizer.h"
+#include "EventManager.h"
+#include "HTTPClient.h"
+#include "Heater.h"
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <string>
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "✓ " : "✗ ") << description << std::endl;
+    failures += condition ? 0 : 1;
+}
+
+// A burst of indoor readings ending at finalTemp, plus solar updates
+void publishBurst(int count, double finalTemp) {
+    auto& events = EventManager::getInstance();
+    for (int i = 0; i < count; ++i) {
+        Event temperature(EventType::TEMPERATURE_CHANGE, "temp_indoor_" + std::to_string(i % 3));
+        temperature.addData(EventKey::TEMPERATURE, i == count - 1 ? finalTemp : 25.0);
+        temperature.addData(EventKey::LOCATION, 0.0);
+        events.publish(temperature);
+
+        Event solar(EventType::SOLAR_PRODUCTION_UPDATE, "solar_1");
+        solar.addData(EventKey::PRODUCTION_KW, 0.1 * i);
+        events.publish(solar);
+    }
+}
+
+int main() {
+    printSeparator("EnergyOptimizer Coalescing Test");
+
+    auto& events = EventManager::getInstance();
+    EnergyOptimizer optimizer(std::make_shared<HTTPClient>("https://api.energyprices.example/v1"));
+    auto heater = std::make_shared<Heater>("heater_1", "Heater", 2.0);
+    optimizer.addAppliance(heater);
+    optimizer.setTargetTemperature(22.0);
+
+    // Step 1: Synchronous delivery
+    printSeparator("Step 1: Synchronous Burst");
+
+    check(events.getDispatchMode() == DispatchMode::SYNCHRONOUS, "EventManager is in its default synchronous mode");
+    publishBurst(50, 18.0);
+    check(optimizer.getOptimizationRunCount() == 0, "100 events ran no optimization pass on their own");
+    check(optimizer.processPendingUpdates(), "The tick found pending updates");
+    check(optimizer.getOptimizationRunCount() == 1, "One optimization pass for the whole burst");
+    check(heater->isOn(), "The pass used the newest reading (18 °C turns the heater on)");
+    check(!optimizer.processPendingUpdates() && optimizer.getOptimizationRunCount() == 1,
+          "A tick without new events does not run again");
+
+    Event consumption(EventType::ENERGY_CONSUMPTION_UPDATE, "energy_meter_1");
+    consumption.addData(EventKey::CONSUMPTION_KW, 3.0);
+    events.publish(consumption);
+    check(!optimizer.processPendingUpdates(), "Consumption updates alone do not trigger a pass");
+
+    // Step 2: Asynchronous delivery
+    printSeparator("Step 2: Asynchronous Burst");
+
+    // The burst interleaves three indoor sensors and ends on temp_indoor_1.
+    // Only its final reading is below the setpoint, so the heater shows
+    // which value the batch left applied.
+    heater->turnOff();
+    events.setCoalescingWindow(std::chrono::milliseconds(5));
+    events.startAsyncDispatch();
+    publishBurst(50, 18.0);
+    events.stopAsyncDispatch();
+    check(optimizer.processPendingUpdates(), "The tick found the async batches");
+    check(optimizer.getOptimizationRunCount() == 2, "Still one pass for the burst");
+    check(heater->isOn(), "The newest reading was applied, not an older one from another sensor");
+    check(!optimizer.processPendingUpdates(), "Nothing left pending afterwards");
+
+    printSeparator("Test Summary");
+    if (failures == 0) {
+        std::cout << "✓ All energy optimizer checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
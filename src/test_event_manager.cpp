@@ -0,0 +1,215 @@
+// Test program for EventManager asynchronous dispatch
+#include "EventManager.h"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "✓ " : "✗ ") << description << std::endl;
+    failures += condition ? 0 : 1;
+}
+
+// Subscriptions cannot be removed from the singleton, so one recorder
+// serves every step and is reset between them
+struct Recorder {
+    std::mutex mutex;
+    std::map<std::string, long> lastSequence;
+    size_t received = 0;
+    size_t outOfOrder = 0;
+
+    void record(const Event& event) {
+        std::lock_guard<std::mutex> lock(mutex);
+        long sequence = static_cast<long>(event.getData(EventKey::TEMPERATURE));
+        auto last = lastSequence.find(event.source);
+        if (last != lastSequence.end() && sequence <= last->second) {
+            outOfOrder++;
+        }
+        lastSequence[event.source] = sequence;
+        received++;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        lastSequence.clear();
+        received = 0;
+        outOfOrder = 0;
+    }
+
+    size_t count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return received;
+    }
+};
+
+Event makeEvent(EventType type, const std::string& source, long sequence) {
+    Event event(type, source);
+    event.addData(EventKey::TEMPERATURE, static_cast<double>(sequence));
+    return event;
+}
+
+int main() {
+    printSeparator("EventManager Async Dispatch Test");
+
+    auto& events = EventManager::getInstance();
+    Recorder recorder;
+    events.subscribe(EventType::TEMPERATURE_CHANGE, [&](const Event& event) { recorder.record(event); });
+
+    // ENERGY_COST_UPDATE parks the dispatcher until the gate opens
+    std::atomic<bool> gateOpen(true);
+    std::atomic<bool> dispatcherParked(false);
+    events.subscribe(EventType::ENERGY_COST_UPDATE, [&](const Event&) {
+        dispatcherParked = true;
+        while (!gateOpen) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    // Step 1: Full queue
+    printSeparator("Step 1: Full Queue Drops New Events");
+
+    events.startAsyncDispatch(8);
+    check(events.getDispatchMode() == DispatchMode::ASYNCHRONOUS, "Async dispatch started");
+    gateOpen = false;
+    events.publish(Event(EventType::ENERGY_COST_UPDATE, "blocker"));
+    while (!dispatcherParked) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    size_t droppedBefore = events.getDroppedEventCount();
+    for (long i = 0; i < 20; ++i) {
+        events.publish(makeEvent(EventType::TEMPERATURE_CHANGE, "full", i));
+    }
+    size_t dropped = events.getDroppedEventCount() - droppedBefore;
+    check(dropped == 12, "8-slot ring accepted 8 of 20 events (" + std::to_string(dropped) + " dropped)");
+    gateOpen = true;
+    events.stopAsyncDispatch();
+    check(recorder.count() == 8 && recorder.outOfOrder == 0, "The 8 accepted events were delivered in order");
+    check(recorder.lastSequence["full"] == 7, "The newest events were the ones dropped");
+
+    // Step 2: Ordering
+    printSeparator("Step 2: Per-Producer Ordering (MPSC)");
+
+    recorder.reset();
+    droppedBefore = events.getDroppedEventCount();
+    // A larger capacity replaces the 8-slot ring on restart
+    events.startAsyncDispatch(1 << 15);
+    const int producers = 4;
+    const long perProducer = 5000;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&events, p, perProducer] {
+            std::string source = "producer_" + std::to_string(p);
+            for (long i = 0; i < perProducer; ++i) {
+                events.publish(makeEvent(EventType::TEMPERATURE_CHANGE, source, i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    events.stopAsyncDispatch();
+    check(events.getDroppedEventCount() == droppedBefore, "Nothing dropped with a large enough ring");
+    check(recorder.count() == static_cast<size_t>(producers * perProducer),
+          "All " + std::to_string(producers * perProducer) + " events delivered (" +
+              std::to_string(recorder.count()) + ")");
+    check(recorder.outOfOrder == 0, "Each producer's events arrived in publish order");
+
+    // Step 3: Stop and restart under load
+    printSeparator("Step 3: Stop/Restart While Publishing");
+
+    recorder.reset();
+    droppedBefore = events.getDroppedEventCount();
+    std::atomic<bool> publishing(true);
+    std::atomic<size_t> published(0);
+    threads.clear();
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            std::string source = "racer_" + std::to_string(p);
+            for (long i = 0; publishing; ++i) {
+                events.publish(makeEvent(EventType::TEMPERATURE_CHANGE, source, i));
+                published++;
+            }
+        });
+    }
+    // Restarts with a small ring, and once with a larger one that replaces it
+    // while publishers are running
+    for (int cycle = 0; cycle < 100; ++cycle) {
+        events.startAsyncDispatch(cycle == 50 ? (1 << 16) : 64);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        events.stopAsyncDispatch();
+    }
+    publishing = false;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    size_t lost = published - recorder.count() - (events.getDroppedEventCount() - droppedBefore);
+    std::cout << "  Published " << published << ", delivered " << recorder.count() << ", dropped "
+              << events.getDroppedEventCount() - droppedBefore << std::endl;
+    check(lost == 0, "Every event was delivered or counted as dropped across 100 restarts");
+
+    // Step 4: Back to synchronous
+    printSeparator("Step 4: Synchronous After Stop");
+
+    recorder.reset();
+    check(events.getDispatchMode() == DispatchMode::SYNCHRONOUS, "Dispatch mode is synchronous again");
+    events.publish(makeEvent(EventType::TEMPERATURE_CHANGE, "sync", 0));
+    check(recorder.count() == 1, "publish() delivers before returning");
+    events.stopAsyncDispatch();
+    check(true, "Stopping twice is harmless");
+
+    // Step 5: Stop requested by a handler
+    printSeparator("Step 5: Stop From the Dispatcher Thread");
+
+    std::atomic<int> handlerStop(-1);
+    events.subscribe(EventType::SOLAR_PRODUCTION_UPDATE, [&](const Event&) {
+        handlerStop = events.stopAsyncDispatch() ? 1 : 0;
+    });
+    events.startAsyncDispatch();
+    events.publish(Event(EventType::SOLAR_PRODUCTION_UPDATE, "stopper"));
+    while (handlerStop < 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    check(handlerStop == 0, "stopAsyncDispatch() from a handler is refused instead of joining itself");
+    check(events.getDispatchMode() == DispatchMode::ASYNCHRONOUS, "The dispatcher keeps running");
+    check(events.stopAsyncDispatch() && events.getDispatchMode() == DispatchMode::SYNCHRONOUS,
+          "Stopping from another thread still works");
+
+    // Step 6: Batch order
+    printSeparator("Step 6: Interleaved Sources in One Batch");
+
+    std::vector<Event> batch;
+    events.subscribeBatch({EventType::EV_CHARGER_STATUS}, [&](const std::vector<Event>& events) {
+        batch.insert(batch.end(), events.begin(), events.end());
+    });
+    events.setCoalescingWindow(std::chrono::milliseconds(50));
+    events.startAsyncDispatch();
+    events.publish(makeEvent(EventType::EV_CHARGER_STATUS, "A", 1));
+    events.publish(makeEvent(EventType::EV_CHARGER_STATUS, "B", 2));
+    events.publish(makeEvent(EventType::EV_CHARGER_STATUS, "A", 3));
+    events.stopAsyncDispatch();
+    events.setCoalescingWindow(std::chrono::milliseconds(0));
+    check(batch.size() == 2, "A=1, B=2, A=3 coalesce to one event per source (" +
+          std::to_string(batch.size()) + ")");
+    check(batch.size() == 2 && batch[0].source == "B" && batch[1].getData(EventKey::TEMPERATURE) == 3.0,
+          "The batch ends on the newest event, A=3, so applying it in order leaves 3");
+
+    printSeparator("Test Summary");
+    if (failures == 0) {
+        std::cout << "✓ All event manager checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+// Test program for the inline Event payload and interned keys
+#include "Event.h"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "✓ " : "✗ ") << description << std::endl;
+    failures += condition ? 0 : 1;
+}
+
+int main() {
+    printSeparator("Event Payload Test");
+
+    // Step 1: String-keyed compatibility API
+    printSeparator("Step 1: String Key Round Trip");
+
+    Event reading(EventType::TEMPERATURE_CHANGE, "temp_indoor_1");
+    check(reading.addData("temperature", 21.5), "addData(\"temperature\") accepted");
+    check(reading.getData("temperature") == 21.5, "getData(\"temperature\") returns the value");
+    check(reading.getData(EventKey::TEMPERATURE) == 21.5, "The string key resolves to the built-in EventKey");
+    check(reading.getData("location", -1.0) == -1.0 && !reading.hasData(EventKey::LOCATION),
+          "A missing key returns the default");
+    EventKey unknown;
+    check(reading.getData("never_added_key", 7.0) == 7.0 && !findEventKey("never_added_key", unknown),
+          "getData() with an unknown name does not intern it");
+
+    // Step 2: Overwriting
+    printSeparator("Step 2: Overwriting a Key");
+
+    reading.addData(EventKey::TEMPERATURE, 22.0);
+    check(reading.getDataCount() == 1 && reading.getData("temperature") == 22.0,
+          "Adding an existing key overwrites it in place");
+    reading.addData("temperature", 23.0);
+    check(reading.getDataCount() == 1 && reading.getData(EventKey::TEMPERATURE) == 23.0,
+          "The string and enum APIs overwrite the same slot");
+
+    // Step 3: Capacity
+    printSeparator("Step 3: Full Payload");
+
+    Event full(EventType::ENERGY_CONSUMPTION_UPDATE, "meter");
+    bool accepted = true;
+    for (size_t i = 0; i < static_cast<size_t>(EventKey::BUILTIN_COUNT); ++i) {
+        accepted = full.addData(static_cast<EventKey>(i), static_cast<double>(i)) && accepted;
+    }
+    accepted = full.addData("payload_extra_1", 100.0) && accepted;
+    check(accepted && full.getDataCount() == Event::MAX_DATA_ENTRIES,
+          "All " + std::to_string(Event::MAX_DATA_ENTRIES) + " slots filled");
+    check(!full.addData("payload_extra_2", 200.0), "addData() returns false for a new key once full");
+    check(!full.addData(internEventKey("payload_extra_3"), 300.0), "Also through the EventKey overload");
+    check(full.getDataCount() == Event::MAX_DATA_ENTRIES && full.getData("payload_extra_2", -1.0) == -1.0,
+          "The rejected key was not stored");
+    check(full.addData(EventKey::LOCATION, 42.0) && full.getData(EventKey::LOCATION) == 42.0,
+          "Overwriting an existing key still succeeds when full");
+
+    // Step 4: Interned keys
+    printSeparator("Step 4: Interned Keys");
+
+    EventKey humidity = internEventKey("humidity");
+    check(static_cast<size_t>(humidity) >= static_cast<size_t>(EventKey::BUILTIN_COUNT),
+          "A non-builtin name gets an ID above the built-in keys");
+    check(internEventKey("humidity") == humidity, "Interning the same name again returns the same ID");
+    check(internEventKey("temperature") == EventKey::TEMPERATURE, "Built-in names are never interned");
+    check(eventKeyName(humidity) == "humidity", "eventKeyName() maps the ID back to its name");
+
+    Event first(EventType::TEMPERATURE_CHANGE, "room_1");
+    Event second(EventType::TEMPERATURE_CHANGE, "room_2");
+    first.addData("humidity", 40.0);
+    second.addData("humidity", 55.0);
+    check(first.getDataEntry(0).key == humidity && second.getDataEntry(0).key == humidity,
+          "Events using the name store the same key");
+    check(second.getData(humidity) == 55.0 && first.getData("humidity") == 40.0,
+          "Either API reads it back from each event");
+
+    // Concurrent interning: every thread sees one ID per name
+    const int threads = 4;
+    const int names = 50;
+    std::vector<std::vector<EventKey>> seen(threads, std::vector<EventKey>(names));
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&seen, t, names] {
+            for (int n = 0; n < names; ++n) {
+                seen[t][n] = internEventKey("concurrent_" + std::to_string(n));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    bool consistent = true;
+    for (int n = 0; n < names; ++n) {
+        for (int t = 1; t < threads; ++t) {
+            consistent = consistent && seen[t][n] == seen[0][n];
+        }
+        consistent = consistent && eventKeyName(seen[0][n]) == "concurrent_" + std::to_string(n);
+    }
+    check(consistent, std::to_string(threads) + " threads interning " + std::to_string(names) +
+          " names agree on every ID");
+
+    printSeparator("Test Summary");
+    if (failures == 0) {
+        std::cout << "✓ All event payload checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,313 @@
+// Test program for HABridge: sensor events mirrored to Home Assistant over the loopback broker
+#include "HABridge.h"
+#include "HAIntegration.h"
+#include "MQTTClient.h"
+#include "MQTTLoopbackBroker.h"
+#include "TemperatureSensor.h"
+#include "EnergyMeter.h"
+#include "SolarSensor.h"
+#include "EVChargerSensor.h"
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <string>
+#include <vector>
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "✓ " : "✗ ") << description << std::endl;
+    failures += condition ? 0 : 1;
+}
+
+// Poll until the condition holds or the timeout expires
+bool waitUntil(std::function<bool()> condition, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+// Latest payload per topic plus message counts, as seen by a plain subscriber
+struct Received {
+    std::mutex mutex;
+    std::map<std::string, std::string> latest;
+    size_t discovery = 0;
+    size_t states = 0;
+
+    std::string get(const std::string& topic) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = latest.find(topic);
+        return it == latest.end() ? "" : it->second;
+    }
+
+    size_t stateCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return states;
+    }
+
+    size_t discoveryCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return discovery;
+    }
+};
+
+// A sensor type the bridge has never heard of
+class EVBatterySensor : public Sensor {
+public:
+    EVBatterySensor(const std::string& id, const std::string& name) : Sensor(id, name), soc_(0.0) {}
+
+    void update() override {
+        Event event(EventType::EV_CHARGER_STATUS, id_);
+        event.addData("soc_percent", soc_);
+        publishEvent(event);
+    }
+
+    void setStateOfCharge(double soc) { soc_ = soc; }
+
+private:
+    double soc_;
+};
+
+int main() {
+    printSeparator("HABridge Test");
+
+    // Step 1: Broker, bridge and an observing subscriber
+    printSeparator("Step 1: Start Broker and Bridge");
+
+    MQTTLoopbackBroker broker;
+    if (!broker.start()) {
+        std::cerr << "✗ Could not start loopback broker" << std::endl;
+        return 1;
+    }
+
+    auto publisher = std::make_shared<MQTTClient>("127.0.0.1", broker.getPort());
+    auto observer = std::make_shared<MQTTClient>("127.0.0.1", broker.getPort());
+    if (!publisher->connect() || !observer->connect()) {
+        std::cerr << "✗ Connection failed" << std::endl;
+        return 1;
+    }
+
+    Received received;
+    observer->subscribe("homeassistant/#", [&received](const std::string& topic, const std::string& payload) {
+        std::lock_guard<std::mutex> lock(received.mutex);
+        received.latest[topic] = payload;
+        bool isDiscovery = topic.size() > 7 && topic.compare(topic.size() - 7, 7, "/config") == 0;
+        (isDiscovery ? received.discovery : received.states)++;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    HAPublishConfig publishConfig;
+    publishConfig.verboseLogging = false;
+    auto integration = std::make_shared<HAIntegration>(publisher, "homeassistant", publishConfig);
+
+    HABridgeConfig bridgeConfig;
+    bridgeConfig.flushIntervalMs = 50;
+    bridgeConfig.maxBatchSize = 20;
+    bridgeConfig.maxPublishesPerSecond = 200.0;
+    HABridge bridge(integration, bridgeConfig);
+    bridge.start();
+    std::cout << "✓ Bridge started" << std::endl;
+
+    // Step 2: Existing sensor types appear without any bridge code
+    printSeparator("Step 2: Automatic Discovery");
+
+    TemperatureSensor indoor("temp_indoor_1", "Living Room Temperature", TemperatureSensor::Location::INDOOR);
+    EnergyMeter meter("energy_meter_1", "Main Energy Meter");
+    SolarSensor solar("solar_1", "Solar Production");
+    EVChargerSensor charger("ev_charger_1", "EV Charger Status");
+
+    indoor.setTemperature(22.5);
+    meter.setConsumption(3.5);
+    solar.setProduction(5.2);
+    charger.setCharging(true, 11.0);
+    for (int round = 0; round < 3; ++round) {
+        indoor.update();
+        meter.update();
+        solar.update();
+        charger.update();
+    }
+
+    bool delivered = waitUntil([&] { return received.discoveryCount() == 5 && received.stateCount() == 5; }, 2000);
+    check(delivered, std::to_string(received.discoveryCount()) + " discovery configs and " +
+          std::to_string(received.stateCount()) + " states for 4 sensors (location is not an entity)");
+
+    std::string discovery = received.get("homeassistant/sensor/home_automation/temp_indoor_1_temperature/config");
+    check(discovery.find("\"state_topic\": \"homeassistant/state/sensor.temp_indoor_1_temperature\"") != std::string::npos &&
+          discovery.find("\"unit_of_measurement\": \"°C\"") != std::string::npos,
+          "Generated discovery: " + discovery);
+    check(received.get("homeassistant/state/sensor.temp_indoor_1_temperature") == "22.5", "Temperature state is 22.5");
+    check(received.get("homeassistant/state/binary_sensor.ev_charger_1_charging") == "ON",
+          "Charging flag published as a binary_sensor");
+    check(bridge.getEntityId("ev_charger_1", EventKey::CHARGE_POWER_KW) == "sensor.ev_charger_1_charge_power",
+          "Entity IDs derived from the source ID");
+
+    // Step 3: New sensors and new sensor types
+    printSeparator("Step 3: Sensors Added Later");
+
+    TemperatureSensor bedroom("temp_bedroom", "Bedroom Temperature", TemperatureSensor::Location::INDOOR);
+    EVBatterySensor battery("ev_battery_1", "EV Battery");
+    TemperatureSensor garage("temp_garage", "Garage Temperature", TemperatureSensor::Location::INDOOR);
+    bridge.setObjectId("temp_garage", EventKey::TEMPERATURE, "local_temp_garage");
+    bedroom.setTemperature(19.0);
+    battery.setStateOfCharge(64.0);
+    garage.setTemperature(12.0);
+    bedroom.update();
+    battery.update();
+    garage.update();
+
+    delivered = waitUntil([&] { return received.get("homeassistant/state/sensor.ev_battery_1_soc_percent") == "64"; }, 2000);
+    check(delivered && received.get("homeassistant/state/sensor.temp_bedroom_temperature") == "19",
+          "New instance and new event key published without configuration");
+    delivered = waitUntil([&] { return received.get("homeassistant/state/sensor.local_temp_garage") == "12"; }, 2000);
+    check(delivered && bridge.getEntityId("temp_garage", EventKey::TEMPERATURE) == "sensor.local_temp_garage" &&
+          received.get("homeassistant/sensor/home_automation/local_temp_garage/config").find(
+              "\"object_id\": \"local_temp_garage\"") != std::string::npos,
+          "A pinned object ID keeps an existing entity ID");
+    check(received.discoveryCount() == 8 && bridge.getStats().discoveryPublished == 8,
+          "Discovery sent once per entity: " + std::to_string(received.discoveryCount()));
+
+    // Step 4: Discovery and states survive broker and connection loss
+    printSeparator("Step 4: Broker Restart and MQTT Outage");
+
+    // Retained configs reach subscribers that connect later, like HA after a restart
+    auto countRetained = [&broker]() {
+        MQTTClient late("127.0.0.1", broker.getPort());
+        std::atomic<size_t> configs(0);
+        if (!late.connect()) {
+            return static_cast<size_t>(0);
+        }
+        late.subscribe("homeassistant/+/home_automation/+/config", [&configs](const std::string&, const std::string&) {
+            configs++;
+        });
+        waitUntil([&configs] { return configs == 8; }, 1000);
+        late.disconnect();
+        return configs.load();
+    };
+    size_t retained = countRetained();
+    check(retained == 8, "A late subscriber receives all 8 retained configs (" + std::to_string(retained) + ")");
+
+    // A broker without persistence comes back empty
+    broker.dropConnections(true);
+    bool reconnected = waitUntil([&] {
+        return publisher->getStats().reconnects == 1 && observer->getStats().reconnects == 1;
+    }, 5000);
+    check(reconnected, "Publisher and observer reconnected");
+    delivered = waitUntil([&] { return integration->getPublishStats().discoveryPublished == 16; }, 2000);
+    retained = countRetained();
+    check(delivered && retained == 8, "The reconnect republished every config (" + std::to_string(retained) +
+          " retained again)");
+
+    // States that cannot be sent are kept and retried, not counted as suppressed
+    HABridgeStats beforeOutage = bridge.getStats();
+    publisher->disconnect();
+    indoor.setTemperature(24.0);
+    indoor.update();
+    delivered = waitUntil([&] { return bridge.getStats().statesFailed > beforeOutage.statesFailed; }, 2000);
+    HABridgeStats outage = bridge.getStats();
+    check(delivered && outage.statesSuppressed == beforeOutage.statesSuppressed && outage.pending == 1,
+          "A failed publish is counted as failed and stays queued");
+    indoor.setTemperature(24.5);
+    indoor.update();
+    publisher->connect();
+    delivered = waitUntil([&] {
+        return received.get("homeassistant/state/sensor.temp_indoor_1_temperature") == "24.5";
+    }, 5000);
+    check(delivered && bridge.getStats().pending == 0, "After reconnecting the newest value was sent");
+
+    // Step 5: Many sensor threads against the rate limit
+    printSeparator("Step 5: Sensor Threads Never Wait on MQTT");
+
+    const size_t threads = 4;
+    const size_t sensorsPerThread = 50;
+    const size_t updatesPerThread = 20000;
+    std::vector<std::unique_ptr<TemperatureSensor>> loadSensors;
+    for (size_t i = 0; i < threads * sensorsPerThread; ++i) {
+        loadSensors.emplace_back(new TemperatureSensor("load_" + std::to_string(i), "Load",
+                                                       TemperatureSensor::Location::INDOOR));
+    }
+
+    HABridgeStats before = bridge.getStats();
+    std::atomic<long long> updateNs(0);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            auto begin = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < updatesPerThread; ++i) {
+                TemperatureSensor& sensor = *loadSensors[t * sensorsPerThread + i % sensorsPerThread];
+                sensor.setTemperature(18.0 + static_cast<double>(i % 40));
+                sensor.update();
+            }
+            updateNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - begin).count();
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    HABridgeStats during = bridge.getStats();
+    size_t updates = threads * updatesPerThread;
+    std::cout << "  update(): " << static_cast<double>(updateNs.load()) / updates << " ns per call" << std::endl;
+    std::cout << "  " << during.eventsReceived - before.eventsReceived << " events, "
+              << during.eventsOverflowed - before.eventsOverflowed << " overflowed, "
+              << during.statesCoalesced - before.statesCoalesced << " coalesced, "
+              << during.statesPublished - before.statesPublished << " published in "
+              << during.batches - before.batches << " batches, " << during.pending << " waiting" << std::endl;
+
+    check(during.eventsReceived - before.eventsReceived == updates, "Every sensor update reached the bridge");
+    check(during.statesPublished - before.statesPublished <= bridgeConfig.maxPublishesPerSecond * elapsed +
+          bridgeConfig.maxBatchSize, "Publish rate stays within the token bucket");
+    check(during.pending > 0, "Entities beyond the rate limit wait in the queue");
+
+    // Step 6: stop() flushes what is still waiting
+    printSeparator("Step 6: Final Flush on Stop");
+
+    indoor.setTemperature(23.0);
+    indoor.update();
+    bridge.stop();
+    HABridgeStats stopped = bridge.getStats();
+    check(stopped.pending == 0, "Nothing left waiting after stop()");
+
+    size_t expectedStates = stopped.statesPublished;
+    delivered = waitUntil([&] { return received.stateCount() == expectedStates; }, 5000);
+    check(delivered, "Observer received every published state: " + std::to_string(received.stateCount()));
+    check(received.get("homeassistant/state/sensor.temp_indoor_1_temperature") == "23",
+          "Last value before stop() was sent");
+    check(received.get("homeassistant/state/sensor.load_0_temperature") == "48",
+          "Load sensors end on their final value");
+
+    indoor.setTemperature(30.0);
+    indoor.update();
+    check(bridge.getStats().eventsReceived == stopped.eventsReceived, "Events after stop() are ignored");
+
+    publisher->disconnect();
+    observer->disconnect();
+    broker.stop();
+
+    printSeparator("Test Summary");
+    if (failures == 0) {
+        std::cout << "✓ All bridge checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+// Test program for HAHistoryBackfill against the in-process HAStubServer
+#include "HAHistoryBackfill.h"
+#include "HARestClient.h"
+#include "HAStubServer.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <ctime>
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "✓ " : "✗ ") << description << std::endl;
+    failures += condition ? 0 : 1;
+}
+
+bool near(double a, double b) {
+    return std::fabs(a - b) < 1e-9;
+}
+
+const long HOUR = 3600;
+
+// Fixture entities the stub generates history for (index % 5: 0 temperature, 1 power)
+const std::string OUTDOOR = "sensor.room_0_temperature";
+const std::string SOLAR = "sensor.circuit_1_power";
+const std::string COST = "sensor.room_5_temperature";
+
+// Request path of the window starting at timestamp, as the stub sees it (percent-decoded)
+std::string historyPath(long timestamp) {
+    std::time_t t = timestamp;
+    std::tm utc;
+    gmtime_r(&t, &utc);
+    char text[40];
+    std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S+00:00", &utc);
+    return std::string("/api/history/period/") + text;
+}
+
+std::string entry(const std::string& entityId, const std::string& state, long timestamp) {
+    std::time_t t = timestamp;
+    std::tm utc;
+    gmtime_r(&t, &utc);
+    char text[40];
+    std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S.000000+00:00", &utc);
+    return "{\"entity_id\":\"" + entityId + "\",\"state\":\"" + state + "\",\"last_changed\":\"" + text + "\"}";
+}
+
+int main() {
+    printSeparator("HAHistoryBackfill Test");
+
+    // 2024-01-15 00:00 UTC, 24 hours in four 6-hour windows
+    const long start = 1705276800;
+    const long end = start + 24 * HOUR;
+
+    HAStubServerConfig serverConfig;
+    serverConfig.historyEntries = 12;   // A state change every 30 minutes in generated windows
+    HAStubServer server(serverConfig);
+    if (!server.start()) {
+        std::cout << "✗ Could not start HAStubServer" << std::endl;
+        return 1;
+    }
+
+    // Window 1: hand-written history with known hourly means
+    //   outdoor: 10 for 30 min, 20 until 03:00, unavailable until 04:00, then 5
+    //   solar:   1.5 throughout
+    //   cost:    0.2 until 02:15, then 0.4
+    server.setResponse(historyPath(start),
+        "[[" + entry(OUTDOOR, "10", start) + "," + entry(OUTDOOR, "20", start + HOUR / 2) + "," +
+        entry(OUTDOOR, "unavailable", start + 3 * HOUR) + "," + entry(OUTDOOR, "5", start + 4 * HOUR) + "],[" +
+        entry(SOLAR, "1.5", start) + "],[" +
+        entry(COST, "0.2", start) + "," + entry(COST, "0.4", start + 2 * HOUR + HOUR / 4) + "]]");
+    // Window 2 fails once and succeeds on the first retry
+    server.failRequests(historyPath(start + 6 * HOUR), 1);
+    // Window 3 fails every attempt
+    server.failRequests(historyPath(start + 12 * HOUR), 3, 500);
+    // Window 4 is served from the generated fixture
+
+    HARestClientConfig clientConfig;
+    clientConfig.verboseLogging = false;
+    auto client = std::make_shared<HARestClient>(server.getBaseUrl(), "token", clientConfig);
+
+    HistoryBackfillConfig config;
+    config.outdoorTempEntity = OUTDOOR;
+    config.solarProductionEntity = SOLAR;
+    config.energyCostEntity = COST;
+    config.windowHours = 6;
+    config.maxParallelRequests = 2;
+    config.maxRetries = 2;
+    config.retryDelayMs = 10;
+    HAHistoryBackfill backfill(client, config);
+
+    std::vector<HistoricalDataPoint> points = backfill.run(start, end);
+    HistoryBackfillStats stats = backfill.getStats();
+
+    // Step 1: Windowing
+    printSeparator("Step 1: Windowing");
+
+    check(stats.windows == 4, "24 hours split into 4 windows of 6 hours (" + std::to_string(stats.windows) + ")");
+    check(server.getStats().requests == 4 + 1 + 2, "One request per window plus 3 retries (" +
+          std::to_string(server.getStats().requests) + " requests)");
+
+    // Step 2: Retries and failed windows
+    printSeparator("Step 2: Retries and Failed Windows");
+
+    check(stats.retries == 3, "Window 2 retried once, window 3 twice (" + std::to_string(stats.retries) + " retries)");
+    check(stats.failedWindows == 1, "Only window 3 reported as failed (" + std::to_string(stats.failedWindows) + ")");
+    check(points.size() == 17, "5 + 6 + 0 + 6 hourly points (" + std::to_string(points.size()) + ")");
+
+    // Step 3: Resampling onto the hourly grid
+    printSeparator("Step 3: Resampling");
+
+    auto hourOf = [](long timestamp) {
+        std::time_t t = timestamp;
+        std::tm local;
+        localtime_r(&t, &local);
+        return local.tm_hour;
+    };
+    if (points.size() == 17) {
+        check(points[0].hour == hourOf(start) && near(points[0].outdoorTemp, 15.0),
+              "Hour 1 outdoor is the time-weighted mean of 10 and 20 (" + std::to_string(points[0].outdoorTemp) + ")");
+        check(near(points[1].outdoorTemp, 20.0) && near(points[1].solarProduction, 1.5),
+              "A state holds until the next change");
+        check(near(points[2].energyCost, 0.35), "Hour 3 cost weighs 0.2 for 15 min and 0.4 for 45 min (" +
+              std::to_string(points[2].energyCost) + ")");
+        check(points[3].hour == hourOf(start + 4 * HOUR) && near(points[3].outdoorTemp, 5.0),
+              "The unavailable hour is skipped, not averaged as 0");
+        check(near(points[4].outdoorTemp, 5.0) && near(points[4].energyCost, 0.4),
+              "The last state holds to the end of the window");
+        // Generated temperatures step by 0.1 every 30 minutes from 18.0
+        check(points[5].hour == hourOf(start + 6 * HOUR) && near(points[5].outdoorTemp, 18.05),
+              "The retried window starts at hour 7 with the mean of two samples (" +
+              std::to_string(points[5].outdoorTemp) + ")");
+        check(points[11].hour == hourOf(start + 18 * HOUR),
+              "Hours 13-18 of the failed window are missing, hour 19 follows");
+    }
+
+    server.stop();
+
+    printSeparator("Test Summary");
+    if (failures == 0) {
+        std::cout << "✓ All history backfill checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+// Test program for HAIntegration state publishing over the loopback broker
+#include "HAIntegration.h"
+#include "MQTTClient.h"
+#include "MQTTLoopbackBroker.h"
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "✓ " : "✗ ") << description << std::endl;
+    failures += condition ? 0 : 1;
+}
+
+// Poll until the condition holds or the timeout expires
+bool waitUntil(std::function<bool()> condition, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+// Messages seen by a plain MQTT subscriber on the state topics
+struct Received {
+    std::mutex mutex;
+    std::vector<std::pair<std::string, std::string>> messages;
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return messages.size();
+    }
+
+    std::pair<std::string, std::string> last() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return messages.empty() ? std::make_pair(std::string(), std::string()) : messages.back();
+    }
+};
+
+int main() {
+    printSeparator("HAIntegration Publishing Test");
+
+    // Step 1: Broker, publisher and an observing subscriber
+    printSeparator("Step 1: Start Broker and Connect");
+
+    MQTTLoopbackBroker broker;
+    if (!broker.start()) {
+        std::cerr << "✗ Could not start loopback broker" << std::endl;
+        return 1;
+    }
+
+    auto publisher = std::make_shared<MQTTClient>("127.0.0.1", broker.getPort());
+    auto observer = std::make_shared<MQTTClient>("127.0.0.1", broker.getPort());
+    if (!publisher->connect() || !observer->connect()) {
+        std::cerr << "✗ Connection failed" << std::endl;
+        return 1;
+    }
+
+    Received received;
+    observer->subscribe("homeassistant/state/#", [&received](const std::string& topic, const std::string& payload) {
+        std::lock_guard<std::mutex> lock(received.mutex);
+        received.messages.emplace_back(topic, payload);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    HAPublishConfig publishConfig;
+    publishConfig.heartbeatSeconds = 1;
+    HAIntegration integration(publisher, "homeassistant", publishConfig);
+    std::cout << "✓ Publisher and observer connected" << std::endl;
+
+    // Step 2: Slow-moving temperature with a deadband
+    printSeparator("Step 2: Deadband on a Slow Temperature");
+
+    const std::string attributes = "{\"unit_of_measurement\": \"°C\", \"device_class\": \"temperature\"}";
+    integration.setDeadband("sensor.living_room_temperature", 0.2);
+
+    std::mt19937 random(42);
+    std::normal_distribution<double> step(0.0, 0.05);
+    double temperature = 21.0;
+    const size_t updates = 500;
+    for (size_t i = 0; i < updates; ++i) {
+        temperature += step(random);
+        integration.publishState("sensor.living_room_temperature", std::to_string(temperature), attributes);
+    }
+
+    HAPublishStats stats = integration.getPublishStats();
+    check(stats.published + stats.suppressed == updates,
+          std::to_string(stats.published) + " published, " + std::to_string(stats.suppressed) + " suppressed");
+    check(stats.published * 10 <= updates, "Broker traffic cut by at least 10x");
+    check(waitUntil([&] { return received.size() == stats.published; }, 2000),
+          "Observer received exactly the published updates");
+
+    // Step 3: Attributes only when they change
+    printSeparator("Step 3: Attributes Only on Change");
+
+    auto before = integration.getPublishStats();
+    integration.publishState("switch.heater", "off", "{\"friendly_name\": \"Heater\"}");
+    waitUntil([&] { return received.last().first == "homeassistant/state/switch.heater"; }, 2000);
+    check(received.last().second == "{\"state\": \"off\", \"attributes\": {\"friendly_name\": \"Heater\"}}",
+          "First publish carries attributes: " + received.last().second);
+
+    integration.publishState("switch.heater", "on", "{\"friendly_name\": \"Heater\"}");
+    waitUntil([&] { return received.last().second == "on"; }, 2000);
+    check(received.last().second == "on", "Unchanged attributes left out, plain state sent");
+
+    check(!integration.publishState("switch.heater", "on", "{\"friendly_name\": \"Heater\"}"),
+          "Repeated state suppressed");
+
+    integration.publishState("switch.heater", "on", "{\"friendly_name\": \"Heater\", \"power\": 2000}");
+    waitUntil([&] { return received.last().second.find("power") != std::string::npos; }, 2000);
+    check(received.last().second.find("\"power\": 2000") != std::string::npos,
+          "Changed attributes published with the same state");
+    auto after = integration.getPublishStats();
+    check(after.attributesPublished - before.attributesPublished == 2, "Two of three messages carried attributes");
+
+    // Step 4: Heartbeat
+    printSeparator("Step 4: Heartbeat");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    size_t messagesBefore = received.size();
+    check(integration.publishState("switch.heater", "on"), "Unchanged state republished once the heartbeat is due");
+    waitUntil([&] { return received.size() > messagesBefore; }, 2000);
+    check(received.last().second.find("\"attributes\"") != std::string::npos,
+          "Heartbeat carries the cached attributes");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    size_t heartbeats = integration.publishHeartbeats();
+    check(heartbeats == 2, "publishHeartbeats() refreshed " + std::to_string(heartbeats) + " silent entities");
+    check(integration.getPublishStats().heartbeats == 3, "Heartbeats counted separately");
+
+    // Step 5: Cache reset
+    printSeparator("Step 5: Cache Reset");
+
+    integration.resetPublishCache();
+    check(integration.publishState("switch.heater", "on"), "Everything is republished after a reset");
+
+    // Step 6: Entity handles
+    printSeparator("Step 6: Entity Handles");
+
+    HAPublishConfig quietConfig;
+    quietConfig.verboseLogging = false;
+    HAIntegration bench(publisher, "bench", quietConfig);
+
+    HAIntegration::EntityHandle meter = bench.registerEntity("sensor.power_meter");
+    check(meter->getStateTopic() == "bench/state/sensor.power_meter" && meter->getDomain() == "sensor",
+          "Handle caches its topics: " + meter->getStateTopic());
+    check(bench.registerEntity("sensor.power_meter") == meter, "Registering again returns the same handle");
+
+    std::vector<std::string> values;
+    for (int i = 0; i < 1000; ++i) {
+        values.push_back(std::to_string(1000 + i));
+    }
+    const size_t publishes = 200000;
+    for (size_t i = 0; i < publishes; ++i) {
+        bench.publishState(meter, values[i % values.size()]);
+    }
+    check(bench.getPublishStats().published == publishes, "All changing states published through the handle");
+
+    // Unchanged states never reach MQTT, so this is the per-call overhead
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < publishes; ++i) {
+        bench.publishState(meter, values.back());
+    }
+    double handleNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < publishes; ++i) {
+        bench.publishState("sensor.power_meter", values.back());
+    }
+    double idNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  Suppressed publish through handle: " << handleNs / publishes << " ns, by entity ID: "
+              << idNs / publishes << " ns" << std::endl;
+
+    // Entity and domain subscriptions on the same entity, plus domain-only
+    // and other-domain entities that only the domain wildcard can see
+    std::atomic<size_t> entityMessages(0);
+    std::atomic<size_t> domainPump(0);
+    std::atomic<size_t> domainFan(0);
+    std::atomic<size_t> domainOther(0);
+    HAIntegration::EntityHandle pump = bench.registerEntity("switch.pump");
+    bench.subscribeToEntity(pump, [&](const std::string& entityId, const std::string&, const std::string&) {
+        entityMessages += entityId == "switch.pump" ? 1 : 0;
+    });
+    bench.subscribeToDomain("switch", [&](const std::string& entityId, const std::string&, const std::string&) {
+        if (entityId == "switch.pump") {
+            domainPump++;
+        } else if (entityId == "switch.fan") {
+            domainFan++;
+        } else {
+            domainOther++;
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    const size_t incoming = 1000;
+    const size_t others = 50;
+    for (size_t i = 0; i < incoming; ++i) {
+        observer->publish(pump->getStateTopic(), i % 2 ? "on" : "off");
+    }
+    for (size_t i = 0; i < others; ++i) {
+        observer->publish("bench/state/sensor.outdoor_temperature", std::to_string(i));
+        observer->publish("bench/state/light.porch", i % 2 ? "on" : "off");
+    }
+    // Sent last, so the messages above have been routed once these arrive
+    for (size_t i = 0; i < others; ++i) {
+        observer->publish("bench/state/switch.fan", i % 2 ? "on" : "off");
+    }
+    bool delivered = waitUntil([&] {
+        return entityMessages == incoming && domainPump == incoming && domainFan == others;
+    }, 5000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    check(delivered && entityMessages == incoming && domainPump == incoming,
+          "Entity and domain callbacks each ran once per message: " + std::to_string(entityMessages.load()) +
+              " / " + std::to_string(domainPump.load()));
+    check(domainFan == others, "The domain wildcard delivered an entity nobody subscribed to: " +
+          std::to_string(domainFan.load()) + " / " + std::to_string(others));
+    check(domainOther == 0, "Sensor and light states were filtered out of the switch domain");
+
+    publisher->disconnect();
+    observer->disconnect();
+    broker.stop();
+
+    printSeparator("Test Summary");
+    if (failures == 0) {
+        std::cout << "✓ All publishing checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+// Test program for the Home Assistant REST JSON parser
+#include "HARestClient.h"
+#include "HAJsonParser.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "✓ " : "✗ ") << description << std::endl;
+    failures += condition ? 0 : 1;
+}
+
+// An /api/states entry the way Home Assistant serializes it
+std::string makeState(size_t index) {
+    std::string id = std::to_string(index);
+    return "{\"entity_id\":\"sensor.room_" + id + "_temperature\",\"state\":\"" + std::to_string(18 + index % 7) +
+           ".5\",\"attributes\":{\"state_class\":\"measurement\",\"unit_of_measurement\":\"\\u00b0C\","
+           "\"device_class\":\"temperature\",\"friendly_name\":\"Room " + id + " Temperature\"},"
+           "\"last_changed\":\"2024-01-15T10:30:00.123456+00:00\",\"last_reported\":\"2024-01-15T10:30:00.123456+00:00\","
+           "\"last_updated\":\"2024-01-15T10:31:00.123456+00:00\","
+           "\"context\":{\"id\":\"01HM8Z4Q\",\"parent_id\":null,\"user_id\":null}}";
+}
+
+int main() {
+    printSeparator("Home Assistant JSON Parser Test");
+
+    // Step 1: Single state with nesting and escapes
+    printSeparator("Step 1: Single State Object");
+
+    const std::string state = R"({
+        "entity_id": "sensor.living_room_temperature",
+        "state": "22.5",
+        "attributes": {
+            "options": ["a", "b", {"nested": "}"}],
+            "friendly_name": "Living \"Main\" Room \u2013 \ud83c\udf21",
+            "unit_of_measurement": "°C",
+            "device_class": "temperature"
+        },
+        "last_changed": "2024-01-15T10:30:00+00:00",
+        "last_updated": "2024-01-15T12:30:00.5+02:00"
+    })";
+
+    HASensorData data;
+    bool parsed = HAJsonParser::parseState(state, data);
+    check(parsed && data.entityId == "sensor.living_room_temperature" && data.state == "22.5",
+          "Entity id and state: " + data.entityId + " = " + data.state);
+    check(data.friendlyName == "Living \"Main\" Room \xE2\x80\x93 \xF0\x9F\x8C\xA1",
+          "Escaped friendly name decoded: " + data.friendlyName);
+    check(data.unitOfMeasurement == "°C" && data.deviceClass == "temperature",
+          "Attributes after a nested array are still found");
+    check(data.lastChanged == 1705314600 && data.lastUpdated == 1705314600,
+          "ISO 8601 timestamps with offsets: " + std::to_string(data.lastChanged));
+
+    // Step 2: State list
+    printSeparator("Step 2: /api/states Array");
+
+    std::string states = "[";
+    const size_t entityCount = 20000;
+    for (size_t i = 0; i < entityCount; ++i) {
+        states += (i ? "," : "") + makeState(i);
+    }
+    states += "]";
+
+    std::vector<HASensorData> sensors;
+    auto start = std::chrono::steady_clock::now();
+    parsed = HAJsonParser::parseStates(states, sensors);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    check(parsed && sensors.size() == entityCount, "Parsed " + std::to_string(sensors.size()) + " entities");
+    check(sensors[7].entityId == "sensor.room_7_temperature" && sensors[7].unitOfMeasurement == "°C" &&
+          sensors[7].friendlyName == "Room 7 Temperature" && sensors[7].lastUpdated == 1705314660,
+          "Fields of entity 7 filled directly");
+    std::cout << "  " << states.size() / 1024 << " KB in " << ms << " ms ("
+              << (states.size() / 1048576.0) / (ms / 1000.0) << " MB/s)" << std::endl;
+
+    // Step 3: History
+    printSeparator("Step 3: /api/history/period");
+
+    const std::string history = R"([[
+        {"entity_id": "sensor.energy_consumption", "state": "1100",
+         "attributes": {"unit_of_measurement": "W", "limits": {"max": 5000}},
+         "last_changed": "2024-01-15T08:00:00+00:00"},
+        {"entity_id": "sensor.energy_consumption", "state": "1250",
+         "last_changed": "2024-01-15T09:00:00Z"}
+    ], [
+        {"entity_id": "sensor.solar_production", "state": "unavailable",
+         "last_updated": "2024-01-15T09:30:00+00:00"}
+    ]])";
+
+    std::vector<HAHistoricalData> entries;
+    parsed = HAJsonParser::parseHistory(history, entries);
+    check(parsed && entries.size() == 3, "Parsed " + std::to_string(entries.size()) + " history entries");
+    check(entries.size() == 3 && entries[0].timestamp == 1705305600 && entries[1].timestamp == 1705309200 &&
+          entries[2].timestamp == 1705311000, "Timestamps from last_changed, falling back to last_updated");
+    check(entries.size() == 3 && entries[0].attributes["unit_of_measurement"] == "W" &&
+          entries[0].attributes["limits"] == "{\"max\": 5000}", "Scalar and nested attributes kept");
+
+    // Step 4: Malformed input
+    printSeparator("Step 4: Malformed Input");
+
+    std::vector<HASensorData> partial;
+    check(!HAJsonParser::parseStates("[" + makeState(1) + ", {\"entity_id\": \"sensor.x\", \"state\": ", partial) &&
+          partial.size() == 1, "Truncated response rejected, complete entities kept");
+    check(!HAJsonParser::parseState("{\"entity_id\" \"sensor.x\"}", data), "Missing colon rejected");
+    check(HAJsonParser::parseTimestamp("not a timestamp") == 0, "Invalid timestamp yields 0");
+
+    // Step 5: Streaming history in network-sized chunks
+    printSeparator("Step 5: Streaming History Parser");
+
+    std::string longHistory = "[[";
+    const size_t historyCount = 50000;
+    for (size_t i = 0; i < historyCount; ++i) {
+        char timestamp[32];
+        std::snprintf(timestamp, sizeof(timestamp), "2024-01-%02zuT%02zu:%02zu:00+00:00",
+                      1 + i / 1440 % 28, i / 60 % 24, i % 60);
+        longHistory += (i ? "," : "") + std::string("{\"entity_id\":\"sensor.energy_consumption\",\"state\":\"") +
+                       std::to_string(1000 + i % 500) + "\",\"attributes\":{\"unit_of_measurement\":\"W\","
+                       "\"friendly_name\":\"Energy \\\"Main\\\" {meter}\"},\"last_changed\":\"" + timestamp + "\"}";
+    }
+    longHistory += "]]";
+
+    std::vector<HAHistoricalData> expected;
+    HAJsonParser::parseHistory(longHistory, expected);
+
+    for (size_t chunkSize : {size_t(1), size_t(7), size_t(16384)}) {
+        size_t matching = 0;
+        size_t index = 0;
+        HAHistoryStreamParser parser([&](const HAHistoricalData& entry) {
+            if (index < expected.size() && entry.state == expected[index].state &&
+                entry.timestamp == expected[index].timestamp && entry.attributes == expected[index].attributes) {
+                matching++;
+            }
+            index++;
+        });
+
+        auto streamStart = std::chrono::steady_clock::now();
+        for (size_t offset = 0; offset < longHistory.size(); offset += chunkSize) {
+            parser.feed(longHistory.data() + offset, std::min(chunkSize, longHistory.size() - offset));
+        }
+        double streamMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - streamStart).count();
+
+        check(parser.finish() && matching == historyCount,
+              std::to_string(chunkSize) + "-byte chunks: " + std::to_string(matching) + "/" +
+              std::to_string(historyCount) + " entries, peak buffer " +
+              std::to_string(parser.getPeakBufferSize()) + " bytes, " + std::to_string(streamMs) + " ms");
+    }
+
+    HAHistoryStreamParser errorParser([](const HAHistoricalData&) {});
+    const std::string errorBody = "{\"message\": \"Entity not found.\"}";
+    check(!errorParser.feed(errorBody.data(), errorBody.size()) && !errorParser.finish(),
+          "Error object instead of history rejected");
+
+    // Step 6: minimal_response history names the entity only once
+    printSeparator("Step 6: minimal_response History");
+
+    const std::string minimal = R"([[
+        {"entity_id": "sensor.outdoor_temperature", "state": "4.5", "last_changed": "2024-01-15T08:00:00+00:00"},
+        {"state": "5.0", "last_changed": "2024-01-15T09:00:00+00:00"}
+    ], [
+        {"entity_id": "sensor.electricity_price", "state": "0.31", "last_changed": "2024-01-15T08:00:00+00:00"},
+        {"state": "0.28", "last_changed": "2024-01-15T09:00:00+00:00"}
+    ]])";
+
+    entries.clear();
+    parsed = HAJsonParser::parseHistory(minimal, entries);
+    check(parsed && entries.size() == 4 && entries[1].entityId == "sensor.outdoor_temperature" &&
+          entries[3].entityId == "sensor.electricity_price", "parseHistory carries entity_id within each array");
+
+    std::vector<std::string> streamedIds;
+    HAHistoryStreamParser minimalParser([&](const HAHistoricalData& entry) {
+        streamedIds.push_back(entry.entityId);
+    });
+    for (size_t offset = 0; offset < minimal.size(); offset += 5) {
+        minimalParser.feed(minimal.data() + offset, std::min<size_t>(5, minimal.size() - offset));
+    }
+    check(minimalParser.finish() && streamedIds.size() == 4 && streamedIds[1] == "sensor.outdoor_temperature" &&
+          streamedIds[3] == "sensor.electricity_price", "Streaming parser carries entity_id forward");
+
+    printSeparator("Test Summary");
+    if (failures == 0) {
+        std::cout << "✓ All parser checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+// Test program exercising MQTTClient against the in-process loopback broker
+#include "MQTTClient.h"
+#include "MQTTLoopbackBroker.h"
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+// Poll until the condition holds or the timeout expires
+bool waitUntil(std::function<bool()> condition, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    printSeparator("MQTT Loopback Transport Test");
+    int failures = 0;
+
+    // Step 1: Broker and clients
+    printSeparator("Step 1: Start Broker and Connect");
+
+    MQTTLoopbackBroker broker;
+    if (!broker.start()) {
+        std::cerr << "✗ Could not start loopback broker" << std::endl;
+        return 1;
+    }
+
+    MQTTClientConfig clientConfig;
+    clientConfig.reconnectMinDelayMs = 100;
+    auto subscriber = std::make_shared<MQTTClient>("127.0.0.1", broker.getPort(), clientConfig);
+    auto publisher = std::make_shared<MQTTClient>("127.0.0.1", broker.getPort(), clientConfig);
+
+    if (subscriber->connect() && publisher->connect()) {
+        std::cout << "✓ Both clients connected (" << broker.getConnectionCount() << " connections)" << std::endl;
+    } else {
+        std::cerr << "✗ Connection failed" << std::endl;
+        return 1;
+    }
+
+    std::atomic<size_t> stateMessages(0);
+    std::atomic<size_t> commandMessages(0);
+    subscriber->subscribe("homeassistant/state/+", [&](const std::string&, const std::string&) {
+        stateMessages++;
+    }, 1);
+    subscriber->subscribe("homeassistant/command/#", [&](const std::string&, const std::string&) {
+        commandMessages++;
+    });
+    subscriber->waitForDelivery(std::chrono::seconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));   // Let the SUBACKs land
+
+    // Step 2: Pipelined QoS 0
+    printSeparator("Step 2: Pipelined QoS 0 Publishing");
+
+    const size_t qos0Count = 20000;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < qos0Count; ++i) {
+        publisher->publish("homeassistant/state/sensor_" + std::to_string(i % 50),
+                           "{\"state\": \"" + std::to_string(i) + "\"}");
+    }
+    bool delivered = waitUntil([&] { return stateMessages >= qos0Count; }, 10000);
+    double qos0Ms = elapsedMs(start);
+
+    auto stats = publisher->getStats();
+    std::cout << (delivered ? "✓ " : "✗ ") << stateMessages << "/" << qos0Count
+              << " messages delivered in " << qos0Ms << " ms ("
+              << static_cast<int>(qos0Count / (qos0Ms / 1000.0)) << " msg/s)" << std::endl;
+    std::cout << "  Publisher send() calls: " << stats.writeCalls
+              << " for " << stats.messagesPublished << " messages (batched writes)" << std::endl;
+    failures += delivered ? 0 : 1;
+
+    // Step 3: QoS 1 with acknowledgements
+    printSeparator("Step 3: Pipelined QoS 1 Publishing");
+
+    const size_t qos1Count = 5000;
+    stateMessages = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < qos1Count; ++i) {
+        publisher->publish("homeassistant/state/ev_charger", std::to_string(i), 1);
+    }
+    bool acknowledged = publisher->waitForDelivery(std::chrono::seconds(10));
+    delivered = waitUntil([&] { return stateMessages >= qos1Count; }, 10000);
+    double qos1Ms = elapsedMs(start);
+
+    stats = publisher->getStats();
+    std::cout << (acknowledged && stats.inflight == 0 ? "✓ " : "✗ ")
+              << "All QoS 1 publishes acknowledged in " << qos1Ms << " ms (inflight: "
+              << stats.inflight << ")" << std::endl;
+    std::cout << (delivered ? "✓ " : "✗ ") << stateMessages << "/" << qos1Count
+              << " QoS 1 messages delivered" << std::endl;
+    failures += (acknowledged && delivered) ? 0 : 1;
+
+    // Step 4: Retained messages
+    printSeparator("Step 4: Retained Discovery Config");
+
+    publisher->publish("homeassistant/sensor/home_automation/temp/config", "{\"name\": \"Temp\"}", 1, true);
+    publisher->waitForDelivery(std::chrono::seconds(1));
+
+    std::atomic<size_t> discoveryMessages(0);
+    auto lateSubscriber = std::make_shared<MQTTClient>("127.0.0.1", broker.getPort(), clientConfig);
+    lateSubscriber->connect();
+    lateSubscriber->subscribe("homeassistant/+/+/+/config", [&](const std::string&, const std::string&) {
+        discoveryMessages++;
+    });
+    bool retained = waitUntil([&] { return discoveryMessages == 1; }, 2000);
+    std::cout << (retained ? "✓ " : "✗ ") << "Late subscriber received the retained config" << std::endl;
+    failures += retained ? 0 : 1;
+    lateSubscriber->disconnect();
+
+    // Step 5: Reconnect
+    printSeparator("Step 5: Reconnect with Backoff");
+
+    std::cout << "Dropping all broker connections..." << std::endl;
+    broker.dropConnections();
+    waitUntil([&] { return !publisher->isConnected() && !subscriber->isConnected(); }, 2000);
+
+    // Published while the connection is down: queued and sent after reconnecting
+    stateMessages = 0;
+    commandMessages = 0;
+    for (int i = 0; i < 100; ++i) {
+        publisher->publish("homeassistant/state/offline_queue", std::to_string(i), 1);
+    }
+    publisher->publish("homeassistant/command/switch.heater", "ON");
+
+    bool reconnected = waitUntil([&] { return publisher->isConnected() && subscriber->isConnected(); }, 5000);
+    std::cout << (reconnected ? "✓ " : "✗ ") << "Both clients reconnected" << std::endl;
+
+    // The subscriber may come back after the publisher; retry the command until it arrives
+    bool resubscribed = waitUntil([&] {
+        if (commandMessages == 0) {
+            publisher->publish("homeassistant/command/switch.heater", "ON");
+        }
+        return commandMessages > 0;
+    }, 5000);
+    bool backlog = publisher->waitForDelivery(std::chrono::seconds(5));
+    std::cout << (resubscribed ? "✓ " : "✗ ") << "Subscriptions restored after reconnect" << std::endl;
+    std::cout << (backlog ? "✓ " : "✗ ") << "Offline QoS 1 backlog acknowledged (reconnects: "
+              << publisher->getStats().reconnects << ")" << std::endl;
+    failures += (reconnected && resubscribed && backlog) ? 0 : 1;
+
+    // Step 6: Keep-alive
+    printSeparator("Step 6: Keep-Alive");
+
+    MQTTClientConfig idleConfig;
+    idleConfig.keepAliveSeconds = 1;
+    auto idleClient = std::make_shared<MQTTClient>("127.0.0.1", broker.getPort(), idleConfig);
+    idleClient->connect();
+    uint64_t bytesBefore = idleClient->getStats().bytesSent;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    auto idleStats = idleClient->getStats();
+    bool alive = idleClient->isConnected() && idleStats.bytesSent > bytesBefore && idleStats.bytesReceived > 0;
+    std::cout << (alive ? "✓ " : "✗ ") << "Idle client kept alive with PINGREQ ("
+              << (idleStats.bytesSent - bytesBefore) << " bytes of pings)" << std::endl;
+    failures += alive ? 0 : 1;
+    idleClient->disconnect();
+
+    // Step 7: Subscription matching
+    printSeparator("Step 7: Subscription Trie Matching");
+
+    const size_t entityCount = 2000;
+    MQTTClient matcher("127.0.0.1", broker.getPort());   // Never connected; subscriptions are local
+    std::atomic<size_t> entityHits(0);
+    std::atomic<size_t> wildcardHits(0);
+    std::atomic<size_t> systemHits(0);
+    for (size_t i = 0; i < entityCount; ++i) {
+        matcher.subscribe("homeassistant/sensor/entity_" + std::to_string(i) + "/state",
+                          [&](const std::string&, const std::string&) { entityHits++; });
+    }
+    matcher.subscribe("homeassistant/+/+/state", [&](const std::string&, const std::string&) {
+        wildcardHits++;
+    });
+    matcher.subscribe("#", [&](const std::string&, const std::string&) {
+        wildcardHits++;
+    });
+    // A second callback on an existing filter must not replace the first
+    matcher.subscribe("homeassistant/sensor/entity_7/state", [&](const std::string&, const std::string&) {
+        entityHits++;
+    });
+    matcher.subscribe("$SYS/#", [&](const std::string&, const std::string&) {
+        systemHits++;
+    });
+
+    const size_t matchCount = 200000;
+    std::vector<std::string> topics;
+    for (size_t i = 0; i < entityCount; ++i) {
+        topics.push_back("homeassistant/sensor/entity_" + std::to_string(i) + "/state");
+    }
+    auto matchStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < matchCount; ++i) {
+        matcher.simulateMessage(topics[i % entityCount], "21.5");
+    }
+    double matchMs = elapsedMs(matchStart);
+    matcher.simulateMessage("$SYS/broker/uptime", "1");
+
+    // entity_7 is hit matchCount / entityCount times with two callbacks
+    size_t expectedEntityHits = matchCount + matchCount / entityCount;
+    bool matched = entityHits == expectedEntityHits && wildcardHits == 2 * matchCount && systemHits == 1;
+    std::cout << (matched ? "✓ " : "✗ ") << matchCount << " messages matched against "
+              << entityCount + 4 << " subscriptions in " << matchMs << " ms ("
+              << (matchMs * 1e6 / matchCount) << " ns/message)" << std::endl;
+    std::cout << "  Entity callbacks: " << entityHits << "/" << expectedEntityHits
+              << ", wildcard callbacks: " << wildcardHits << "/" << 2 * matchCount
+              << ", $SYS callbacks: " << systemHits << "/1" << std::endl;
+    failures += matched ? 0 : 1;
+
+    printSeparator("Test Summary");
+    publisher->disconnect();
+    subscriber->disconnect();
+    broker.stop();
+
+    if (failures == 0) {
+        std::cout << "✓ All MQTT transport checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,255 @@
+// Test program for receding-horizon (MPC) re-planning
+#include "RecedingHorizonPlanner.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "✓ " : "✗ ") << description << std::endl;
+    failures += condition ? 0 : 1;
+}
+
+std::string format(double value, int digits = 4) {
+    std::string text = std::to_string(value);
+    return text.substr(0, text.find('.') + 1 + digits);
+}
+
+ScheduleDevice energyDevice(const std::string& id, double maxPowerKw, bool onOff, double energyKwh,
+                            int earliestSlot = 0, int deadlineSlot = -1) {
+    ScheduleDevice device;
+    device.id = id;
+    device.maxPowerKw = maxPowerKw;
+    device.onOff = onOff;
+    device.energyKwh = energyKwh;
+    device.earliestSlot = earliestSlot;
+    device.deadlineSlot = deadlineSlot;
+    return device;
+}
+
+ScheduleDevice thermalDevice(const std::string& id, double maxPowerKw, bool onOff, double minTemp, double maxTemp) {
+    ScheduleDevice device;
+    device.id = id;
+    device.maxPowerKw = maxPowerKw;
+    device.onOff = onOff;
+    device.thermal = true;
+    device.initialTemp = (minTemp + maxTemp) / 2.0;
+    device.minTemp = minTemp;
+    device.maxTemp = maxTemp;
+    return device;
+}
+
+// One day at 15-minute resolution: tariff, solar, base load, outdoor temperature
+ScheduleProblem makeDay() {
+    const double pi = 3.14159265358979;
+    ScheduleProblem problem;
+    problem.slotHours = 0.25;
+    for (size_t t = 0; t < 96; ++t) {
+        double hour = t * problem.slotHours;
+        double price = hour < 6 ? 0.10 : (hour >= 17 && hour < 20 ? 0.32 : (hour >= 7 && hour < 22 ? 0.22 : 0.14));
+        problem.prices.push_back(price + 0.01 * std::sin(t * 0.7));
+        problem.solarKw.push_back(hour > 6 && hour < 18 ? 7.0 * std::sin((hour - 6) / 12 * pi) : 0.0);
+        problem.baseLoadKw.push_back(0.6 + 0.4 * std::sin(hour / 24 * 2 * pi));
+        problem.outdoorTemp.push_back(7.0 + 4.0 * std::sin((hour - 9) / 24 * 2 * pi));
+    }
+    problem.battery.capacityKwh = 10.0;
+    problem.battery.initialKwh = 5.0;
+    problem.battery.minKwh = 1.0;
+    problem.battery.maxChargeKw = 5.0;
+    problem.battery.maxDischargeKw = 5.0;
+    return problem;
+}
+
+double energyBetween(const ScheduleSolution& plan, size_t device, size_t from, size_t to, double slotHours) {
+    double energy = 0.0;
+    for (size_t t = from; t < to && t < plan.powerKw[device].size(); ++t) {
+        energy += plan.powerKw[device][t] * slotHours;
+    }
+    return energy;
+}
+
+int main() {
+    printSeparator("Receding Horizon Planner Test");
+
+    ScheduleProblem day = makeDay();
+    day.importLimitKw = 12.0;
+    day.devices.push_back(energyDevice("ev_1", 11.0, false, 20.0, 0, 40));
+    day.devices.push_back(thermalDevice("heater_1", 2.0, false, 20.0, 23.0));
+    day.devices.push_back(thermalDevice("heater_2", 3.0, true, 19.5, 22.5));
+    day.devices.push_back(energyDevice("dishwasher", 1.8, true, 1.8, 40, 88));
+
+    // Step 1: Nothing changed
+    printSeparator("Step 1: Forecasts and Measurements on Plan");
+
+    RecedingHorizonPlanner planner(std::make_shared<MILPScheduleSolver>());
+    ScheduleSolution initial = planner.start(day);
+    check(initial.feasible, "Initial plan is feasible: $" + format(initial.cost));
+
+    planner.update(4, day);
+    ReplanStats stats = planner.getLastStats();
+    const ScheduleSolution& kept = planner.getPlan();
+    bool unchanged = kept.powerKw[0] == std::vector<double>(initial.powerKw[0].begin() + 4, initial.powerKw[0].end());
+    check(stats.resolvedSlots == 0 && planner.getStartSlot() == 4, "No slot re-solved after 4 slots");
+    check(kept.feasible && unchanged, "Remaining plan is the initial plan from slot 4 on");
+    check(planner.getProblem().getSlotCount() == 92, "Problem re-based onto the 92 remaining slots");
+
+    // Step 2: Price update later in the day
+    printSeparator("Step 2: Price Spike in Slots 60-67");
+
+    ScheduleSolution before = planner.getPlan();
+    ScheduleProblem spiked = day;
+    for (size_t t = 60; t < 68; ++t) {
+        spiked.prices[t] = 0.90;
+    }
+    planner.update(8, spiked);
+    stats = planner.getLastStats();
+    const ScheduleSolution& replanned = planner.getPlan();
+    std::cout << "  Re-solved " << stats.resolvedSlots << " slots from slot " << stats.fromSlot << " in "
+              << format(stats.solveMs, 1) << " ms" << std::endl;
+    check(stats.fromSlot == 60 && stats.resolvedSlots == 36, "Only the suffix from slot 60 was re-solved");
+
+    bool prefixKept = true;
+    for (size_t d = 0; d < day.devices.size(); ++d) {
+        for (size_t t = 0; t < 52; ++t) {
+            prefixKept = prefixKept && replanned.powerKw[d][t] == before.powerKw[d][t + 4];
+        }
+    }
+    check(prefixKept, "Plan before the spike kept as it was");
+
+    ScheduleSolution stale = before;
+    for (auto& power : stale.powerKw) {
+        power.erase(power.begin(), power.begin() + 4);
+    }
+    stale.batteryKw.erase(stale.batteryKw.begin(), stale.batteryKw.begin() + 4);
+    ScheduleSolver::evaluate(planner.getProblem(), stale);
+    check(replanned.feasible && replanned.cost <= stale.cost + 1e-9,
+          "Re-planned $" + format(replanned.cost) + " vs. $" + format(stale.cost) + " for the old plan at new prices");
+
+    // Step 3: Measured state off the plan
+    printSeparator("Step 3: Room Temperature off the Plan");
+
+    // Predicted temperature at the start of slot 12
+    const ScheduleDevice& heater = planner.getProblem().devices[1];
+    double predicted = ScheduleSolver::simulateTemperature(planner.getProblem(), heater, planner.getPlan().powerKw[1])[3];
+    double measuredTemp = predicted > 21.5 ? predicted - 1.0 : predicted + 1.0;
+    ScheduleMeasurement offPlan;
+    offPlan.indoorTemp["heater_1"] = measuredTemp;
+    planner.update(12, spiked, offPlan);
+    stats = planner.getLastStats();
+    check(stats.stateDiverged && stats.fromSlot == 12, "Divergence re-solved from the current slot");
+    std::vector<double> temps = ScheduleSolver::simulateTemperature(planner.getProblem(), planner.getProblem().devices[1],
+                                                                    planner.getPlan().powerKw[1]);
+    check(planner.getProblem().devices[1].initialTemp == measuredTemp && planner.getPlan().feasible &&
+              *std::min_element(temps.begin(), temps.end()) >= 20.0 - 1e-4,
+          "Plan starts from the measured " + format(measuredTemp, 2) + " °C instead of " + format(predicted, 2) +
+              " °C and keeps heater_1 at 20 °C or above");
+
+    // Step 4: EV charged less than planned
+    printSeparator("Step 4: EV Behind on Charging");
+
+    double deliveredBy16 = 20.0 - planner.getProblem().devices[0].energyKwh +
+                           energyBetween(planner.getPlan(), 0, 0, 4, day.slotHours);
+    ScheduleMeasurement behind;
+    behind.deliveredKwh["ev_1"] = std::max(0.0, deliveredBy16 - 3.0);
+    planner.update(16, spiked, behind);
+    double missing = 20.0 - behind.deliveredKwh["ev_1"];
+    double remaining = energyBetween(planner.getPlan(), 0, 0, 96, day.slotHours);
+    check(planner.getLastStats().stateDiverged && planner.getPlan().feasible, "EV shortfall re-planned");
+    check(remaining >= missing - 1e-4 && remaining < missing + 11.0 * 0.25 / 4,
+          "Remaining plan delivers " + format(remaining, 2) + " kWh of the " + format(missing, 2) +
+              " kWh still missing");
+
+    // Step 5: Battery drained
+    printSeparator("Step 5: Battery Lower than Predicted");
+
+    ScheduleMeasurement drained;
+    drained.batteryKwh = 1.2;
+    planner.update(20, spiked, drained);
+    check(planner.getLastStats().stateDiverged && planner.getPlan().feasible,
+          "Re-planned from 1.2 kWh; battery ends at " +
+              format(ScheduleSolver::simulateBattery(planner.getProblem(), planner.getPlan().batteryKw).back(), 2) +
+              " kWh (target " + format(planner.getProblem().battery.getTargetKwh(), 2) + ")");
+
+    // Step 6: A day of 5-minute re-planning for a 20-device household
+    printSeparator("Step 6: 5-Minute MPC Loop, 20 Devices");
+
+    ScheduleProblem full = makeDay();
+    full.importLimitKw = 17.0;
+    full.devices.push_back(energyDevice("ev_1", 11.0, false, 30.0, 0, 28));
+    full.devices.push_back(energyDevice("ev_2", 7.4, true, 20.0));
+    for (int i = 0; i < 4; ++i) {
+        full.devices.push_back(thermalDevice("heater_" + std::to_string(i), 2.0, false, 20.0, 23.0));
+    }
+    full.devices.push_back(thermalDevice("panel_1", 3.0, true, 19.0, 22.0));
+    full.devices.push_back(thermalDevice("panel_2", 3.0, true, 19.5, 22.5));
+    full.devices.push_back(energyDevice("dishwasher", 1.8, true, 1.8));
+    full.devices.push_back(energyDevice("washer", 2.0, true, 2.0, 32, 80));
+    full.devices.push_back(energyDevice("dryer", 2.5, true, 3.0, 40));
+    full.devices.push_back(energyDevice("pool_pump", 1.1, false, 6.0));
+    full.devices.push_back(energyDevice("water_heater", 3.0, true, 9.0));
+    full.devices.push_back(energyDevice("dehumidifier", 0.5, false, 3.0));
+    full.devices.push_back(energyDevice("sauna", 6.0, true, 6.0, 64, 88));
+    full.devices.push_back(energyDevice("ev_3", 3.7, false, 10.0, 40));
+    full.devices.push_back(energyDevice("freezer_boost", 0.3, true, 1.2));
+    full.devices.push_back(energyDevice("bread_maker", 0.6, true, 0.6, 0, 28));
+    full.devices.push_back(energyDevice("robot_mower", 0.4, true, 0.8, 32, 72));
+    full.devices.push_back(energyDevice("irrigation", 0.8, true, 1.6, 0, 32));
+
+    RecedingHorizonPlanner loop(std::make_shared<MILPScheduleSolver>());
+    ScheduleSolution fullPlan = loop.start(full);
+    std::cout << "  Initial plan: $" << format(fullPlan.cost) << " in " << format(fullPlan.solveMs, 1) << " ms"
+              << std::endl;
+
+    // Three updates per slot; the solar forecast for the next hour is revised
+    // once per slot, the other two updates see no change
+    ScheduleProblem latest = full;
+    size_t updates = 0;
+    size_t skipped = 0;
+    size_t resolvedSlots = 0;
+    double totalMs = 0.0;
+    double worstMs = 0.0;
+    bool allFeasible = true;
+    for (size_t slot = 28; slot < 76; ++slot) {
+        for (int tick = 0; tick < 3; ++tick) {
+            if (tick == 0) {
+                for (size_t t = slot; t < std::min<size_t>(slot + 4, 96); ++t) {
+                    latest.solarKw[t] = full.solarKw[t] * (0.9 + 0.05 * ((slot + t) % 5));
+                }
+            }
+            loop.update(slot, latest);
+            const ReplanStats& replan = loop.getLastStats();
+            ++updates;
+            skipped += replan.resolvedSlots == 0 ? 1 : 0;
+            resolvedSlots += replan.resolvedSlots;
+            totalMs += replan.solveMs;
+            worstMs = std::max(worstMs, replan.solveMs);
+            allFeasible = allFeasible && loop.getPlan().feasible;
+        }
+    }
+    std::cout << "  " << updates << " updates, " << skipped << " without a solve, "
+              << format(static_cast<double>(resolvedSlots) / (updates - skipped), 1) << " slots per re-solve"
+              << std::endl;
+    std::cout << "  Solver time: " << format(totalMs / updates, 2) << " ms per update on average, "
+              << format(worstMs, 1) << " ms worst" << std::endl;
+    check(allFeasible, "Plan stayed feasible through every update");
+    check(skipped >= updates / 2, "Updates without forecast changes skipped the solver");
+    check(worstMs < 100.0, "Every re-plan finished within 100 ms");
+
+    printSeparator("Test Summary");
+    if (failures == 0) {
+        std::cout << "✓ All receding horizon checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
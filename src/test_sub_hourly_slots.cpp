@@ -0,0 +1,303 @@
+// Test program for 5/15/60-minute forecasting and scheduling slots
+#include "DayAheadOptimizer.h"
+#include "DeferrableLoadController.h"
+#include "MLPredictor.h"
+#include "HistoricalDataCollector.h"
+#include "HistoricalDataGenerator.h"
+#include "Heater.h"
+#include "EVCharger.h"
+#include "Light.h"
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+void printSeparator(const std::string& title) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "=== " << title << " ===" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "✓ " : "✗ ") << description << std::endl;
+    failures += condition ? 0 : 1;
+}
+
+// Readings every 5 minutes; the first half of each hour settles at $0.30/kWh
+// and the second at $0.10/kWh on weekdays, 20% less at weekends. No solar,
+// so only the price decides.
+std::vector<HistoricalDataPoint> halfHourPriceData(int numDays) {
+    std::vector<HistoricalDataPoint> data;
+    for (int day = 0; day < numDays; day++) {
+        for (int minuteOfDay = 0; minuteOfDay < TimeSlots::MINUTES_PER_DAY; minuteOfDay += 5) {
+            HistoricalDataPoint point;
+            point.hour = minuteOfDay / 60;
+            point.minute = minuteOfDay % 60;
+            point.dayOfWeek = day % 7;
+            bool weekend = point.dayOfWeek == 0 || point.dayOfWeek == 6;
+            point.energyCost = (point.minute < 30 ? 0.30 : 0.10) * (weekend ? 0.8 : 1.0);
+            point.solarProduction = 0.0;
+            point.outdoorTemp = 15.0 + 5.0 * std::sin((minuteOfDay / 60.0 - 6) * 3.14159 / 12.0);
+            data.push_back(point);
+        }
+    }
+    return data;
+}
+
+bool isCheapSlot(const HourlyForecast& forecast) {
+    return forecast.minute >= 30;
+}
+
+// A day from 8:00 at a constant outdoor temperature, $0.30/kWh until 22:00
+// and $0.10/kWh overnight, no solar
+std::vector<HourlyForecast> coldDay(double outdoorTemp) {
+    std::vector<HourlyForecast> forecasts;
+    for (int i = 0; i < 24; i++) {
+        int hour = (8 + i) % 24;
+        forecasts.push_back(HourlyForecast{hour, hour >= 8 && hour < 22 ? 0.30 : 0.10, 0.0, outdoorTemp, 1.0});
+    }
+    return forecasts;
+}
+
+// Energy one appliance is scheduled to charge and slots it is switched on
+void scheduledUse(const DayAheadSchedule& schedule, const std::string& id, double& chargedKwh, size_t& onSlots) {
+    chargedKwh = 0.0;
+    onSlots = 0;
+    double hours = schedule.getSlotMinutes() / 60.0;
+    for (size_t slot = 0; slot < schedule.getSlotCount(); slot++) {
+        for (const auto& action : schedule.getActionsForSlot(slot)) {
+            if (schedule.getApplianceId(action.appliance) != id) {
+                continue;
+            }
+            chargedKwh += action.type == ActionType::CHARGE ? action.value * hours : 0.0;
+            onSlots += action.type == ActionType::ON ? 1 : 0;
+        }
+    }
+}
+
+int main() {
+    printSeparator("Sub-Hourly Slot Test");
+
+    // Step 1: Slot grids
+    printSeparator("Step 1: Slot Grids");
+
+    static_assert(std::tuple_size<SlotArray<SlotLength::FIVE_MINUTES>>::value == 288, "288 five-minute slots");
+    static_assert(std::tuple_size<SlotArray<SlotLength::FIFTEEN_MINUTES>>::value == 96, "96 quarter-hour slots");
+    static_assert(std::tuple_size<SlotArray<SlotLength::ONE_HOUR>>::value == 24, "24 hourly slots");
+    SlotLength parsed = SlotLength::ONE_HOUR;
+    check(TimeSlots::fromMinutes(15, parsed) && parsed == SlotLength::FIFTEEN_MINUTES &&
+              !TimeSlots::fromMinutes(10, parsed),
+          "15 minutes parses, 10 minutes is rejected");
+    check(TimeSlots::slotOfDay(SlotLength::FIFTEEN_MINUTES, 8, 20) == 33 &&
+              TimeSlots::slotOfDay(SlotLength::FIVE_MINUTES, 23, 59) == 287,
+          "8:20 is quarter-hour slot 33, 23:59 is five-minute slot 287");
+
+    // Step 2: Sub-hourly forecasts
+    printSeparator("Step 2: Forecasts from 5-Minute Readings");
+
+    auto predictor = std::make_shared<MLPredictor>();
+    predictor->train(halfHourPriceData(14));
+
+    auto quarterHours = predictor->predictNextDay(SlotLength::FIFTEEN_MINUTES, 8, 5);
+    auto fiveMinutes = predictor->predictNextDay(SlotLength::FIVE_MINUTES, 8, 5, 40);
+    auto hourly = predictor->predictNext24Hours(8, 5);
+    check(quarterHours.size() == 96 && fiveMinutes.size() == 288 && hourly.size() == 24,
+          "96, 288 and 24 slots per day");
+    check(quarterHours[0].hour == 8 && quarterHours[1].minute == 15 && quarterHours[95].hour == 7 &&
+              quarterHours[95].minute == 45,
+          "Quarter hours run from 8:00 to 7:45");
+    check(fiveMinutes[0].hour == 8 && fiveMinutes[0].minute == 40, "Five-minute slots start at 8:40");
+    check(std::abs(quarterHours[0].predictedEnergyCost - 0.30) < 1e-9 &&
+              std::abs(quarterHours[2].predictedEnergyCost - 0.10) < 1e-9,
+          "8:00 forecasts the peak half hour, 8:30 the cheap one");
+    check(std::abs(hourly[0].predictedEnergyCost - 0.20) < 1e-9, "Hourly slots average both halves");
+
+    // Friday's horizon runs into Saturday, which has learned its weekend discount
+    SlotProfile<SlotLength::FIFTEEN_MINUTES> saturday = predictor->predictProfile<SlotLength::FIFTEEN_MINUTES>(6);
+    check(quarterHours[64].hour == 0 && quarterHours[64].predictedEnergyCost == saturday.cost[0] &&
+              std::abs(saturday.cost[0] - 0.24) < 1e-9,
+          "Midnight switches to Saturday's profile");
+
+    // Step 3: Hourly readings
+    printSeparator("Step 3: Hourly Readings at 15 Minutes");
+
+    MLPredictor hourlyPredictor;
+    hourlyPredictor.train(HistoricalDataGenerator::generateSampleData(14));
+    auto fromHourly = hourlyPredictor.predictNextDay(SlotLength::FIFTEEN_MINUTES, 8, 2);
+    auto hours = hourlyPredictor.predictNext24Hours(8, 2);
+    check(fromHourly[1].predictedEnergyCost == hours[0].predictedEnergyCost &&
+              fromHourly[7].predictedEnergyCost == hours[1].predictedEnergyCost,
+          "Quarter hours without readings fall back to their hour");
+
+    HistoricalDataPoint reading;
+    reading.hour = 3;
+    reading.minute = 35;
+    reading.dayOfWeek = 2;
+    reading.energyCost = 0.5;
+    reading.solarProduction = 0.0;
+    reading.outdoorTemp = 10.0;
+    hourlyPredictor.update(reading);
+    HistoricalAggregates stats = hourlyPredictor.getStatistics();
+    check(stats.bySlot[TimeSlots::slotOfDay(TimeSlots::FINEST, 3, 35)].count > 0.0 &&
+              stats.bySlot[TimeSlots::slotOfDay(TimeSlots::FINEST, 3, 30)].count == 0.0,
+          "A 3:35 reading updates only the 3:35 bucket");
+    auto updated = hourlyPredictor.predictNextDay(SlotLength::FIFTEEN_MINUTES, 3, 2, 30);
+    check(std::abs(updated[0].predictedEnergyCost - 0.55) < 1e-9, "The 3:30 quarter hour follows the reading");
+
+    // Step 4: Quarter-hour schedule
+    printSeparator("Step 4: Day-Ahead Schedule in 15-Minute Slots");
+
+    auto heater = std::make_shared<Heater>("heater_1", "Living Room Heater", 2.5);
+    auto evCharger = std::make_shared<EVCharger>("ev_1", "EV Charger", 7.2);
+    auto light = std::make_shared<Light>("light_1", "Decorative Lights", 0.3);
+    evCharger->setDeferrable(true);
+    light->setDeferrable(true);
+
+    auto controller = std::make_shared<DeferrableLoadController>(predictor);
+    controller->setSlotLength(SlotLength::FIFTEEN_MINUTES);
+    controller->addDeferrableLoad(light);
+
+    DayAheadOptimizer optimizer(predictor);
+    optimizer.setSlotLength(SlotLength::FIFTEEN_MINUTES);
+    optimizer.setDeferrableLoadController(controller);
+    optimizer.addAppliance(heater);
+    optimizer.addAppliance(evCharger);
+    optimizer.setTargetTemperature(20.0);
+
+    auto start = std::chrono::steady_clock::now();
+    DayAheadSchedule schedule = optimizer.generateSchedule(8, 2);
+    double quarterMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    const ScheduleSolution& plan = optimizer.getLastSolution();
+
+    check(schedule.getSlotCount() == 96 && schedule.getSlotMinutes() == 15, "96 slots of 15 minutes");
+    double evEnergy = 0.0;
+    bool cheapOnly = true;
+    auto forecasts = predictor->predictNextDay(SlotLength::FIFTEEN_MINUTES, 8, 2);
+    for (size_t slot = 0; slot < schedule.getSlotCount(); slot++) {
+        for (const auto& action : schedule.getActionsForSlot(slot)) {
+            if (schedule.getApplianceId(action.appliance) == "ev_1" && action.type == ActionType::CHARGE) {
+                evEnergy += action.value * 0.25;
+                cheapOnly = cheapOnly && isCheapSlot(forecasts[slot]);
+            }
+        }
+    }
+    check(plan.feasible && std::abs(evEnergy - 4 * 7.2) < 1e-3,
+          "EV gets 4 hours of charge (" + std::to_string(evEnergy) + " kWh)");
+    check(cheapOnly, "EV charges only in cheap half hours");
+    check(!schedule.getActionsAt(8, 30).empty() && schedule.getSlotLabel(2) == "8:30", "8:30 slot is addressable");
+
+    // Step 5: Re-planning by slots
+    printSeparator("Step 5: Re-planning after 4 Slots");
+
+    DayAheadSchedule remaining = optimizer.updateSchedule(4, forecasts);
+    check(remaining.getSlotCount() == 92 && remaining.getSlotLabel(0) == "9:00",
+          "Re-planned schedule starts at 9:00");
+    check(remaining.getActionsAt(8, 45).empty() && !remaining.getActionsAt(7, 45).empty(),
+          "8:45 has passed, 7:45 tomorrow is still planned");
+
+    // Step 6: Five-minute schedule
+    printSeparator("Step 6: Day-Ahead Schedule in 5-Minute Slots");
+
+    optimizer.setSlotLength(SlotLength::FIVE_MINUTES);
+    controller->setSlotLength(SlotLength::FIVE_MINUTES);
+    start = std::chrono::steady_clock::now();
+    DayAheadSchedule fine = optimizer.generateSchedule(8, 2);
+    double fiveMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  96 slots: " << quarterMs << " ms, 288 slots: " << fiveMs << " ms" << std::endl;
+    check(fine.getSlotCount() == 288 && optimizer.getLastSolution().feasible, "288 five-minute slots planned");
+    check(fiveMs < 1000.0, "288 slots scheduled within a second");
+
+    // Step 7: Deferrable recommendations
+    printSeparator("Step 7: Deferrable Recommendations per Slot");
+
+    controller->setSlotLength(SlotLength::FIFTEEN_MINUTES);
+    DayAheadRecommendations recommendations = controller->getDayAheadRecommendations(8, 2);
+    check(recommendations.getSlotCount() == 96, "Recommendations for all 96 slots");
+    check(!recommendations.at(8).empty() && recommendations.at(8)[0].find("Switch OFF") != std::string::npos,
+          "8:00: " + (recommendations.at(8).empty() ? std::string("none") : recommendations.at(8)[0]));
+    check(!recommendations.at(8, 40).empty() && recommendations.at(8, 40)[0].find("Can operate") != std::string::npos,
+          "8:40: " + (recommendations.at(8, 40).empty() ? std::string("none") : recommendations.at(8, 40)[0]));
+
+    // Step 8: Days colder than the heater can make up for
+    printSeparator("Step 8: Cold Days");
+
+    DayAheadOptimizer cold(predictor);
+    cold.setVerbose(false);
+    cold.addAppliance(heater);
+    cold.addAppliance(evCharger);
+    cold.setTargetTemperature(21.0);
+
+    double charged = 0.0;
+    size_t heated = 0;
+    DayAheadSchedule freezing = cold.generateSchedule(coldDay(-5.0));
+    scheduledUse(freezing, "ev_1", charged, heated);
+    check(cold.getLastSolution().feasible && freezing.getActionCount() == 48,
+          "-5 °C: heater and EV planned in every slot (" + std::to_string(freezing.getActionCount()) + " actions)");
+    check(std::abs(charged - 4 * 7.2) < 1e-3, "-5 °C: EV still gets its 4 hours");
+
+    freezing = cold.generateSchedule(coldDay(-15.0));
+    const ScheduleSolution& frozen = cold.getLastSolution();
+    scheduledUse(freezing, "ev_1", charged, heated);
+    check(frozen.feasible && std::abs(charged - 4 * 7.2) < 1e-3,
+          "-15 °C: EV still gets its 4 hours (" + std::to_string(charged) + " kWh)");
+    scheduledUse(freezing, "heater_1", charged, heated);
+    check(heated == 24, "-15 °C: heater on in every slot (" + std::to_string(heated) + " slots)");
+    check(frozen.comfortCost > 0.0 && std::abs(freezing.getEstimatedCost() - (frozen.cost - frozen.comfortCost)) < 1e-9,
+          "The comfort penalty is reported, not billed as energy ($" + std::to_string(frozen.comfortCost) + ")");
+
+    cold.setComfortPenalty(0.0);
+    freezing = cold.generateSchedule(coldDay(-15.0));
+    check(!cold.getLastSolution().feasible, "With a hard band the same day has no device plan");
+
+    // Step 9: Retention counts days, not hours
+    printSeparator("Step 9: Retention at 15-Minute Collection");
+
+    const std::string retentionFile = "sub_hourly_retention.bin";
+    std::remove(retentionFile.c_str());
+    DataCollectionConfig collection;
+    collection.maxDaysToRetain = 2;
+    collection.collectionIntervalMinutes = 15;
+    collection.persistenceFile = retentionFile;
+    std::vector<HistoricalDataPoint> readings;
+    for (int day = 0; day < 3; ++day) {
+        for (int slot = 0; slot < 96; ++slot) {
+            HistoricalDataPoint point;
+            point.hour = slot / 4;
+            point.minute = (slot % 4) * 15;
+            point.dayOfWeek = day + 1;
+            point.outdoorTemp = 10.0;
+            point.solarProduction = 0.0;
+            point.energyCost = 0.2;
+            readings.push_back(point);
+        }
+    }
+    {
+        HistoricalDataCollector collector(collection);
+        for (const auto& point : readings) {
+            collector.addDataPoint(point);
+        }
+        check(collector.getDataPointCount() == 2 * 96, "3 days collected, the last 2 days (192 points) retained (" +
+              std::to_string(collector.getDataPointCount()) + ")");
+        std::vector<HistoricalDataPoint> lastDay = collector.getRecentData(1);
+        check(lastDay.size() == 96 && lastDay[0].dayOfWeek == 3 && lastDay[0].hour == 0 && lastDay[0].minute == 0,
+              "getRecentData(1) returns the whole last day, from 00:00 (" + std::to_string(lastDay.size()) + " points)");
+        check(collector.getRecentData(7).size() == 2 * 96, "getRecentData(7) returns everything retained");
+    }
+    HistoricalDataCollector reloaded(collection);
+    check(reloaded.getDataPointCount() == 2 * 96, "The persistence file keeps 2 days as well (" +
+          std::to_string(reloaded.getDataPointCount()) + " points reloaded)");
+    std::remove(retentionFile.c_str());
+
+    printSeparator("Test Summary");
+    if (failures == 0) {
+        std::cout << "✓ All sub-hourly slot checks passed" << std::endl;
+    } else {
+        std::cout << "✗ " << failures << " check(s) failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}